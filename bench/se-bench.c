@@ -0,0 +1,604 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+/*
+ * se-bench: throughput of the exported string functions.
+ *
+ *     se-bench [-j] [-s SIZE] [-t SECONDS] [-f FILTER]
+ *
+ *     -j          Print JSON instead of a table.
+ *     -s SIZE     Corpus size in bytes of UTF-8 (default 1 MiB).
+ *     -t SECONDS  Minimum measuring time per case (default 0.2).
+ *     -f FILTER   Only run functions whose name contains FILTER.
+ *
+ * Each function runs over corpora of several scripts from se-corpus.c,
+ * and the functions accepting un-safe input also run over corpora with
+ * 0.1%, 1% and 10% of the characters ill-formed. Throughput is reported in
+ * GB/s and cycles per byte of input. The cycle counts come from the time
+ * stamp counter, so they are reference cycles.
+ */
+
+#ifndef SE_UNICODE_H
+    #include "se-unicode.h"
+#endif
+
+#ifndef SE_UTILS_H
+    #include "se-utils.h"
+#endif
+
+#ifndef SE_UNICODE_EXT_H
+    #include "se-unicode-ext.h"
+#endif
+
+#ifndef SE_CORPUS_H
+    #include "se-corpus.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+    #define SE_BENCH_HAVE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define SE_BENCH_HAVE_TSC 1
+#else
+    #define SE_BENCH_HAVE_TSC 0
+#endif
+
+/***************************************************************************
+ *                                                                         *
+ * Corpora.                                                                *
+ *                                                                         *
+ ***************************************************************************/
+
+typedef struct se_bench_corpus se_bench_corpus;
+
+struct se_bench_corpus
+{
+    char name[32];
+    int invalid_permille;
+
+    seunichar8* u8;
+    ptrdiff_t u8_len;
+    seunichar8* u8_copy;
+
+    seunichar16* u16;
+    ptrdiff_t u16_len;
+    seunichar16* u16_copy;
+    char* u16be;
+    ptrdiff_t u16be_len;
+
+    seunichar32* u32;
+    ptrdiff_t u32_len;
+
+    char* gb18030;
+    ptrdiff_t gb18030_len;
+
+    char* shift_jis;
+    ptrdiff_t shift_jis_len;
+
+    char* euc_kr;
+    ptrdiff_t euc_kr_len;
+
+    char* big5;
+    ptrdiff_t big5_len;
+};
+
+static void se_bench_make_corpus(se_bench_corpus* corpus, const char* preset, int invalid_permille, ptrdiff_t size)
+{
+    se_corpus_options options;
+    seunichar8* safe_u8;
+    ptrdiff_t safe_u8_len;
+    ptrdiff_t i;
+
+    if (invalid_permille)
+        sprintf(corpus->name, "%s-%d.%d%%", preset, invalid_permille / 10, invalid_permille % 10);
+    else
+        sprintf(corpus->name, "%s", preset);
+    corpus->invalid_permille = invalid_permille;
+
+    se_corpus_options_init(&options, preset);
+    se_corpus_set_error_rate(&options, invalid_permille * 1000);
+
+    corpus->u8 = se_corpus_generate(&options, SE_CORPUS_UTF8, size, &corpus->u8_len);
+    corpus->u16 = se_corpus_generate(&options, SE_CORPUS_UTF16, size, &corpus->u16_len);
+    corpus->u32 = se_corpus_generate(&options, SE_CORPUS_UTF32, size, &corpus->u32_len);
+
+    corpus->u8_copy = se_utf8_strdup_n(corpus->u8, (int) corpus->u8_len);
+    corpus->u16_copy = se_utf16_strdup_n(corpus->u16, (int) corpus->u16_len);
+
+    /* Byte swapped as is, so the errors are kept */
+    corpus->u16be_len = corpus->u16_len * sizeof(seunichar16);
+    corpus->u16be = SE_MALLOC(corpus->u16be_len);
+    for (i = 0; i < corpus->u16_len; i++)
+    {
+        corpus->u16be[2 * i] = (char) (corpus->u16[i] >> 8);
+        corpus->u16be[2 * i + 1] = (char) corpus->u16[i];
+    }
+
+    safe_u8 = se_unsafe_utf8_str_safe_copy_sz(corpus->u8, corpus->u8_len, &safe_u8_len);
+    corpus->gb18030 = se_safe_utf8_to_gb18030_sz(safe_u8, safe_u8_len, &corpus->gb18030_len);
+    corpus->shift_jis = se_safe_utf8_to_shift_jis_sz(safe_u8, safe_u8_len, &corpus->shift_jis_len);
+    corpus->euc_kr = se_safe_utf8_to_euc_kr_sz(safe_u8, safe_u8_len, &corpus->euc_kr_len);
+    corpus->big5 = se_safe_utf8_to_big5_sz(safe_u8, safe_u8_len, &corpus->big5_len);
+    SE_FREE(safe_u8);
+}
+
+static void se_bench_free_corpus(se_bench_corpus* corpus)
+{
+    SE_FREE(corpus->u8);
+    SE_FREE(corpus->u8_copy);
+    SE_FREE(corpus->u16);
+    SE_FREE(corpus->u16_copy);
+    SE_FREE(corpus->u16be);
+    SE_FREE(corpus->u32);
+    SE_FREE(corpus->gb18030);
+    SE_FREE(corpus->shift_jis);
+    SE_FREE(corpus->euc_kr);
+    SE_FREE(corpus->big5);
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Benchmarked functions.                                                  *
+ *                                                                         *
+ * Each case returns the number of input bytes it processed.               *
+ *                                                                         *
+ ***************************************************************************/
+
+/* Results are folded in here so the calls cannot be optimized away */
+static volatile ptrdiff_t se_bench_sink;
+
+#define SE_BENCH_U8     1       /* Input is the UTF-8 corpus */
+#define SE_BENCH_U16    2       /* Input is the UTF-16 corpus */
+#define SE_BENCH_U32    4       /* Input is the UTF-32 corpus */
+#define SE_BENCH_SAFE   8       /* Only run on well-formed corpora */
+#define SE_BENCH_MBCS   16      /* Input is the UTF-8 corpus in a legacy encoding */
+
+typedef struct se_bench_case se_bench_case;
+
+struct se_bench_case
+{
+    const char* name;
+    int flags;
+    ptrdiff_t (*run)(const se_bench_corpus* corpus);
+};
+
+#define U8_BYTES(c)     ((c)->u8_len)
+#define U16_BYTES(c)    ((c)->u16_len * (ptrdiff_t) sizeof(seunichar16))
+#define U32_BYTES(c)    ((c)->u32_len * (ptrdiff_t) sizeof(seunichar32))
+#define GB_BYTES(c)     ((c)->gb18030_len)
+#define SJIS_BYTES(c)   ((c)->shift_jis_len)
+#define KR_BYTES(c)     ((c)->euc_kr_len)
+#define BIG5_BYTES(c)   ((c)->big5_len)
+
+static ptrdiff_t b_is_valid_utf8(const se_bench_corpus* c) { se_bench_sink += se_is_valid_utf8_str_sz(c->u8, c->u8_len); return U8_BYTES(c); }
+static ptrdiff_t b_is_valid_utf16(const se_bench_corpus* c) { se_bench_sink += se_is_valid_utf16_str_sz(c->u16, c->u16_len); return U16_BYTES(c); }
+static ptrdiff_t b_is_valid_utf32(const se_bench_corpus* c) { se_bench_sink += se_is_valid_utf32_str_sz(c->u32, c->u32_len); return U32_BYTES(c); }
+
+#define SE_BENCH_CONVERT(name, func, in, bytes) \
+    static ptrdiff_t name(const se_bench_corpus* c) \
+    { \
+        ptrdiff_t out_len; \
+        SE_FREE(func(c->in, c->in##_len, &out_len)); \
+        se_bench_sink += out_len; \
+        return bytes(c); \
+    }
+
+SE_BENCH_CONVERT(b_unsafe_utf8_safe_copy, se_unsafe_utf8_str_safe_copy_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_unsafe_utf16_safe_copy, se_unsafe_utf16_str_safe_copy_sz, u16, U16_BYTES)
+SE_BENCH_CONVERT(b_unsafe_utf32_safe_copy, se_unsafe_utf32_str_safe_copy_sz, u32, U32_BYTES)
+SE_BENCH_CONVERT(b_unsafe_utf8_to_utf16, se_unsafe_utf8_to_safe_utf16_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_unsafe_utf16_to_utf8, se_unsafe_utf16_to_safe_utf8_sz, u16, U16_BYTES)
+SE_BENCH_CONVERT(b_unsafe_utf8_to_utf32, se_unsafe_utf8_to_safe_utf32_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_unsafe_utf32_to_utf8, se_unsafe_utf32_to_safe_utf8_sz, u32, U32_BYTES)
+SE_BENCH_CONVERT(b_unsafe_utf16_to_utf32, se_unsafe_utf16_to_safe_utf32_sz, u16, U16_BYTES)
+SE_BENCH_CONVERT(b_unsafe_utf32_to_utf16, se_unsafe_utf32_to_safe_utf16_sz, u32, U32_BYTES)
+SE_BENCH_CONVERT(b_safe_utf8_to_utf16, se_safe_utf8_to_utf16_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_safe_utf16_to_utf8, se_safe_utf16_to_utf8_sz, u16, U16_BYTES)
+SE_BENCH_CONVERT(b_safe_utf8_to_utf32, se_safe_utf8_to_utf32_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_safe_utf32_to_utf8, se_safe_utf32_to_utf8_sz, u32, U32_BYTES)
+SE_BENCH_CONVERT(b_safe_utf16_to_utf32, se_safe_utf16_to_utf32_sz, u16, U16_BYTES)
+SE_BENCH_CONVERT(b_safe_utf32_to_utf16, se_safe_utf32_to_utf16_sz, u32, U32_BYTES)
+
+/* The UTF-8 corpus is also read as Latin-1, where every byte is a character */
+SE_BENCH_CONVERT(b_latin1_to_utf8, se_latin1_to_utf8_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_latin1_to_utf16, se_latin1_to_utf16_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_safe_utf8_to_latin1, se_safe_utf8_to_latin1_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_safe_utf16_to_latin1, se_safe_utf16_to_latin1_sz, u16, U16_BYTES)
+
+SE_BENCH_CONVERT(b_gb18030_to_utf8, se_unsafe_gb18030_to_safe_utf8_sz, gb18030, GB_BYTES)
+SE_BENCH_CONVERT(b_gb18030_to_utf16, se_unsafe_gb18030_to_safe_utf16_sz, gb18030, GB_BYTES)
+SE_BENCH_CONVERT(b_safe_utf8_to_gb18030, se_safe_utf8_to_gb18030_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_safe_utf16_to_gb18030, se_safe_utf16_to_gb18030_sz, u16, U16_BYTES)
+SE_BENCH_CONVERT(b_shift_jis_to_utf8, se_unsafe_shift_jis_to_safe_utf8_sz, shift_jis, SJIS_BYTES)
+SE_BENCH_CONVERT(b_shift_jis_to_utf16, se_unsafe_shift_jis_to_safe_utf16_sz, shift_jis, SJIS_BYTES)
+SE_BENCH_CONVERT(b_safe_utf8_to_shift_jis, se_safe_utf8_to_shift_jis_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_euc_kr_to_utf8, se_unsafe_euc_kr_to_safe_utf8_sz, euc_kr, KR_BYTES)
+SE_BENCH_CONVERT(b_euc_kr_to_utf16, se_unsafe_euc_kr_to_safe_utf16_sz, euc_kr, KR_BYTES)
+SE_BENCH_CONVERT(b_safe_utf8_to_euc_kr, se_safe_utf8_to_euc_kr_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_big5_to_utf8, se_unsafe_big5_to_safe_utf8_sz, big5, BIG5_BYTES)
+SE_BENCH_CONVERT(b_big5_to_utf16, se_unsafe_big5_to_safe_utf16_sz, big5, BIG5_BYTES)
+SE_BENCH_CONVERT(b_safe_utf8_to_big5, se_safe_utf8_to_big5_sz, u8, U8_BYTES)
+
+#define SE_BENCH_STREAM_CHUNK   4096
+
+static ptrdiff_t b_gb18030_to_utf16_stream(const se_bench_corpus* c)
+{
+    seunichar16 buf[SE_BENCH_STREAM_CHUNK];
+    const char* iter;
+    ptrdiff_t left;
+    ptrdiff_t len;
+    ptrdiff_t in_len;
+
+    /* A cut character is left in place to start the next chunk */
+    iter = c->gb18030;
+    left = c->gb18030_len;
+    while (left > 0)
+    {
+        len = left < SE_BENCH_STREAM_CHUNK ? left : SE_BENCH_STREAM_CHUNK;
+        se_bench_sink += se_unsafe_gb18030_to_safe_utf16_stream(iter, len, len == left, &in_len, buf);
+        iter += in_len;
+        left -= in_len;
+    }
+
+    return GB_BYTES(c);
+}
+
+SE_BENCH_CONVERT(b_utf16be_to_utf8, se_unsafe_utf16be_to_safe_utf8_sz, u16be, U16_BYTES)
+SE_BENCH_CONVERT(b_utf16be_to_utf16, se_unsafe_utf16be_to_safe_utf16_sz, u16be, U16_BYTES)
+SE_BENCH_CONVERT(b_safe_utf8_to_utf16be, se_safe_utf8_to_utf16be_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_safe_utf16_to_utf16be, se_safe_utf16_to_utf16be_sz, u16, U16_BYTES)
+SE_BENCH_CONVERT(b_wtf8_to_utf16, se_unsafe_wtf8_to_utf16_sz, u8, U8_BYTES)
+SE_BENCH_CONVERT(b_utf16_to_wtf8, se_utf16_to_wtf8_sz, u16, U16_BYTES)
+SE_BENCH_CONVERT(b_safe_utf8_to_cesu8, se_safe_utf8_to_cesu8_sz, u8, U8_BYTES)
+
+/* Strict conversions of ill-formed corpora stop at the first error and return NULL */
+#define SE_BENCH_CONVERT_EX(name, func, policy, in, bytes) \
+    static ptrdiff_t name(const se_bench_corpus* c) \
+    { \
+        ptrdiff_t out_len; \
+        SE_FREE(func(c->in, c->in##_len, policy, &out_len, 0)); \
+        se_bench_sink += out_len; \
+        return bytes(c); \
+    }
+
+SE_BENCH_CONVERT_EX(b_unsafe_utf8_to_utf16_strict, se_unsafe_utf8_to_safe_utf16_ex_sz, SE_ERROR_STRICT, u8, U8_BYTES)
+SE_BENCH_CONVERT_EX(b_unsafe_utf8_to_utf16_maximal, se_unsafe_utf8_to_safe_utf16_ex_sz, SE_ERROR_MAXIMAL, u8, U8_BYTES)
+SE_BENCH_CONVERT_EX(b_unsafe_utf16_to_utf8_strict, se_unsafe_utf16_to_safe_utf8_ex_sz, SE_ERROR_STRICT, u16, U16_BYTES)
+
+/* Detection reads no more than the default SE_DETECT_PREFIX_LEN bytes */
+#define DETECT_BYTES(len)   ((len) < 65536 ? (len) : 65536)
+
+static ptrdiff_t b_detect_utf8(const se_bench_corpus* c) { se_bench_sink += se_detect_encoding_sz(c->u8, c->u8_len, 0, 0)[0]; return DETECT_BYTES(U8_BYTES(c)); }
+static ptrdiff_t b_detect_gb18030(const se_bench_corpus* c) { se_bench_sink += se_detect_encoding_sz(c->gb18030, c->gb18030_len, 0, 0)[0]; return DETECT_BYTES(GB_BYTES(c)); }
+
+static ptrdiff_t b_utf8_char_count(const se_bench_corpus* c) { se_bench_sink += se_safe_utf8_str_char_count_sz(c->u8, c->u8_len); return U8_BYTES(c); }
+static ptrdiff_t b_utf16_char_count(const se_bench_corpus* c) { se_bench_sink += se_safe_utf16_str_char_count_sz(c->u16, c->u16_len); return U16_BYTES(c); }
+static ptrdiff_t b_utf32_char_count(const se_bench_corpus* c) { se_bench_sink += se_safe_utf32_str_char_count_sz(c->u32, -1); return U32_BYTES(c); }
+
+/* Making the string computes its length, character count and hash once */
+static ptrdiff_t b_ustr_new(const se_bench_corpus* c)
+{
+    se_ustr* s;
+
+    s = se_ustr_new_sz(c->u8, c->u8_len);
+    se_bench_sink += se_ustr_char_count_sz(s) + se_ustr_hash(s);
+    se_ustr_unref(s);
+
+    return U8_BYTES(c);
+}
+
+static ptrdiff_t b_utf8_strcmp_ignore_ascii_case(const se_bench_corpus* c) { se_bench_sink += se_utf8_strcmp_ignore_ascii_case(c->u8, c->u8_copy); return U8_BYTES(c); }
+static ptrdiff_t b_utf16_strcmp(const se_bench_corpus* c) { se_bench_sink += se_utf16_strcmp(c->u16, c->u16_copy); return U16_BYTES(c); }
+static ptrdiff_t b_utf16_strcmp_code_point_order(const se_bench_corpus* c) { se_bench_sink += se_utf16_strcmp_code_point_order(c->u16, c->u16_copy); return U16_BYTES(c); }
+
+/* The needles never occur, so the whole haystack is searched */
+static ptrdiff_t b_utf8_strstr_ignore_space_and_ascii_case(const se_bench_corpus* c) { se_bench_sink += se_utf8_strstr_ignore_space_and_ascii_case(c->u8, "q#x") != 0; return U8_BYTES(c); }
+static ptrdiff_t b_utf8_find_str(const se_bench_corpus* c) { se_bench_sink += se_utf8_str_find_str(c->u8, (int) c->u8_len, "q#x", 3) != 0; return U8_BYTES(c); }
+static ptrdiff_t b_utf8_find_char(const se_bench_corpus* c) { se_bench_sink += se_utf8_str_find_char(c->u8, (int) c->u8_len, '#') != 0; return U8_BYTES(c); }
+static ptrdiff_t b_utf16_find_char(const se_bench_corpus* c) { se_bench_sink += se_utf16_str_find_char(c->u16, (int) c->u16_len, '#') != 0; return U16_BYTES(c); }
+
+static ptrdiff_t b_utf8_hash(const se_bench_corpus* c) { se_bench_sink += se_utf8_str_hash(c->u8); return U8_BYTES(c); }
+
+static ptrdiff_t b_utf8_next_char(const se_bench_corpus* c)
+{
+    const seunichar8* iter;
+    const seunichar8* end;
+
+    iter = c->u8;
+    end = c->u8 + c->u8_len;
+    while (iter < end)
+        iter = se_safe_utf8_next_char(iter);
+
+    se_bench_sink += iter - c->u8;
+    return U8_BYTES(c);
+}
+
+static ptrdiff_t b_utf8_prev_char(const se_bench_corpus* c)
+{
+    const seunichar8* iter;
+
+    iter = c->u8 + c->u8_len;
+    while (iter > c->u8)
+        iter = se_safe_utf8_prev_char(iter);
+
+    se_bench_sink += iter - c->u8;
+    return U8_BYTES(c);
+}
+
+static ptrdiff_t b_utf16_next_char(const se_bench_corpus* c)
+{
+    const seunichar16* iter;
+    const seunichar16* end;
+
+    iter = c->u16;
+    end = c->u16 + c->u16_len;
+    while (iter < end)
+        iter = se_safe_utf16_next_char(iter);
+
+    se_bench_sink += iter - c->u16;
+    return U16_BYTES(c);
+}
+
+static ptrdiff_t b_utf8_offset_to_pointer(const se_bench_corpus* c) { se_bench_sink += se_safe_utf8_offset_to_pointer(c->u8, (int) c->u32_len - 1) - c->u8; return U8_BYTES(c); }
+static ptrdiff_t b_utf8_offset_to_pointer_back(const se_bench_corpus* c) { se_bench_sink += se_safe_utf8_offset_to_pointer(c->u8 + c->u8_len, 1 - (int) c->u32_len) - c->u8; return U8_BYTES(c); }
+static ptrdiff_t b_utf8_pointer_to_offset(const se_bench_corpus* c) { se_bench_sink += se_safe_utf8_pointer_to_offset(c->u8, c->u8 + c->u8_len); return U8_BYTES(c); }
+static ptrdiff_t b_utf16_offset_to_pointer(const se_bench_corpus* c) { se_bench_sink += se_safe_utf16_offset_to_pointer(c->u16, (int) c->u32_len - 1) - c->u16; return U16_BYTES(c); }
+static ptrdiff_t b_utf8_utf16_offset(const se_bench_corpus* c) { se_bench_sink += se_safe_utf8_utf16_offset_to_byte_offset(c->u8, (int) c->u8_len, (int) c->u16_len); return U8_BYTES(c); }
+
+/*
+ * Validation stops at the first ill-formed code, so it is only measured
+ * over well-formed corpora.
+ */
+static const se_bench_case se_bench_cases[] =
+{
+    { "se_is_valid_utf8_str", SE_BENCH_U8 | SE_BENCH_SAFE, b_is_valid_utf8 },
+    { "se_is_valid_utf16_str", SE_BENCH_U16 | SE_BENCH_SAFE, b_is_valid_utf16 },
+    { "se_is_valid_utf32_str", SE_BENCH_U32 | SE_BENCH_SAFE, b_is_valid_utf32 },
+    { "se_unsafe_utf8_str_safe_copy", SE_BENCH_U8, b_unsafe_utf8_safe_copy },
+    { "se_unsafe_utf16_str_safe_copy", SE_BENCH_U16, b_unsafe_utf16_safe_copy },
+    { "se_unsafe_utf32_str_safe_copy", SE_BENCH_U32, b_unsafe_utf32_safe_copy },
+    { "se_unsafe_utf8_to_safe_utf16", SE_BENCH_U8, b_unsafe_utf8_to_utf16 },
+    { "se_unsafe_utf16_to_safe_utf8", SE_BENCH_U16, b_unsafe_utf16_to_utf8 },
+    { "se_unsafe_utf8_to_safe_utf32", SE_BENCH_U8, b_unsafe_utf8_to_utf32 },
+    { "se_unsafe_utf32_to_safe_utf8", SE_BENCH_U32, b_unsafe_utf32_to_utf8 },
+    { "se_unsafe_utf16_to_safe_utf32", SE_BENCH_U16, b_unsafe_utf16_to_utf32 },
+    { "se_unsafe_utf32_to_safe_utf16", SE_BENCH_U32, b_unsafe_utf32_to_utf16 },
+    { "se_safe_utf8_to_utf16", SE_BENCH_U8 | SE_BENCH_SAFE, b_safe_utf8_to_utf16 },
+    { "se_safe_utf16_to_utf8", SE_BENCH_U16 | SE_BENCH_SAFE, b_safe_utf16_to_utf8 },
+    { "se_safe_utf8_to_utf32", SE_BENCH_U8 | SE_BENCH_SAFE, b_safe_utf8_to_utf32 },
+    { "se_safe_utf32_to_utf8", SE_BENCH_U32 | SE_BENCH_SAFE, b_safe_utf32_to_utf8 },
+    { "se_safe_utf16_to_utf32", SE_BENCH_U16 | SE_BENCH_SAFE, b_safe_utf16_to_utf32 },
+    { "se_safe_utf32_to_utf16", SE_BENCH_U32 | SE_BENCH_SAFE, b_safe_utf32_to_utf16 },
+    { "se_latin1_to_utf8", SE_BENCH_U8, b_latin1_to_utf8 },
+    { "se_latin1_to_utf16", SE_BENCH_U8, b_latin1_to_utf16 },
+    { "se_safe_utf8_to_latin1", SE_BENCH_U8 | SE_BENCH_SAFE, b_safe_utf8_to_latin1 },
+    { "se_safe_utf16_to_latin1", SE_BENCH_U16 | SE_BENCH_SAFE, b_safe_utf16_to_latin1 },
+    { "se_unsafe_gb18030_to_safe_utf8", SE_BENCH_MBCS | SE_BENCH_SAFE, b_gb18030_to_utf8 },
+    { "se_unsafe_gb18030_to_safe_utf16", SE_BENCH_MBCS | SE_BENCH_SAFE, b_gb18030_to_utf16 },
+    { "se_safe_utf8_to_gb18030", SE_BENCH_U8 | SE_BENCH_SAFE, b_safe_utf8_to_gb18030 },
+    { "se_safe_utf16_to_gb18030", SE_BENCH_U16 | SE_BENCH_SAFE, b_safe_utf16_to_gb18030 },
+    { "se_unsafe_gb18030_to_safe_utf16_stream", SE_BENCH_MBCS | SE_BENCH_SAFE, b_gb18030_to_utf16_stream },
+    { "se_unsafe_shift_jis_to_safe_utf8", SE_BENCH_MBCS | SE_BENCH_SAFE, b_shift_jis_to_utf8 },
+    { "se_unsafe_shift_jis_to_safe_utf16", SE_BENCH_MBCS | SE_BENCH_SAFE, b_shift_jis_to_utf16 },
+    { "se_safe_utf8_to_shift_jis", SE_BENCH_U8 | SE_BENCH_SAFE, b_safe_utf8_to_shift_jis },
+    { "se_unsafe_euc_kr_to_safe_utf8", SE_BENCH_MBCS | SE_BENCH_SAFE, b_euc_kr_to_utf8 },
+    { "se_unsafe_euc_kr_to_safe_utf16", SE_BENCH_MBCS | SE_BENCH_SAFE, b_euc_kr_to_utf16 },
+    { "se_safe_utf8_to_euc_kr", SE_BENCH_U8 | SE_BENCH_SAFE, b_safe_utf8_to_euc_kr },
+    { "se_unsafe_big5_to_safe_utf8", SE_BENCH_MBCS | SE_BENCH_SAFE, b_big5_to_utf8 },
+    { "se_unsafe_big5_to_safe_utf16", SE_BENCH_MBCS | SE_BENCH_SAFE, b_big5_to_utf16 },
+    { "se_safe_utf8_to_big5", SE_BENCH_U8 | SE_BENCH_SAFE, b_safe_utf8_to_big5 },
+    { "se_unsafe_utf16be_to_safe_utf8", SE_BENCH_U16, b_utf16be_to_utf8 },
+    { "se_unsafe_utf16be_to_safe_utf16", SE_BENCH_U16, b_utf16be_to_utf16 },
+    { "se_safe_utf8_to_utf16be", SE_BENCH_U8 | SE_BENCH_SAFE, b_safe_utf8_to_utf16be },
+    { "se_safe_utf16_to_utf16be", SE_BENCH_U16 | SE_BENCH_SAFE, b_safe_utf16_to_utf16be },
+    { "se_unsafe_wtf8_to_utf16", SE_BENCH_U8, b_wtf8_to_utf16 },
+    { "se_utf16_to_wtf8", SE_BENCH_U16, b_utf16_to_wtf8 },
+    { "se_safe_utf8_to_cesu8", SE_BENCH_U8 | SE_BENCH_SAFE, b_safe_utf8_to_cesu8 },
+    { "se_unsafe_utf8_to_safe_utf16_ex(strict)", SE_BENCH_U8, b_unsafe_utf8_to_utf16_strict },
+    { "se_unsafe_utf8_to_safe_utf16_ex(maximal)", SE_BENCH_U8, b_unsafe_utf8_to_utf16_maximal },
+    { "se_unsafe_utf16_to_safe_utf8_ex(strict)", SE_BENCH_U16, b_unsafe_utf16_to_utf8_strict },
+    { "se_detect_encoding_utf8", SE_BENCH_U8, b_detect_utf8 },
+    { "se_detect_encoding_gb18030", SE_BENCH_MBCS, b_detect_gb18030 },
+    { "se_safe_utf8_str_char_count", SE_BENCH_U8 | SE_BENCH_SAFE, b_utf8_char_count },
+    { "se_safe_utf16_str_char_count", SE_BENCH_U16 | SE_BENCH_SAFE, b_utf16_char_count },
+    { "se_safe_utf32_str_char_count", SE_BENCH_U32 | SE_BENCH_SAFE, b_utf32_char_count },
+    { "se_ustr_new", SE_BENCH_U8, b_ustr_new },
+    { "se_utf8_strcmp_ignore_ascii_case", SE_BENCH_U8, b_utf8_strcmp_ignore_ascii_case },
+    { "se_utf16_strcmp", SE_BENCH_U16, b_utf16_strcmp },
+    { "se_utf16_strcmp_code_point_order", SE_BENCH_U16, b_utf16_strcmp_code_point_order },
+    { "se_utf8_strstr_ignore_space_and_ascii_case", SE_BENCH_U8, b_utf8_strstr_ignore_space_and_ascii_case },
+    { "se_utf8_str_find_str", SE_BENCH_U8, b_utf8_find_str },
+    { "se_utf8_str_find_char", SE_BENCH_U8, b_utf8_find_char },
+    { "se_utf16_str_find_char", SE_BENCH_U16, b_utf16_find_char },
+    { "se_utf8_str_hash", SE_BENCH_U8, b_utf8_hash },
+    { "se_safe_utf8_next_char", SE_BENCH_U8 | SE_BENCH_SAFE, b_utf8_next_char },
+    { "se_safe_utf8_prev_char", SE_BENCH_U8 | SE_BENCH_SAFE, b_utf8_prev_char },
+    { "se_safe_utf16_next_char", SE_BENCH_U16 | SE_BENCH_SAFE, b_utf16_next_char },
+    { "se_safe_utf8_offset_to_pointer", SE_BENCH_U8 | SE_BENCH_SAFE, b_utf8_offset_to_pointer },
+    { "se_safe_utf8_offset_to_pointer(back)", SE_BENCH_U8 | SE_BENCH_SAFE, b_utf8_offset_to_pointer_back },
+    { "se_safe_utf8_pointer_to_offset", SE_BENCH_U8 | SE_BENCH_SAFE, b_utf8_pointer_to_offset },
+    { "se_safe_utf16_offset_to_pointer", SE_BENCH_U16 | SE_BENCH_SAFE, b_utf16_offset_to_pointer },
+    { "se_safe_utf8_utf16_offset_to_byte_offset", SE_BENCH_U8 | SE_BENCH_SAFE, b_utf8_utf16_offset },
+};
+
+/***************************************************************************
+ *                                                                         *
+ * Measuring.                                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+static double se_bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static unsigned long long se_bench_cycles(void)
+{
+    #if SE_BENCH_HAVE_TSC
+        return __rdtsc();
+    #else
+        return 0;
+    #endif
+}
+
+typedef struct se_bench_result se_bench_result;
+
+struct se_bench_result
+{
+    ptrdiff_t bytes;
+    double seconds;
+    double cycles;
+};
+
+static void se_bench_measure(const se_bench_case* bench, const se_bench_corpus* corpus, double min_time, se_bench_result* result)
+/*
+ * Run the case in rounds of growing repeat counts until a round lasts
+ * min_time / 4, then keep the best of four such rounds.
+ */
+{
+    long reps;
+    long i;
+    int round;
+    double start;
+    double seconds;
+    unsigned long long start_cycles;
+    unsigned long long cycles;
+
+    result->bytes = bench->run(corpus);
+    result->seconds = 0;
+    result->cycles = 0;
+
+    reps = 1;
+    round = 0;
+    while (round < 4)
+    {
+        start = se_bench_now();
+        start_cycles = se_bench_cycles();
+
+        for (i = 0; i < reps; i++)
+            bench->run(corpus);
+
+        cycles = se_bench_cycles() - start_cycles;
+        seconds = se_bench_now() - start;
+
+        if (seconds < min_time / 4)
+        {
+            reps *= 2;
+            continue;
+        }
+
+        if (round == 0 || seconds / reps < result->seconds)
+        {
+            result->seconds = seconds / reps;
+            result->cycles = (double) cycles / reps;
+        }
+
+        round++;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    static const char* presets[] = { "ascii", "latin", "cjk", "emoji", "mixed" };
+    static const int invalid_rates[] = { 0, 1, 10, 100 };
+    se_bench_corpus corpora[sizeof(presets) / sizeof(presets[0]) * sizeof(invalid_rates) / sizeof(invalid_rates[0])];
+    se_bench_result result;
+    const se_bench_case* bench;
+    const char* filter;
+    ptrdiff_t size;
+    double min_time;
+    int json;
+    int corpus_count;
+    int first;
+    int i;
+    int j;
+
+    json = 0;
+    size = 1 << 20;
+    min_time = 0.2;
+    filter = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-j") == 0)
+            json = 1;
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            size = atol(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            min_time = atof(argv[++i]);
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else
+        {
+            fputs("usage: se-bench [-j] [-s SIZE] [-t SECONDS] [-f FILTER]\n", stderr);
+            return 2;
+        }
+    }
+
+    if (size < 16 || size > 0x7FFFFFFF / 4)
+    {
+        fputs("se-bench: size out of range\n", stderr);
+        return 2;
+    }
+
+    corpus_count = 0;
+    for (i = 0; i < (int) (sizeof(presets) / sizeof(presets[0])); i++)
+        for (j = 0; j < (int) (sizeof(invalid_rates) / sizeof(invalid_rates[0])); j++)
+            se_bench_make_corpus(&corpora[corpus_count++], presets[i], invalid_rates[j], size);
+
+    if (json)
+        printf("{\n  \"size\": %ld,\n  \"tsc\": %s,\n  \"results\": [", (long) size, SE_BENCH_HAVE_TSC ? "true" : "false");
+    else
+        printf("%-44s %-14s %10s %10s\n", "function", "corpus", "GB/s", "cycles/B");
+
+    first = 1;
+    for (i = 0; i < (int) (sizeof(se_bench_cases) / sizeof(se_bench_cases[0])); i++)
+    {
+        bench = &se_bench_cases[i];
+        if (filter && !strstr(bench->name, filter))
+            continue;
+
+        for (j = 0; j < corpus_count; j++)
+        {
+            if ((bench->flags & SE_BENCH_SAFE) && corpora[j].invalid_permille)
+                continue;
+
+            se_bench_measure(bench, &corpora[j], min_time, &result);
+
+            if (json)
+            {
+                printf("%s\n    { \"function\": \"%s\", \"corpus\": \"%s\", \"bytes\": %ld, \"seconds\": %.9g, \"gbps\": %.4f, \"cycles_per_byte\": %.4f }",
+                       first ? "" : ",", bench->name, corpora[j].name, (long) result.bytes, result.seconds,
+                       result.bytes / result.seconds * 1e-9, result.cycles / result.bytes);
+            }
+            else
+            {
+                printf("%-44s %-14s %10.3f %10.3f\n", bench->name, corpora[j].name,
+                       result.bytes / result.seconds * 1e-9, result.cycles / result.bytes);
+            }
+
+            fflush(stdout);
+            first = 0;
+        }
+    }
+
+    if (json)
+        printf("\n  ]\n}\n");
+
+    for (i = 0; i < corpus_count; i++)
+        se_bench_free_corpus(&corpora[i]);
+
+    return 0;
+}
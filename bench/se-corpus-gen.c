@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+/*
+ * se-corpus-gen: write a synthetic corpus to standard output.
+ *
+ *     se-corpus-gen [options] PRESET SIZE
+ *
+ *     -e ENCODING     utf8 (default), utf16 or utf32, in native byte order.
+ *     -r SEED         Random seed.
+ *     -l LENGTH       Mean run length of a script.
+ *     -w WEIGHTS      Script weights, comma separated in the order ascii,
+ *                     latin, cyrillic, arabic, devanagari, cjk, hangul, emoji.
+ *     -L WEIGHTS      UTF-8 sequence length weights, comma separated for
+ *                     1 to 4 bytes. Replaces the script weights.
+ *     -s PERMILLE     Spaces per thousand characters.
+ *     -E PPM          Errors per million characters, of all kinds.
+ *     -t/-o/-u/-c PPM Truncated, overlong, surrogate or stray continuation
+ *                     errors per million characters.
+ *
+ * SIZE is counted in bytes of the UTF-8 form, so corpora generated with
+ * the same options in different encodings hold the same text.
+ */
+
+#ifndef SE_CORPUS_H
+    #include "se-corpus.h"
+#endif
+
+#ifndef SE_UTILS_H
+    #include "se-utils.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int usage(void)
+{
+    fputs("usage: se-corpus-gen [-e utf8|utf16|utf32] [-r SEED] [-l LENGTH] [-w WEIGHTS] [-L WEIGHTS]\n"
+          "                     [-s PERMILLE] [-E PPM] [-t|-o|-u|-c PPM] PRESET SIZE\n", stderr);
+    return 2;
+}
+
+static void parse_weights(const char* arg, int* weights, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        weights[i] = atoi(arg);
+        arg = strchr(arg, ',');
+        if (!arg)
+            break;
+        arg++;
+    }
+
+    for (i++; i < count; i++)
+        weights[i] = 0;
+}
+
+int main(int argc, char** argv)
+{
+    se_corpus_options options;
+    const char* arg;
+    void* str;
+    ptrdiff_t len;
+    size_t unit_size;
+    int encoding;
+    int i;
+    int j;
+
+    encoding = SE_CORPUS_UTF8;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i += 2)
+        if (i + 1 >= argc)
+            return usage();
+
+    if (argc - i != 2)
+        return usage();
+
+    se_corpus_options_init(&options, argv[i]);
+
+    for (j = 1; j < i; j += 2)
+    {
+        arg = argv[j + 1];
+
+        if (strcmp(argv[j], "-e") == 0)
+        {
+            if (strcmp(arg, "utf8") == 0)
+                encoding = SE_CORPUS_UTF8;
+            else if (strcmp(arg, "utf16") == 0)
+                encoding = SE_CORPUS_UTF16;
+            else if (strcmp(arg, "utf32") == 0)
+                encoding = SE_CORPUS_UTF32;
+            else
+                return usage();
+        }
+        else if (strcmp(argv[j], "-r") == 0)
+            options.seed = (unsigned int) strtoul(arg, 0, 0);
+        else if (strcmp(argv[j], "-l") == 0)
+            options.mean_run_length = atoi(arg);
+        else if (strcmp(argv[j], "-w") == 0)
+            parse_weights(arg, options.script_weights, SE_CORPUS_SCRIPT_COUNT);
+        else if (strcmp(argv[j], "-L") == 0)
+        {
+            memset(options.script_weights, 0, sizeof(options.script_weights));
+            parse_weights(arg, options.length_weights, 4);
+        }
+        else if (strcmp(argv[j], "-s") == 0)
+            options.space_permille = atoi(arg);
+        else if (strcmp(argv[j], "-E") == 0)
+            se_corpus_set_error_rate(&options, atoi(arg));
+        else if (strcmp(argv[j], "-t") == 0)
+            options.error_ppm[SE_CORPUS_TRUNCATED] = atoi(arg);
+        else if (strcmp(argv[j], "-o") == 0)
+            options.error_ppm[SE_CORPUS_OVERLONG] = atoi(arg);
+        else if (strcmp(argv[j], "-u") == 0)
+            options.error_ppm[SE_CORPUS_SURROGATE] = atoi(arg);
+        else if (strcmp(argv[j], "-c") == 0)
+            options.error_ppm[SE_CORPUS_STRAY] = atoi(arg);
+        else
+            return usage();
+    }
+
+    str = se_corpus_generate(&options, encoding, (ptrdiff_t) atol(argv[i + 1]), &len);
+
+    unit_size = encoding == SE_CORPUS_UTF8 ? 1 : encoding == SE_CORPUS_UTF16 ? 2 : 4;
+    if (fwrite(str, unit_size, (size_t) len, stdout) != (size_t) len)
+    {
+        perror("se-corpus-gen");
+        SE_FREE(str);
+        return 1;
+    }
+
+    SE_FREE(str);
+
+    return 0;
+}
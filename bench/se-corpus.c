@@ -0,0 +1,465 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+#ifndef SE_CORPUS_H
+    #include "se-corpus.h"
+#endif
+
+#ifndef SE_UTILS_H
+    #include "se-utils.h"
+#endif
+
+#include <string.h>
+
+typedef struct se_corpus_range se_corpus_range;
+
+struct se_corpus_range
+{
+    seunichar32 first;
+    seunichar32 last;
+};
+
+/* Character ranges of each script, terminated by an empty range */
+static const se_corpus_range se_corpus_ascii[] = { { 0x21, 0x7E }, { 0, 0 } };
+static const se_corpus_range se_corpus_latin[] = { { 0xC0, 0xD6 }, { 0xD8, 0xF6 }, { 0xF8, 0x17F }, { 0, 0 } };
+static const se_corpus_range se_corpus_cyrillic[] = { { 0x410, 0x44F }, { 0, 0 } };
+static const se_corpus_range se_corpus_arabic[] = { { 0x621, 0x64A }, { 0, 0 } };
+static const se_corpus_range se_corpus_devanagari[] = { { 0x905, 0x939 }, { 0x93E, 0x94C }, { 0, 0 } };
+static const se_corpus_range se_corpus_cjk[] = { { 0x4E00, 0x9FFF }, { 0, 0 } };
+static const se_corpus_range se_corpus_hangul[] = { { 0xAC00, 0xD7A3 }, { 0, 0 } };
+static const se_corpus_range se_corpus_emoji[] = { { 0x1F300, 0x1F64F }, { 0x1F900, 0x1F9FF }, { 0, 0 } };
+
+static const se_corpus_range* const se_corpus_scripts[SE_CORPUS_SCRIPT_COUNT] =
+{
+    se_corpus_ascii,
+    se_corpus_latin,
+    se_corpus_cyrillic,
+    se_corpus_arabic,
+    se_corpus_devanagari,
+    se_corpus_cjk,
+    se_corpus_hangul,
+    se_corpus_emoji,
+};
+
+/* Character ranges of each UTF-8 sequence length, avoiding surrogates and noncharacters */
+static const se_corpus_range se_corpus_length_1[] = { { 0x21, 0x7E }, { 0, 0 } };
+static const se_corpus_range se_corpus_length_2[] = { { 0x80, 0x7FF }, { 0, 0 } };
+static const se_corpus_range se_corpus_length_3[] = { { 0x800, 0xD7FF }, { 0xE000, 0xFDCF }, { 0xFDF0, 0xFFFD }, { 0, 0 } };
+static const se_corpus_range se_corpus_length_4[] = { { 0x10000, 0x10FFFD }, { 0, 0 } };
+
+static const se_corpus_range* const se_corpus_lengths[4] =
+{
+    se_corpus_length_1,
+    se_corpus_length_2,
+    se_corpus_length_3,
+    se_corpus_length_4,
+};
+
+/***************************************************************************
+ *                                                                         *
+ * Options.                                                                *
+ *                                                                         *
+ ***************************************************************************/
+
+void se_corpus_options_init(se_corpus_options* options, const char* preset)
+/*
+ * preset:
+ *      One of "ascii", "latin", "cyrillic", "cjk", "emoji", "mixed" or
+ *      "random". Unknown names give "mixed".
+ *
+ * Fill options with a preset workload, without errors.
+ */
+{
+    memset(options, 0, sizeof(*options));
+
+    options->seed = 20071;
+    options->mean_run_length = 64;
+    options->space_permille = 150;
+
+    if (strcmp(preset, "ascii") == 0)
+    {
+        options->script_weights[SE_CORPUS_ASCII] = 1;
+    }
+    else if (strcmp(preset, "latin") == 0)
+    {
+        /* Accented letters come in short runs within ASCII words */
+        options->script_weights[SE_CORPUS_ASCII] = 6;
+        options->script_weights[SE_CORPUS_LATIN] = 1;
+        options->mean_run_length = 4;
+    }
+    else if (strcmp(preset, "cyrillic") == 0)
+    {
+        options->script_weights[SE_CORPUS_CYRILLIC] = 1;
+    }
+    else if (strcmp(preset, "cjk") == 0)
+    {
+        /* Mostly ideographs with some embedded ASCII, no spaces */
+        options->script_weights[SE_CORPUS_ASCII] = 1;
+        options->script_weights[SE_CORPUS_CJK] = 9;
+        options->mean_run_length = 16;
+        options->space_permille = 0;
+    }
+    else if (strcmp(preset, "emoji") == 0)
+    {
+        options->script_weights[SE_CORPUS_ASCII] = 2;
+        options->script_weights[SE_CORPUS_EMOJI] = 3;
+        options->mean_run_length = 3;
+    }
+    else if (strcmp(preset, "random") == 0)
+    {
+        options->length_weights[0] = 1;
+        options->length_weights[1] = 1;
+        options->length_weights[2] = 1;
+        options->length_weights[3] = 1;
+        options->mean_run_length = 1;
+        options->space_permille = 0;
+    }
+    else
+    {
+        options->script_weights[SE_CORPUS_ASCII] = 8;
+        options->script_weights[SE_CORPUS_LATIN] = 2;
+        options->script_weights[SE_CORPUS_CYRILLIC] = 2;
+        options->script_weights[SE_CORPUS_ARABIC] = 1;
+        options->script_weights[SE_CORPUS_DEVANAGARI] = 1;
+        options->script_weights[SE_CORPUS_CJK] = 3;
+        options->script_weights[SE_CORPUS_HANGUL] = 1;
+        options->script_weights[SE_CORPUS_EMOJI] = 1;
+        options->mean_run_length = 12;
+    }
+}
+
+void se_corpus_set_error_rate(se_corpus_options* options, int ppm)
+/*
+ * Spread ppm errors per million characters evenly over all error kinds.
+ */
+{
+    int i;
+
+    for (i = 0; i < SE_CORPUS_ERROR_COUNT; i++)
+        options->error_ppm[i] = ppm / SE_CORPUS_ERROR_COUNT;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Generating.                                                             *
+ *                                                                         *
+ ***************************************************************************/
+
+static unsigned int se_corpus_rand(unsigned int* state)
+/*
+ * xorshift32, good enough for workloads and cheap to reproduce anywhere.
+ */
+{
+    unsigned int x;
+
+    x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+
+    return x;
+}
+
+static unsigned int se_corpus_rand_below(unsigned int* state, unsigned int n)
+{
+    return (unsigned int) (((unsigned long long) se_corpus_rand(state) * n) >> 32);
+}
+
+static int se_corpus_pick(unsigned int* state, const int* weights, int count)
+/*
+ * Return an index drawn with the given weights, or -1 if all are zero.
+ */
+{
+    unsigned int total;
+    unsigned int r;
+    int i;
+
+    total = 0;
+    for (i = 0; i < count; i++)
+        total += weights[i] > 0 ? weights[i] : 0;
+
+    if (total == 0)
+        return -1;
+
+    r = se_corpus_rand_below(state, total);
+    for (i = 0; i < count; i++)
+    {
+        if (weights[i] <= 0)
+            continue;
+        if (r < (unsigned int) weights[i])
+            return i;
+        r -= weights[i];
+    }
+
+    return count - 1;
+}
+
+static seunichar32 se_corpus_pick_char(unsigned int* state, const se_corpus_range* ranges)
+{
+    unsigned int total;
+    unsigned int r;
+    const se_corpus_range* range;
+
+    total = 0;
+    for (range = ranges; range->last; range++)
+        total += range->last - range->first + 1;
+
+    r = se_corpus_rand_below(state, total);
+    for (range = ranges; r > range->last - range->first; range++)
+        r -= range->last - range->first + 1;
+
+    return range->first + r;
+}
+
+static int se_corpus_utf8_len(seunichar32 c)
+{
+    return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+}
+
+static unsigned char* se_corpus_put_utf8(unsigned char* out, seunichar32 c)
+{
+    if (c < 0x80)
+    {
+        *out++ = (unsigned char) c;
+    }
+    else if (c < 0x800)
+    {
+        *out++ = (unsigned char) (0xC0 | (c >> 6));
+        *out++ = (unsigned char) (0x80 | (c & 0x3F));
+    }
+    else if (c < 0x10000)
+    {
+        *out++ = (unsigned char) (0xE0 | (c >> 12));
+        *out++ = (unsigned char) (0x80 | ((c >> 6) & 0x3F));
+        *out++ = (unsigned char) (0x80 | (c & 0x3F));
+    }
+    else
+    {
+        *out++ = (unsigned char) (0xF0 | (c >> 18));
+        *out++ = (unsigned char) (0x80 | ((c >> 12) & 0x3F));
+        *out++ = (unsigned char) (0x80 | ((c >> 6) & 0x3F));
+        *out++ = (unsigned char) (0x80 | (c & 0x3F));
+    }
+
+    return out;
+}
+
+void* se_corpus_generate(const se_corpus_options* options, int encoding, ptrdiff_t size, ptrdiff_t* out_len)
+/*
+ * encoding:
+ *      SE_CORPUS_UTF8, SE_CORPUS_UTF16 or SE_CORPUS_UTF32.
+ *
+ * size:
+ *      Length of the corpus, counted in bytes of its UTF-8 form whatever
+ *      the encoding, so the three encodings hold the same text.
+ *
+ * The injected errors take these forms:
+ *
+ *      Error       UTF-8                   UTF-16                  UTF-32
+ *      ---------   ---------------------   ---------------------   ----------------
+ *      truncated   sequence missing its    high surrogate and      (not generated)
+ *                  last byte               a space
+ *      overlong    ASCII in 2 bytes, or    (not generated)         (not generated)
+ *                  3-byte form of U+07xx
+ *      surrogate   ED A0..BF 80..BF        lone low surrogate      D800..DFFF
+ *      stray       lone 80..BF byte        low surrogate, high     above 10FFFF
+ *                                          surrogate and a space
+ *
+ * A high surrogate is always followed by a space, so two errors never
+ * join into a valid pair. Errors that have no form in the encoding still
+ * consume their random numbers, so the text around them is unchanged. No
+ * NUL is generated.
+ *
+ * Return:
+ *      A newly allocated NUL terminated string, its length in units is
+ *      returned in out_len. This string must be freed by caller.
+ */
+{
+    unsigned int state;
+    unsigned char* u8;
+    seunichar16* u16;
+    seunichar32* u32;
+    void* str;
+    ptrdiff_t bytes;
+    seunichar32 c;
+    seunichar32 payload;
+    int script;
+    int kind;
+    int i;
+
+    SE_DEBUG_ASSERT(options);
+    SE_DEBUG_ASSERT(encoding == SE_CORPUS_UTF8 || encoding == SE_CORPUS_UTF16 || encoding == SE_CORPUS_UTF32);
+    SE_DEBUG_ASSERT(size >= 0);
+
+    /* Every item counts at least one UTF-8 byte and takes at most three UTF-16 units */
+    if (encoding == SE_CORPUS_UTF8)
+        str = SE_MALLOC(size + 5);
+    else if (encoding == SE_CORPUS_UTF16)
+        str = SE_MALLOC((size * 3 + 1) * sizeof(seunichar16));
+    else
+        str = SE_MALLOC((size + 1) * sizeof(seunichar32));
+
+    u8 = (unsigned char*) str;
+    u16 = (seunichar16*) str;
+    u32 = (seunichar32*) str;
+
+    state = options->seed ^ 0x9E3779B9;
+    if (state == 0)
+        state = 1;
+
+    script = se_corpus_pick(&state, options->script_weights, SE_CORPUS_SCRIPT_COUNT);
+    bytes = 0;
+
+    while (bytes < size)
+    {
+        /* Draw an error kind first, -1 for none */
+        kind = -1;
+        payload = se_corpus_rand(&state);
+        for (i = 0; i < SE_CORPUS_ERROR_COUNT; i++)
+        {
+            if (se_corpus_rand_below(&state, 1000000) < (unsigned int) options->error_ppm[i])
+            {
+                kind = i;
+                break;
+            }
+        }
+
+        if (kind >= 0)
+        {
+            switch (kind)
+            {
+                case SE_CORPUS_TRUNCATED:
+                    c = 0x800 + payload % 0xD000;
+                    bytes += 2;
+                    if (encoding == SE_CORPUS_UTF8)
+                        u8 = se_corpus_put_utf8(u8, c) - 1;
+                    else if (encoding == SE_CORPUS_UTF16)
+                    {
+                        *u16++ = (seunichar16) (0xD800 + payload % 0x400);
+                        *u16++ = ' ';
+                    }
+                    break;
+
+                case SE_CORPUS_OVERLONG:
+                    if (payload & 1)
+                    {
+                        c = 0x21 + (payload >> 1) % 0x5E;
+                        bytes += 2;
+                        if (encoding == SE_CORPUS_UTF8)
+                        {
+                            *u8++ = (unsigned char) (0xC0 | (c >> 6));
+                            *u8++ = (unsigned char) (0x80 | (c & 0x3F));
+                        }
+                    }
+                    else
+                    {
+                        c = 0x700 + (payload >> 1) % 0x100;
+                        bytes += 3;
+                        if (encoding == SE_CORPUS_UTF8)
+                        {
+                            *u8++ = 0xE0;
+                            *u8++ = (unsigned char) (0x80 | (c >> 6));
+                            *u8++ = (unsigned char) (0x80 | (c & 0x3F));
+                        }
+                    }
+                    break;
+
+                case SE_CORPUS_SURROGATE:
+                    c = 0xD800 + payload % 0x800;
+                    bytes += 3;
+                    if (encoding == SE_CORPUS_UTF8)
+                        u8 = se_corpus_put_utf8(u8, c);
+                    else if (encoding == SE_CORPUS_UTF16)
+                        *u16++ = (seunichar16) (0xDC00 | (c & 0x3FF));
+                    else
+                        *u32++ = c;
+                    break;
+
+                case SE_CORPUS_STRAY:
+                    bytes += 1;
+                    if (encoding == SE_CORPUS_UTF8)
+                    {
+                        *u8++ = (unsigned char) (0x80 + payload % 0x40);
+                    }
+                    else if (encoding == SE_CORPUS_UTF16)
+                    {
+                        *u16++ = (seunichar16) (0xDC00 + payload % 0x400);
+                        *u16++ = (seunichar16) (0xD800 + (payload >> 10) % 0x400);
+                        *u16++ = ' ';
+                    }
+                    else
+                    {
+                        *u32++ = 0x110000 + payload % 0xEF0000;
+                    }
+                    break;
+            }
+
+            continue;
+        }
+
+        /* Then a space, or a character of the current script */
+        if (options->space_permille && se_corpus_rand_below(&state, 1000) < (unsigned int) options->space_permille)
+        {
+            c = se_corpus_rand_below(&state, 16) ? ' ' : '\n';
+        }
+        else
+        {
+            if (options->mean_run_length <= 1 || se_corpus_rand_below(&state, options->mean_run_length) == 0)
+                script = se_corpus_pick(&state, options->script_weights, SE_CORPUS_SCRIPT_COUNT);
+
+            if (script >= 0)
+            {
+                c = se_corpus_pick_char(&state, se_corpus_scripts[script]);
+            }
+            else
+            {
+                i = se_corpus_pick(&state, options->length_weights, 4);
+                c = se_corpus_pick_char(&state, se_corpus_lengths[i >= 0 ? i : 0]);
+            }
+        }
+
+        bytes += se_corpus_utf8_len(c);
+
+        if (encoding == SE_CORPUS_UTF8)
+        {
+            u8 = se_corpus_put_utf8(u8, c);
+        }
+        else if (encoding == SE_CORPUS_UTF16)
+        {
+            if (c >= 0x10000)
+            {
+                *u16++ = (seunichar16) (0xD800 | ((c - 0x10000) >> 10));
+                *u16++ = (seunichar16) (0xDC00 | ((c - 0x10000) & 0x3FF));
+            }
+            else
+            {
+                *u16++ = (seunichar16) c;
+            }
+        }
+        else
+        {
+            *u32++ = c;
+        }
+    }
+
+    if (encoding == SE_CORPUS_UTF8)
+    {
+        *u8 = 0;
+        *out_len = u8 - (unsigned char*) str;
+    }
+    else if (encoding == SE_CORPUS_UTF16)
+    {
+        *u16 = 0;
+        *out_len = u16 - (seunichar16*) str;
+    }
+    else
+    {
+        *u32 = 0;
+        *out_len = u32 - (seunichar32*) str;
+    }
+
+    return str;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+#ifndef SE_CORPUS_H
+#define SE_CORPUS_H
+
+#ifndef SE_UNICODE_H
+    #include "se-unicode.h"
+#endif
+
+#include <stddef.h>
+
+/*
+ * Deterministic synthetic text for benchmarks and differential tests.
+ *
+ * Text is generated as runs of characters from one script, switching
+ * script with a configurable mean run length. The same options and seed
+ * always give the same characters, whatever the output encoding, so UTF-8,
+ * UTF-16 and UTF-32 corpora of one workload are translations of each
+ * other up to the injected errors.
+ */
+
+/* Scripts */
+#define SE_CORPUS_ASCII         0       /* Printable ASCII */
+#define SE_CORPUS_LATIN         1       /* ASCII with Latin-1 and Latin Extended-A letters */
+#define SE_CORPUS_CYRILLIC      2
+#define SE_CORPUS_ARABIC        3
+#define SE_CORPUS_DEVANAGARI    4
+#define SE_CORPUS_CJK           5       /* CJK Unified Ideographs */
+#define SE_CORPUS_HANGUL        6
+#define SE_CORPUS_EMOJI         7
+#define SE_CORPUS_SCRIPT_COUNT  8
+
+/* Injected errors, see se_corpus_generate() for their form per encoding */
+#define SE_CORPUS_TRUNCATED     0
+#define SE_CORPUS_OVERLONG      1
+#define SE_CORPUS_SURROGATE     2
+#define SE_CORPUS_STRAY         3
+#define SE_CORPUS_ERROR_COUNT   4
+
+/* Encodings */
+#define SE_CORPUS_UTF8          1
+#define SE_CORPUS_UTF16         2
+#define SE_CORPUS_UTF32         4
+
+typedef struct se_corpus_options se_corpus_options;
+
+struct se_corpus_options
+{
+    unsigned int seed;
+
+    /*
+     * Relative weights of the scripts. When all are zero, characters are
+     * drawn by their UTF-8 sequence length instead, with length_weights[0]
+     * for 1-byte sequences up to length_weights[3] for 4-byte ones.
+     */
+    int script_weights[SE_CORPUS_SCRIPT_COUNT];
+    int length_weights[4];
+
+    /* Mean number of characters before the script changes */
+    int mean_run_length;
+
+    /* Spaces per thousand characters */
+    int space_permille;
+
+    /* Errors of each kind per million characters */
+    int error_ppm[SE_CORPUS_ERROR_COUNT];
+};
+
+void se_corpus_options_init(se_corpus_options* options, const char* preset);
+
+void* se_corpus_generate(const se_corpus_options* options, int encoding, ptrdiff_t size, ptrdiff_t* out_len);
+
+void se_corpus_set_error_rate(se_corpus_options* options, int ppm);
+
+#endif /* SE_CORPUS_H */
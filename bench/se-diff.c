@@ -0,0 +1,2273 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+/*
+ * se-diff: differential test of the accelerated string functions.
+ *
+ *     se-diff [-n COUNT] [-r SEED] [-m SIZE] [-c RATIO] [-f FILTER] [-v] [FILE...]
+ *
+ *     -n COUNT    Number of generated inputs (default 2000).
+ *     -r SEED     Seed of the first input, input i uses SEED + i (default 1).
+ *     -m SIZE     Maximum size of a generated input in bytes (default 65536).
+ *     -c RATIO    Report inputs on which the library is more than RATIO
+ *                 times slower than the reference (default 2).
+ *     -f FILTER   Only run functions whose name contains FILTER.
+ *     -v          Print every performance cliff, not only a summary.
+ *
+ * Every function is called on the same input in the library as built and
+ * in the scalar reference build of se-reference.c, and the results must
+ * be identical: return values, output lengths and every output unit, so
+ * replacement characters must come out at exactly the same places. Inputs
+ * are placed flush against an inaccessible page, so a vector load reading
+ * past the end of the input crashes instead of passing unnoticed.
+ * se_detect_encoding_sz() has no reference and is checked on a table of
+ * known answers first, and so is the GB18030 transcoder, whose reference
+ * shares its mapping tables, and the rules of the UTF-8 variants. Those
+ * that keep lone surrogates must also give back any string of 16 bit
+ * units they encode. The _stream decoders are fed their input in
+ * chunks, and their joined output is compared with the one-shot
+ * conversion of the reference build, which is also what they are timed
+ * against.
+ *
+ * Generated inputs come from se-corpus.c with random presets, sizes and
+ * error rates, and from generators of adversarial byte patterns. FILE
+ * arguments are used as raw inputs instead, the same way the fuzzer entry
+ * point does, so inputs saved by libFuzzer can be replayed.
+ *
+ * Each call is also timed in both builds. An input of at least 4 KiB on
+ * which the library is more than RATIO times slower than the reference
+ * is a performance cliff, reported with the seed that reproduces it with
+ * "-r SEED -n 1". Throughput is counted over the whole input, also for
+ * the searches that stop at the first match.
+ *
+ * Built with -DSE_DIFF_FUZZER, this file provides LLVMFuzzerTestOneInput()
+ * instead of main() and aborts on the first mismatch:
+ *
+ *     clang -fsanitize=fuzzer,address -DSE_DIFF_FUZZER bench/se-diff.c
+ *         bench/se-reference.c bench/se-corpus.c se-unicode-string.c
+ *
+ * The exit status is 0 if all results match, 1 on a mismatch and 2 on a
+ * usage error.
+ */
+
+#ifndef SE_UNICODE_H
+    #include "se-unicode.h"
+#endif
+
+#ifndef SE_UTILS_H
+    #include "se-utils.h"
+#endif
+
+#ifndef SE_UNICODE_EXT_H
+    #include "se-unicode-ext.h"
+#endif
+
+#ifndef SE_CORPUS_H
+    #include "se-corpus.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #define SE_DIFF_HAVE_GUARD 1
+#else
+    #define SE_DIFF_HAVE_GUARD 0
+#endif
+
+/***************************************************************************
+ *                                                                         *
+ * The reference build, see se-reference.c.                                *
+ *                                                                         *
+ ***************************************************************************/
+
+sebool se_ref_is_valid_utf8_str_sz(const seunichar8* str, ptrdiff_t len);
+sebool se_ref_is_valid_utf16_str_sz(const seunichar16* str, ptrdiff_t len);
+sebool se_ref_is_valid_utf32_str_sz(const seunichar32* str, ptrdiff_t len);
+seunichar8* se_ref_unsafe_utf8_str_safe_copy_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_utf16_str_safe_copy_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar32* se_ref_unsafe_utf32_str_safe_copy_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+ptrdiff_t se_ref_unsafe_utf8_str_safe_copy_into(const seunichar8* str, ptrdiff_t len, seunichar8* buf);
+seunichar16* se_ref_unsafe_utf8_to_safe_utf16_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+ptrdiff_t se_ref_unsafe_utf8_to_safe_utf16_into(const seunichar8* str, ptrdiff_t len, seunichar16* buf);
+seunichar16* se_ref_unsafe_utf8_to_safe_utf16_batch(const seunichar8* const* strs, const int* lens, int count, int* offsets, int* out_len);
+seunichar8* se_ref_unsafe_utf16_to_safe_utf8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+ptrdiff_t se_ref_unsafe_utf16_to_safe_utf8_into(const seunichar16* str, ptrdiff_t len, seunichar8* buf);
+seunichar32* se_ref_unsafe_utf8_to_safe_utf32_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_unsafe_utf32_to_safe_utf8_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar32* se_ref_unsafe_utf16_to_safe_utf32_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_utf32_to_safe_utf16_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_unsafe_utf8_str_safe_copy_ex_sz(const seunichar8* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+seunichar16* se_ref_unsafe_utf16_str_safe_copy_ex_sz(const seunichar16* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+seunichar32* se_ref_unsafe_utf32_str_safe_copy_ex_sz(const seunichar32* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+seunichar16* se_ref_unsafe_utf8_to_safe_utf16_ex_sz(const seunichar8* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+seunichar8* se_ref_unsafe_utf16_to_safe_utf8_ex_sz(const seunichar16* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+seunichar32* se_ref_unsafe_utf8_to_safe_utf32_ex_sz(const seunichar8* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+seunichar8* se_ref_unsafe_utf32_to_safe_utf8_ex_sz(const seunichar32* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+seunichar32* se_ref_unsafe_utf16_to_safe_utf32_ex_sz(const seunichar16* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+seunichar16* se_ref_unsafe_utf32_to_safe_utf16_ex_sz(const seunichar32* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+seunichar16* se_ref_safe_utf8_to_utf16_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_safe_utf16_to_utf8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar32* se_ref_safe_utf8_to_utf32_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_safe_utf32_to_utf8_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar32* se_ref_safe_utf16_to_utf32_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_safe_utf32_to_utf16_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+sebool se_ref_is_ascii_str_sz(const seunichar8* str, ptrdiff_t len);
+sebool se_ref_is_ascii_utf16_str_sz(const seunichar16* str, ptrdiff_t len);
+sebool se_ref_is_latin1_utf8_str_sz(const seunichar8* str, ptrdiff_t len);
+sebool se_ref_is_latin1_utf16_str_sz(const seunichar16* str, ptrdiff_t len);
+seunichar8* se_ref_latin1_to_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+ptrdiff_t se_ref_latin1_to_utf8_into(const char* str, ptrdiff_t len, seunichar8* buf);
+seunichar16* se_ref_latin1_to_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+ptrdiff_t se_ref_latin1_to_utf16_into(const char* str, ptrdiff_t len, seunichar16* buf);
+char* se_ref_safe_utf8_to_latin1_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+ptrdiff_t se_ref_safe_utf8_to_latin1_into(const seunichar8* str, ptrdiff_t len, char* buf);
+char* se_ref_safe_utf16_to_latin1_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+ptrdiff_t se_ref_safe_utf16_to_latin1_into(const seunichar16* str, ptrdiff_t len, char* buf);
+ptrdiff_t se_ref_safe_utf8_str_char_count_sz(const seunichar8* str, ptrdiff_t len);
+ptrdiff_t se_ref_safe_utf16_str_char_count_sz(const seunichar16* str, ptrdiff_t len);
+ptrdiff_t se_ref_safe_utf32_str_char_count_sz(const seunichar32* str, ptrdiff_t len);
+seunichar32 se_ref_safe_utf8_get_char(const seunichar8* str);
+const seunichar8* se_ref_safe_utf8_offset_to_pointer(const seunichar8* str, int offset);
+int se_ref_safe_utf8_pointer_to_offset(const seunichar8* str, const seunichar8* pos);
+const seunichar16* se_ref_safe_utf16_offset_to_pointer(const seunichar16* str, int offset);
+int se_ref_safe_utf16_pointer_to_offset(const seunichar16* str, const seunichar16* pos);
+se_utf8_index* se_ref_utf8_index_new(const seunichar8* str, int len, int interval);
+void se_ref_utf8_index_free(se_utf8_index* index);
+int se_ref_utf8_index_char_count(const se_utf8_index* index);
+const seunichar8* se_ref_utf8_index_offset_to_pointer(const se_utf8_index* index, int offset);
+int se_ref_utf8_index_pointer_to_offset(const se_utf8_index* index, const seunichar8* pos);
+int se_ref_safe_utf8_utf16_len(const seunichar8* str, int len);
+int se_ref_safe_utf16_utf8_len(const seunichar16* str, int len);
+int se_ref_safe_utf8_utf16_offset_to_byte_offset(const seunichar8* str, int len, int utf16_offset);
+void se_ref_safe_utf8_byte_offsets_to_utf16_offsets(const seunichar8* str, int len, const int* byte_offsets, int* utf16_offsets, int count);
+void se_ref_safe_utf8_utf16_offsets_to_byte_offsets(const seunichar8* str, int len, const int* utf16_offsets, int* byte_offsets, int count);
+unsigned int se_ref_utf8_str_hash(const seunichar8* str);
+int se_ref_utf16_strcmp(const seunichar16* str1, const seunichar16* str2);
+int se_ref_utf16_strcmp_code_point_order(const seunichar16* str1, const seunichar16* str2);
+const seunichar8* se_ref_utf8_str_find_char(const seunichar8* str, int len, seunichar8 c);
+const seunichar16* se_ref_utf16_str_find_char(const seunichar16* str, int len, seunichar16 c);
+const seunichar32* se_ref_utf32_str_find_char(const seunichar32* str, int len, seunichar32 c);
+const seunichar8* se_ref_safe_utf8_str_find_unichar(const seunichar8* str, int len, seunichar c);
+const seunichar16* se_ref_safe_utf16_str_find_unichar(const seunichar16* str, int len, seunichar c);
+const seunichar8* se_ref_utf8_str_find_str(const seunichar8* str, int len, const seunichar8* sub_str, int sub_len);
+const seunichar16* se_ref_utf16_str_find_str(const seunichar16* str, int len, const seunichar16* sub_str, int sub_len);
+const seunichar32* se_ref_utf32_str_find_str(const seunichar32* str, int len, const seunichar32* sub_str, int sub_len);
+const seunichar8* se_ref_safe_utf8_str_find_any(const seunichar8* str, int len, const seunichar8* set, int set_len);
+const seunichar16* se_ref_safe_utf16_str_find_any(const seunichar16* str, int len, const seunichar16* set, int set_len);
+const seunichar32* se_ref_utf32_str_find_any(const seunichar32* str, int len, const seunichar32* set, int set_len);
+
+sebool se_ref_is_valid_utf16be_str_sz(const char* str, ptrdiff_t len);
+sebool se_ref_is_valid_utf16le_str_sz(const char* str, ptrdiff_t len);
+sebool se_ref_is_valid_utf32be_str_sz(const char* str, ptrdiff_t len);
+sebool se_ref_is_valid_utf32le_str_sz(const char* str, ptrdiff_t len);
+seunichar8* se_ref_unsafe_utf16be_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_utf16be_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar32* se_ref_unsafe_utf16be_to_safe_utf32_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_unsafe_utf16le_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_utf16le_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar32* se_ref_unsafe_utf16le_to_safe_utf32_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_unsafe_utf32be_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_utf32be_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar32* se_ref_unsafe_utf32be_to_safe_utf32_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_unsafe_utf32le_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_utf32le_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar32* se_ref_unsafe_utf32le_to_safe_utf32_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf8_to_utf16be_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf8_to_utf16le_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf8_to_utf32be_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf8_to_utf32le_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf16_to_utf16be_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf16_to_utf16le_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf16_to_utf32be_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf16_to_utf32le_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf32_to_utf16be_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf32_to_utf16le_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf32_to_utf32be_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf32_to_utf32le_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_unsafe_gb18030_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_gb18030_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf8_to_gb18030_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf16_to_gb18030_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_unsafe_shift_jis_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_shift_jis_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf8_to_shift_jis_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf16_to_shift_jis_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_unsafe_euc_kr_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_euc_kr_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf8_to_euc_kr_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf16_to_euc_kr_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_unsafe_big5_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_big5_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf8_to_big5_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf16_to_big5_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+sebool se_ref_is_valid_wtf8_str_sz(const char* str, ptrdiff_t len);
+seunichar16* se_ref_unsafe_wtf8_to_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_wtf8_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_unsafe_wtf8_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_utf16_to_wtf8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+sebool se_ref_is_valid_cesu8_str_sz(const char* str, ptrdiff_t len);
+seunichar8* se_ref_unsafe_cesu8_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_cesu8_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf8_to_cesu8_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf16_to_cesu8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+sebool se_ref_is_valid_mutf8_str_sz(const char* str, ptrdiff_t len);
+seunichar16* se_ref_unsafe_mutf8_to_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar16* se_ref_unsafe_mutf8_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+seunichar8* se_ref_unsafe_mutf8_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_utf16_to_mutf8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+char* se_ref_safe_utf8_to_mutf8_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+/* Call func in the library, or in the reference build if ref is set */
+#define SE_DIFF_CALL(ref, func, args)   ((ref) ? se_ref_##func args : se_##func args)
+
+/***************************************************************************
+ *                                                                         *
+ * Guarded buffers.                                                        *
+ *                                                                         *
+ * A string is copied to the end of a buffer that is followed by an        *
+ * inaccessible page, with its NUL terminator as the last accessible unit. *
+ *                                                                         *
+ ***************************************************************************/
+
+typedef struct se_diff_buffer se_diff_buffer;
+
+struct se_diff_buffer
+{
+    unsigned char* base;
+    size_t size;
+};
+
+static void* se_diff_place(se_diff_buffer* buffer, const void* data, size_t bytes, size_t unit)
+{
+    #if SE_DIFF_HAVE_GUARD
+        size_t page;
+    #endif
+    unsigned char* str;
+    size_t size;
+
+    size = bytes + unit;
+
+    if (size > buffer->size)
+    {
+        #if SE_DIFF_HAVE_GUARD
+
+            page = (size_t) sysconf(_SC_PAGESIZE);
+
+            if (buffer->base)
+                munmap(buffer->base, buffer->size + page);
+
+            buffer->size = (size + page - 1) / page * page;
+            buffer->base = mmap(0, buffer->size + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (buffer->base == MAP_FAILED || mprotect(buffer->base + buffer->size, page, PROT_NONE) < 0)
+            {
+                perror("se-diff: mmap");
+                exit(2);
+            }
+
+        #else
+
+            SE_FREE(buffer->base);
+            buffer->size = size;
+            buffer->base = SE_MALLOC(size);
+            if (!buffer->base)
+            {
+                fputs("se-diff: out of memory\n", stderr);
+                exit(2);
+            }
+
+        #endif
+    }
+
+    str = buffer->base + buffer->size - size;
+    if (data && bytes)
+        memcpy(str, data, bytes);
+    memset(str + bytes, 0, unit);
+
+    return str;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Inputs.                                                                 *
+ *                                                                         *
+ ***************************************************************************/
+
+#define SE_DIFF_OFFSET_COUNT    4
+
+/* Indexes of se_diff_mbcs_encoders */
+#define SE_DIFF_GB18030         0
+#define SE_DIFF_SHIFT_JIS       1
+#define SE_DIFF_EUC_KR          2
+#define SE_DIFF_BIG5            3
+#define SE_DIFF_MBCS_COUNT      4
+
+/* Indexes of the UTF-8 variants */
+#define SE_DIFF_WTF8            0
+#define SE_DIFF_CESU8           1
+#define SE_DIFF_MUTF8           2
+#define SE_DIFF_VARIANT_COUNT   3
+
+typedef struct se_diff_input se_diff_input;
+
+struct se_diff_input
+{
+    unsigned int seed;
+    char kind[32];
+
+    /* Un-safe strings, for generated inputs three encodings of one text */
+    const seunichar8* u8;
+    ptrdiff_t u8_len;
+    const seunichar16* u16;
+    ptrdiff_t u16_len;
+    const seunichar32* u32;
+    ptrdiff_t u32_len;
+
+    /* The same strings repaired by the reference build */
+    const seunichar8* safe_u8;
+    ptrdiff_t safe_u8_len;
+    const seunichar16* safe_u16;
+    ptrdiff_t safe_u16_len;
+    const seunichar32* safe_u32;
+    ptrdiff_t safe_u32_len;
+
+    /* safe_u16 with one unit changed, for the comparisons */
+    const seunichar16* other_u16;
+
+    /* safe_u8 in the legacy encodings, see se_diff_mbcs_encoders */
+    const char* mbcs[SE_DIFF_MBCS_COUNT];
+    ptrdiff_t mbcs_len[SE_DIFF_MBCS_COUNT];
+
+    /* u16 in WTF-8 and Modified UTF-8, with its lone surrogates, and safe_u16 in CESU-8 */
+    const char* variants[SE_DIFF_VARIANT_COUNT];
+    ptrdiff_t variants_len[SE_DIFF_VARIANT_COUNT];
+
+    /* Needles and character sets, taken from the strings */
+    const seunichar8* u8_needle;
+    int u8_needle_len;
+    const seunichar16* u16_needle;
+    int u16_needle_len;
+    const seunichar32* u32_needle;
+    int u32_needle_len;
+    int safe_u8_set_len;
+    int safe_u16_set_len;
+
+    /* Positions within safe_u8 and safe_u16, all at character boundaries */
+    int u8_chars;
+    int u8_offset;
+    int u8_pos;
+    int u8_utf16_len;
+    int u8_byte_offsets[SE_DIFF_OFFSET_COUNT];
+    int u8_utf16_offsets[SE_DIFF_OFFSET_COUNT];
+    int u16_chars;
+    int u16_offset;
+    int u16_pos;
+
+    /* Picks characters, offsets and split points */
+    unsigned int pick;
+};
+
+static se_diff_buffer se_diff_buffers[10];
+static se_diff_buffer se_diff_mbcs_buffers[SE_DIFF_MBCS_COUNT];
+static se_diff_buffer se_diff_variant_buffers[SE_DIFF_VARIANT_COUNT];
+
+static char* (*const se_diff_mbcs_encoders[SE_DIFF_MBCS_COUNT])(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len) =
+{
+    se_ref_safe_utf8_to_gb18030_sz,
+    se_ref_safe_utf8_to_shift_jis_sz,
+    se_ref_safe_utf8_to_euc_kr_sz,
+    se_ref_safe_utf8_to_big5_sz
+};
+
+static unsigned int se_diff_random(unsigned int* state)
+{
+    unsigned int x;
+
+    x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+
+    return x;
+}
+
+static int se_diff_clamp(ptrdiff_t len, unsigned int pick, int max)
+/*
+ * A length from 1 to max, not reaching past len.
+ */
+{
+    int n;
+
+    n = 1 + (int) (pick % (unsigned int) max);
+    if (n > len)
+        n = (int) len;
+
+    return n;
+}
+
+static void se_diff_set_input(se_diff_input* in, const void* u8, ptrdiff_t u8_len, const void* u16, ptrdiff_t u16_len,
+                              const void* u32, ptrdiff_t u32_len)
+/*
+ * Place the strings in guarded buffers and derive everything the checks
+ * need from them. Only the reference build is used here.
+ */
+{
+    seunichar8* safe_u8;
+    seunichar16* safe_u16;
+    seunichar32* safe_u32;
+    seunichar16* other_u16;
+    seunichar8* needle8;
+    seunichar16* needle16;
+    seunichar32* needle32;
+    char* mbcs;
+    unsigned int state;
+    ptrdiff_t at;
+    int i;
+
+    in->u8 = se_diff_place(&se_diff_buffers[0], u8, (size_t) u8_len, sizeof(seunichar8));
+    in->u8_len = u8_len;
+    in->u16 = se_diff_place(&se_diff_buffers[1], u16, (size_t) u16_len * sizeof(seunichar16), sizeof(seunichar16));
+    in->u16_len = u16_len;
+    in->u32 = se_diff_place(&se_diff_buffers[2], u32, (size_t) u32_len * sizeof(seunichar32), sizeof(seunichar32));
+    in->u32_len = u32_len;
+
+    safe_u8 = se_ref_unsafe_utf8_str_safe_copy_sz(in->u8, in->u8_len, &in->safe_u8_len);
+    safe_u16 = se_ref_unsafe_utf16_str_safe_copy_sz(in->u16, in->u16_len, &in->safe_u16_len);
+    safe_u32 = se_ref_unsafe_utf32_str_safe_copy_sz(in->u32, in->u32_len, &in->safe_u32_len);
+    in->safe_u8 = se_diff_place(&se_diff_buffers[3], safe_u8, (size_t) in->safe_u8_len, sizeof(seunichar8));
+    in->safe_u16 = se_diff_place(&se_diff_buffers[4], safe_u16, (size_t) in->safe_u16_len * sizeof(seunichar16), sizeof(seunichar16));
+    in->safe_u32 = se_diff_place(&se_diff_buffers[5], safe_u32, (size_t) in->safe_u32_len * sizeof(seunichar32), sizeof(seunichar32));
+    SE_FREE(safe_u8);
+    SE_FREE(safe_u32);
+
+    /* Well-formed legacy text, of the characters each encoding has */
+    for (i = 0; i < SE_DIFF_MBCS_COUNT; i++)
+    {
+        mbcs = se_diff_mbcs_encoders[i](in->safe_u8, in->safe_u8_len, &in->mbcs_len[i]);
+        in->mbcs[i] = se_diff_place(&se_diff_mbcs_buffers[i], mbcs, (size_t) in->mbcs_len[i], 1);
+        SE_FREE(mbcs);
+    }
+
+    mbcs = se_ref_utf16_to_wtf8_sz(in->u16, in->u16_len, &in->variants_len[SE_DIFF_WTF8]);
+    in->variants[SE_DIFF_WTF8] = se_diff_place(&se_diff_variant_buffers[SE_DIFF_WTF8], mbcs, (size_t) in->variants_len[SE_DIFF_WTF8], 1);
+    SE_FREE(mbcs);
+    mbcs = se_ref_safe_utf16_to_cesu8_sz(in->safe_u16, in->safe_u16_len, &in->variants_len[SE_DIFF_CESU8]);
+    in->variants[SE_DIFF_CESU8] = se_diff_place(&se_diff_variant_buffers[SE_DIFF_CESU8], mbcs, (size_t) in->variants_len[SE_DIFF_CESU8], 1);
+    SE_FREE(mbcs);
+    mbcs = se_ref_utf16_to_mutf8_sz(in->u16, in->u16_len, &in->variants_len[SE_DIFF_MUTF8]);
+    in->variants[SE_DIFF_MUTF8] = se_diff_place(&se_diff_variant_buffers[SE_DIFF_MUTF8], mbcs, (size_t) in->variants_len[SE_DIFF_MUTF8], 1);
+    SE_FREE(mbcs);
+
+    state = in->pick | 1;
+
+    /* Change one unit, so the comparisons run up to a random point */
+    other_u16 = safe_u16;
+    if (in->safe_u16_len)
+        other_u16[se_diff_random(&state) % (unsigned int) in->safe_u16_len] = (seunichar16) se_diff_random(&state);
+    in->other_u16 = se_diff_place(&se_diff_buffers[6], other_u16, (size_t) in->safe_u16_len * sizeof(seunichar16), sizeof(seunichar16));
+    SE_FREE(safe_u16);
+
+    /*
+     * Needles of up to 8 units cut from the strings, so most of them are
+     * found. Every other one gets its last unit changed, so it is mostly
+     * not found and the whole string is searched.
+     */
+    at = in->u8_len ? (ptrdiff_t) (se_diff_random(&state) % (unsigned int) in->u8_len) : 0;
+    in->u8_needle_len = se_diff_clamp(in->u8_len - at, se_diff_random(&state), 8);
+    needle8 = se_diff_place(&se_diff_buffers[7], in->u8 + at, (size_t) in->u8_needle_len, sizeof(seunichar8));
+    if (in->u8_needle_len && (in->pick & 1))
+        needle8[in->u8_needle_len - 1] ^= 0x5A;
+    in->u8_needle = needle8;
+
+    at = in->u16_len ? (ptrdiff_t) (se_diff_random(&state) % (unsigned int) in->u16_len) : 0;
+    in->u16_needle_len = se_diff_clamp(in->u16_len - at, se_diff_random(&state), 8);
+    needle16 = se_diff_place(&se_diff_buffers[8], in->u16 + at, (size_t) in->u16_needle_len * sizeof(seunichar16), sizeof(seunichar16));
+    if (in->u16_needle_len && (in->pick & 1))
+        needle16[in->u16_needle_len - 1] ^= 0x5A5A;
+    in->u16_needle = needle16;
+
+    at = in->u32_len ? (ptrdiff_t) (se_diff_random(&state) % (unsigned int) in->u32_len) : 0;
+    in->u32_needle_len = se_diff_clamp(in->u32_len - at, se_diff_random(&state), 8);
+    needle32 = se_diff_place(&se_diff_buffers[9], in->u32 + at, (size_t) in->u32_needle_len * sizeof(seunichar32), sizeof(seunichar32));
+    if (in->u32_needle_len && (in->pick & 1))
+        needle32[in->u32_needle_len - 1] ^= 0x5A5A;
+    in->u32_needle = needle32;
+
+    /* Character positions */
+    in->u8_chars = (int) se_ref_safe_utf8_str_char_count_sz(in->safe_u8, in->safe_u8_len);
+    in->u8_offset = (int) (se_diff_random(&state) % (unsigned int) (in->u8_chars + 1));
+    in->u8_pos = (int) (se_ref_safe_utf8_offset_to_pointer(in->safe_u8, in->u8_offset) - in->safe_u8);
+    in->u8_utf16_len = se_ref_safe_utf8_utf16_len(in->safe_u8, (int) in->safe_u8_len);
+
+    in->u16_chars = (int) se_ref_safe_utf16_str_char_count_sz(in->safe_u16, in->safe_u16_len);
+    in->u16_offset = (int) (se_diff_random(&state) % (unsigned int) (in->u16_chars + 1));
+    in->u16_pos = (int) (se_ref_safe_utf16_offset_to_pointer(in->safe_u16, in->u16_offset) - in->safe_u16);
+
+    /* Sets of up to 3 characters from the position on */
+    in->safe_u8_set_len = (int) (se_ref_safe_utf8_offset_to_pointer(in->safe_u8 + in->u8_pos, se_diff_clamp(in->u8_chars - in->u8_offset, in->pick, 3))
+                                 - (in->safe_u8 + in->u8_pos));
+    in->safe_u16_set_len = (int) (se_ref_safe_utf16_offset_to_pointer(in->safe_u16 + in->u16_pos, se_diff_clamp(in->u16_chars - in->u16_offset, in->pick, 3))
+                                  - (in->safe_u16 + in->u16_pos));
+
+    /* Sorted offsets, the byte ones at character boundaries */
+    at = 0;
+    for (i = 0; i < SE_DIFF_OFFSET_COUNT; i++)
+    {
+        at += (ptrdiff_t) (se_diff_random(&state) % (unsigned int) (in->u8_chars - at + 1));
+        in->u8_byte_offsets[i] = (int) (se_ref_safe_utf8_offset_to_pointer(in->safe_u8, (int) at) - in->safe_u8);
+    }
+
+    at = 0;
+    for (i = 0; i < SE_DIFF_OFFSET_COUNT; i++)
+    {
+        at += (ptrdiff_t) (se_diff_random(&state) % (unsigned int) (in->u8_utf16_len - at + 1));
+        in->u8_utf16_offsets[i] = (int) at;
+    }
+}
+
+static void se_diff_set_raw_input(se_diff_input* in, const unsigned char* data, size_t size)
+/*
+ * Use the same bytes as UTF-8, as UTF-16 and, with the code points
+ * brought near the Unicode range, as UTF-32.
+ */
+{
+    seunichar32* u32;
+    size_t count;
+    size_t i;
+
+    count = size / sizeof(seunichar32);
+    u32 = SE_MALLOC(count * sizeof(seunichar32) + 1);
+    if (count)
+        memcpy(u32, data, count * sizeof(seunichar32));
+    for (i = 0; i < count; i++)
+        u32[i] &= 0x1FFFFF;
+
+    in->pick = 0x9E3779B9u;
+    for (i = 0; i < size; i++)
+        in->pick = (in->pick ^ data[i]) * 16777619u;
+
+    se_diff_set_input(in, data, (ptrdiff_t) size, data, (ptrdiff_t) (size / sizeof(seunichar16)), u32, (ptrdiff_t) count);
+
+    SE_FREE(u32);
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Checked functions.                                                      *
+ *                                                                         *
+ * Each check calls one or a few functions in the library or in the        *
+ * reference build, and keeps what they return in a se_diff_result.        *
+ *                                                                         *
+ ***************************************************************************/
+
+#define SE_DIFF_VALUE_COUNT     8
+
+typedef struct se_diff_result se_diff_result;
+
+struct se_diff_result
+{
+    /* Return values, lengths and offsets */
+    ptrdiff_t values[SE_DIFF_VALUE_COUNT];
+
+    /* Output string, freed by the caller */
+    void* data;
+    ptrdiff_t size;
+};
+
+#define SE_DIFF_U8      1       /* Input is u8 */
+#define SE_DIFF_U16     2       /* Input is u16 */
+#define SE_DIFF_U32     4       /* Input is u32 */
+#define SE_DIFF_SAFE    8       /* Input is the repaired string */
+
+typedef struct se_diff_check se_diff_check;
+
+struct se_diff_check
+{
+    const char* name;
+    int flags;
+    void (*run)(const se_diff_input* in, int ref, se_diff_result* result);
+};
+
+/* Offset of a found pointer, -1 for NULL */
+#define SE_DIFF_OFFSET(found, str)  ((found) ? (ptrdiff_t) ((found) - (str)) : -1)
+
+/* Only the sign of a comparison is specified */
+#define SE_DIFF_SIGN(x)             (((x) > 0) - ((x) < 0))
+
+static void c_is_valid_utf8(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, is_valid_utf8_str_sz, (in->u8, in->u8_len));
+    r->values[1] = SE_DIFF_CALL(ref, is_valid_utf8_str_sz, (in->u8, -1));
+}
+
+static void c_is_valid_utf16(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, is_valid_utf16_str_sz, (in->u16, in->u16_len));
+    r->values[1] = SE_DIFF_CALL(ref, is_valid_utf16_str_sz, (in->u16, -1));
+}
+
+static void c_is_valid_utf32(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, is_valid_utf32_str_sz, (in->u32, in->u32_len));
+    r->values[1] = SE_DIFF_CALL(ref, is_valid_utf32_str_sz, (in->u32, -1));
+}
+
+static void c_is_ascii(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, is_ascii_str_sz, (in->u8, in->u8_len));
+    r->values[1] = SE_DIFF_CALL(ref, is_ascii_str_sz, (in->u8, -1));
+}
+
+static void c_is_ascii_utf16(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, is_ascii_utf16_str_sz, (in->u16, in->u16_len));
+    r->values[1] = SE_DIFF_CALL(ref, is_ascii_utf16_str_sz, (in->u16, -1));
+}
+
+/* Also over the repaired string, which is more often accepted */
+static void c_is_latin1_utf8(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, is_latin1_utf8_str_sz, (in->u8, in->u8_len));
+    r->values[1] = SE_DIFF_CALL(ref, is_latin1_utf8_str_sz, (in->safe_u8, in->safe_u8_len));
+}
+
+static void c_is_latin1_utf16(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, is_latin1_utf16_str_sz, (in->u16, in->u16_len));
+    r->values[1] = SE_DIFF_CALL(ref, is_latin1_utf16_str_sz, (in->safe_u16, in->safe_u16_len));
+}
+
+/* The output is compared with its NUL terminator */
+#define SE_DIFF_CONVERT(name, func, str, out_type) \
+    static void name(const se_diff_input* in, int ref, se_diff_result* r) \
+    { \
+        ptrdiff_t out_len; \
+        out_len = -1; \
+        r->data = SE_DIFF_CALL(ref, func, (in->str, in->str##_len, &out_len)); \
+        r->values[0] = out_len; \
+        r->size = r->data ? (out_len + 1) * (ptrdiff_t) sizeof(out_type) : 0; \
+    }
+
+SE_DIFF_CONVERT(c_unsafe_utf8_safe_copy, unsafe_utf8_str_safe_copy_sz, u8, seunichar8)
+SE_DIFF_CONVERT(c_unsafe_utf16_safe_copy, unsafe_utf16_str_safe_copy_sz, u16, seunichar16)
+SE_DIFF_CONVERT(c_unsafe_utf32_safe_copy, unsafe_utf32_str_safe_copy_sz, u32, seunichar32)
+SE_DIFF_CONVERT(c_unsafe_utf8_to_utf16, unsafe_utf8_to_safe_utf16_sz, u8, seunichar16)
+SE_DIFF_CONVERT(c_unsafe_utf16_to_utf8, unsafe_utf16_to_safe_utf8_sz, u16, seunichar8)
+SE_DIFF_CONVERT(c_unsafe_utf8_to_utf32, unsafe_utf8_to_safe_utf32_sz, u8, seunichar32)
+SE_DIFF_CONVERT(c_unsafe_utf32_to_utf8, unsafe_utf32_to_safe_utf8_sz, u32, seunichar8)
+SE_DIFF_CONVERT(c_unsafe_utf16_to_utf32, unsafe_utf16_to_safe_utf32_sz, u16, seunichar32)
+SE_DIFF_CONVERT(c_unsafe_utf32_to_utf16, unsafe_utf32_to_safe_utf16_sz, u32, seunichar16)
+SE_DIFF_CONVERT(c_safe_utf8_to_utf16, safe_utf8_to_utf16_sz, safe_u8, seunichar16)
+SE_DIFF_CONVERT(c_safe_utf16_to_utf8, safe_utf16_to_utf8_sz, safe_u16, seunichar8)
+SE_DIFF_CONVERT(c_safe_utf8_to_utf32, safe_utf8_to_utf32_sz, safe_u8, seunichar32)
+SE_DIFF_CONVERT(c_safe_utf32_to_utf8, safe_utf32_to_utf8_sz, safe_u32, seunichar8)
+SE_DIFF_CONVERT(c_safe_utf16_to_utf32, safe_utf16_to_utf32_sz, safe_u16, seunichar32)
+SE_DIFF_CONVERT(c_safe_utf32_to_utf16, safe_utf32_to_utf16_sz, safe_u32, seunichar16)
+
+/* Every error policy, with the offset of the first ill-formed code unit */
+#define SE_DIFF_CONVERT_EX(name, func, str, out_type, policy) \
+    static void name(const se_diff_input* in, int ref, se_diff_result* r) \
+    { \
+        ptrdiff_t out_len; \
+        ptrdiff_t error_offset; \
+        out_len = -1; \
+        error_offset = -2; \
+        r->data = SE_DIFF_CALL(ref, func, (in->str, in->str##_len, policy, &out_len, &error_offset)); \
+        r->values[0] = out_len; \
+        r->values[1] = error_offset; \
+        r->size = r->data ? (out_len + 1) * (ptrdiff_t) sizeof(out_type) : 0; \
+    }
+
+SE_DIFF_CONVERT_EX(c_utf8_safe_copy_replace, unsafe_utf8_str_safe_copy_ex_sz, u8, seunichar8, SE_ERROR_REPLACE)
+SE_DIFF_CONVERT_EX(c_utf8_safe_copy_maximal, unsafe_utf8_str_safe_copy_ex_sz, u8, seunichar8, SE_ERROR_MAXIMAL)
+SE_DIFF_CONVERT_EX(c_utf8_safe_copy_skip, unsafe_utf8_str_safe_copy_ex_sz, u8, seunichar8, SE_ERROR_SKIP)
+SE_DIFF_CONVERT_EX(c_utf8_safe_copy_strict, unsafe_utf8_str_safe_copy_ex_sz, u8, seunichar8, SE_ERROR_STRICT)
+
+SE_DIFF_CONVERT_EX(c_utf16_safe_copy_replace, unsafe_utf16_str_safe_copy_ex_sz, u16, seunichar16, SE_ERROR_REPLACE)
+SE_DIFF_CONVERT_EX(c_utf16_safe_copy_maximal, unsafe_utf16_str_safe_copy_ex_sz, u16, seunichar16, SE_ERROR_MAXIMAL)
+SE_DIFF_CONVERT_EX(c_utf16_safe_copy_skip, unsafe_utf16_str_safe_copy_ex_sz, u16, seunichar16, SE_ERROR_SKIP)
+SE_DIFF_CONVERT_EX(c_utf16_safe_copy_strict, unsafe_utf16_str_safe_copy_ex_sz, u16, seunichar16, SE_ERROR_STRICT)
+
+SE_DIFF_CONVERT_EX(c_utf32_safe_copy_replace, unsafe_utf32_str_safe_copy_ex_sz, u32, seunichar32, SE_ERROR_REPLACE)
+SE_DIFF_CONVERT_EX(c_utf32_safe_copy_maximal, unsafe_utf32_str_safe_copy_ex_sz, u32, seunichar32, SE_ERROR_MAXIMAL)
+SE_DIFF_CONVERT_EX(c_utf32_safe_copy_skip, unsafe_utf32_str_safe_copy_ex_sz, u32, seunichar32, SE_ERROR_SKIP)
+SE_DIFF_CONVERT_EX(c_utf32_safe_copy_strict, unsafe_utf32_str_safe_copy_ex_sz, u32, seunichar32, SE_ERROR_STRICT)
+
+SE_DIFF_CONVERT_EX(c_utf8_to_utf16_replace, unsafe_utf8_to_safe_utf16_ex_sz, u8, seunichar16, SE_ERROR_REPLACE)
+SE_DIFF_CONVERT_EX(c_utf8_to_utf16_maximal, unsafe_utf8_to_safe_utf16_ex_sz, u8, seunichar16, SE_ERROR_MAXIMAL)
+SE_DIFF_CONVERT_EX(c_utf8_to_utf16_skip, unsafe_utf8_to_safe_utf16_ex_sz, u8, seunichar16, SE_ERROR_SKIP)
+SE_DIFF_CONVERT_EX(c_utf8_to_utf16_strict, unsafe_utf8_to_safe_utf16_ex_sz, u8, seunichar16, SE_ERROR_STRICT)
+
+SE_DIFF_CONVERT_EX(c_utf16_to_utf8_replace, unsafe_utf16_to_safe_utf8_ex_sz, u16, seunichar8, SE_ERROR_REPLACE)
+SE_DIFF_CONVERT_EX(c_utf16_to_utf8_maximal, unsafe_utf16_to_safe_utf8_ex_sz, u16, seunichar8, SE_ERROR_MAXIMAL)
+SE_DIFF_CONVERT_EX(c_utf16_to_utf8_skip, unsafe_utf16_to_safe_utf8_ex_sz, u16, seunichar8, SE_ERROR_SKIP)
+SE_DIFF_CONVERT_EX(c_utf16_to_utf8_strict, unsafe_utf16_to_safe_utf8_ex_sz, u16, seunichar8, SE_ERROR_STRICT)
+
+SE_DIFF_CONVERT_EX(c_utf8_to_utf32_replace, unsafe_utf8_to_safe_utf32_ex_sz, u8, seunichar32, SE_ERROR_REPLACE)
+SE_DIFF_CONVERT_EX(c_utf8_to_utf32_maximal, unsafe_utf8_to_safe_utf32_ex_sz, u8, seunichar32, SE_ERROR_MAXIMAL)
+SE_DIFF_CONVERT_EX(c_utf8_to_utf32_skip, unsafe_utf8_to_safe_utf32_ex_sz, u8, seunichar32, SE_ERROR_SKIP)
+SE_DIFF_CONVERT_EX(c_utf8_to_utf32_strict, unsafe_utf8_to_safe_utf32_ex_sz, u8, seunichar32, SE_ERROR_STRICT)
+
+SE_DIFF_CONVERT_EX(c_utf32_to_utf8_replace, unsafe_utf32_to_safe_utf8_ex_sz, u32, seunichar8, SE_ERROR_REPLACE)
+SE_DIFF_CONVERT_EX(c_utf32_to_utf8_maximal, unsafe_utf32_to_safe_utf8_ex_sz, u32, seunichar8, SE_ERROR_MAXIMAL)
+SE_DIFF_CONVERT_EX(c_utf32_to_utf8_skip, unsafe_utf32_to_safe_utf8_ex_sz, u32, seunichar8, SE_ERROR_SKIP)
+SE_DIFF_CONVERT_EX(c_utf32_to_utf8_strict, unsafe_utf32_to_safe_utf8_ex_sz, u32, seunichar8, SE_ERROR_STRICT)
+
+SE_DIFF_CONVERT_EX(c_utf16_to_utf32_replace, unsafe_utf16_to_safe_utf32_ex_sz, u16, seunichar32, SE_ERROR_REPLACE)
+SE_DIFF_CONVERT_EX(c_utf16_to_utf32_maximal, unsafe_utf16_to_safe_utf32_ex_sz, u16, seunichar32, SE_ERROR_MAXIMAL)
+SE_DIFF_CONVERT_EX(c_utf16_to_utf32_skip, unsafe_utf16_to_safe_utf32_ex_sz, u16, seunichar32, SE_ERROR_SKIP)
+SE_DIFF_CONVERT_EX(c_utf16_to_utf32_strict, unsafe_utf16_to_safe_utf32_ex_sz, u16, seunichar32, SE_ERROR_STRICT)
+
+SE_DIFF_CONVERT_EX(c_utf32_to_utf16_replace, unsafe_utf32_to_safe_utf16_ex_sz, u32, seunichar16, SE_ERROR_REPLACE)
+SE_DIFF_CONVERT_EX(c_utf32_to_utf16_maximal, unsafe_utf32_to_safe_utf16_ex_sz, u32, seunichar16, SE_ERROR_MAXIMAL)
+SE_DIFF_CONVERT_EX(c_utf32_to_utf16_skip, unsafe_utf32_to_safe_utf16_ex_sz, u32, seunichar16, SE_ERROR_SKIP)
+SE_DIFF_CONVERT_EX(c_utf32_to_utf16_strict, unsafe_utf32_to_safe_utf16_ex_sz, u32, seunichar16, SE_ERROR_STRICT)
+
+/* Any byte string is Latin-1, so u8 is converted as is */
+SE_DIFF_CONVERT(c_latin1_to_utf8, latin1_to_utf8_sz, u8, seunichar8)
+SE_DIFF_CONVERT(c_latin1_to_utf16, latin1_to_utf16_sz, u8, seunichar16)
+SE_DIFF_CONVERT(c_safe_utf8_to_latin1, safe_utf8_to_latin1_sz, safe_u8, char)
+SE_DIFF_CONVERT(c_safe_utf16_to_latin1, safe_utf16_to_latin1_sz, safe_u16, char)
+
+/* The buffer gets the documented worst case size, and nothing more */
+#define SE_DIFF_INTO(name, func, str, out_type, worst) \
+    static void name(const se_diff_input* in, int ref, se_diff_result* r) \
+    { \
+        out_type* buf; \
+        buf = se_diff_place(&se_diff_outputs[ref], 0, (size_t) (in->str##_len * (worst)) * sizeof(out_type), 0); \
+        r->values[0] = SE_DIFF_CALL(ref, func, (in->str, in->str##_len, buf)); \
+        r->data = SE_MALLOC((size_t) r->values[0] * sizeof(out_type) + 1); \
+        memcpy(r->data, buf, (size_t) r->values[0] * sizeof(out_type)); \
+        r->size = r->values[0] * (ptrdiff_t) sizeof(out_type); \
+    }
+
+static se_diff_buffer se_diff_outputs[2];
+
+SE_DIFF_INTO(c_unsafe_utf8_safe_copy_into, unsafe_utf8_str_safe_copy_into, u8, seunichar8, 3)
+SE_DIFF_INTO(c_unsafe_utf8_to_utf16_into, unsafe_utf8_to_safe_utf16_into, u8, seunichar16, 1)
+SE_DIFF_INTO(c_unsafe_utf16_to_utf8_into, unsafe_utf16_to_safe_utf8_into, u16, seunichar8, 3)
+SE_DIFF_INTO(c_latin1_to_utf8_into, latin1_to_utf8_into, u8, seunichar8, 2)
+SE_DIFF_INTO(c_latin1_to_utf16_into, latin1_to_utf16_into, u8, seunichar16, 1)
+SE_DIFF_INTO(c_safe_utf8_to_latin1_into, safe_utf8_to_latin1_into, safe_u8, char, 1)
+SE_DIFF_INTO(c_safe_utf16_to_latin1_into, safe_utf16_to_latin1_into, safe_u16, char, 1)
+
+static void c_unsafe_utf8_to_utf16_batch(const se_diff_input* in, int ref, se_diff_result* r)
+/*
+ * Three pieces of u8 split at random points, which can fall within
+ * characters. The last piece is passed NUL terminated every other time.
+ */
+{
+    const seunichar8* strs[3];
+    int lens[3];
+    int offsets[4];
+    int split1;
+    int split2;
+    int out_len;
+    int i;
+
+    split1 = (int) (in->pick % (unsigned int) (in->u8_len + 1));
+    split2 = split1 + (int) ((in->pick >> 8) % (unsigned int) (in->u8_len - split1 + 1));
+
+    strs[0] = in->u8;
+    lens[0] = split1;
+    strs[1] = in->u8 + split1;
+    lens[1] = split2 - split1;
+    strs[2] = in->u8 + split2;
+    lens[2] = (in->pick >> 16) & 1 ? -1 : (int) in->u8_len - split2;
+
+    out_len = -1;
+    r->data = SE_DIFF_CALL(ref, unsafe_utf8_to_safe_utf16_batch, (strs, lens, 3, offsets, &out_len));
+    r->values[0] = out_len;
+    for (i = 0; i < 4; i++)
+        r->values[1 + i] = offsets[i];
+    r->size = r->data ? (out_len + 1) * (ptrdiff_t) sizeof(seunichar16) : 0;
+}
+
+static void c_utf8_char_count(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, safe_utf8_str_char_count_sz, (in->safe_u8, in->safe_u8_len));
+    r->values[1] = SE_DIFF_CALL(ref, safe_utf8_str_char_count_sz, (in->safe_u8, -1));
+}
+
+static void c_utf16_char_count(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, safe_utf16_str_char_count_sz, (in->safe_u16, in->safe_u16_len));
+    r->values[1] = SE_DIFF_CALL(ref, safe_utf16_str_char_count_sz, (in->safe_u16, -1));
+}
+
+static void c_utf32_char_count(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, safe_utf32_str_char_count_sz, (in->safe_u32, in->safe_u32_len));
+    r->values[1] = SE_DIFF_CALL(ref, safe_utf32_str_char_count_sz, (in->safe_u32, -1));
+}
+
+static void c_utf8_utf16_len(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, safe_utf8_utf16_len, (in->safe_u8, (int) in->safe_u8_len));
+    r->values[1] = SE_DIFF_CALL(ref, safe_utf8_utf16_len, (in->safe_u8, in->u8_pos));
+}
+
+static void c_utf16_utf8_len(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, safe_utf16_utf8_len, (in->safe_u16, (int) in->safe_u16_len));
+    r->values[1] = SE_DIFF_CALL(ref, safe_utf16_utf8_len, (in->safe_u16, in->u16_pos));
+}
+
+static void c_utf8_offsets(const se_diff_input* in, int ref, se_diff_result* r)
+/*
+ * Step forwards from the start and backwards from the end to the same
+ * character, and back to offsets from both ends.
+ */
+{
+    const seunichar8* start;
+    const seunichar8* end;
+    const seunichar8* pos;
+
+    start = in->safe_u8;
+    end = in->safe_u8 + in->safe_u8_len;
+    pos = start + in->u8_pos;
+
+    r->values[0] = SE_DIFF_CALL(ref, safe_utf8_offset_to_pointer, (start, in->u8_offset)) - start;
+    r->values[1] = SE_DIFF_CALL(ref, safe_utf8_offset_to_pointer, (end, in->u8_offset - in->u8_chars)) - start;
+    r->values[2] = SE_DIFF_CALL(ref, safe_utf8_pointer_to_offset, (start, pos));
+    r->values[3] = SE_DIFF_CALL(ref, safe_utf8_pointer_to_offset, (end, pos));
+}
+
+static void c_utf16_offsets(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    const seunichar16* start;
+    const seunichar16* end;
+    const seunichar16* pos;
+
+    start = in->safe_u16;
+    end = in->safe_u16 + in->safe_u16_len;
+    pos = start + in->u16_pos;
+
+    r->values[0] = SE_DIFF_CALL(ref, safe_utf16_offset_to_pointer, (start, in->u16_offset)) - start;
+    r->values[1] = SE_DIFF_CALL(ref, safe_utf16_pointer_to_offset, (start, pos));
+    r->values[2] = SE_DIFF_CALL(ref, safe_utf16_pointer_to_offset, (end, pos));
+}
+
+static void c_utf8_index(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    se_utf8_index* index;
+    int interval;
+
+    interval = (int) (in->pick % 100);
+
+    index = SE_DIFF_CALL(ref, utf8_index_new, (in->safe_u8, (int) in->safe_u8_len, interval));
+    r->values[0] = SE_DIFF_CALL(ref, utf8_index_char_count, (index));
+    r->values[1] = SE_DIFF_CALL(ref, utf8_index_offset_to_pointer, (index, in->u8_offset)) - in->safe_u8;
+    r->values[2] = SE_DIFF_CALL(ref, utf8_index_pointer_to_offset, (index, in->safe_u8 + in->u8_pos));
+    SE_DIFF_CALL(ref, utf8_index_free, (index));
+}
+
+static void c_ustr(const se_diff_input* in, int ref, se_diff_result* r)
+/*
+ * A string made from u8 and a slice of a slice of it, cut at the sorted
+ * byte offsets. The string and the first slice are released before the
+ * inner slice is read, so a string freed too early or twice shows up
+ * under AddressSanitizer. The reference computes the same values from
+ * the bytes of u8 repaired by the reference build. Hashes are only comparable without NULs, as
+ * se_utf8_str_hash() stops at the first one.
+ */
+{
+    const int* offsets;
+    const seunichar8* bytes;
+    seunichar8* safe;
+    ptrdiff_t safe_len;
+    ptrdiff_t len;
+    se_ustr* s;
+    se_ustr* slice;
+    se_ustr* inner;
+
+    offsets = in->u8_byte_offsets;
+
+    if (ref)
+    {
+        safe = se_ref_unsafe_utf8_str_safe_copy_sz(in->u8, in->u8_len, &safe_len);
+        r->values[0] = memchr(safe, 0, (size_t) safe_len) ? -1 : (ptrdiff_t) se_ref_utf8_str_hash(safe);
+        r->values[1] = se_ref_safe_utf8_str_char_count_sz(safe, safe_len);
+        r->values[2] = se_ref_is_ascii_str_sz(safe, safe_len);
+
+        len = offsets[2] - offsets[1];
+        bytes = se_diff_place(&se_diff_outputs[1], safe + offsets[1], (size_t) len, sizeof(seunichar8));
+        SE_FREE(safe);
+
+        r->values[3] = memchr(bytes, 0, (size_t) len) ? -1 : (ptrdiff_t) se_ref_utf8_str_hash(bytes);
+        r->values[4] = se_ref_safe_utf8_str_char_count_sz(bytes, len);
+        r->values[5] = se_ref_is_ascii_str_sz(bytes, len);
+        r->values[6] = se_ref_is_valid_utf8_str_sz(bytes, len);
+        r->values[7] = len;
+    }
+    else
+    {
+        s = se_ustr_new_sz(in->u8, in->u8_len);
+        r->values[0] = memchr(se_ustr_str(s), 0, (size_t) se_ustr_len_sz(s)) ? -1 : (ptrdiff_t) se_ustr_hash(s);
+        r->values[1] = se_ustr_char_count_sz(s);
+        r->values[2] = se_ustr_is_ascii(s);
+
+        slice = se_ustr_slice_sz(s, offsets[0], offsets[3]);
+        se_ustr_unref(s);
+        inner = se_ustr_slice_sz(slice, offsets[1] - offsets[0], offsets[2] - offsets[0]);
+        se_ustr_unref(slice);
+
+        len = se_ustr_len_sz(inner);
+        bytes = se_ustr_str(inner);
+
+        r->values[3] = memchr(bytes, 0, (size_t) len) ? -1 : (ptrdiff_t) se_ustr_hash(inner);
+        r->values[4] = se_ustr_char_count_sz(inner);
+        r->values[5] = se_ustr_is_ascii(inner);
+        r->values[6] = se_is_valid_utf8_str_sz(bytes, len);
+        r->values[7] = len;
+    }
+
+    r->data = SE_MALLOC((size_t) len + 1);
+    memcpy(r->data, bytes, (size_t) len);
+    r->size = len;
+
+    if (!ref)
+        se_ustr_unref(inner);
+}
+
+static void c_utf8_utf16_offsets(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    int offsets[SE_DIFF_OFFSET_COUNT];
+    int i;
+
+    SE_DIFF_CALL(ref, safe_utf8_byte_offsets_to_utf16_offsets, (in->safe_u8, (int) in->safe_u8_len, in->u8_byte_offsets, offsets, SE_DIFF_OFFSET_COUNT));
+    for (i = 0; i < SE_DIFF_OFFSET_COUNT; i++)
+        r->values[i] = offsets[i];
+
+    SE_DIFF_CALL(ref, safe_utf8_utf16_offsets_to_byte_offsets, (in->safe_u8, (int) in->safe_u8_len, in->u8_utf16_offsets, offsets, SE_DIFF_OFFSET_COUNT));
+    for (i = 0; i < SE_DIFF_OFFSET_COUNT; i++)
+        r->values[SE_DIFF_OFFSET_COUNT + i] = offsets[i];
+}
+
+static void c_utf8_utf16_offset(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_CALL(ref, safe_utf8_utf16_offset_to_byte_offset, (in->safe_u8, (int) in->safe_u8_len, in->u8_utf16_offsets[0]));
+    r->values[1] = SE_DIFF_CALL(ref, safe_utf8_utf16_offset_to_byte_offset, (in->safe_u8, (int) in->safe_u8_len, in->u8_utf16_len));
+}
+
+static void c_utf16_strcmp(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_SIGN(SE_DIFF_CALL(ref, utf16_strcmp, (in->safe_u16, in->other_u16)));
+    r->values[1] = SE_DIFF_SIGN(SE_DIFF_CALL(ref, utf16_strcmp, (in->safe_u16, in->safe_u16)));
+}
+
+static void c_utf16_strcmp_code_point_order(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_SIGN(SE_DIFF_CALL(ref, utf16_strcmp_code_point_order, (in->safe_u16, in->other_u16)));
+    r->values[1] = SE_DIFF_SIGN(SE_DIFF_CALL(ref, utf16_strcmp_code_point_order, (in->other_u16, in->safe_u16)));
+}
+
+static void c_utf8_find_char(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    seunichar8 c;
+
+    c = in->u8_needle_len ? in->u8_needle[0] : 'a';
+    r->values[0] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, utf8_str_find_char, (in->u8, (int) in->u8_len, c)), in->u8);
+    r->values[1] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, utf8_str_find_char, (in->u8, (int) in->u8_len, '\x80')), in->u8);
+}
+
+static void c_utf16_find_char(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    seunichar16 c;
+
+    c = in->u16_needle_len ? in->u16_needle[0] : 'a';
+    r->values[0] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, utf16_str_find_char, (in->u16, (int) in->u16_len, c)), in->u16);
+    r->values[1] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, utf16_str_find_char, (in->u16, (int) in->u16_len, 0xDC00)), in->u16);
+}
+
+static void c_utf32_find_char(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    seunichar32 c;
+
+    c = in->u32_needle_len ? in->u32_needle[0] : 'a';
+    r->values[0] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, utf32_str_find_char, (in->u32, (int) in->u32_len, c)), in->u32);
+}
+
+static void c_utf8_find_unichar(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    seunichar c;
+
+    c = in->u8_offset < in->u8_chars ? se_ref_safe_utf8_get_char(in->safe_u8 + in->u8_pos) : 0x10400;
+    r->values[0] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, safe_utf8_str_find_unichar, (in->safe_u8, (int) in->safe_u8_len, c)), in->safe_u8);
+}
+
+static void c_utf16_find_unichar(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    seunichar c;
+
+    c = in->u8_offset < in->u8_chars ? se_ref_safe_utf8_get_char(in->safe_u8 + in->u8_pos) : 0x10400;
+    r->values[0] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, safe_utf16_str_find_unichar, (in->safe_u16, (int) in->safe_u16_len, c)), in->safe_u16);
+}
+
+static void c_utf8_find_str(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, utf8_str_find_str, (in->u8, (int) in->u8_len, in->u8_needle, in->u8_needle_len)), in->u8);
+}
+
+static void c_utf16_find_str(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, utf16_str_find_str, (in->u16, (int) in->u16_len, in->u16_needle, in->u16_needle_len)), in->u16);
+}
+
+static void c_utf32_find_str(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, utf32_str_find_str, (in->u32, (int) in->u32_len, in->u32_needle, in->u32_needle_len)), in->u32);
+}
+
+static void c_utf8_find_any(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, safe_utf8_str_find_any, (in->safe_u8, (int) in->safe_u8_len,
+                                                                            in->safe_u8 + in->u8_pos, in->safe_u8_set_len)), in->safe_u8);
+}
+
+static void c_utf16_find_any(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, safe_utf16_str_find_any, (in->safe_u16, (int) in->safe_u16_len,
+                                                                             in->safe_u16 + in->u16_pos, in->safe_u16_set_len)), in->safe_u16);
+}
+
+static void c_utf32_find_any(const se_diff_input* in, int ref, se_diff_result* r)
+{
+    r->values[0] = SE_DIFF_OFFSET(SE_DIFF_CALL(ref, utf32_str_find_any, (in->u32, (int) in->u32_len, in->u32_needle, in->u32_needle_len)), in->u32);
+}
+
+/* The byte order conversions take u16 and u32 as bytes */
+static ptrdiff_t se_diff_endian_len(const se_diff_input* in, ptrdiff_t len, int unit)
+/*
+ * The byte length of len code units of unit bytes, cut within the last
+ * code unit for every other input.
+ */
+{
+    if (len && ((in->pick >> 12) & 1))
+        return len * unit - 1 - (ptrdiff_t) ((in->pick >> 13) % (unsigned int) (unit - 1));
+
+    return len * unit;
+}
+
+#define SE_DIFF_IS_VALID_ENDIAN(name, func, str, unit) \
+    static void name(const se_diff_input* in, int ref, se_diff_result* r) \
+    { \
+        r->values[0] = SE_DIFF_CALL(ref, func, ((const char*) in->str, in->str##_len * (unit))); \
+        r->values[1] = SE_DIFF_CALL(ref, func, ((const char*) in->str, -1)); \
+        r->values[2] = SE_DIFF_CALL(ref, func, ((const char*) in->str, se_diff_endian_len(in, in->str##_len, unit))); \
+    }
+
+#define SE_DIFF_FROM_ENDIAN(name, func, str, unit, out_type) \
+    static void name(const se_diff_input* in, int ref, se_diff_result* r) \
+    { \
+        ptrdiff_t out_len; \
+        out_len = -1; \
+        r->data = SE_DIFF_CALL(ref, func, ((const char*) in->str, se_diff_endian_len(in, in->str##_len, unit), &out_len)); \
+        r->values[0] = out_len; \
+        r->size = r->data ? (out_len + 1) * (ptrdiff_t) sizeof(out_type) : 0; \
+    }
+
+/* The output length is in bytes, the NUL code unit is compared too */
+#define SE_DIFF_TO_ENDIAN(name, func, str, unit) \
+    static void name(const se_diff_input* in, int ref, se_diff_result* r) \
+    { \
+        ptrdiff_t out_len; \
+        out_len = -1; \
+        r->data = SE_DIFF_CALL(ref, func, (in->str, in->str##_len, &out_len)); \
+        r->values[0] = out_len; \
+        r->size = r->data ? out_len + (unit) : 0; \
+    }
+
+SE_DIFF_IS_VALID_ENDIAN(c_is_valid_utf16be, is_valid_utf16be_str_sz, u16, 2)
+SE_DIFF_IS_VALID_ENDIAN(c_is_valid_utf16le, is_valid_utf16le_str_sz, u16, 2)
+SE_DIFF_IS_VALID_ENDIAN(c_is_valid_utf32be, is_valid_utf32be_str_sz, u32, 4)
+SE_DIFF_IS_VALID_ENDIAN(c_is_valid_utf32le, is_valid_utf32le_str_sz, u32, 4)
+
+SE_DIFF_FROM_ENDIAN(c_unsafe_utf16be_to_utf8, unsafe_utf16be_to_safe_utf8_sz, u16, 2, seunichar8)
+SE_DIFF_FROM_ENDIAN(c_unsafe_utf16be_to_utf16, unsafe_utf16be_to_safe_utf16_sz, u16, 2, seunichar16)
+SE_DIFF_FROM_ENDIAN(c_unsafe_utf16be_to_utf32, unsafe_utf16be_to_safe_utf32_sz, u16, 2, seunichar32)
+SE_DIFF_FROM_ENDIAN(c_unsafe_utf16le_to_utf8, unsafe_utf16le_to_safe_utf8_sz, u16, 2, seunichar8)
+SE_DIFF_FROM_ENDIAN(c_unsafe_utf16le_to_utf16, unsafe_utf16le_to_safe_utf16_sz, u16, 2, seunichar16)
+SE_DIFF_FROM_ENDIAN(c_unsafe_utf16le_to_utf32, unsafe_utf16le_to_safe_utf32_sz, u16, 2, seunichar32)
+SE_DIFF_FROM_ENDIAN(c_unsafe_utf32be_to_utf8, unsafe_utf32be_to_safe_utf8_sz, u32, 4, seunichar8)
+SE_DIFF_FROM_ENDIAN(c_unsafe_utf32be_to_utf16, unsafe_utf32be_to_safe_utf16_sz, u32, 4, seunichar16)
+SE_DIFF_FROM_ENDIAN(c_unsafe_utf32be_to_utf32, unsafe_utf32be_to_safe_utf32_sz, u32, 4, seunichar32)
+SE_DIFF_FROM_ENDIAN(c_unsafe_utf32le_to_utf8, unsafe_utf32le_to_safe_utf8_sz, u32, 4, seunichar8)
+SE_DIFF_FROM_ENDIAN(c_unsafe_utf32le_to_utf16, unsafe_utf32le_to_safe_utf16_sz, u32, 4, seunichar16)
+SE_DIFF_FROM_ENDIAN(c_unsafe_utf32le_to_utf32, unsafe_utf32le_to_safe_utf32_sz, u32, 4, seunichar32)
+
+SE_DIFF_TO_ENDIAN(c_safe_utf8_to_utf16be, safe_utf8_to_utf16be_sz, safe_u8, 2)
+SE_DIFF_TO_ENDIAN(c_safe_utf8_to_utf16le, safe_utf8_to_utf16le_sz, safe_u8, 2)
+SE_DIFF_TO_ENDIAN(c_safe_utf8_to_utf32be, safe_utf8_to_utf32be_sz, safe_u8, 4)
+SE_DIFF_TO_ENDIAN(c_safe_utf8_to_utf32le, safe_utf8_to_utf32le_sz, safe_u8, 4)
+SE_DIFF_TO_ENDIAN(c_safe_utf16_to_utf16be, safe_utf16_to_utf16be_sz, safe_u16, 2)
+SE_DIFF_TO_ENDIAN(c_safe_utf16_to_utf16le, safe_utf16_to_utf16le_sz, safe_u16, 2)
+SE_DIFF_TO_ENDIAN(c_safe_utf16_to_utf32be, safe_utf16_to_utf32be_sz, safe_u16, 4)
+SE_DIFF_TO_ENDIAN(c_safe_utf16_to_utf32le, safe_utf16_to_utf32le_sz, safe_u16, 4)
+SE_DIFF_TO_ENDIAN(c_safe_utf32_to_utf16be, safe_utf32_to_utf16be_sz, safe_u32, 2)
+SE_DIFF_TO_ENDIAN(c_safe_utf32_to_utf16le, safe_utf32_to_utf16le_sz, safe_u32, 2)
+SE_DIFF_TO_ENDIAN(c_safe_utf32_to_utf32be, safe_utf32_to_utf32be_sz, safe_u32, 4)
+SE_DIFF_TO_ENDIAN(c_safe_utf32_to_utf32le, safe_utf32_to_utf32le_sz, safe_u32, 4)
+
+/*
+ * The legacy decoders take the text encoded by the reference build, or u8
+ * as is for every other input, which is mostly ill-formed.
+ */
+#define SE_DIFF_FROM_MBCS(name, func, encoding, out_type) \
+    static void name(const se_diff_input* in, int ref, se_diff_result* r) \
+    { \
+        ptrdiff_t out_len; \
+        out_len = -1; \
+        if ((in->pick >> 14) & 1) \
+            r->data = SE_DIFF_CALL(ref, func, (in->u8, in->u8_len, &out_len)); \
+        else \
+            r->data = SE_DIFF_CALL(ref, func, (in->mbcs[encoding], in->mbcs_len[encoding], &out_len)); \
+        r->values[0] = out_len; \
+        r->size = r->data ? (out_len + 1) * (ptrdiff_t) sizeof(out_type) : 0; \
+    }
+
+SE_DIFF_FROM_MBCS(c_unsafe_gb18030_to_utf8, unsafe_gb18030_to_safe_utf8_sz, SE_DIFF_GB18030, seunichar8)
+SE_DIFF_FROM_MBCS(c_unsafe_gb18030_to_utf16, unsafe_gb18030_to_safe_utf16_sz, SE_DIFF_GB18030, seunichar16)
+SE_DIFF_CONVERT(c_safe_utf8_to_gb18030, safe_utf8_to_gb18030_sz, safe_u8, char)
+SE_DIFF_CONVERT(c_safe_utf16_to_gb18030, safe_utf16_to_gb18030_sz, safe_u16, char)
+SE_DIFF_FROM_MBCS(c_unsafe_shift_jis_to_utf8, unsafe_shift_jis_to_safe_utf8_sz, SE_DIFF_SHIFT_JIS, seunichar8)
+SE_DIFF_FROM_MBCS(c_unsafe_shift_jis_to_utf16, unsafe_shift_jis_to_safe_utf16_sz, SE_DIFF_SHIFT_JIS, seunichar16)
+SE_DIFF_CONVERT(c_safe_utf8_to_shift_jis, safe_utf8_to_shift_jis_sz, safe_u8, char)
+SE_DIFF_CONVERT(c_safe_utf16_to_shift_jis, safe_utf16_to_shift_jis_sz, safe_u16, char)
+SE_DIFF_FROM_MBCS(c_unsafe_euc_kr_to_utf8, unsafe_euc_kr_to_safe_utf8_sz, SE_DIFF_EUC_KR, seunichar8)
+SE_DIFF_FROM_MBCS(c_unsafe_euc_kr_to_utf16, unsafe_euc_kr_to_safe_utf16_sz, SE_DIFF_EUC_KR, seunichar16)
+SE_DIFF_CONVERT(c_safe_utf8_to_euc_kr, safe_utf8_to_euc_kr_sz, safe_u8, char)
+SE_DIFF_CONVERT(c_safe_utf16_to_euc_kr, safe_utf16_to_euc_kr_sz, safe_u16, char)
+SE_DIFF_FROM_MBCS(c_unsafe_big5_to_utf8, unsafe_big5_to_safe_utf8_sz, SE_DIFF_BIG5, seunichar8)
+SE_DIFF_FROM_MBCS(c_unsafe_big5_to_utf16, unsafe_big5_to_safe_utf16_sz, SE_DIFF_BIG5, seunichar16)
+SE_DIFF_CONVERT(c_safe_utf8_to_big5, safe_utf8_to_big5_sz, safe_u8, char)
+SE_DIFF_CONVERT(c_safe_utf16_to_big5, safe_utf16_to_big5_sz, safe_u16, char)
+
+/*
+ * The _stream decoders are fed the same text in chunks of random sizes,
+ * each starting with the bytes the previous call left, and the joined
+ * output must be the one-shot conversion of the reference build. Every
+ * other input is cut into chunks of at most 16 bytes, so most characters
+ * are cut somewhere.
+ */
+#define SE_DIFF_STREAM(name, func, one_shot, encoding, out_type, out_units) \
+    static void name(const se_diff_input* in, int ref, se_diff_result* r) \
+    { \
+        const char* str; \
+        ptrdiff_t len; \
+        ptrdiff_t pos; \
+        ptrdiff_t chunk; \
+        ptrdiff_t in_len; \
+        ptrdiff_t out_len; \
+        out_type* out; \
+        unsigned int state; \
+        unsigned int max_chunk; \
+        if ((in->pick >> 14) & 1) \
+        { \
+            str = (const char*) in->u8; \
+            len = in->u8_len; \
+        } \
+        else \
+        { \
+            str = in->mbcs[encoding]; \
+            len = in->mbcs_len[encoding]; \
+        } \
+        if (ref) \
+        { \
+            out_len = -1; \
+            r->data = se_ref_##one_shot(str, len, &out_len); \
+            r->values[0] = out_len; \
+            r->size = r->data ? (out_len + 1) * (ptrdiff_t) sizeof(out_type) : 0; \
+            return; \
+        } \
+        out = SE_MALLOC(((size_t) len * (out_units) + 1) * sizeof(out_type)); \
+        state = in->pick | 1; \
+        max_chunk = (in->pick >> 15) & 1 ? 16 : 4096; \
+        pos = 0; \
+        out_len = 0; \
+        do \
+        { \
+            chunk = 1 + (ptrdiff_t) (se_diff_random(&state) % max_chunk); \
+            if (chunk > len - pos) \
+                chunk = len - pos; \
+            in_len = -1; \
+            out_len += se_##func(str + pos, chunk, pos + chunk == len, &in_len, out + out_len); \
+            pos += in_len; \
+        } \
+        while (pos < len); \
+        out[out_len] = 0; \
+        r->data = out; \
+        r->values[0] = out_len; \
+        r->size = (out_len + 1) * (ptrdiff_t) sizeof(out_type); \
+    }
+
+SE_DIFF_STREAM(c_unsafe_gb18030_to_utf8_stream, unsafe_gb18030_to_safe_utf8_stream, unsafe_gb18030_to_safe_utf8_sz, SE_DIFF_GB18030, seunichar8, 3)
+SE_DIFF_STREAM(c_unsafe_gb18030_to_utf16_stream, unsafe_gb18030_to_safe_utf16_stream, unsafe_gb18030_to_safe_utf16_sz, SE_DIFF_GB18030, seunichar16, 1)
+SE_DIFF_STREAM(c_unsafe_shift_jis_to_utf8_stream, unsafe_shift_jis_to_safe_utf8_stream, unsafe_shift_jis_to_safe_utf8_sz, SE_DIFF_SHIFT_JIS, seunichar8, 3)
+SE_DIFF_STREAM(c_unsafe_shift_jis_to_utf16_stream, unsafe_shift_jis_to_safe_utf16_stream, unsafe_shift_jis_to_safe_utf16_sz, SE_DIFF_SHIFT_JIS, seunichar16, 1)
+SE_DIFF_STREAM(c_unsafe_euc_kr_to_utf8_stream, unsafe_euc_kr_to_safe_utf8_stream, unsafe_euc_kr_to_safe_utf8_sz, SE_DIFF_EUC_KR, seunichar8, 3)
+SE_DIFF_STREAM(c_unsafe_euc_kr_to_utf16_stream, unsafe_euc_kr_to_safe_utf16_stream, unsafe_euc_kr_to_safe_utf16_sz, SE_DIFF_EUC_KR, seunichar16, 1)
+SE_DIFF_STREAM(c_unsafe_big5_to_utf8_stream, unsafe_big5_to_safe_utf8_stream, unsafe_big5_to_safe_utf8_sz, SE_DIFF_BIG5, seunichar8, 3)
+SE_DIFF_STREAM(c_unsafe_big5_to_utf16_stream, unsafe_big5_to_safe_utf16_stream, unsafe_big5_to_safe_utf16_sz, SE_DIFF_BIG5, seunichar16, 1)
+
+/* Over u8, the text in the variant, and u8 up to its first NUL */
+#define SE_DIFF_IS_VALID_VARIANT(name, func, variant) \
+    static void name(const se_diff_input* in, int ref, se_diff_result* r) \
+    { \
+        r->values[0] = SE_DIFF_CALL(ref, func, (in->u8, in->u8_len)); \
+        r->values[1] = SE_DIFF_CALL(ref, func, (in->variants[variant], in->variants_len[variant])); \
+        r->values[2] = SE_DIFF_CALL(ref, func, (in->u8, -1)); \
+    }
+
+/* As the legacy decoders */
+#define SE_DIFF_FROM_VARIANT(name, func, variant, out_type) \
+    static void name(const se_diff_input* in, int ref, se_diff_result* r) \
+    { \
+        ptrdiff_t out_len; \
+        out_len = -1; \
+        if ((in->pick >> 14) & 1) \
+            r->data = SE_DIFF_CALL(ref, func, (in->u8, in->u8_len, &out_len)); \
+        else \
+            r->data = SE_DIFF_CALL(ref, func, (in->variants[variant], in->variants_len[variant], &out_len)); \
+        r->values[0] = out_len; \
+        r->size = r->data ? (out_len + 1) * (ptrdiff_t) sizeof(out_type) : 0; \
+    }
+
+/*
+ * A string of 16 bit units converted to a variant and back must come out
+ * as it went in, lone surrogates and NUL units included, so the reference
+ * build makes the same round trip, to be timed alike, but its result is
+ * the input itself.
+ */
+#define SE_DIFF_ROUND_TRIP(name, to, from, str) \
+    static void name(const se_diff_input* in, int ref, se_diff_result* r) \
+    { \
+        ptrdiff_t len; \
+        ptrdiff_t out_len; \
+        char* variant; \
+        variant = SE_DIFF_CALL(ref, to, (in->str, in->str##_len, &len)); \
+        out_len = -1; \
+        r->data = SE_DIFF_CALL(ref, from, (variant, len, &out_len)); \
+        SE_FREE(variant); \
+        if (ref) \
+        { \
+            SE_FREE(r->data); \
+            out_len = in->str##_len; \
+            r->data = SE_MALLOC(((size_t) out_len + 1) * sizeof(seunichar16)); \
+            memcpy(r->data, in->str, (size_t) out_len * sizeof(seunichar16)); \
+            ((seunichar16*) r->data)[out_len] = 0; \
+        } \
+        r->values[0] = out_len; \
+        r->size = r->data ? (out_len + 1) * (ptrdiff_t) sizeof(seunichar16) : 0; \
+    }
+
+SE_DIFF_IS_VALID_VARIANT(c_is_valid_wtf8, is_valid_wtf8_str_sz, SE_DIFF_WTF8)
+SE_DIFF_IS_VALID_VARIANT(c_is_valid_cesu8, is_valid_cesu8_str_sz, SE_DIFF_CESU8)
+SE_DIFF_IS_VALID_VARIANT(c_is_valid_mutf8, is_valid_mutf8_str_sz, SE_DIFF_MUTF8)
+
+SE_DIFF_FROM_VARIANT(c_unsafe_wtf8_to_utf16, unsafe_wtf8_to_utf16_sz, SE_DIFF_WTF8, seunichar16)
+SE_DIFF_FROM_VARIANT(c_unsafe_wtf8_to_safe_utf16, unsafe_wtf8_to_safe_utf16_sz, SE_DIFF_WTF8, seunichar16)
+SE_DIFF_FROM_VARIANT(c_unsafe_wtf8_to_safe_utf8, unsafe_wtf8_to_safe_utf8_sz, SE_DIFF_WTF8, seunichar8)
+SE_DIFF_FROM_VARIANT(c_unsafe_cesu8_to_safe_utf8, unsafe_cesu8_to_safe_utf8_sz, SE_DIFF_CESU8, seunichar8)
+SE_DIFF_FROM_VARIANT(c_unsafe_cesu8_to_safe_utf16, unsafe_cesu8_to_safe_utf16_sz, SE_DIFF_CESU8, seunichar16)
+SE_DIFF_FROM_VARIANT(c_unsafe_mutf8_to_utf16, unsafe_mutf8_to_utf16_sz, SE_DIFF_MUTF8, seunichar16)
+SE_DIFF_FROM_VARIANT(c_unsafe_mutf8_to_safe_utf16, unsafe_mutf8_to_safe_utf16_sz, SE_DIFF_MUTF8, seunichar16)
+SE_DIFF_FROM_VARIANT(c_unsafe_mutf8_to_safe_utf8, unsafe_mutf8_to_safe_utf8_sz, SE_DIFF_MUTF8, seunichar8)
+
+SE_DIFF_CONVERT(c_utf16_to_wtf8, utf16_to_wtf8_sz, u16, char)
+SE_DIFF_CONVERT(c_safe_utf8_to_cesu8, safe_utf8_to_cesu8_sz, safe_u8, char)
+SE_DIFF_CONVERT(c_safe_utf16_to_cesu8, safe_utf16_to_cesu8_sz, safe_u16, char)
+SE_DIFF_CONVERT(c_utf16_to_mutf8, utf16_to_mutf8_sz, u16, char)
+SE_DIFF_CONVERT(c_safe_utf8_to_mutf8, safe_utf8_to_mutf8_sz, safe_u8, char)
+
+SE_DIFF_ROUND_TRIP(c_wtf8_round_trip, utf16_to_wtf8_sz, unsafe_wtf8_to_utf16_sz, u16)
+SE_DIFF_ROUND_TRIP(c_cesu8_round_trip, safe_utf16_to_cesu8_sz, unsafe_cesu8_to_safe_utf16_sz, safe_u16)
+SE_DIFF_ROUND_TRIP(c_mutf8_round_trip, utf16_to_mutf8_sz, unsafe_mutf8_to_utf16_sz, u16)
+
+static const se_diff_check se_diff_checks[] =
+{
+    { "se_is_valid_utf8_str", SE_DIFF_U8, c_is_valid_utf8 },
+    { "se_is_valid_utf16_str", SE_DIFF_U16, c_is_valid_utf16 },
+    { "se_is_valid_utf32_str", SE_DIFF_U32, c_is_valid_utf32 },
+    { "se_unsafe_utf8_str_safe_copy", SE_DIFF_U8, c_unsafe_utf8_safe_copy },
+    { "se_unsafe_utf16_str_safe_copy", SE_DIFF_U16, c_unsafe_utf16_safe_copy },
+    { "se_unsafe_utf32_str_safe_copy", SE_DIFF_U32, c_unsafe_utf32_safe_copy },
+    { "se_unsafe_utf8_str_safe_copy_into", SE_DIFF_U8, c_unsafe_utf8_safe_copy_into },
+    { "se_unsafe_utf8_to_safe_utf16", SE_DIFF_U8, c_unsafe_utf8_to_utf16 },
+    { "se_unsafe_utf8_to_safe_utf16_into", SE_DIFF_U8, c_unsafe_utf8_to_utf16_into },
+    { "se_unsafe_utf8_to_safe_utf16_batch", SE_DIFF_U8, c_unsafe_utf8_to_utf16_batch },
+    { "se_unsafe_utf16_to_safe_utf8", SE_DIFF_U16, c_unsafe_utf16_to_utf8 },
+    { "se_unsafe_utf16_to_safe_utf8_into", SE_DIFF_U16, c_unsafe_utf16_to_utf8_into },
+    { "se_unsafe_utf8_to_safe_utf32", SE_DIFF_U8, c_unsafe_utf8_to_utf32 },
+    { "se_unsafe_utf32_to_safe_utf8", SE_DIFF_U32, c_unsafe_utf32_to_utf8 },
+    { "se_unsafe_utf16_to_safe_utf32", SE_DIFF_U16, c_unsafe_utf16_to_utf32 },
+    { "se_unsafe_utf32_to_safe_utf16", SE_DIFF_U32, c_unsafe_utf32_to_utf16 },
+    { "se_unsafe_utf8_str_safe_copy_ex(replace)", SE_DIFF_U8, c_utf8_safe_copy_replace },
+    { "se_unsafe_utf8_str_safe_copy_ex(maximal)", SE_DIFF_U8, c_utf8_safe_copy_maximal },
+    { "se_unsafe_utf8_str_safe_copy_ex(skip)", SE_DIFF_U8, c_utf8_safe_copy_skip },
+    { "se_unsafe_utf8_str_safe_copy_ex(strict)", SE_DIFF_U8, c_utf8_safe_copy_strict },
+    { "se_unsafe_utf16_str_safe_copy_ex(replace)", SE_DIFF_U16, c_utf16_safe_copy_replace },
+    { "se_unsafe_utf16_str_safe_copy_ex(maximal)", SE_DIFF_U16, c_utf16_safe_copy_maximal },
+    { "se_unsafe_utf16_str_safe_copy_ex(skip)", SE_DIFF_U16, c_utf16_safe_copy_skip },
+    { "se_unsafe_utf16_str_safe_copy_ex(strict)", SE_DIFF_U16, c_utf16_safe_copy_strict },
+    { "se_unsafe_utf32_str_safe_copy_ex(replace)", SE_DIFF_U32, c_utf32_safe_copy_replace },
+    { "se_unsafe_utf32_str_safe_copy_ex(maximal)", SE_DIFF_U32, c_utf32_safe_copy_maximal },
+    { "se_unsafe_utf32_str_safe_copy_ex(skip)", SE_DIFF_U32, c_utf32_safe_copy_skip },
+    { "se_unsafe_utf32_str_safe_copy_ex(strict)", SE_DIFF_U32, c_utf32_safe_copy_strict },
+    { "se_unsafe_utf8_to_safe_utf16_ex(replace)", SE_DIFF_U8, c_utf8_to_utf16_replace },
+    { "se_unsafe_utf8_to_safe_utf16_ex(maximal)", SE_DIFF_U8, c_utf8_to_utf16_maximal },
+    { "se_unsafe_utf8_to_safe_utf16_ex(skip)", SE_DIFF_U8, c_utf8_to_utf16_skip },
+    { "se_unsafe_utf8_to_safe_utf16_ex(strict)", SE_DIFF_U8, c_utf8_to_utf16_strict },
+    { "se_unsafe_utf16_to_safe_utf8_ex(replace)", SE_DIFF_U16, c_utf16_to_utf8_replace },
+    { "se_unsafe_utf16_to_safe_utf8_ex(maximal)", SE_DIFF_U16, c_utf16_to_utf8_maximal },
+    { "se_unsafe_utf16_to_safe_utf8_ex(skip)", SE_DIFF_U16, c_utf16_to_utf8_skip },
+    { "se_unsafe_utf16_to_safe_utf8_ex(strict)", SE_DIFF_U16, c_utf16_to_utf8_strict },
+    { "se_unsafe_utf8_to_safe_utf32_ex(replace)", SE_DIFF_U8, c_utf8_to_utf32_replace },
+    { "se_unsafe_utf8_to_safe_utf32_ex(maximal)", SE_DIFF_U8, c_utf8_to_utf32_maximal },
+    { "se_unsafe_utf8_to_safe_utf32_ex(skip)", SE_DIFF_U8, c_utf8_to_utf32_skip },
+    { "se_unsafe_utf8_to_safe_utf32_ex(strict)", SE_DIFF_U8, c_utf8_to_utf32_strict },
+    { "se_unsafe_utf32_to_safe_utf8_ex(replace)", SE_DIFF_U32, c_utf32_to_utf8_replace },
+    { "se_unsafe_utf32_to_safe_utf8_ex(maximal)", SE_DIFF_U32, c_utf32_to_utf8_maximal },
+    { "se_unsafe_utf32_to_safe_utf8_ex(skip)", SE_DIFF_U32, c_utf32_to_utf8_skip },
+    { "se_unsafe_utf32_to_safe_utf8_ex(strict)", SE_DIFF_U32, c_utf32_to_utf8_strict },
+    { "se_unsafe_utf16_to_safe_utf32_ex(replace)", SE_DIFF_U16, c_utf16_to_utf32_replace },
+    { "se_unsafe_utf16_to_safe_utf32_ex(maximal)", SE_DIFF_U16, c_utf16_to_utf32_maximal },
+    { "se_unsafe_utf16_to_safe_utf32_ex(skip)", SE_DIFF_U16, c_utf16_to_utf32_skip },
+    { "se_unsafe_utf16_to_safe_utf32_ex(strict)", SE_DIFF_U16, c_utf16_to_utf32_strict },
+    { "se_unsafe_utf32_to_safe_utf16_ex(replace)", SE_DIFF_U32, c_utf32_to_utf16_replace },
+    { "se_unsafe_utf32_to_safe_utf16_ex(maximal)", SE_DIFF_U32, c_utf32_to_utf16_maximal },
+    { "se_unsafe_utf32_to_safe_utf16_ex(skip)", SE_DIFF_U32, c_utf32_to_utf16_skip },
+    { "se_unsafe_utf32_to_safe_utf16_ex(strict)", SE_DIFF_U32, c_utf32_to_utf16_strict },
+    { "se_safe_utf8_to_utf16", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_utf16 },
+    { "se_safe_utf16_to_utf8", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_utf8 },
+    { "se_safe_utf8_to_utf32", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_utf32 },
+    { "se_safe_utf32_to_utf8", SE_DIFF_U32 | SE_DIFF_SAFE, c_safe_utf32_to_utf8 },
+    { "se_safe_utf16_to_utf32", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_utf32 },
+    { "se_safe_utf32_to_utf16", SE_DIFF_U32 | SE_DIFF_SAFE, c_safe_utf32_to_utf16 },
+    { "se_is_ascii_str", SE_DIFF_U8, c_is_ascii },
+    { "se_is_ascii_utf16_str", SE_DIFF_U16, c_is_ascii_utf16 },
+    { "se_is_latin1_utf8_str", SE_DIFF_U8, c_is_latin1_utf8 },
+    { "se_is_latin1_utf16_str", SE_DIFF_U16, c_is_latin1_utf16 },
+    { "se_latin1_to_utf8", SE_DIFF_U8, c_latin1_to_utf8 },
+    { "se_latin1_to_utf8_into", SE_DIFF_U8, c_latin1_to_utf8_into },
+    { "se_latin1_to_utf16", SE_DIFF_U8, c_latin1_to_utf16 },
+    { "se_latin1_to_utf16_into", SE_DIFF_U8, c_latin1_to_utf16_into },
+    { "se_safe_utf8_to_latin1", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_latin1 },
+    { "se_safe_utf8_to_latin1_into", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_latin1_into },
+    { "se_safe_utf16_to_latin1", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_latin1 },
+    { "se_safe_utf16_to_latin1_into", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_latin1_into },
+    { "se_safe_utf8_str_char_count", SE_DIFF_U8 | SE_DIFF_SAFE, c_utf8_char_count },
+    { "se_safe_utf16_str_char_count", SE_DIFF_U16 | SE_DIFF_SAFE, c_utf16_char_count },
+    { "se_safe_utf32_str_char_count", SE_DIFF_U32 | SE_DIFF_SAFE, c_utf32_char_count },
+    { "se_safe_utf8_utf16_len", SE_DIFF_U8 | SE_DIFF_SAFE, c_utf8_utf16_len },
+    { "se_safe_utf16_utf8_len", SE_DIFF_U16 | SE_DIFF_SAFE, c_utf16_utf8_len },
+    { "se_safe_utf8_offset_to_pointer", SE_DIFF_U8 | SE_DIFF_SAFE, c_utf8_offsets },
+    { "se_safe_utf16_offset_to_pointer", SE_DIFF_U16 | SE_DIFF_SAFE, c_utf16_offsets },
+    { "se_utf8_index", SE_DIFF_U8 | SE_DIFF_SAFE, c_utf8_index },
+    { "se_ustr", SE_DIFF_U8, c_ustr },
+    { "se_safe_utf8_byte_offsets_to_utf16_offsets", SE_DIFF_U8 | SE_DIFF_SAFE, c_utf8_utf16_offsets },
+    { "se_safe_utf8_utf16_offset_to_byte_offset", SE_DIFF_U8 | SE_DIFF_SAFE, c_utf8_utf16_offset },
+    { "se_utf16_strcmp", SE_DIFF_U16 | SE_DIFF_SAFE, c_utf16_strcmp },
+    { "se_utf16_strcmp_code_point_order", SE_DIFF_U16 | SE_DIFF_SAFE, c_utf16_strcmp_code_point_order },
+    { "se_utf8_str_find_char", SE_DIFF_U8, c_utf8_find_char },
+    { "se_utf16_str_find_char", SE_DIFF_U16, c_utf16_find_char },
+    { "se_utf32_str_find_char", SE_DIFF_U32, c_utf32_find_char },
+    { "se_safe_utf8_str_find_unichar", SE_DIFF_U8 | SE_DIFF_SAFE, c_utf8_find_unichar },
+    { "se_safe_utf16_str_find_unichar", SE_DIFF_U16 | SE_DIFF_SAFE, c_utf16_find_unichar },
+    { "se_utf8_str_find_str", SE_DIFF_U8, c_utf8_find_str },
+    { "se_utf16_str_find_str", SE_DIFF_U16, c_utf16_find_str },
+    { "se_utf32_str_find_str", SE_DIFF_U32, c_utf32_find_str },
+    { "se_safe_utf8_str_find_any", SE_DIFF_U8 | SE_DIFF_SAFE, c_utf8_find_any },
+    { "se_safe_utf16_str_find_any", SE_DIFF_U16 | SE_DIFF_SAFE, c_utf16_find_any },
+    { "se_utf32_str_find_any", SE_DIFF_U32, c_utf32_find_any },
+    { "se_is_valid_utf16be_str", SE_DIFF_U16, c_is_valid_utf16be },
+    { "se_is_valid_utf16le_str", SE_DIFF_U16, c_is_valid_utf16le },
+    { "se_is_valid_utf32be_str", SE_DIFF_U32, c_is_valid_utf32be },
+    { "se_is_valid_utf32le_str", SE_DIFF_U32, c_is_valid_utf32le },
+    { "se_unsafe_utf16be_to_safe_utf8", SE_DIFF_U16, c_unsafe_utf16be_to_utf8 },
+    { "se_unsafe_utf16be_to_safe_utf16", SE_DIFF_U16, c_unsafe_utf16be_to_utf16 },
+    { "se_unsafe_utf16be_to_safe_utf32", SE_DIFF_U16, c_unsafe_utf16be_to_utf32 },
+    { "se_unsafe_utf16le_to_safe_utf8", SE_DIFF_U16, c_unsafe_utf16le_to_utf8 },
+    { "se_unsafe_utf16le_to_safe_utf16", SE_DIFF_U16, c_unsafe_utf16le_to_utf16 },
+    { "se_unsafe_utf16le_to_safe_utf32", SE_DIFF_U16, c_unsafe_utf16le_to_utf32 },
+    { "se_unsafe_utf32be_to_safe_utf8", SE_DIFF_U32, c_unsafe_utf32be_to_utf8 },
+    { "se_unsafe_utf32be_to_safe_utf16", SE_DIFF_U32, c_unsafe_utf32be_to_utf16 },
+    { "se_unsafe_utf32be_to_safe_utf32", SE_DIFF_U32, c_unsafe_utf32be_to_utf32 },
+    { "se_unsafe_utf32le_to_safe_utf8", SE_DIFF_U32, c_unsafe_utf32le_to_utf8 },
+    { "se_unsafe_utf32le_to_safe_utf16", SE_DIFF_U32, c_unsafe_utf32le_to_utf16 },
+    { "se_unsafe_utf32le_to_safe_utf32", SE_DIFF_U32, c_unsafe_utf32le_to_utf32 },
+    { "se_safe_utf8_to_utf16be", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_utf16be },
+    { "se_safe_utf8_to_utf16le", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_utf16le },
+    { "se_safe_utf8_to_utf32be", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_utf32be },
+    { "se_safe_utf8_to_utf32le", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_utf32le },
+    { "se_safe_utf16_to_utf16be", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_utf16be },
+    { "se_safe_utf16_to_utf16le", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_utf16le },
+    { "se_safe_utf16_to_utf32be", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_utf32be },
+    { "se_safe_utf16_to_utf32le", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_utf32le },
+    { "se_safe_utf32_to_utf16be", SE_DIFF_U32 | SE_DIFF_SAFE, c_safe_utf32_to_utf16be },
+    { "se_safe_utf32_to_utf16le", SE_DIFF_U32 | SE_DIFF_SAFE, c_safe_utf32_to_utf16le },
+    { "se_safe_utf32_to_utf32be", SE_DIFF_U32 | SE_DIFF_SAFE, c_safe_utf32_to_utf32be },
+    { "se_safe_utf32_to_utf32le", SE_DIFF_U32 | SE_DIFF_SAFE, c_safe_utf32_to_utf32le },
+    { "se_unsafe_gb18030_to_safe_utf8", SE_DIFF_U8, c_unsafe_gb18030_to_utf8 },
+    { "se_unsafe_gb18030_to_safe_utf16", SE_DIFF_U8, c_unsafe_gb18030_to_utf16 },
+    { "se_safe_utf8_to_gb18030", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_gb18030 },
+    { "se_safe_utf16_to_gb18030", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_gb18030 },
+    { "se_unsafe_shift_jis_to_safe_utf8", SE_DIFF_U8, c_unsafe_shift_jis_to_utf8 },
+    { "se_unsafe_shift_jis_to_safe_utf16", SE_DIFF_U8, c_unsafe_shift_jis_to_utf16 },
+    { "se_safe_utf8_to_shift_jis", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_shift_jis },
+    { "se_safe_utf16_to_shift_jis", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_shift_jis },
+    { "se_unsafe_euc_kr_to_safe_utf8", SE_DIFF_U8, c_unsafe_euc_kr_to_utf8 },
+    { "se_unsafe_euc_kr_to_safe_utf16", SE_DIFF_U8, c_unsafe_euc_kr_to_utf16 },
+    { "se_safe_utf8_to_euc_kr", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_euc_kr },
+    { "se_safe_utf16_to_euc_kr", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_euc_kr },
+    { "se_unsafe_big5_to_safe_utf8", SE_DIFF_U8, c_unsafe_big5_to_utf8 },
+    { "se_unsafe_big5_to_safe_utf16", SE_DIFF_U8, c_unsafe_big5_to_utf16 },
+    { "se_safe_utf8_to_big5", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_big5 },
+    { "se_safe_utf16_to_big5", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_big5 },
+    { "se_unsafe_gb18030_to_safe_utf8_stream", SE_DIFF_U8, c_unsafe_gb18030_to_utf8_stream },
+    { "se_unsafe_gb18030_to_safe_utf16_stream", SE_DIFF_U8, c_unsafe_gb18030_to_utf16_stream },
+    { "se_unsafe_shift_jis_to_safe_utf8_stream", SE_DIFF_U8, c_unsafe_shift_jis_to_utf8_stream },
+    { "se_unsafe_shift_jis_to_safe_utf16_stream", SE_DIFF_U8, c_unsafe_shift_jis_to_utf16_stream },
+    { "se_unsafe_euc_kr_to_safe_utf8_stream", SE_DIFF_U8, c_unsafe_euc_kr_to_utf8_stream },
+    { "se_unsafe_euc_kr_to_safe_utf16_stream", SE_DIFF_U8, c_unsafe_euc_kr_to_utf16_stream },
+    { "se_unsafe_big5_to_safe_utf8_stream", SE_DIFF_U8, c_unsafe_big5_to_utf8_stream },
+    { "se_unsafe_big5_to_safe_utf16_stream", SE_DIFF_U8, c_unsafe_big5_to_utf16_stream },
+    { "se_is_valid_wtf8_str", SE_DIFF_U8, c_is_valid_wtf8 },
+    { "se_is_valid_cesu8_str", SE_DIFF_U8, c_is_valid_cesu8 },
+    { "se_is_valid_mutf8_str", SE_DIFF_U8, c_is_valid_mutf8 },
+    { "se_unsafe_wtf8_to_utf16", SE_DIFF_U8, c_unsafe_wtf8_to_utf16 },
+    { "se_unsafe_wtf8_to_safe_utf16", SE_DIFF_U8, c_unsafe_wtf8_to_safe_utf16 },
+    { "se_unsafe_wtf8_to_safe_utf8", SE_DIFF_U8, c_unsafe_wtf8_to_safe_utf8 },
+    { "se_unsafe_cesu8_to_safe_utf8", SE_DIFF_U8, c_unsafe_cesu8_to_safe_utf8 },
+    { "se_unsafe_cesu8_to_safe_utf16", SE_DIFF_U8, c_unsafe_cesu8_to_safe_utf16 },
+    { "se_unsafe_mutf8_to_utf16", SE_DIFF_U8, c_unsafe_mutf8_to_utf16 },
+    { "se_unsafe_mutf8_to_safe_utf16", SE_DIFF_U8, c_unsafe_mutf8_to_safe_utf16 },
+    { "se_unsafe_mutf8_to_safe_utf8", SE_DIFF_U8, c_unsafe_mutf8_to_safe_utf8 },
+    { "se_utf16_to_wtf8", SE_DIFF_U16, c_utf16_to_wtf8 },
+    { "se_safe_utf8_to_cesu8", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_cesu8 },
+    { "se_safe_utf16_to_cesu8", SE_DIFF_U16 | SE_DIFF_SAFE, c_safe_utf16_to_cesu8 },
+    { "se_utf16_to_mutf8", SE_DIFF_U16, c_utf16_to_mutf8 },
+    { "se_safe_utf8_to_mutf8", SE_DIFF_U8 | SE_DIFF_SAFE, c_safe_utf8_to_mutf8 },
+    { "se_utf16_to_wtf8(round trip)", SE_DIFF_U16, c_wtf8_round_trip },
+    { "se_safe_utf16_to_cesu8(round trip)", SE_DIFF_U16 | SE_DIFF_SAFE, c_cesu8_round_trip },
+    { "se_utf16_to_mutf8(round trip)", SE_DIFF_U16, c_mutf8_round_trip },
+};
+
+#define SE_DIFF_CHECK_COUNT     ((int) (sizeof(se_diff_checks) / sizeof(se_diff_checks[0])))
+
+/***************************************************************************
+ *                                                                         *
+ * Comparing.                                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+static ptrdiff_t se_diff_input_bytes(const se_diff_input* in, int flags)
+{
+    if (flags & SE_DIFF_U8)
+        return (flags & SE_DIFF_SAFE) ? in->safe_u8_len : in->u8_len;
+    else if (flags & SE_DIFF_U16)
+        return ((flags & SE_DIFF_SAFE) ? in->safe_u16_len : in->u16_len) * (ptrdiff_t) sizeof(seunichar16);
+    else
+        return ((flags & SE_DIFF_SAFE) ? in->safe_u32_len : in->u32_len) * (ptrdiff_t) sizeof(seunichar32);
+}
+
+static int se_diff_compare(const se_diff_check* check, const se_diff_input* in, const se_diff_result* lib, const se_diff_result* ref)
+/*
+ * Return 1 and describe the first difference if the results differ.
+ */
+{
+    ptrdiff_t size;
+    ptrdiff_t i;
+
+    for (i = 0; i < SE_DIFF_VALUE_COUNT; i++)
+    {
+        if (lib->values[i] != ref->values[i])
+        {
+            fprintf(stderr, "se-diff: %s: seed %u (%s, %ld bytes): value %d is %ld, reference %ld\n",
+                    check->name, in->seed, in->kind, (long) se_diff_input_bytes(in, check->flags), (int) i,
+                    (long) lib->values[i], (long) ref->values[i]);
+            return 1;
+        }
+    }
+
+    size = lib->size < ref->size ? lib->size : ref->size;
+    for (i = 0; i < size; i++)
+    {
+        if (((const unsigned char*) lib->data)[i] != ((const unsigned char*) ref->data)[i])
+            break;
+    }
+
+    if (i < size || lib->size != ref->size)
+    {
+        fprintf(stderr, "se-diff: %s: seed %u (%s, %ld bytes): output of %ld bytes, reference %ld bytes, first difference at byte %ld\n",
+                check->name, in->seed, in->kind, (long) se_diff_input_bytes(in, check->flags),
+                (long) lib->size, (long) ref->size, (long) i);
+        return 1;
+    }
+
+    return 0;
+}
+
+static double se_diff_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Calls are timed a few times, keeping the fastest */
+#define SE_DIFF_REPEAT          3
+
+/*
+ * Calls on shorter inputs, or taking less time because they return early,
+ * are too noisy to report as cliffs.
+ */
+#define SE_DIFF_CLIFF_MIN_BYTES     4096
+#define SE_DIFF_CLIFF_MIN_SECONDS   2e-6
+
+static double se_diff_run(const se_diff_check* check, const se_diff_input* in, int ref, int repeat, se_diff_result* result)
+{
+    double best;
+    double start;
+    double seconds;
+    int i;
+
+    best = 0;
+    for (i = 0; i < repeat; i++)
+    {
+        if (i)
+            SE_FREE(result->data);
+        memset(result, 0, sizeof(*result));
+
+        start = se_diff_now();
+        check->run(in, ref, result);
+        seconds = se_diff_now() - start;
+
+        if (i == 0 || seconds < best)
+            best = seconds;
+    }
+
+    return best;
+}
+
+#if defined(SE_DIFF_FUZZER)
+
+int LLVMFuzzerTestOneInput(const unsigned char* data, size_t size);
+
+int LLVMFuzzerTestOneInput(const unsigned char* data, size_t size)
+{
+    se_diff_input in;
+    se_diff_result lib;
+    se_diff_result ref;
+    int i;
+
+    memset(&in, 0, sizeof(in));
+    strcpy(in.kind, "fuzz");
+    se_diff_set_raw_input(&in, data, size);
+
+    for (i = 0; i < SE_DIFF_CHECK_COUNT; i++)
+    {
+        se_diff_run(&se_diff_checks[i], &in, 1, 1, &ref);
+        se_diff_run(&se_diff_checks[i], &in, 0, 1, &lib);
+
+        if (se_diff_compare(&se_diff_checks[i], &in, &lib, &ref))
+            abort();
+
+        SE_FREE(lib.data);
+        SE_FREE(ref.data);
+    }
+
+    return 0;
+}
+
+#else
+
+/***************************************************************************
+ *                                                                         *
+ * Generated inputs.                                                       *
+ *                                                                         *
+ ***************************************************************************/
+
+static unsigned char* se_diff_adversarial(unsigned int seed, int pattern, size_t size, char* kind)
+/*
+ * Byte patterns aimed at the vector code paths: chunks that are almost
+ * ASCII, characters and errors straddling chunk boundaries, long runs of
+ * ill-formed bytes, and surrogates and NULs for the UTF-16 views.
+ */
+{
+    static const char* names[] = { "continuation", "truncated", "sparse", "straddle", "random", "surrogates", "nul" };
+    unsigned char* data;
+    unsigned int state;
+    unsigned int r;
+    seunichar16 unit;
+    size_t hole;
+    size_t i;
+
+    strcpy(kind, names[pattern]);
+
+    data = SE_MALLOC(size + 4);
+    state = seed | 1;
+
+    hole = 14;
+    i = 0;
+    while (i < size)
+    {
+        r = se_diff_random(&state);
+
+        switch (pattern)
+        {
+        case 0:
+            /* Only continuation bytes */
+            data[i++] = (unsigned char) (0x80 + r % 0x40);
+            break;
+
+        case 1:
+            /* Lead bytes followed by too few continuation bytes */
+            data[i++] = (unsigned char) (0xC0 + r % 0x40);
+            if ((r >> 8) % 3)
+                data[i++] = (unsigned char) (0x80 + (r >> 12) % 0x40);
+            break;
+
+        case 2:
+            /* ASCII with one non-ASCII byte near each 16 byte boundary */
+            data[i] = (unsigned char) (i == hole ? 0x80 + r % 0x80 : 0x20 + r % 0x5F);
+            if (i % 16 == 0)
+                hole = i + 14 + (r >> 8) % 3;
+            i++;
+            break;
+
+        case 3:
+            /* 4 byte characters shifted off the chunk boundaries by ASCII */
+            if (r % 5 == 0)
+            {
+                data[i++] = (unsigned char) ('a' + (r >> 8) % 26);
+            }
+            else
+            {
+                data[i++] = 0xF0;
+                data[i++] = (unsigned char) (0x90 + (r >> 8) % 0x30);
+                data[i++] = (unsigned char) (0x80 + (r >> 16) % 0x40);
+                data[i++] = (unsigned char) (0x80 + (r >> 24) % 0x40);
+            }
+            break;
+
+        case 4:
+            data[i++] = (unsigned char) r;
+            break;
+
+        case 5:
+            /* Mostly surrogates, paired or not */
+            unit = (seunichar16) ((r % 4) ? 0xD800 + (r >> 8) % 0x800 : 0x20 + (r >> 8) % 0x60);
+            memcpy(data + i, &unit, sizeof(unit));
+            i += sizeof(unit);
+            break;
+
+        default:
+            /* Text with NULs */
+            data[i++] = (unsigned char) ((r % 16) ? 0x20 + (r >> 8) % 0x60 : 0);
+            break;
+        }
+    }
+
+    return data;
+}
+
+static void se_diff_make_input(se_diff_input* in, unsigned int seed, ptrdiff_t max_size)
+/*
+ * Make input seed: one in four inputs is an adversarial byte pattern, the
+ * others are corpora of a random preset and error rate.
+ */
+{
+    static const char* presets[] = { "ascii", "latin", "cyrillic", "cjk", "emoji", "random", "mixed" };
+    static const int error_ppm[] = { 0, 100, 10000, 100000, 500000 };
+    se_corpus_options options;
+    unsigned char* data;
+    void* u8;
+    void* u16;
+    void* u32;
+    ptrdiff_t u8_len;
+    ptrdiff_t u16_len;
+    ptrdiff_t u32_len;
+    ptrdiff_t size;
+    unsigned int state;
+    int ppm;
+    int bits;
+
+    memset(in, 0, sizeof(*in));
+    in->seed = seed;
+
+    /* Sizes spread evenly over the powers of two */
+    state = seed * 2654435761u | 1;
+    se_diff_random(&state);
+    for (bits = 0; ((ptrdiff_t) 1 << bits) < max_size; bits++)
+        ;
+    size = (ptrdiff_t) (se_diff_random(&state) % ((1u << (se_diff_random(&state) % (unsigned int) (bits + 1))) + 1));
+    if (size > max_size)
+        size = max_size;
+    in->pick = se_diff_random(&state);
+
+    if (seed % 4 == 0)
+    {
+        data = se_diff_adversarial(seed, (int) (seed / 4 % 7), (size_t) size, in->kind);
+        se_diff_set_raw_input(in, data, (size_t) size);
+        SE_FREE(data);
+        return;
+    }
+
+    se_corpus_options_init(&options, presets[seed / 4 % 7]);
+    ppm = error_ppm[se_diff_random(&state) % 5];
+    se_corpus_set_error_rate(&options, ppm);
+    options.seed = seed;
+    sprintf(in->kind, "%s-%dppm", presets[seed / 4 % 7], ppm);
+
+    u8 = se_corpus_generate(&options, SE_CORPUS_UTF8, size, &u8_len);
+    u16 = se_corpus_generate(&options, SE_CORPUS_UTF16, size, &u16_len);
+    u32 = se_corpus_generate(&options, SE_CORPUS_UTF32, size, &u32_len);
+
+    se_diff_set_input(in, u8, u8_len, u16, u16_len, u32, u32_len);
+
+    SE_FREE(u8);
+    SE_FREE(u16);
+    SE_FREE(u32);
+}
+
+static int se_diff_read_input(se_diff_input* in, const char* path)
+{
+    unsigned char* data;
+    size_t size;
+    size_t capacity;
+    size_t n;
+    FILE* file;
+
+    file = fopen(path, "rb");
+    if (!file)
+    {
+        perror(path);
+        return -1;
+    }
+
+    size = 0;
+    capacity = 4096;
+    data = malloc(capacity);
+    while ((n = fread(data + size, 1, capacity - size, file)) > 0)
+    {
+        size += n;
+        if (size == capacity)
+        {
+            capacity *= 2;
+            data = realloc(data, capacity);
+        }
+    }
+    fclose(file);
+
+    memset(in, 0, sizeof(*in));
+    sprintf(in->kind, "file %.24s", strrchr(path, '/') ? strrchr(path, '/') + 1 : path);
+    se_diff_set_raw_input(in, data, size);
+    free(data);
+
+    return 0;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Known answers of se_detect_encoding_sz(), which has no reference.       *
+ *                                                                         *
+ ***************************************************************************/
+
+typedef struct se_diff_detect_case se_diff_detect_case;
+
+struct se_diff_detect_case
+{
+    const char* name;
+    const char* data;
+    int size;
+    int repeat;
+    const char* expected;
+
+    /* Highest confidence allowed, below 100 for guesses on scant evidence */
+    int max_confidence;
+};
+
+static const se_diff_detect_case se_diff_detect_cases[] =
+{
+    /* "这是一个测试。" without NUL bytes */
+    { "utf16le-zh", "\xD9\x8F\x2F\x66\x00\x4E\x2A\x4E\x4B\x6D\xD5\x8B\x02\x30", 14, 20, "UTF-16LE", 100 },
+
+    /* A few NULs from U+4E00 on the wrong side */
+    { "utf16be-zh",
+      "\x4E\x2D\x53\x4E\x4E\xBA\x6C\x11\x51\x71\x54\x8C\x56\xFD\x4E\x8E\x4E\x00\x4E\x5D\x56\xDB\x4E\x5D\x5E\x74\x53\x41\x67\x08"
+      "\x4E\x00\x65\xE5\x62\x10\x7A\xCB\xFF\x0C\x99\x96\x90\xFD\x66\x2F\x53\x17\x4E\xAC\x30\x02\x4E\x00\x4E\x5D\x56\xDB\x4E\x5D"
+      "\x5E\x74\x66\x2F\x65\xB0\x4E\x2D\x56\xFD\x76\x84\x5F\x00\x59\xCB\x30\x02", 78, 1, "UTF-16BE", 100 },
+
+    /* "北京是中国的首都。" in both byte orders, against the legacy decoders */
+    { "utf16be-zh-short", "\x53\x17\x4E\xAC\x66\x2F\x4E\x2D\x56\xFD\x76\x84\x99\x96\x90\xFD\x30\x02", 18, 1, "UTF-16BE", 100 },
+    { "utf16le-zh-short", "\x17\x53\xAC\x4E\x2F\x66\x2D\x4E\xFD\x56\x84\x76\x96\x99\xFD\x90\x02\x30", 18, 1, "UTF-16LE", 100 },
+
+    /* Legacy text that reads as CJK in UTF-16BE */
+    { "gb18030-zh", "\xB1\xB1\xBE\xA9\xCA\xC7\xD6\xD0\xB9\xFA\xB5\xC4\xCA\xD7\xB6\xBC\xA1\xA3", 18, 1, "GB18030", 100 },
+    { "shift_jis-ja", "\x93\x8C\x8B\x9E\x82\xCD\x93\xFA\x96\x7B\x82\xCC\x8E\xF1\x93\x73\x82\xC5\x82\xB7\x81\x42", 22, 1, "Shift_JIS", 100 },
+    { "euc-kr-ko", "\xBC\xAD\xBF\xEF\xC0\xBA\x20\xC7\xD1\xB1\xB9\xC0\xC7\x20\xBC\xF6\xB5\xB5\xC0\xD4\xB4\xCF\xB4\xD9\x2E", 25, 1, "EUC-KR", 100 },
+    { "utf8-zh", "\xE5\x8C\x97\xE4\xBA\xAC\xE6\x98\xAF\xE4\xB8\xAD\xE5\x9B\xBD\xE7\x9A\x84\xE9\xA6\x96\xE9\x83\xBD\xE3\x80\x82", 27, 1, "UTF-8", 100 },
+
+    /* Greek, Russian, Arabic, Hindi and Hebrew, with the NUL bytes of spaces all on the high side */
+    { "utf16le-el",
+      "\x97\x03\x20\x00\x91\x03\xB8\x03\xAE\x03\xBD\x03\xB1\x03\x20\x00\xB5\x03\xAF\x03\xBD\x03\xB1\x03\xB9\x03\x20\x00\xB7\x03"
+      "\x20\x00\xC0\x03\xC1\x03\xC9\x03\xC4\x03\xB5\x03\xCD\x03\xBF\x03\xC5\x03\xC3\x03\xB1\x03\x20\x00\xC4\x03\xB7\x03\xC2\x03"
+      "\x20\x00\x95\x03\xBB\x03\xBB\x03\xAC\x03\xB4\x03\xB1\x03\xC2\x03\x2E\x00", 78, 1, "UTF-16LE", 100 },
+    { "utf16be-el",
+      "\x03\x97\x00\x20\x03\x91\x03\xB8\x03\xAE\x03\xBD\x03\xB1\x00\x20\x03\xB5\x03\xAF\x03\xBD\x03\xB1\x03\xB9\x00\x20\x03\xB7"
+      "\x00\x20\x03\xC0\x03\xC1\x03\xC9\x03\xC4\x03\xB5\x03\xCD\x03\xBF\x03\xC5\x03\xC3\x03\xB1\x00\x20\x03\xC4\x03\xB7\x03\xC2"
+      "\x00\x20\x03\x95\x03\xBB\x03\xBB\x03\xAC\x03\xB4\x03\xB1\x03\xC2\x00\x2E", 78, 1, "UTF-16BE", 100 },
+    { "utf16le-ru",
+      "\x1C\x04\x3E\x04\x41\x04\x3A\x04\x32\x04\x30\x04\x20\x00\x4F\x04\x32\x04\x3B\x04\x4F\x04\x35\x04\x42\x04\x41\x04\x4F\x04"
+      "\x20\x00\x41\x04\x42\x04\x3E\x04\x3B\x04\x38\x04\x46\x04\x35\x04\x39\x04\x20\x00\x20\x04\x3E\x04\x41\x04\x41\x04\x38\x04"
+      "\x38\x04\x2E\x00", 64, 1, "UTF-16LE", 100 },
+    { "utf16be-ar",
+      "\x06\x27\x06\x44\x06\x42\x06\x27\x06\x47\x06\x31\x06\x29\x00\x20\x06\x47\x06\x4A\x00\x20\x06\x39\x06\x27\x06\x35\x06\x45"
+      "\x06\x29\x00\x20\x06\x45\x06\x35\x06\x31\x00\x2E", 42, 1, "UTF-16BE", 100 },
+    { "utf16le-hi",
+      "\x28\x09\x08\x09\x20\x00\x26\x09\x3F\x09\x32\x09\x4D\x09\x32\x09\x40\x09\x20\x00\x2D\x09\x3E\x09\x30\x09\x24\x09\x20\x00"
+      "\x15\x09\x40\x09\x20\x00\x30\x09\x3E\x09\x1C\x09\x27\x09\x3E\x09\x28\x09\x40\x09\x20\x00\x39\x09\x48\x09\x64\x09", 58, 1, "UTF-16LE", 100 },
+    { "utf16be-he",
+      "\x05\xD9\x05\xE8\x05\xD5\x05\xE9\x05\xDC\x05\xD9\x05\xDD\x00\x20\x05\xD4\x05\xD9\x05\xD0\x00\x20\x05\xD1\x05\xD9\x05\xE8"
+      "\x05\xEA\x00\x20\x05\xD9\x05\xE9\x05\xE8\x05\xD0\x05\xDC\x00\x2E", 46, 1, "UTF-16BE", 100 },
+
+    /* "台北是台灣的首都。今天天氣很好。" in GBK, and "서울은 대한민국의 수도입니다." in four byte codes */
+    { "gbk-zh-hant",
+      "\xCC\xA8\xB1\xB1\xCA\xC7\xCC\xA8\x9E\xB3\xB5\xC4\xCA\xD7\xB6\xBC\xA1\xA3\xBD\xF1\xCC\xEC\xCC\xEC\x9A\xE2\xBA\xDC\xBA\xC3"
+      "\xA1\xA3", 32, 1, "GB18030", 100 },
+    { "gb18030-ko",
+      "\x83\x31\xF3\x39\x83\x33\x87\x35\x83\x33\x95\x31\x20\x82\x39\x86\x37\x83\x36\x84\x33\x83\x30\xEE\x37\x82\x37\xF4\x30\x83"
+      "\x33\x97\x35\x20\x83\x32\x8F\x31\x82\x39\x9A\x33\x83\x33\x9C\x30\x82\x39\x81\x31\x82\x39\x83\x39\x2E", 55, 1, "GB18030", 100 },
+
+    /* Latin-1, with a low confidence for only a few letters above ASCII */
+    { "latin1-fr", "Le ch\xE2teau de Versailles est situ\xE9 \xE0 l'ouest de Paris. Il a \xE9t\xE9 construit au dix-septi\xE8me si\xE8" "cle.", 97, 1, "ISO-8859-1", 100 },
+    { "latin1-short", "h\xE9llo world", 11, 1, "ISO-8859-1", 20 },
+    { "latin1-stray", "h\xE9llo \xFF world\n", 14, 1, "ISO-8859-1", 20 }
+};
+
+static long se_diff_detect(void)
+/*
+ * Check se_detect_encoding_sz() on the known answers, print each wrong
+ * guess and return their number.
+ */
+{
+    const se_diff_detect_case* c;
+    const char* name;
+    char* data;
+    long mismatches;
+    int confidence;
+    int i;
+    int j;
+
+    mismatches = 0;
+    for (i = 0; i < (int) (sizeof(se_diff_detect_cases) / sizeof(se_diff_detect_cases[0])); i++)
+    {
+        c = &se_diff_detect_cases[i];
+        data = SE_MALLOC((size_t) (c->size * c->repeat));
+        for (j = 0; j < c->repeat; j++)
+            memcpy(data + j * c->size, c->data, (size_t) c->size);
+
+        name = se_detect_encoding_sz(data, (ptrdiff_t) (c->size * c->repeat), &confidence, 0);
+        if (strcmp(name, c->expected) != 0 || confidence > c->max_confidence)
+        {
+            fprintf(stderr, "se-diff: se_detect_encoding: %s: %s (%d%%), expected %s (at most %d%%)\n", c->name, name, confidence, c->expected, c->max_confidence);
+            mismatches++;
+        }
+
+        SE_FREE(data);
+    }
+
+    return mismatches;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Known answers of the GB18030 transcoder.                                *
+ *                                                                         *
+ * The reference build shares the mapping tables, so only codes checked    *
+ * against GB18030-2005 catch a wrong table or range.                      *
+ *                                                                         *
+ ***************************************************************************/
+
+typedef struct se_diff_gb18030_case se_diff_gb18030_case;
+
+struct se_diff_gb18030_case
+{
+    const char* gb18030;
+    int gb18030_len;
+    const char* utf8;
+    int utf8_len;
+
+    /* FALSE for ill-formed GB18030, only decoded */
+    sebool round_trip;
+};
+
+static const se_diff_gb18030_case se_diff_gb18030_cases[] =
+{
+    /* Two byte codes, four byte codes of the BMP, supplementary planes */
+    { "\x41", 1, "\x41", 1, TRUE },
+    { "\x81\x30\x81\x30", 4, "\xC2\x80", 2, TRUE },
+    { "\x81\x30\x84\x36", 4, "\xC2\xA5", 2, TRUE },
+    { "\xA1\xA4", 2, "\xC2\xB7", 2, TRUE },
+    { "\xA2\xE3", 2, "\xE2\x82\xAC", 3, TRUE },
+    { "\xA1\xA1", 2, "\xE3\x80\x80", 3, TRUE },
+    { "\xD6\xD0", 2, "\xE4\xB8\xAD", 3, TRUE },
+    { "\xFD\x9B", 2, "\xE9\xBE\xA5", 3, TRUE },
+    { "\x81\x35\xF4\x37", 4, "\xE1\xB8\xBF", 3, TRUE },
+    { "\xA3\xA0", 2, "\xEE\x97\xA5", 3, TRUE },
+    { "\xA8\xBC", 2, "\xEE\x9F\x87", 3, TRUE },
+    { "\x84\x31\xA4\x39", 4, "\xEF\xBF\xBF", 3, TRUE },
+    { "\x90\x30\x81\x30", 4, "\xF0\x90\x80\x80", 4, TRUE },
+    { "\x95\x32\x82\x36", 4, "\xF0\xA0\x80\x80", 4, TRUE },
+    { "\xE3\x32\x9A\x35", 4, "\xF4\x8F\xBF\xBF", 4, TRUE },
+
+    /* Replaced, decoding resumes at the second byte */
+    { "\xFF", 1, "\xEF\xBF\xBD", 3, FALSE },
+    { "\x80", 1, "\xEF\xBF\xBD", 3, FALSE },
+    { "\x81", 1, "\xEF\xBF\xBD", 3, FALSE },
+    { "\x41\x81\x30\x81", 4, "\x41\xEF\xBF\xBD\x30\xEF\xBF\xBD", 8, FALSE },
+    { "\x84\x31\xA5\x30", 4, "\xEF\xBF\xBD\x31\xEF\xBF\xBD\x30", 8, FALSE },
+    { "\xE3\x32\x9A\x36", 4, "\xEF\xBF\xBD\x32\xEF\xBF\xBD\x36", 8, FALSE }
+};
+
+static long se_diff_gb18030(void)
+/*
+ * Check the GB18030 decoder, and the encoder where the code is
+ * well-formed, on the known answers, print each wrong result and return
+ * their number.
+ */
+{
+    const se_diff_gb18030_case* c;
+    seunichar8* utf8;
+    char* gb18030;
+    ptrdiff_t len;
+    long mismatches;
+    int i;
+
+    mismatches = 0;
+    for (i = 0; i < (int) (sizeof(se_diff_gb18030_cases) / sizeof(se_diff_gb18030_cases[0])); i++)
+    {
+        c = &se_diff_gb18030_cases[i];
+
+        utf8 = se_unsafe_gb18030_to_safe_utf8_sz(c->gb18030, c->gb18030_len, &len);
+        if (len != c->utf8_len || memcmp(utf8, c->utf8, (size_t) len) != 0)
+        {
+            fprintf(stderr, "se-diff: se_unsafe_gb18030_to_safe_utf8: case %d: wrong output\n", i);
+            mismatches++;
+        }
+        SE_FREE(utf8);
+
+        if (!c->round_trip)
+            continue;
+
+        gb18030 = se_safe_utf8_to_gb18030_sz(c->utf8, c->utf8_len, &len);
+        if (len != c->gb18030_len || memcmp(gb18030, c->gb18030, (size_t) len) != 0)
+        {
+            fprintf(stderr, "se-diff: se_safe_utf8_to_gb18030: case %d: wrong output\n", i);
+            mismatches++;
+        }
+        SE_FREE(gb18030);
+    }
+
+    return mismatches;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Known answers of the UTF-8 variants.                                    *
+ *                                                                         *
+ * The rules that tell the variants apart, checked in the library as       *
+ * built: surrogates, pairs split in two sequences, and U+0000.            *
+ *                                                                         *
+ ***************************************************************************/
+
+typedef struct se_diff_variant_case se_diff_variant_case;
+
+struct se_diff_variant_case
+{
+    const char* name;
+    sebool (*is_valid)(const char* str, ptrdiff_t len);
+    const char* str;
+    int len;
+    sebool expected;
+};
+
+static const se_diff_variant_case se_diff_variant_cases[] =
+{
+    { "wtf8-split-pair", se_is_valid_wtf8_str_sz, "\xED\xA0\x80\xED\xB0\x80", 6, FALSE },
+    { "wtf8-lone-surrogates", se_is_valid_wtf8_str_sz, "\xED\xA0\x80\x41\xED\xB0\x80", 7, TRUE },
+    { "wtf8-pair", se_is_valid_wtf8_str_sz, "\xF0\x90\x80\x80", 4, TRUE },
+    { "wtf8-nul", se_is_valid_wtf8_str_sz, "\x41\x00\x42", 3, TRUE },
+    { "cesu8-split-pair", se_is_valid_cesu8_str_sz, "\xED\xA0\x80\xED\xB0\x80", 6, TRUE },
+    { "cesu8-lone-surrogate", se_is_valid_cesu8_str_sz, "\xED\xA0\x80", 3, FALSE },
+    { "cesu8-pair", se_is_valid_cesu8_str_sz, "\xF0\x90\x80\x80", 4, FALSE },
+    { "mutf8-nul", se_is_valid_mutf8_str_sz, "\x41\x00\x42", 3, FALSE },
+    { "mutf8-c0-80", se_is_valid_mutf8_str_sz, "\x41\xC0\x80\x42", 4, TRUE },
+    { "mutf8-lone-surrogate", se_is_valid_mutf8_str_sz, "\xED\xA0\x80", 3, TRUE },
+    { "mutf8-split-pair", se_is_valid_mutf8_str_sz, "\xED\xA0\x80\xED\xB0\x80", 6, TRUE },
+    { "mutf8-pair", se_is_valid_mutf8_str_sz, "\xF0\x90\x80\x80", 4, FALSE }
+};
+
+typedef struct se_diff_variant_code se_diff_variant_code;
+
+struct se_diff_variant_code
+{
+    const char* name;
+    char* (*encode)(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+    seunichar16* (*decode)(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+    seunichar16 units[4];
+    int units_len;
+    const char* str;
+    int len;
+};
+
+static const se_diff_variant_code se_diff_variant_codes[] =
+{
+    { "wtf8-lone-surrogates", se_utf16_to_wtf8_sz, se_unsafe_wtf8_to_utf16_sz, { 0xD800, 0x41, 0xDC00 }, 3, "\xED\xA0\x80\x41\xED\xB0\x80", 7 },
+    { "wtf8-reversed-pair", se_utf16_to_wtf8_sz, se_unsafe_wtf8_to_utf16_sz, { 0xDC00, 0xD800 }, 2, "\xED\xB0\x80\xED\xA0\x80", 6 },
+    { "wtf8-pair", se_utf16_to_wtf8_sz, se_unsafe_wtf8_to_utf16_sz, { 0xD83D, 0xDE00 }, 2, "\xF0\x9F\x98\x80", 4 },
+    { "mutf8-lone-surrogates", se_utf16_to_mutf8_sz, se_unsafe_mutf8_to_utf16_sz, { 0xDBFF, 0x41, 0xDFFF }, 3, "\xED\xAF\xBF\x41\xED\xBF\xBF", 7 },
+    { "mutf8-nul", se_utf16_to_mutf8_sz, se_unsafe_mutf8_to_utf16_sz, { 0, 0xD800, 0 }, 3, "\xC0\x80\xED\xA0\x80\xC0\x80", 7 },
+    { "mutf8-pair", se_utf16_to_mutf8_sz, se_unsafe_mutf8_to_utf16_sz, { 0xD83D, 0xDE00 }, 2, "\xED\xA0\xBD\xED\xB8\x80", 6 }
+};
+
+static long se_diff_variants(void)
+/*
+ * Check the validation of the UTF-8 variants, and their encoding and
+ * decoding of lone surrogates and U+0000, on the known answers, print
+ * each wrong result and return their number.
+ */
+{
+    const se_diff_variant_case* c;
+    const se_diff_variant_code* code;
+    seunichar16* units;
+    char* str;
+    ptrdiff_t len;
+    long mismatches;
+    sebool valid;
+    int i;
+
+    mismatches = 0;
+    for (i = 0; i < (int) (sizeof(se_diff_variant_cases) / sizeof(se_diff_variant_cases[0])); i++)
+    {
+        c = &se_diff_variant_cases[i];
+        valid = c->is_valid(c->str, c->len);
+        if (!valid != !c->expected)
+        {
+            fprintf(stderr, "se-diff: se_is_valid_*_str: %s: %s, expected %s\n", c->name,
+                    valid ? "valid" : "invalid", c->expected ? "valid" : "invalid");
+            mismatches++;
+        }
+    }
+
+    for (i = 0; i < (int) (sizeof(se_diff_variant_codes) / sizeof(se_diff_variant_codes[0])); i++)
+    {
+        code = &se_diff_variant_codes[i];
+
+        str = code->encode(code->units, code->units_len, &len);
+        if (len != code->len || memcmp(str, code->str, (size_t) len) != 0)
+        {
+            fprintf(stderr, "se-diff: se_utf16_to_*: %s: wrong output\n", code->name);
+            mismatches++;
+        }
+        SE_FREE(str);
+
+        units = code->decode(code->str, code->len, &len);
+        if (len != code->units_len || memcmp(units, code->units, (size_t) len * sizeof(seunichar16)) != 0)
+        {
+            fprintf(stderr, "se-diff: se_unsafe_*_to_utf16: %s: wrong output\n", code->name);
+            mismatches++;
+        }
+        SE_FREE(units);
+    }
+
+    return mismatches;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Main.                                                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+typedef struct se_diff_summary se_diff_summary;
+
+struct se_diff_summary
+{
+    long inputs;
+    long mismatches;
+    long cliffs;
+    double bytes;
+    double lib_seconds;
+    double ref_seconds;
+
+    /* The input with the highest library / reference time ratio */
+    double worst_ratio;
+    unsigned int worst_seed;
+};
+
+int main(int argc, char** argv)
+{
+    static se_diff_summary summaries[SE_DIFF_CHECK_COUNT];
+    se_diff_input in;
+    se_diff_result lib;
+    se_diff_result ref;
+    se_diff_summary* summary;
+    const se_diff_check* check;
+    const char* filter;
+    ptrdiff_t max_size;
+    ptrdiff_t bytes;
+    unsigned int seed;
+    double cliff_ratio;
+    double lib_seconds;
+    double ref_seconds;
+    long count;
+    long mismatches;
+    long n;
+    int verbose;
+    int cliff;
+    int files;
+    int i;
+
+    count = 2000;
+    seed = 1;
+    max_size = 65536;
+    cliff_ratio = 2;
+    filter = 0;
+    verbose = 0;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            count = atol(argv[++i]);
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            seed = (unsigned int) strtoul(argv[++i], 0, 0);
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+            max_size = atol(argv[++i]);
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+            cliff_ratio = atof(argv[++i]);
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "-v") == 0)
+            verbose = 1;
+        else
+        {
+            fputs("usage: se-diff [-n COUNT] [-r SEED] [-m SIZE] [-c RATIO] [-f FILTER] [-v] [FILE...]\n", stderr);
+            return 2;
+        }
+    }
+
+    if (max_size < 0 || max_size > 0x7FFFFFFF / 4)
+    {
+        fputs("se-diff: size out of range\n", stderr);
+        return 2;
+    }
+
+    files = i;
+    if (files < argc)
+        count = argc - files;
+
+    mismatches = 0;
+    if (!filter || strstr("se_detect_encoding", filter))
+        mismatches += se_diff_detect();
+    if (!filter || strstr("se_unsafe_gb18030_to_safe_utf8", filter) || strstr("se_safe_utf8_to_gb18030", filter))
+        mismatches += se_diff_gb18030();
+    if (!filter || strstr("se_is_valid_wtf8_str se_is_valid_cesu8_str se_is_valid_mutf8_str", filter))
+        mismatches += se_diff_variants();
+
+    for (n = 0; n < count; n++)
+    {
+        if (files < argc)
+        {
+            if (se_diff_read_input(&in, argv[files + n]) < 0)
+                return 2;
+        }
+        else
+        {
+            se_diff_make_input(&in, seed + (unsigned int) n, max_size);
+        }
+
+        for (i = 0; i < SE_DIFF_CHECK_COUNT; i++)
+        {
+            check = &se_diff_checks[i];
+            if (filter && !strstr(check->name, filter))
+                continue;
+
+            summary = &summaries[i];
+            bytes = se_diff_input_bytes(&in, check->flags);
+
+            ref_seconds = se_diff_run(check, &in, 1, SE_DIFF_REPEAT, &ref);
+            lib_seconds = se_diff_run(check, &in, 0, SE_DIFF_REPEAT, &lib);
+
+            cliff = bytes >= SE_DIFF_CLIFF_MIN_BYTES && ref_seconds >= SE_DIFF_CLIFF_MIN_SECONDS;
+
+            /* Time a suspected cliff again, most of them are interrupts */
+            if (cliff && lib_seconds > ref_seconds * cliff_ratio)
+            {
+                SE_FREE(lib.data);
+                SE_FREE(ref.data);
+                ref_seconds = se_diff_run(check, &in, 1, SE_DIFF_REPEAT * 4, &ref);
+                lib_seconds = se_diff_run(check, &in, 0, SE_DIFF_REPEAT * 4, &lib);
+            }
+
+            summary->inputs++;
+            summary->bytes += (double) bytes;
+            summary->lib_seconds += lib_seconds;
+            summary->ref_seconds += ref_seconds;
+
+            if (se_diff_compare(check, &in, &lib, &ref))
+            {
+                summary->mismatches++;
+                mismatches++;
+            }
+
+            if (cliff)
+            {
+                if (lib_seconds / ref_seconds > summary->worst_ratio)
+                {
+                    summary->worst_ratio = lib_seconds / ref_seconds;
+                    summary->worst_seed = in.seed;
+                }
+
+                if (lib_seconds > ref_seconds * cliff_ratio)
+                {
+                    summary->cliffs++;
+                    if (verbose)
+                    {
+                        printf("cliff: %s: seed %u (%s, %ld bytes): %.3f GB/s, reference %.3f GB/s\n",
+                               check->name, in.seed, in.kind, (long) bytes, bytes / lib_seconds * 1e-9, bytes / ref_seconds * 1e-9);
+                    }
+                }
+            }
+
+            SE_FREE(lib.data);
+            SE_FREE(ref.data);
+        }
+    }
+
+    printf("%-44s %8s %8s %8s %10s %10s %12s\n", "function", "inputs", "diffs", "cliffs", "GB/s", "ref GB/s", "worst(seed)");
+    for (i = 0; i < SE_DIFF_CHECK_COUNT; i++)
+    {
+        summary = &summaries[i];
+        if (!summary->inputs)
+            continue;
+
+        printf("%-44s %8ld %8ld %8ld %10.3f %10.3f %5.2f(%u)\n", se_diff_checks[i].name, summary->inputs, summary->mismatches,
+               summary->cliffs, summary->bytes / summary->lib_seconds * 1e-9, summary->bytes / summary->ref_seconds * 1e-9,
+               summary->worst_ratio, summary->worst_seed);
+    }
+
+    return mismatches ? 1 : 0;
+}
+
+#endif /* SE_DIFF_FUZZER */
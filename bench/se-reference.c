@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+/*
+ * Scalar reference build of the library sources for se-diff.
+ *
+ * The library sources included at the end are compiled a second time in
+ * this translation unit with every vectorized code path and the UTF-8
+ * automaton turned off, and every exported function renamed from se_xxx()
+ * to se_ref_xxx(), so both builds can be linked into one program and
+ * compared call by call. Calls from one source into another stay within
+ * the reference build.
+ *
+ * Every SE_API function of the included sources must be listed below. A
+ * missing one is caught as a duplicate symbol when se-diff is linked.
+ */
+
+#undef SE_OPT_SSE2
+#undef SE_OPT_UTF8_DFA
+#undef SE_OPT_STATS
+#undef SE_OPT_ALLOC_TRACE
+
+#define SE_OPT_SSE2         0
+#define SE_OPT_UTF8_DFA     0
+#define SE_OPT_STATS        0
+#define SE_OPT_ALLOC_TRACE  0
+
+#define se_stats_snapshot                                  se_ref_stats_snapshot
+#define se_alloc_trace_read                                se_ref_alloc_trace_read
+#define se_alloc_trace_reset                               se_ref_alloc_trace_reset
+#define se_alloc_trace_function_name                       se_ref_alloc_trace_function_name
+#define se_unichar_is_valid                                se_ref_unichar_is_valid
+#define se_unichar_is_surrogate                            se_ref_unichar_is_surrogate
+#define se_unichar_is_hi_surrogate                         se_ref_unichar_is_hi_surrogate
+#define se_unichar_is_lo_surrogate                         se_ref_unichar_is_lo_surrogate
+#define se_unichar_is_noncharacter                         se_ref_unichar_is_noncharacter
+#define se_unsafe_unichar_to_utf8                          se_ref_unsafe_unichar_to_utf8
+#define se_unsafe_unichar_to_utf16                         se_ref_unsafe_unichar_to_utf16
+#define se_unsafe_utf8_get_char                            se_ref_unsafe_utf8_get_char
+#define se_unsafe_utf16_get_char                           se_ref_unsafe_utf16_get_char
+#define se_safe_unichar_to_utf8                            se_ref_safe_unichar_to_utf8
+#define se_safe_unichar_to_utf16                           se_ref_safe_unichar_to_utf16
+#define se_safe_utf8_get_char                              se_ref_safe_utf8_get_char
+#define se_safe_utf16_get_char                             se_ref_safe_utf16_get_char
+#define se_utf8_str_len_sz                                 se_ref_utf8_str_len_sz
+#define se_utf8_str_len                                    se_ref_utf8_str_len
+#define se_utf16_str_len_sz                                se_ref_utf16_str_len_sz
+#define se_utf16_str_len                                   se_ref_utf16_str_len
+#define se_utf32_str_len_sz                                se_ref_utf32_str_len_sz
+#define se_utf32_str_len                                   se_ref_utf32_str_len
+#define se_is_valid_utf8_str_sz                            se_ref_is_valid_utf8_str_sz
+#define se_is_valid_utf8_str                               se_ref_is_valid_utf8_str
+#define se_is_valid_utf16_str_sz                           se_ref_is_valid_utf16_str_sz
+#define se_is_valid_utf16_str                              se_ref_is_valid_utf16_str
+#define se_is_valid_utf32_str_sz                           se_ref_is_valid_utf32_str_sz
+#define se_is_valid_utf32_str                              se_ref_is_valid_utf32_str
+#define se_utf8_str_copy                                   se_ref_utf8_str_copy
+#define se_utf16_str_copy                                  se_ref_utf16_str_copy
+#define se_utf32_str_copy                                  se_ref_utf32_str_copy
+#define se_unsafe_utf8_str_safe_copy_sz                    se_ref_unsafe_utf8_str_safe_copy_sz
+#define se_unsafe_utf8_str_safe_copy                       se_ref_unsafe_utf8_str_safe_copy
+#define se_unsafe_utf8_str_safe_copy_into                  se_ref_unsafe_utf8_str_safe_copy_into
+#define se_unsafe_utf16_str_safe_copy_sz                   se_ref_unsafe_utf16_str_safe_copy_sz
+#define se_unsafe_utf16_str_safe_copy                      se_ref_unsafe_utf16_str_safe_copy
+#define se_unsafe_utf32_str_safe_copy_sz                   se_ref_unsafe_utf32_str_safe_copy_sz
+#define se_unsafe_utf32_str_safe_copy                      se_ref_unsafe_utf32_str_safe_copy
+#define se_safe_utf8_str_char_count_sz                     se_ref_safe_utf8_str_char_count_sz
+#define se_safe_utf8_str_char_count                        se_ref_safe_utf8_str_char_count
+#define se_safe_utf16_str_char_count_sz                    se_ref_safe_utf16_str_char_count_sz
+#define se_safe_utf16_str_char_count                       se_ref_safe_utf16_str_char_count
+#define se_safe_utf32_str_char_count_sz                    se_ref_safe_utf32_str_char_count_sz
+#define se_safe_utf32_str_char_count                       se_ref_safe_utf32_str_char_count
+#define se_unsafe_utf8_to_safe_utf16_sz                    se_ref_unsafe_utf8_to_safe_utf16_sz
+#define se_unsafe_utf8_to_safe_utf16                       se_ref_unsafe_utf8_to_safe_utf16
+#define se_unsafe_utf8_to_safe_utf16_into                  se_ref_unsafe_utf8_to_safe_utf16_into
+#define se_unsafe_utf8_to_safe_utf16_batch                 se_ref_unsafe_utf8_to_safe_utf16_batch
+#define se_unsafe_utf16_to_safe_utf8_sz                    se_ref_unsafe_utf16_to_safe_utf8_sz
+#define se_unsafe_utf16_to_safe_utf8                       se_ref_unsafe_utf16_to_safe_utf8
+#define se_unsafe_utf16_to_safe_utf8_into                  se_ref_unsafe_utf16_to_safe_utf8_into
+#define se_unsafe_utf8_to_safe_utf32_sz                    se_ref_unsafe_utf8_to_safe_utf32_sz
+#define se_unsafe_utf8_to_safe_utf32                       se_ref_unsafe_utf8_to_safe_utf32
+#define se_unsafe_utf32_to_safe_utf8_sz                    se_ref_unsafe_utf32_to_safe_utf8_sz
+#define se_unsafe_utf32_to_safe_utf8                       se_ref_unsafe_utf32_to_safe_utf8
+#define se_unsafe_utf16_to_safe_utf32_sz                   se_ref_unsafe_utf16_to_safe_utf32_sz
+#define se_unsafe_utf16_to_safe_utf32                      se_ref_unsafe_utf16_to_safe_utf32
+#define se_unsafe_utf32_to_safe_utf16_sz                   se_ref_unsafe_utf32_to_safe_utf16_sz
+#define se_unsafe_utf32_to_safe_utf16                      se_ref_unsafe_utf32_to_safe_utf16
+#define se_unsafe_utf8_str_safe_copy_ex_sz                 se_ref_unsafe_utf8_str_safe_copy_ex_sz
+#define se_unsafe_utf8_str_safe_copy_ex                    se_ref_unsafe_utf8_str_safe_copy_ex
+#define se_unsafe_utf16_str_safe_copy_ex_sz                se_ref_unsafe_utf16_str_safe_copy_ex_sz
+#define se_unsafe_utf16_str_safe_copy_ex                   se_ref_unsafe_utf16_str_safe_copy_ex
+#define se_unsafe_utf32_str_safe_copy_ex_sz                se_ref_unsafe_utf32_str_safe_copy_ex_sz
+#define se_unsafe_utf32_str_safe_copy_ex                   se_ref_unsafe_utf32_str_safe_copy_ex
+#define se_unsafe_utf8_to_safe_utf16_ex_sz                 se_ref_unsafe_utf8_to_safe_utf16_ex_sz
+#define se_unsafe_utf8_to_safe_utf16_ex                    se_ref_unsafe_utf8_to_safe_utf16_ex
+#define se_unsafe_utf16_to_safe_utf8_ex_sz                 se_ref_unsafe_utf16_to_safe_utf8_ex_sz
+#define se_unsafe_utf16_to_safe_utf8_ex                    se_ref_unsafe_utf16_to_safe_utf8_ex
+#define se_unsafe_utf8_to_safe_utf32_ex_sz                 se_ref_unsafe_utf8_to_safe_utf32_ex_sz
+#define se_unsafe_utf8_to_safe_utf32_ex                    se_ref_unsafe_utf8_to_safe_utf32_ex
+#define se_unsafe_utf32_to_safe_utf8_ex_sz                 se_ref_unsafe_utf32_to_safe_utf8_ex_sz
+#define se_unsafe_utf32_to_safe_utf8_ex                    se_ref_unsafe_utf32_to_safe_utf8_ex
+#define se_unsafe_utf16_to_safe_utf32_ex_sz                se_ref_unsafe_utf16_to_safe_utf32_ex_sz
+#define se_unsafe_utf16_to_safe_utf32_ex                   se_ref_unsafe_utf16_to_safe_utf32_ex
+#define se_unsafe_utf32_to_safe_utf16_ex_sz                se_ref_unsafe_utf32_to_safe_utf16_ex_sz
+#define se_unsafe_utf32_to_safe_utf16_ex                   se_ref_unsafe_utf32_to_safe_utf16_ex
+#define se_safe_utf8_to_utf16_sz                           se_ref_safe_utf8_to_utf16_sz
+#define se_safe_utf8_to_utf16                              se_ref_safe_utf8_to_utf16
+#define se_safe_utf16_to_utf8_sz                           se_ref_safe_utf16_to_utf8_sz
+#define se_safe_utf16_to_utf8                              se_ref_safe_utf16_to_utf8
+#define se_safe_utf8_to_utf32_sz                           se_ref_safe_utf8_to_utf32_sz
+#define se_safe_utf8_to_utf32                              se_ref_safe_utf8_to_utf32
+#define se_safe_utf32_to_utf8_sz                           se_ref_safe_utf32_to_utf8_sz
+#define se_safe_utf32_to_utf8                              se_ref_safe_utf32_to_utf8
+#define se_safe_utf16_to_utf32_sz                          se_ref_safe_utf16_to_utf32_sz
+#define se_safe_utf16_to_utf32                             se_ref_safe_utf16_to_utf32
+#define se_safe_utf32_to_utf16_sz                          se_ref_safe_utf32_to_utf16_sz
+#define se_safe_utf32_to_utf16                             se_ref_safe_utf32_to_utf16
+#define se_is_ascii_str_sz                                 se_ref_is_ascii_str_sz
+#define se_is_ascii_str                                    se_ref_is_ascii_str
+#define se_is_ascii_utf16_str_sz                           se_ref_is_ascii_utf16_str_sz
+#define se_is_ascii_utf16_str                              se_ref_is_ascii_utf16_str
+#define se_is_latin1_utf8_str_sz                           se_ref_is_latin1_utf8_str_sz
+#define se_is_latin1_utf8_str                              se_ref_is_latin1_utf8_str
+#define se_is_latin1_utf16_str_sz                          se_ref_is_latin1_utf16_str_sz
+#define se_is_latin1_utf16_str                             se_ref_is_latin1_utf16_str
+#define se_latin1_to_utf8_sz                               se_ref_latin1_to_utf8_sz
+#define se_latin1_to_utf8                                  se_ref_latin1_to_utf8
+#define se_latin1_to_utf8_into                             se_ref_latin1_to_utf8_into
+#define se_latin1_to_utf16_sz                              se_ref_latin1_to_utf16_sz
+#define se_latin1_to_utf16                                 se_ref_latin1_to_utf16
+#define se_latin1_to_utf16_into                            se_ref_latin1_to_utf16_into
+#define se_safe_utf8_to_latin1_sz                          se_ref_safe_utf8_to_latin1_sz
+#define se_safe_utf8_to_latin1                             se_ref_safe_utf8_to_latin1
+#define se_safe_utf8_to_latin1_into                        se_ref_safe_utf8_to_latin1_into
+#define se_safe_utf16_to_latin1_sz                         se_ref_safe_utf16_to_latin1_sz
+#define se_safe_utf16_to_latin1                            se_ref_safe_utf16_to_latin1
+#define se_safe_utf16_to_latin1_into                       se_ref_safe_utf16_to_latin1_into
+#define se_utf8_strcmp_ignore_ascii_case                   se_ref_utf8_strcmp_ignore_ascii_case
+#define se_utf8_strcmp_n_ignore_ascii_case                 se_ref_utf8_strcmp_n_ignore_ascii_case
+#define se_utf8_strcmp_ignore_space_and_ascii_case         se_ref_utf8_strcmp_ignore_space_and_ascii_case
+#define se_utf8_strstr_ignore_space_and_ascii_case         se_ref_utf8_strstr_ignore_space_and_ascii_case
+#define se_utf8_str_hash                                   se_ref_utf8_str_hash
+#define se_utf8_strdup                                     se_ref_utf8_strdup
+#define se_utf8_strdup_n                                   se_ref_utf8_strdup_n
+#define se_safe_utf8_next_char                             se_ref_safe_utf8_next_char
+#define se_safe_utf8_prev_char                             se_ref_safe_utf8_prev_char
+#define se_safe_utf8_offset_to_pointer                     se_ref_safe_utf8_offset_to_pointer
+#define se_safe_utf8_str_last_chars                        se_ref_safe_utf8_str_last_chars
+#define se_safe_utf8_str_truncate                          se_ref_safe_utf8_str_truncate
+#define se_safe_utf8_str_truncate_chars                    se_ref_safe_utf8_str_truncate_chars
+#define se_safe_utf8_pointer_to_offset                     se_ref_safe_utf8_pointer_to_offset
+#define se_utf8_index_new                                  se_ref_utf8_index_new
+#define se_utf8_index_free                                 se_ref_utf8_index_free
+#define se_utf8_index_append                               se_ref_utf8_index_append
+#define se_utf8_index_char_count                           se_ref_utf8_index_char_count
+#define se_utf8_index_offset_to_pointer                    se_ref_utf8_index_offset_to_pointer
+#define se_utf8_index_pointer_to_offset                    se_ref_utf8_index_pointer_to_offset
+#define se_ustr_new_sz                                     se_ref_ustr_new_sz
+#define se_ustr_new                                        se_ref_ustr_new
+#define se_ustr_ref                                        se_ref_ustr_ref
+#define se_ustr_unref                                      se_ref_ustr_unref
+#define se_ustr_slice_sz                                   se_ref_ustr_slice_sz
+#define se_ustr_slice                                      se_ref_ustr_slice
+#define se_ustr_str                                        se_ref_ustr_str
+#define se_ustr_len_sz                                     se_ref_ustr_len_sz
+#define se_ustr_len                                        se_ref_ustr_len
+#define se_ustr_char_count_sz                              se_ref_ustr_char_count_sz
+#define se_ustr_char_count                                 se_ref_ustr_char_count
+#define se_ustr_hash                                       se_ref_ustr_hash
+#define se_ustr_is_ascii                                   se_ref_ustr_is_ascii
+#define se_ustr_equal                                      se_ref_ustr_equal
+#define se_safe_utf8_utf16_len                             se_ref_safe_utf8_utf16_len
+#define se_safe_utf16_utf8_len                             se_ref_safe_utf16_utf8_len
+#define se_safe_utf8_utf16_offset_to_byte_offset           se_ref_safe_utf8_utf16_offset_to_byte_offset
+#define se_safe_utf8_byte_offsets_to_utf16_offsets         se_ref_safe_utf8_byte_offsets_to_utf16_offsets
+#define se_safe_utf8_utf16_offsets_to_byte_offsets         se_ref_safe_utf8_utf16_offsets_to_byte_offsets
+#define se_utf16_strcmp                                    se_ref_utf16_strcmp
+#define se_utf16_strncmp                                   se_ref_utf16_strncmp
+#define se_utf16_strcmp_code_point_order                   se_ref_utf16_strcmp_code_point_order
+#define se_utf16_strncmp_code_point_order                  se_ref_utf16_strncmp_code_point_order
+#define se_utf16_strdup                                    se_ref_utf16_strdup
+#define se_utf16_strdup_n                                  se_ref_utf16_strdup_n
+#define se_safe_utf16_str_truncate                         se_ref_safe_utf16_str_truncate
+#define se_safe_utf16_next_char                            se_ref_safe_utf16_next_char
+#define se_safe_utf16_prev_char                            se_ref_safe_utf16_prev_char
+#define se_safe_utf16_offset_to_pointer                    se_ref_safe_utf16_offset_to_pointer
+#define se_safe_utf16_pointer_to_offset                    se_ref_safe_utf16_pointer_to_offset
+#define se_utf32_strdup                                    se_ref_utf32_strdup
+#define se_utf32_strdup_n                                  se_ref_utf32_strdup_n
+#define se_utf8_str_find_char                              se_ref_utf8_str_find_char
+#define se_utf16_str_find_char                             se_ref_utf16_str_find_char
+#define se_utf32_str_find_char                             se_ref_utf32_str_find_char
+#define se_safe_utf8_str_find_unichar                      se_ref_safe_utf8_str_find_unichar
+#define se_safe_utf16_str_find_unichar                     se_ref_safe_utf16_str_find_unichar
+#define se_utf8_str_find_str                               se_ref_utf8_str_find_str
+#define se_utf16_str_find_str                              se_ref_utf16_str_find_str
+#define se_utf32_str_find_str                              se_ref_utf32_str_find_str
+#define se_safe_utf8_str_find_any                          se_ref_safe_utf8_str_find_any
+#define se_safe_utf16_str_find_any                         se_ref_safe_utf16_str_find_any
+#define se_utf32_str_find_any                              se_ref_utf32_str_find_any
+#define se_is_valid_utf16be_str_sz                         se_ref_is_valid_utf16be_str_sz
+#define se_is_valid_utf16be_str                            se_ref_is_valid_utf16be_str
+#define se_unsafe_utf16be_to_safe_utf8_sz                  se_ref_unsafe_utf16be_to_safe_utf8_sz
+#define se_unsafe_utf16be_to_safe_utf8                     se_ref_unsafe_utf16be_to_safe_utf8
+#define se_unsafe_utf16be_to_safe_utf16_sz                 se_ref_unsafe_utf16be_to_safe_utf16_sz
+#define se_unsafe_utf16be_to_safe_utf16                    se_ref_unsafe_utf16be_to_safe_utf16
+#define se_unsafe_utf16be_to_safe_utf32_sz                 se_ref_unsafe_utf16be_to_safe_utf32_sz
+#define se_unsafe_utf16be_to_safe_utf32                    se_ref_unsafe_utf16be_to_safe_utf32
+#define se_safe_utf8_to_utf16be_sz                         se_ref_safe_utf8_to_utf16be_sz
+#define se_safe_utf8_to_utf16be                            se_ref_safe_utf8_to_utf16be
+#define se_safe_utf16_to_utf16be_sz                        se_ref_safe_utf16_to_utf16be_sz
+#define se_safe_utf16_to_utf16be                           se_ref_safe_utf16_to_utf16be
+#define se_safe_utf32_to_utf16be_sz                        se_ref_safe_utf32_to_utf16be_sz
+#define se_safe_utf32_to_utf16be                           se_ref_safe_utf32_to_utf16be
+#define se_is_valid_utf16le_str_sz                         se_ref_is_valid_utf16le_str_sz
+#define se_is_valid_utf16le_str                            se_ref_is_valid_utf16le_str
+#define se_unsafe_utf16le_to_safe_utf8_sz                  se_ref_unsafe_utf16le_to_safe_utf8_sz
+#define se_unsafe_utf16le_to_safe_utf8                     se_ref_unsafe_utf16le_to_safe_utf8
+#define se_unsafe_utf16le_to_safe_utf16_sz                 se_ref_unsafe_utf16le_to_safe_utf16_sz
+#define se_unsafe_utf16le_to_safe_utf16                    se_ref_unsafe_utf16le_to_safe_utf16
+#define se_unsafe_utf16le_to_safe_utf32_sz                 se_ref_unsafe_utf16le_to_safe_utf32_sz
+#define se_unsafe_utf16le_to_safe_utf32                    se_ref_unsafe_utf16le_to_safe_utf32
+#define se_safe_utf8_to_utf16le_sz                         se_ref_safe_utf8_to_utf16le_sz
+#define se_safe_utf8_to_utf16le                            se_ref_safe_utf8_to_utf16le
+#define se_safe_utf16_to_utf16le_sz                        se_ref_safe_utf16_to_utf16le_sz
+#define se_safe_utf16_to_utf16le                           se_ref_safe_utf16_to_utf16le
+#define se_safe_utf32_to_utf16le_sz                        se_ref_safe_utf32_to_utf16le_sz
+#define se_safe_utf32_to_utf16le                           se_ref_safe_utf32_to_utf16le
+#define se_is_valid_utf32be_str_sz                         se_ref_is_valid_utf32be_str_sz
+#define se_is_valid_utf32be_str                            se_ref_is_valid_utf32be_str
+#define se_unsafe_utf32be_to_safe_utf8_sz                  se_ref_unsafe_utf32be_to_safe_utf8_sz
+#define se_unsafe_utf32be_to_safe_utf8                     se_ref_unsafe_utf32be_to_safe_utf8
+#define se_unsafe_utf32be_to_safe_utf16_sz                 se_ref_unsafe_utf32be_to_safe_utf16_sz
+#define se_unsafe_utf32be_to_safe_utf16                    se_ref_unsafe_utf32be_to_safe_utf16
+#define se_unsafe_utf32be_to_safe_utf32_sz                 se_ref_unsafe_utf32be_to_safe_utf32_sz
+#define se_unsafe_utf32be_to_safe_utf32                    se_ref_unsafe_utf32be_to_safe_utf32
+#define se_safe_utf8_to_utf32be_sz                         se_ref_safe_utf8_to_utf32be_sz
+#define se_safe_utf8_to_utf32be                            se_ref_safe_utf8_to_utf32be
+#define se_safe_utf16_to_utf32be_sz                        se_ref_safe_utf16_to_utf32be_sz
+#define se_safe_utf16_to_utf32be                           se_ref_safe_utf16_to_utf32be
+#define se_safe_utf32_to_utf32be_sz                        se_ref_safe_utf32_to_utf32be_sz
+#define se_safe_utf32_to_utf32be                           se_ref_safe_utf32_to_utf32be
+#define se_is_valid_utf32le_str_sz                         se_ref_is_valid_utf32le_str_sz
+#define se_is_valid_utf32le_str                            se_ref_is_valid_utf32le_str
+#define se_unsafe_utf32le_to_safe_utf8_sz                  se_ref_unsafe_utf32le_to_safe_utf8_sz
+#define se_unsafe_utf32le_to_safe_utf8                     se_ref_unsafe_utf32le_to_safe_utf8
+#define se_unsafe_utf32le_to_safe_utf16_sz                 se_ref_unsafe_utf32le_to_safe_utf16_sz
+#define se_unsafe_utf32le_to_safe_utf16                    se_ref_unsafe_utf32le_to_safe_utf16
+#define se_unsafe_utf32le_to_safe_utf32_sz                 se_ref_unsafe_utf32le_to_safe_utf32_sz
+#define se_unsafe_utf32le_to_safe_utf32                    se_ref_unsafe_utf32le_to_safe_utf32
+#define se_safe_utf8_to_utf32le_sz                         se_ref_safe_utf8_to_utf32le_sz
+#define se_safe_utf8_to_utf32le                            se_ref_safe_utf8_to_utf32le
+#define se_safe_utf16_to_utf32le_sz                        se_ref_safe_utf16_to_utf32le_sz
+#define se_safe_utf16_to_utf32le                           se_ref_safe_utf16_to_utf32le
+#define se_safe_utf32_to_utf32le_sz                        se_ref_safe_utf32_to_utf32le_sz
+#define se_safe_utf32_to_utf32le                           se_ref_safe_utf32_to_utf32le
+#define se_unsafe_gb18030_to_safe_utf8_sz                  se_ref_unsafe_gb18030_to_safe_utf8_sz
+#define se_unsafe_gb18030_to_safe_utf8                     se_ref_unsafe_gb18030_to_safe_utf8
+#define se_unsafe_gb18030_to_safe_utf8_stream              se_ref_unsafe_gb18030_to_safe_utf8_stream
+#define se_unsafe_gb18030_to_safe_utf16_sz                 se_ref_unsafe_gb18030_to_safe_utf16_sz
+#define se_unsafe_gb18030_to_safe_utf16                    se_ref_unsafe_gb18030_to_safe_utf16
+#define se_unsafe_gb18030_to_safe_utf16_stream             se_ref_unsafe_gb18030_to_safe_utf16_stream
+#define se_safe_utf8_to_gb18030_sz                         se_ref_safe_utf8_to_gb18030_sz
+#define se_safe_utf8_to_gb18030                            se_ref_safe_utf8_to_gb18030
+#define se_safe_utf16_to_gb18030_sz                        se_ref_safe_utf16_to_gb18030_sz
+#define se_safe_utf16_to_gb18030                           se_ref_safe_utf16_to_gb18030
+#define se_unsafe_shift_jis_to_safe_utf8_sz                se_ref_unsafe_shift_jis_to_safe_utf8_sz
+#define se_unsafe_shift_jis_to_safe_utf8                   se_ref_unsafe_shift_jis_to_safe_utf8
+#define se_unsafe_shift_jis_to_safe_utf8_stream            se_ref_unsafe_shift_jis_to_safe_utf8_stream
+#define se_unsafe_shift_jis_to_safe_utf16_sz               se_ref_unsafe_shift_jis_to_safe_utf16_sz
+#define se_unsafe_shift_jis_to_safe_utf16                  se_ref_unsafe_shift_jis_to_safe_utf16
+#define se_unsafe_shift_jis_to_safe_utf16_stream           se_ref_unsafe_shift_jis_to_safe_utf16_stream
+#define se_safe_utf8_to_shift_jis_sz                       se_ref_safe_utf8_to_shift_jis_sz
+#define se_safe_utf8_to_shift_jis                          se_ref_safe_utf8_to_shift_jis
+#define se_safe_utf16_to_shift_jis_sz                      se_ref_safe_utf16_to_shift_jis_sz
+#define se_safe_utf16_to_shift_jis                         se_ref_safe_utf16_to_shift_jis
+#define se_unsafe_euc_kr_to_safe_utf8_sz                   se_ref_unsafe_euc_kr_to_safe_utf8_sz
+#define se_unsafe_euc_kr_to_safe_utf8                      se_ref_unsafe_euc_kr_to_safe_utf8
+#define se_unsafe_euc_kr_to_safe_utf8_stream               se_ref_unsafe_euc_kr_to_safe_utf8_stream
+#define se_unsafe_euc_kr_to_safe_utf16_sz                  se_ref_unsafe_euc_kr_to_safe_utf16_sz
+#define se_unsafe_euc_kr_to_safe_utf16                     se_ref_unsafe_euc_kr_to_safe_utf16
+#define se_unsafe_euc_kr_to_safe_utf16_stream              se_ref_unsafe_euc_kr_to_safe_utf16_stream
+#define se_safe_utf8_to_euc_kr_sz                          se_ref_safe_utf8_to_euc_kr_sz
+#define se_safe_utf8_to_euc_kr                             se_ref_safe_utf8_to_euc_kr
+#define se_safe_utf16_to_euc_kr_sz                         se_ref_safe_utf16_to_euc_kr_sz
+#define se_safe_utf16_to_euc_kr                            se_ref_safe_utf16_to_euc_kr
+#define se_unsafe_big5_to_safe_utf8_sz                     se_ref_unsafe_big5_to_safe_utf8_sz
+#define se_unsafe_big5_to_safe_utf8                        se_ref_unsafe_big5_to_safe_utf8
+#define se_unsafe_big5_to_safe_utf8_stream                 se_ref_unsafe_big5_to_safe_utf8_stream
+#define se_unsafe_big5_to_safe_utf16_sz                    se_ref_unsafe_big5_to_safe_utf16_sz
+#define se_unsafe_big5_to_safe_utf16                       se_ref_unsafe_big5_to_safe_utf16
+#define se_unsafe_big5_to_safe_utf16_stream                se_ref_unsafe_big5_to_safe_utf16_stream
+#define se_safe_utf8_to_big5_sz                            se_ref_safe_utf8_to_big5_sz
+#define se_safe_utf8_to_big5                               se_ref_safe_utf8_to_big5
+#define se_safe_utf16_to_big5_sz                           se_ref_safe_utf16_to_big5_sz
+#define se_safe_utf16_to_big5                              se_ref_safe_utf16_to_big5
+#define se_detect_encoding_sz                              se_ref_detect_encoding_sz
+#define se_detect_encoding                                 se_ref_detect_encoding
+#define se_is_valid_wtf8_str_sz                            se_ref_is_valid_wtf8_str_sz
+#define se_is_valid_wtf8_str                               se_ref_is_valid_wtf8_str
+#define se_unsafe_wtf8_to_utf16_sz                         se_ref_unsafe_wtf8_to_utf16_sz
+#define se_unsafe_wtf8_to_utf16                            se_ref_unsafe_wtf8_to_utf16
+#define se_unsafe_wtf8_to_safe_utf16_sz                    se_ref_unsafe_wtf8_to_safe_utf16_sz
+#define se_unsafe_wtf8_to_safe_utf16                       se_ref_unsafe_wtf8_to_safe_utf16
+#define se_unsafe_wtf8_to_safe_utf8_sz                     se_ref_unsafe_wtf8_to_safe_utf8_sz
+#define se_unsafe_wtf8_to_safe_utf8                        se_ref_unsafe_wtf8_to_safe_utf8
+#define se_utf16_to_wtf8_sz                                se_ref_utf16_to_wtf8_sz
+#define se_utf16_to_wtf8                                   se_ref_utf16_to_wtf8
+#define se_is_valid_cesu8_str_sz                           se_ref_is_valid_cesu8_str_sz
+#define se_is_valid_cesu8_str                              se_ref_is_valid_cesu8_str
+#define se_unsafe_cesu8_to_safe_utf8_sz                    se_ref_unsafe_cesu8_to_safe_utf8_sz
+#define se_unsafe_cesu8_to_safe_utf8                       se_ref_unsafe_cesu8_to_safe_utf8
+#define se_unsafe_cesu8_to_safe_utf16_sz                   se_ref_unsafe_cesu8_to_safe_utf16_sz
+#define se_unsafe_cesu8_to_safe_utf16                      se_ref_unsafe_cesu8_to_safe_utf16
+#define se_safe_utf8_to_cesu8_sz                           se_ref_safe_utf8_to_cesu8_sz
+#define se_safe_utf8_to_cesu8                              se_ref_safe_utf8_to_cesu8
+#define se_safe_utf16_to_cesu8_sz                          se_ref_safe_utf16_to_cesu8_sz
+#define se_safe_utf16_to_cesu8                             se_ref_safe_utf16_to_cesu8
+#define se_is_valid_mutf8_str_sz                           se_ref_is_valid_mutf8_str_sz
+#define se_is_valid_mutf8_str                              se_ref_is_valid_mutf8_str
+#define se_unsafe_mutf8_to_utf16_sz                        se_ref_unsafe_mutf8_to_utf16_sz
+#define se_unsafe_mutf8_to_utf16                           se_ref_unsafe_mutf8_to_utf16
+#define se_unsafe_mutf8_to_safe_utf16_sz                   se_ref_unsafe_mutf8_to_safe_utf16_sz
+#define se_unsafe_mutf8_to_safe_utf16                      se_ref_unsafe_mutf8_to_safe_utf16
+#define se_unsafe_mutf8_to_safe_utf8_sz                    se_ref_unsafe_mutf8_to_safe_utf8_sz
+#define se_unsafe_mutf8_to_safe_utf8                       se_ref_unsafe_mutf8_to_safe_utf8
+#define se_utf16_to_mutf8_sz                               se_ref_utf16_to_mutf8_sz
+#define se_utf16_to_mutf8                                  se_ref_utf16_to_mutf8
+#define se_safe_utf8_to_mutf8_sz                           se_ref_safe_utf8_to_mutf8_sz
+#define se_safe_utf8_to_mutf8                              se_ref_safe_utf8_to_mutf8
+
+#include "../se-unicode-string.c"
+#include "../se-unicode-endian.c"
+#include "../se-unicode-mbcs.c"
+#include "../se-unicode-variants.c"
@@ -0,0 +1,347 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+/*
+ * se-train: training workload for profile guided builds.
+ *
+ *     se-train [-s SIZE] [-n ROUNDS] [-v] PROFILE
+ *
+ *     -s SIZE     Size in bytes of UTF-8 of each corpus (default 256 KiB).
+ *     -n ROUNDS   Number of passes over the corpora (default 8).
+ *     -v          Print the time spent.
+ *
+ * PROFILE is the traffic the profile guided build is tuned for:
+ *
+ *     ascii-heavy Mostly ASCII and Latin text, such as markup, logs and
+ *                 western languages.
+ *     cjk-heavy   Mostly CJK ideographs with embedded ASCII.
+ *     mixed       Many scripts in short runs, with some emoji and a few
+ *                 ill-formed strings.
+ *
+ * The branch layout of the conversion routines follows the script mix of
+ * the training input, so a build should be trained with the profile that
+ * matches the traffic of its deployment. Each corpus of a profile gets a
+ * share of the passes by its weight. A pass runs the functions once over
+ * the whole corpus and once over short strings cut from it, as most
+ * strings met in practice are short.
+ */
+
+#ifndef SE_UNICODE_H
+    #include "se-unicode.h"
+#endif
+
+#ifndef SE_UTILS_H
+    #include "se-utils.h"
+#endif
+
+#ifndef SE_UNICODE_EXT_H
+    #include "se-unicode-ext.h"
+#endif
+
+#ifndef SE_CORPUS_H
+    #include "se-corpus.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/***************************************************************************
+ *                                                                         *
+ * Profiles.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#define SE_TRAIN_MAX_MIXES      4
+
+typedef struct se_train_mix se_train_mix;
+
+struct se_train_mix
+{
+    const char* preset;     /* se_corpus_options_init() preset */
+    int weight;             /* Share of the calls in percent */
+    int error_ppm;          /* Ill-formed characters per million */
+};
+
+typedef struct se_train_profile se_train_profile;
+
+struct se_train_profile
+{
+    const char* name;
+    se_train_mix mixes[SE_TRAIN_MAX_MIXES];
+};
+
+static const se_train_profile se_train_profiles[] =
+{
+    { "ascii-heavy", { { "ascii", 70, 0 }, { "latin", 20, 0 }, { "mixed", 7, 0 }, { "emoji", 3, 100 } } },
+    { "cjk-heavy", { { "cjk", 70, 0 }, { "ascii", 15, 0 }, { "mixed", 10, 0 }, { "emoji", 5, 100 } } },
+    { "mixed", { { "mixed", 55, 0 }, { "ascii", 20, 0 }, { "cjk", 10, 0 }, { "emoji", 10, 100 } } },
+};
+
+/***************************************************************************
+ *                                                                         *
+ * Workload.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+typedef struct se_train_corpus se_train_corpus;
+
+struct se_train_corpus
+{
+    const se_train_mix* mix;
+
+    /* Un-safe strings as generated */
+    seunichar8* u8;
+    ptrdiff_t u8_len;
+    seunichar16* u16;
+    ptrdiff_t u16_len;
+    seunichar32* u32;
+    ptrdiff_t u32_len;
+
+    /* The same strings repaired */
+    seunichar8* safe_u8;
+    ptrdiff_t safe_u8_len;
+    seunichar16* safe_u16;
+    ptrdiff_t safe_u16_len;
+};
+
+/* Results are folded in here so the calls cannot be optimized away */
+static volatile ptrdiff_t se_train_sink;
+
+static void se_train_make_corpus(se_train_corpus* corpus, const se_train_mix* mix, ptrdiff_t size)
+{
+    se_corpus_options options;
+
+    corpus->mix = mix;
+
+    se_corpus_options_init(&options, mix->preset);
+    se_corpus_set_error_rate(&options, mix->error_ppm);
+
+    corpus->u8 = se_corpus_generate(&options, SE_CORPUS_UTF8, size, &corpus->u8_len);
+    corpus->u16 = se_corpus_generate(&options, SE_CORPUS_UTF16, size, &corpus->u16_len);
+    corpus->u32 = se_corpus_generate(&options, SE_CORPUS_UTF32, size, &corpus->u32_len);
+
+    corpus->safe_u8 = se_unsafe_utf8_str_safe_copy_sz(corpus->u8, corpus->u8_len, &corpus->safe_u8_len);
+    corpus->safe_u16 = se_unsafe_utf16_str_safe_copy_sz(corpus->u16, corpus->u16_len, &corpus->safe_u16_len);
+}
+
+static void se_train_free_corpus(se_train_corpus* corpus)
+{
+    SE_FREE(corpus->u8);
+    SE_FREE(corpus->u16);
+    SE_FREE(corpus->u32);
+    SE_FREE(corpus->safe_u8);
+    SE_FREE(corpus->safe_u16);
+}
+
+static void se_train_u8(const seunichar8* str, ptrdiff_t len, const seunichar8* safe_str, ptrdiff_t safe_len)
+{
+    ptrdiff_t out_len;
+
+    se_train_sink += se_is_valid_utf8_str_sz(str, len);
+    SE_FREE(se_unsafe_utf8_str_safe_copy_sz(str, len, &out_len));
+    SE_FREE(se_unsafe_utf8_to_safe_utf16_sz(str, len, &out_len));
+    SE_FREE(se_unsafe_utf8_to_safe_utf32_sz(str, len, &out_len));
+
+    se_train_sink += se_safe_utf8_str_char_count_sz(safe_str, safe_len);
+    se_train_sink += se_safe_utf8_utf16_len(safe_str, (int) safe_len);
+    se_train_sink += se_utf8_str_find_char(safe_str, (int) safe_len, '<') != 0;
+    SE_FREE(se_safe_utf8_to_utf16_sz(safe_str, safe_len, &out_len));
+    SE_FREE(se_safe_utf8_to_utf32_sz(safe_str, safe_len, &out_len));
+}
+
+static void se_train_u16(const seunichar16* str, ptrdiff_t len, const seunichar16* safe_str, ptrdiff_t safe_len)
+{
+    ptrdiff_t out_len;
+
+    se_train_sink += se_is_valid_utf16_str_sz(str, len);
+    SE_FREE(se_unsafe_utf16_str_safe_copy_sz(str, len, &out_len));
+    SE_FREE(se_unsafe_utf16_to_safe_utf8_sz(str, len, &out_len));
+    SE_FREE(se_unsafe_utf16_to_safe_utf32_sz(str, len, &out_len));
+
+    se_train_sink += se_safe_utf16_str_char_count_sz(safe_str, safe_len);
+    se_train_sink += se_safe_utf16_utf8_len(safe_str, (int) safe_len);
+    se_train_sink += se_utf16_str_find_char(safe_str, (int) safe_len, '<') != 0;
+    SE_FREE(se_safe_utf16_to_utf8_sz(safe_str, safe_len, &out_len));
+    SE_FREE(se_safe_utf16_to_utf32_sz(safe_str, safe_len, &out_len));
+}
+
+static void se_train_u32(const seunichar32* str, ptrdiff_t len)
+{
+    ptrdiff_t out_len;
+
+    se_train_sink += se_is_valid_utf32_str_sz(str, len);
+    SE_FREE(se_unsafe_utf32_to_safe_utf8_sz(str, len, &out_len));
+    SE_FREE(se_unsafe_utf32_to_safe_utf16_sz(str, len, &out_len));
+}
+
+static void se_train_whole(const se_train_corpus* c)
+{
+    se_train_u8(c->u8, c->u8_len, c->safe_u8, c->safe_u8_len);
+    se_train_u16(c->u16, c->u16_len, c->safe_u16, c->safe_u16_len);
+    se_train_u32(c->u32, c->u32_len);
+
+    se_train_sink += se_safe_utf8_offset_to_pointer(c->safe_u8, (int) (c->u32_len / 2)) - c->safe_u8;
+    se_train_sink += se_utf16_strcmp(c->safe_u16, c->u16);
+}
+
+static void se_train_short(const se_train_corpus* c, unsigned int* state)
+/*
+ * Strings of 1 to 512 bytes. The un-safe ones are cut anywhere, the safe
+ * ones at character boundaries.
+ */
+{
+    const seunichar8* u8;
+    const seunichar16* u16;
+    const seunichar8* safe_u8;
+    const seunichar8* safe_u8_end;
+    const seunichar16* safe_u16;
+    const seunichar16* safe_u16_end;
+    ptrdiff_t u8_len;
+    ptrdiff_t u16_len;
+    ptrdiff_t unsafe_len;
+    ptrdiff_t len;
+
+    u8 = c->u8;
+    u16 = c->u16;
+    safe_u8 = c->safe_u8;
+    safe_u16 = c->safe_u16;
+    safe_u8_end = c->safe_u8 + c->safe_u8_len;
+    safe_u16_end = c->safe_u16 + c->safe_u16_len;
+
+    while (safe_u8 < safe_u8_end && safe_u16 < safe_u16_end)
+    {
+        *state ^= *state << 13;
+        *state ^= *state >> 17;
+        *state ^= *state << 5;
+        len = 1 + (ptrdiff_t) (*state % 512);
+
+        u8_len = len;
+        if (u8_len > safe_u8_end - safe_u8)
+            u8_len = safe_u8_end - safe_u8;
+        while (u8_len < safe_u8_end - safe_u8 && (safe_u8[u8_len] & 0xC0) == 0x80)
+            u8_len++;
+
+        u16_len = len / 2 + 1;
+        if (u16_len > safe_u16_end - safe_u16)
+            u16_len = safe_u16_end - safe_u16;
+        if (u16_len < safe_u16_end - safe_u16 && (safe_u16[u16_len] & 0xFC00) == 0xDC00)
+            u16_len++;
+
+        /* The un-safe strings take as many units, where they are long enough */
+        unsafe_len = c->u8 + c->u8_len - u8;
+        if (unsafe_len > u8_len)
+            unsafe_len = u8_len;
+        se_train_u8(u8, unsafe_len, safe_u8, u8_len);
+        u8 += unsafe_len;
+
+        unsafe_len = c->u16 + c->u16_len - u16;
+        if (unsafe_len > u16_len)
+            unsafe_len = u16_len;
+        se_train_u16(u16, unsafe_len, safe_u16, u16_len);
+        u16 += unsafe_len;
+
+        safe_u8 += u8_len;
+        safe_u16 += u16_len;
+    }
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Main.                                                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+static int usage(void)
+{
+    fputs("usage: se-train [-s SIZE] [-n ROUNDS] [-v] ascii-heavy|cjk-heavy|mixed\n", stderr);
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    se_train_corpus corpora[SE_TRAIN_MAX_MIXES];
+    const se_train_profile* profile;
+    ptrdiff_t size;
+    unsigned int state;
+    double start;
+    int corpus_count;
+    int rounds;
+    int verbose;
+    int calls;
+    int i;
+    int j;
+    int k;
+    struct timespec ts;
+
+    size = 256 * 1024;
+    rounds = 8;
+    verbose = 0;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            size = atol(argv[++i]);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            rounds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-v") == 0)
+            verbose = 1;
+        else
+            return usage();
+    }
+
+    if (i + 1 != argc)
+        return usage();
+
+    if (size < 16 || size > 0x7FFFFFFF / 4)
+    {
+        fputs("se-train: size out of range\n", stderr);
+        return 2;
+    }
+
+    profile = 0;
+    for (j = 0; j < (int) (sizeof(se_train_profiles) / sizeof(se_train_profiles[0])); j++)
+    {
+        if (strcmp(argv[i], se_train_profiles[j].name) == 0)
+            profile = &se_train_profiles[j];
+    }
+
+    if (!profile)
+        return usage();
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    start = ts.tv_sec + ts.tv_nsec * 1e-9;
+
+    corpus_count = 0;
+    for (j = 0; j < SE_TRAIN_MAX_MIXES && profile->mixes[j].preset; j++)
+        se_train_make_corpus(&corpora[corpus_count++], &profile->mixes[j], size);
+
+    /* Each corpus gets a number of passes per round by its weight */
+    state = 20071;
+    for (i = 0; i < rounds; i++)
+    {
+        for (j = 0; j < corpus_count; j++)
+        {
+            calls = corpora[j].mix->weight / 5 + 1;
+            for (k = 0; k < calls; k++)
+            {
+                se_train_whole(&corpora[j]);
+                se_train_short(&corpora[j], &state);
+            }
+        }
+    }
+
+    for (j = 0; j < corpus_count; j++)
+        se_train_free_corpus(&corpora[j]);
+
+    if (verbose)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        fprintf(stderr, "se-train: %s, %d rounds in %.2f s\n", profile->name, rounds, ts.tv_sec + ts.tv_nsec * 1e-9 - start);
+    }
+
+    return 0;
+}
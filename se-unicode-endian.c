@@ -0,0 +1,1821 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+#ifndef SE_UNICODE_H
+    #include "se-unicode.h"
+#endif
+
+#ifndef SE_UTILS_H
+    #include "se-utils.h"
+#endif
+
+#ifndef SE_UNICODE_EXT_H
+    #include "se-unicode-ext.h"
+#endif
+
+/*
+ * Conversion between Unicode in host byte order and UTF-16BE, UTF-16LE,
+ * UTF-32BE and UTF-32LE byte strings.
+ *
+ * The seunichar16 and seunichar32 strings of se-unicode-string.c are in
+ * host byte order. Text from files and the network is in a byte order of
+ * its own, and is taken here as a byte string with its byte length, so
+ * it needs no byte swapped copy before it is converted. No byte order
+ * mark is read or written.
+ *
+ * Byte strings are un-safe input: an ill-formed code unit is replaced by
+ * U+FFFD as by se_unsafe_utf16_to_safe_utf8(), and so are the 1 to 3
+ * bytes of an incomplete code unit at the end. Unicode input must be
+ * safe. A NUL terminated byte string ends with a whole NUL code unit,
+ * and the byte strings returned are terminated the same way.
+ *
+ * As in se-unicode-string.c, the output length is counted by a first
+ * pass, and the output is allocated at its exact size. With SSE2, runs of
+ * 8 code units of the BMP are loaded at once, and the byte swap, on a
+ * little endian host, is done on the loaded vector.
+ */
+
+/* As in se-unicode-string.c */
+#ifndef SE_OPT_SSE2
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define SE_OPT_SSE2 1
+    #else
+        #define SE_OPT_SSE2 0
+    #endif
+#endif
+
+#if SE_OPT_SSE2
+    #include <emmintrin.h>
+#endif
+
+#define SE_REPLACEMENT_CHAR                 0xFFFD
+
+#define SE_IS_VALID_SCALAR_VALUE(c) ( (c) < 0xD800 || ((c) >= 0xE000 && (c) < 0x110000) )
+#define SE_IS_SURROGATE(c)          ( (c) >= 0xD800 && (c) < 0xE000 )
+#define SE_IS_HI_SURROGATE(c)       ( (c) >= 0xD800 && (c) < 0xDC00 )
+#define SE_IS_LO_SURROGATE(c)       ( (c) >= 0xDC00 && (c) < 0xE000 )
+#define SE_SURROGATE_VALUE(hi, lo)  (seunichar32) ( ((((hi) & 0x3FF) << 10) | ((lo) & 0x3FF)) + 0x10000 )
+
+/***************************************************************************
+ *                                                                         *
+ * Code units.                                                             *
+ *                                                                         *
+ * A byte string is described by the width of its code units, 2 or 4       *
+ * bytes, and whether they are big endian.                                 *
+ *                                                                         *
+ ***************************************************************************/
+
+static seunichar32 se_endian_get_unit(const unsigned char* iter, int width, sebool big)
+{
+    if (width == 2)
+        return big ? (iter[0] << 8) | iter[1] : (iter[1] << 8) | iter[0];
+    else if (big)
+        return ((seunichar32) iter[0] << 24) | ((seunichar32) iter[1] << 16) | (iter[2] << 8) | iter[3];
+    else
+        return ((seunichar32) iter[3] << 24) | ((seunichar32) iter[2] << 16) | (iter[1] << 8) | iter[0];
+}
+
+static void se_endian_put_unit(seunichar32 unit, int width, sebool big, unsigned char* new_str_iter)
+{
+    int i;
+
+    for (i = 0; i < width; i++)
+        new_str_iter[big ? width - 1 - i : i] = (unsigned char) (unit >> (8 * i));
+}
+
+static ptrdiff_t se_endian_str_len(const unsigned char* str, int width)
+/*
+ * Return the byte length of a string terminated by a NUL code unit.
+ */
+{
+    const unsigned char* iter;
+
+    for (iter = str; ; iter += width)
+    {
+        if (iter[0] == 0 && iter[1] == 0 && (width == 2 || (iter[2] == 0 && iter[3] == 0)))
+            return iter - str;
+    }
+}
+
+static int se_endian_decode_char(const unsigned char* iter, const unsigned char* end, int width, sebool big, seunichar32* c)
+/*
+ * Decode the character at iter into *c, or U+FFFD if it is ill-formed,
+ * and return its byte length.
+ */
+{
+    seunichar32 unit;
+    seunichar32 lo;
+
+    if (end - iter < width)
+    {
+        *c = SE_REPLACEMENT_CHAR;
+        return (int) (end - iter);
+    }
+
+    unit = se_endian_get_unit(iter, width, big);
+
+    if (width == 4)
+    {
+        *c = SE_IS_VALID_SCALAR_VALUE(unit) ? unit : SE_REPLACEMENT_CHAR;
+        return 4;
+    }
+
+    if (SE_IS_HI_SURROGATE(unit))
+    {
+        /* Cut in the low surrogate */
+        if (end - iter < 4)
+        {
+            *c = SE_REPLACEMENT_CHAR;
+            return (int) (end - iter);
+        }
+
+        lo = se_endian_get_unit(iter + 2, 2, big);
+        if (SE_IS_LO_SURROGATE(lo))
+        {
+            *c = SE_SURROGATE_VALUE(unit, lo);
+            return 4;
+        }
+    }
+
+    *c = SE_IS_SURROGATE(unit) ? SE_REPLACEMENT_CHAR : unit;
+    return 2;
+}
+
+static int se_endian_encode_char(seunichar32 c, int width, sebool big, unsigned char* new_str_iter)
+/*
+ * Write the code point c at new_str_iter, if it is not NULL, and return
+ * its byte length.
+ */
+{
+    if (width == 2 && c > 0xFFFF)
+    {
+        if (new_str_iter)
+        {
+            se_endian_put_unit(0xD800 | ((c - 0x10000) >> 10), 2, big, new_str_iter);
+            se_endian_put_unit(0xDC00 | (c & 0x3FF), 2, big, new_str_iter + 2);
+        }
+        return 4;
+    }
+
+    if (new_str_iter)
+        se_endian_put_unit(c, width, big, new_str_iter);
+
+    return width;
+}
+
+static const unsigned char* se_endian_safe_utf8_next(const unsigned char* iter, seunichar32* c)
+/*
+ * Decode the character at iter of a well-formed UTF-8 string into *c, and
+ * return the start of the next one.
+ */
+{
+    if (iter[0] <= 0x7F)
+    {
+        *c = iter[0];
+        return iter + 1;
+    }
+    else if (iter[0] <= 0xDF)
+    {
+        *c = ((iter[0] & 0x1F) << 6) | (iter[1] & 0x3F);
+        return iter + 2;
+    }
+    else if (iter[0] <= 0xEF)
+    {
+        *c = ((iter[0] & 0x0F) << 12) | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F);
+        return iter + 3;
+    }
+    else
+    {
+        SE_DEBUG_ASSERT(iter[0] <= 0xF4);
+        *c = ((iter[0] & 0x07) << 18) | ((iter[1] & 0x3F) << 12) | ((iter[2] & 0x3F) << 6) | (iter[3] & 0x3F);
+        return iter + 4;
+    }
+}
+
+static unsigned char* se_endian_put_utf8(seunichar32 c, unsigned char* new_str_iter)
+/*
+ * Write the code point c as UTF-8 at new_str_iter, and return the end of
+ * it.
+ */
+{
+    if (c <= 0x7F)
+    {
+        new_str_iter[0] = (unsigned char) c;
+        return new_str_iter + 1;
+    }
+    else if (c <= 0x7FF)
+    {
+        new_str_iter[0] = (unsigned char) (0xC0 | (c >> 6));
+        new_str_iter[1] = (unsigned char) (0x80 | (c & 0x3F));
+        return new_str_iter + 2;
+    }
+    else if (c <= 0xFFFF)
+    {
+        new_str_iter[0] = (unsigned char) (0xE0 | (c >> 12));
+        new_str_iter[1] = (unsigned char) (0x80 | ((c >> 6) & 0x3F));
+        new_str_iter[2] = (unsigned char) (0x80 | (c & 0x3F));
+        return new_str_iter + 3;
+    }
+    else
+    {
+        new_str_iter[0] = (unsigned char) (0xF0 | (c >> 18));
+        new_str_iter[1] = (unsigned char) (0x80 | ((c >> 12) & 0x3F));
+        new_str_iter[2] = (unsigned char) (0x80 | ((c >> 6) & 0x3F));
+        new_str_iter[3] = (unsigned char) (0x80 | (c & 0x3F));
+        return new_str_iter + 4;
+    }
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Vectors of 8 code units.                                                *
+ *                                                                         *
+ * SSE2 has no byte shuffle, so a big endian unit is swapped by shifting   *
+ * the bytes of each 16 bit lane past each other, and a 32 bit unit by     *
+ * also swapping its two lanes. The vectors hold the units in host byte    *
+ * order, which is little endian wherever SSE2 is.                         *
+ *                                                                         *
+ ***************************************************************************/
+
+#if SE_OPT_SSE2
+static __m128i se_endian_swap16(__m128i units)
+{
+    return _mm_or_si128(_mm_slli_epi16(units, 8), _mm_srli_epi16(units, 8));
+}
+
+static __m128i se_endian_swap32(__m128i units)
+{
+    units = se_endian_swap16(units);
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(units, 0xB1), 0xB1);
+}
+
+static sebool se_endian_load_bmp_8(const unsigned char* iter, int width, sebool big, __m128i* units)
+/*
+ * Load the 8 code units at iter into *units as 16 bit units in host byte
+ * order, and return whether they are all code points of the BMP other
+ * than surrogates.
+ */
+{
+    __m128i lo;
+    __m128i hi;
+    __m128i surrogates;
+
+    if (width == 2)
+    {
+        lo = _mm_loadu_si128((const __m128i*)iter);
+        *units = big ? se_endian_swap16(lo) : lo;
+    }
+    else
+    {
+        lo = _mm_loadu_si128((const __m128i*)iter);
+        hi = _mm_loadu_si128((const __m128i*)(iter + 16));
+        if (big)
+        {
+            lo = se_endian_swap32(lo);
+            hi = se_endian_swap32(hi);
+        }
+
+        /* The high halves must be 0, then the low halves are packed */
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(_mm_or_si128(lo, hi), 16), _mm_setzero_si128())) != 0xFFFF)
+            return FALSE;
+
+        lo = _mm_sub_epi32(lo, _mm_set1_epi32(0x8000));
+        hi = _mm_sub_epi32(hi, _mm_set1_epi32(0x8000));
+        *units = _mm_add_epi16(_mm_packs_epi32(lo, hi), _mm_set1_epi16((short) 0x8000));
+    }
+
+    surrogates = _mm_cmpeq_epi16(_mm_and_si128(*units, _mm_set1_epi16((short) 0xF800)), _mm_set1_epi16((short) 0xD800));
+
+    return !_mm_movemask_epi8(surrogates);
+}
+
+static sebool se_endian_ascii_8(__m128i units)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16((short) 0xFF80)), _mm_setzero_si128())) == 0xFFFF;
+}
+
+static void se_endian_store_8(__m128i units, int width, sebool big, unsigned char* new_str_iter)
+/*
+ * Store the 8 host byte order 16 bit units of the BMP as code units.
+ */
+{
+    __m128i lo;
+    __m128i hi;
+
+    if (width == 2)
+    {
+        _mm_storeu_si128((__m128i*)new_str_iter, big ? se_endian_swap16(units) : units);
+    }
+    else
+    {
+        lo = _mm_unpacklo_epi16(units, _mm_setzero_si128());
+        hi = _mm_unpackhi_epi16(units, _mm_setzero_si128());
+        if (big)
+        {
+            lo = se_endian_swap32(lo);
+            hi = se_endian_swap32(hi);
+        }
+        _mm_storeu_si128((__m128i*)new_str_iter, lo);
+        _mm_storeu_si128((__m128i*)(new_str_iter + 16), hi);
+    }
+}
+#endif
+
+/***************************************************************************
+ *                                                                         *
+ * Strings.                                                                *
+ *                                                                         *
+ * Each conversion is done by a pair of functions over any of the byte     *
+ * orders, one counting the length of the output and one writing it.       *
+ *                                                                         *
+ ***************************************************************************/
+
+static sebool se_endian_is_valid(const unsigned char* iter, const unsigned char* end, int width, sebool big)
+{
+    const unsigned char* scalar_end;
+    seunichar32 c;
+    int len;
+    #if SE_OPT_SSE2
+        __m128i units;
+    #endif
+
+    while (iter < end)
+    {
+        scalar_end = end;
+
+        #if SE_OPT_SSE2
+            if (end - iter >= 8 * width)
+            {
+                if (se_endian_load_bmp_8(iter, width, big, &units))
+                {
+                    iter += 8 * width;
+                    continue;
+                }
+                scalar_end = iter + 8 * width;
+            }
+        #endif
+
+        while (iter < scalar_end)
+        {
+            len = se_endian_decode_char(iter, end, width, big, &c);
+
+            /* Unless it is a real U+FFFD */
+            if (c == SE_REPLACEMENT_CHAR && (len < width || se_endian_get_unit(iter, width, big) != SE_REPLACEMENT_CHAR))
+                return FALSE;
+
+            iter += len;
+        }
+    }
+
+    return TRUE;
+}
+
+static ptrdiff_t se_endian_utf8_len(const unsigned char* iter, const unsigned char* end, int width, sebool big)
+/*
+ * Return the length in bytes of the string from iter to end once
+ * converted to UTF-8.
+ */
+{
+    ptrdiff_t new_str_len;
+    const unsigned char* scalar_end;
+    seunichar32 c;
+    #if SE_OPT_SSE2
+        __m128i units;
+        seunichar16 block[8];
+        int i;
+    #endif
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        scalar_end = end;
+
+        #if SE_OPT_SSE2
+            if (end - iter >= 8 * width)
+            {
+                if (se_endian_load_bmp_8(iter, width, big, &units))
+                {
+                    new_str_len += 8;
+                    if (!se_endian_ascii_8(units))
+                    {
+                        _mm_storeu_si128((__m128i*)block, units);
+                        for (i = 0; i < 8; i++)
+                            new_str_len += (block[i] > 0x7F) + (block[i] > 0x7FF);
+                    }
+                    iter += 8 * width;
+                    continue;
+                }
+                scalar_end = iter + 8 * width;
+            }
+        #endif
+
+        while (iter < scalar_end)
+        {
+            iter += se_endian_decode_char(iter, end, width, big, &c);
+            new_str_len += c <= 0x7F ? 1 : c <= 0x7FF ? 2 : c <= 0xFFFF ? 3 : 4;
+        }
+    }
+
+    return new_str_len;
+}
+
+static unsigned char* se_endian_utf8_fill(const unsigned char* iter, const unsigned char* end, int width, sebool big, unsigned char* new_str_iter)
+/*
+ * Convert the string from iter to end into new_str_iter, which has room
+ * for se_endian_utf8_len() bytes, and return the end of the output.
+ */
+{
+    const unsigned char* scalar_end;
+    seunichar32 c;
+    #if SE_OPT_SSE2
+        __m128i units;
+        seunichar16 block[8];
+        int i;
+    #endif
+
+    while (iter < end)
+    {
+        scalar_end = end;
+
+        #if SE_OPT_SSE2
+            if (end - iter >= 8 * width)
+            {
+                if (se_endian_load_bmp_8(iter, width, big, &units))
+                {
+                    if (se_endian_ascii_8(units))
+                    {
+                        _mm_storel_epi64((__m128i*)new_str_iter, _mm_packus_epi16(units, units));
+                        new_str_iter += 8;
+                    }
+                    else
+                    {
+                        /* Well-formed already */
+                        _mm_storeu_si128((__m128i*)block, units);
+                        for (i = 0; i < 8; i++)
+                            new_str_iter = se_endian_put_utf8(block[i], new_str_iter);
+                    }
+                    iter += 8 * width;
+                    continue;
+                }
+                scalar_end = iter + 8 * width;
+            }
+        #endif
+
+        while (iter < scalar_end)
+        {
+            iter += se_endian_decode_char(iter, end, width, big, &c);
+            new_str_iter = se_endian_put_utf8(c, new_str_iter);
+        }
+    }
+
+    return new_str_iter;
+}
+
+static ptrdiff_t se_endian_utf16_len(const unsigned char* iter, const unsigned char* end, int width, sebool big)
+/*
+ * Return the length in UTF-16 units of the string from iter to end once
+ * converted to UTF-16.
+ */
+{
+    ptrdiff_t new_str_len;
+    const unsigned char* scalar_end;
+    seunichar32 c;
+    #if SE_OPT_SSE2
+        __m128i units;
+    #endif
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        scalar_end = end;
+
+        #if SE_OPT_SSE2
+            if (end - iter >= 8 * width)
+            {
+                if (se_endian_load_bmp_8(iter, width, big, &units))
+                {
+                    new_str_len += 8;
+                    iter += 8 * width;
+                    continue;
+                }
+                scalar_end = iter + 8 * width;
+            }
+        #endif
+
+        while (iter < scalar_end)
+        {
+            iter += se_endian_decode_char(iter, end, width, big, &c);
+            new_str_len += c <= 0xFFFF ? 1 : 2;
+        }
+    }
+
+    return new_str_len;
+}
+
+static seunichar16* se_endian_utf16_fill(const unsigned char* iter, const unsigned char* end, int width, sebool big, seunichar16* new_str_iter)
+/*
+ * Convert the string from iter to end into new_str_iter, which has room
+ * for se_endian_utf16_len() units, and return the end of the output.
+ */
+{
+    const unsigned char* scalar_end;
+    seunichar32 c;
+    #if SE_OPT_SSE2
+        __m128i units;
+    #endif
+
+    while (iter < end)
+    {
+        scalar_end = end;
+
+        #if SE_OPT_SSE2
+            if (end - iter >= 8 * width)
+            {
+                if (se_endian_load_bmp_8(iter, width, big, &units))
+                {
+                    _mm_storeu_si128((__m128i*)new_str_iter, units);
+                    new_str_iter += 8;
+                    iter += 8 * width;
+                    continue;
+                }
+                scalar_end = iter + 8 * width;
+            }
+        #endif
+
+        while (iter < scalar_end)
+        {
+            iter += se_endian_decode_char(iter, end, width, big, &c);
+            if (c <= 0xFFFF)
+            {
+                *new_str_iter++ = (seunichar16) c;
+            }
+            else
+            {
+                *new_str_iter++ = (seunichar16) (0xD800 | ((c - 0x10000) >> 10));
+                *new_str_iter++ = (seunichar16) (0xDC00 | (c & 0x3FF));
+            }
+        }
+    }
+
+    return new_str_iter;
+}
+
+static ptrdiff_t se_endian_utf32_len(const unsigned char* iter, const unsigned char* end, int width, sebool big)
+/*
+ * Return the length in UTF-32 units of the string from iter to end once
+ * converted to UTF-32.
+ */
+{
+    ptrdiff_t new_str_len;
+    const unsigned char* scalar_end;
+    seunichar32 c;
+    #if SE_OPT_SSE2
+        __m128i units;
+    #endif
+
+    /* Each unit or incomplete unit is a character */
+    if (width == 4)
+        return (end - iter + 3) / 4;
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        scalar_end = end;
+
+        #if SE_OPT_SSE2
+            if (end - iter >= 16)
+            {
+                if (se_endian_load_bmp_8(iter, 2, big, &units))
+                {
+                    new_str_len += 8;
+                    iter += 16;
+                    continue;
+                }
+                scalar_end = iter + 16;
+            }
+        #endif
+
+        while (iter < scalar_end)
+        {
+            iter += se_endian_decode_char(iter, end, 2, big, &c);
+            new_str_len++;
+        }
+    }
+
+    return new_str_len;
+}
+
+static seunichar32* se_endian_utf32_fill(const unsigned char* iter, const unsigned char* end, int width, sebool big, seunichar32* new_str_iter)
+/*
+ * Convert the string from iter to end into new_str_iter, which has room
+ * for se_endian_utf32_len() units, and return the end of the output.
+ */
+{
+    const unsigned char* scalar_end;
+    seunichar32 c;
+    #if SE_OPT_SSE2
+        __m128i units;
+    #endif
+
+    while (iter < end)
+    {
+        scalar_end = end;
+
+        #if SE_OPT_SSE2
+            if (end - iter >= 8 * width)
+            {
+                if (se_endian_load_bmp_8(iter, width, big, &units))
+                {
+                    _mm_storeu_si128((__m128i*)new_str_iter, _mm_unpacklo_epi16(units, _mm_setzero_si128()));
+                    _mm_storeu_si128((__m128i*)(new_str_iter + 4), _mm_unpackhi_epi16(units, _mm_setzero_si128()));
+                    new_str_iter += 8;
+                    iter += 8 * width;
+                    continue;
+                }
+                scalar_end = iter + 8 * width;
+            }
+        #endif
+
+        while (iter < scalar_end)
+        {
+            iter += se_endian_decode_char(iter, end, width, big, &c);
+            *new_str_iter++ = c;
+        }
+    }
+
+    return new_str_iter;
+}
+
+static ptrdiff_t se_safe_utf8_endian_len(const unsigned char* iter, const unsigned char* end, int width)
+/*
+ * Return the length in bytes of the well-formed UTF-8 string from iter to
+ * end once converted.
+ */
+{
+    ptrdiff_t new_str_len;
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)iter)))
+                {
+                    new_str_len += 16 * width;
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            iter++;
+        }
+        else if (iter[0] <= 0xDF)
+            iter += 2;
+        else if (iter[0] <= 0xEF)
+            iter += 3;
+        else
+        {
+            /* A surrogate pair in UTF-16 */
+            new_str_len += 4 - width;
+            iter += 4;
+        }
+        new_str_len += width;
+    }
+
+    return new_str_len;
+}
+
+static unsigned char* se_safe_utf8_endian_fill(const unsigned char* iter, const unsigned char* end, int width, sebool big, unsigned char* new_str_iter)
+/*
+ * Convert the well-formed UTF-8 string from iter to end into
+ * new_str_iter, which has room for se_safe_utf8_endian_len() bytes, and
+ * return the end of the output.
+ */
+{
+    seunichar32 c;
+
+    while (iter < end)
+    {
+        #if SE_OPT_SSE2
+            if (end - iter >= 16)
+            {
+                __m128i block;
+
+                block = _mm_loadu_si128((const __m128i*)iter);
+                if (!_mm_movemask_epi8(block))
+                {
+                    se_endian_store_8(_mm_unpacklo_epi8(block, _mm_setzero_si128()), width, big, new_str_iter);
+                    se_endian_store_8(_mm_unpackhi_epi8(block, _mm_setzero_si128()), width, big, new_str_iter + 8 * width);
+                    new_str_iter += 16 * width;
+                    iter += 16;
+                    continue;
+                }
+            }
+        #endif
+
+        iter = se_endian_safe_utf8_next(iter, &c);
+        new_str_iter += se_endian_encode_char(c, width, big, new_str_iter);
+    }
+
+    return new_str_iter;
+}
+
+static ptrdiff_t se_safe_utf16_endian_len(const seunichar16* iter, const seunichar16* end, int width)
+/*
+ * Return the length in bytes of the well-formed UTF-16 string from iter to
+ * end once converted.
+ */
+{
+    ptrdiff_t new_str_len;
+
+    if (width == 2)
+        return (end - iter) * 2;
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        iter += SE_IS_HI_SURROGATE(iter[0]) ? 2 : 1;
+        new_str_len += 4;
+    }
+
+    return new_str_len;
+}
+
+static unsigned char* se_safe_utf16_endian_fill(const seunichar16* iter, const seunichar16* end, int width, sebool big, unsigned char* new_str_iter)
+/*
+ * Convert the well-formed UTF-16 string from iter to end into
+ * new_str_iter, which has room for se_safe_utf16_endian_len() bytes, and
+ * return the end of the output.
+ */
+{
+    seunichar32 c;
+
+    #if SE_OPT_SSE2
+        const seunichar16* vector_iter;
+
+        /* No vector load before vector_iter */
+        vector_iter = iter;
+    #endif
+
+    while (iter < end)
+    {
+        #if SE_OPT_SSE2
+            __m128i units;
+
+            if (end - iter >= 8 && iter >= vector_iter)
+            {
+                /* To UTF-16, surrogates are swapped like any other unit */
+                if (width == 2)
+                {
+                    units = _mm_loadu_si128((const __m128i*)iter);
+                    _mm_storeu_si128((__m128i*)new_str_iter, big ? se_endian_swap16(units) : units);
+                    new_str_iter += 16;
+                    iter += 8;
+                    continue;
+                }
+
+                if (se_endian_load_bmp_8((const unsigned char*)iter, 2, FALSE, &units))
+                {
+                    se_endian_store_8(units, width, big, new_str_iter);
+                    new_str_iter += 8 * width;
+                    iter += 8;
+                    continue;
+                }
+
+                /* Convert the 8 units one by one before the next try */
+                vector_iter = iter + 8;
+            }
+        #endif
+
+        if (SE_IS_HI_SURROGATE(iter[0]))
+        {
+            c = SE_SURROGATE_VALUE(iter[0], iter[1]);
+            iter += 2;
+        }
+        else
+        {
+            c = iter[0];
+            iter++;
+        }
+        new_str_iter += se_endian_encode_char(c, width, big, new_str_iter);
+    }
+
+    return new_str_iter;
+}
+
+static ptrdiff_t se_safe_utf32_endian_len(const seunichar32* iter, const seunichar32* end, int width)
+/*
+ * Return the length in bytes of the well-formed UTF-32 string from iter to
+ * end once converted.
+ */
+{
+    ptrdiff_t new_str_len;
+
+    if (width == 4)
+        return (end - iter) * 4;
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        new_str_len += iter[0] <= 0xFFFF ? 2 : 4;
+        iter++;
+    }
+
+    return new_str_len;
+}
+
+static unsigned char* se_safe_utf32_endian_fill(const seunichar32* iter, const seunichar32* end, int width, sebool big, unsigned char* new_str_iter)
+/*
+ * Convert the well-formed UTF-32 string from iter to end into
+ * new_str_iter, which has room for se_safe_utf32_endian_len() bytes, and
+ * return the end of the output.
+ */
+{
+    #if SE_OPT_SSE2
+        const seunichar32* vector_iter;
+
+        /* No vector load before vector_iter */
+        vector_iter = iter;
+    #endif
+
+    while (iter < end)
+    {
+        #if SE_OPT_SSE2
+            __m128i units;
+
+            /* To UTF-32, every code point is swapped as is */
+            if (width == 4 && end - iter >= 4)
+            {
+                units = _mm_loadu_si128((const __m128i*)iter);
+                _mm_storeu_si128((__m128i*)new_str_iter, big ? se_endian_swap32(units) : units);
+                new_str_iter += 16;
+                iter += 4;
+                continue;
+            }
+
+            if (end - iter >= 8 && iter >= vector_iter)
+            {
+                if (se_endian_load_bmp_8((const unsigned char*)iter, 4, FALSE, &units))
+                {
+                    se_endian_store_8(units, width, big, new_str_iter);
+                    new_str_iter += 8 * width;
+                    iter += 8;
+                    continue;
+                }
+
+                /* Convert the 8 code points one by one before the next try */
+                vector_iter = iter + 8;
+            }
+        #endif
+
+        new_str_iter += se_endian_encode_char(*iter++, width, big, new_str_iter);
+    }
+
+    return new_str_iter;
+}
+
+static sebool se_endian_is_valid_str(const char* str, ptrdiff_t len, int width, sebool big)
+{
+    const unsigned char* iter;
+
+    SE_DEBUG_ASSERT(str);
+
+    iter = (const unsigned char*)str;
+
+    if (len < 0)
+        len = se_endian_str_len(iter, width);
+
+    return se_endian_is_valid(iter, iter + len, width, big);
+}
+
+static seunichar8* se_endian_to_utf8(const char* str, ptrdiff_t len, int width, sebool big, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    seunichar8* new_str;
+    unsigned char* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    iter = (const unsigned char*)str;
+
+    if (len < 0)
+        len = se_endian_str_len(iter, width);
+
+    end = iter + len;
+
+    new_str_len = se_endian_utf8_len(iter, end, width, big);
+
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar8));
+
+    new_str_iter = se_endian_utf8_fill(iter, end, width, big, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    *new_str_iter = 0;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(new_str, new_str_len));
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static seunichar16* se_endian_to_utf16(const char* str, ptrdiff_t len, int width, sebool big, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    seunichar16* new_str;
+    seunichar16* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    iter = (const unsigned char*)str;
+
+    if (len < 0)
+        len = se_endian_str_len(iter, width);
+
+    end = iter + len;
+
+    new_str_len = se_endian_utf16_len(iter, end, width, big);
+
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar16));
+
+    new_str_iter = se_endian_utf16_fill(iter, end, width, big, new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
+    *new_str_iter = 0;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(new_str, new_str_len));
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static seunichar32* se_endian_to_utf32(const char* str, ptrdiff_t len, int width, sebool big, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    seunichar32* new_str;
+    seunichar32* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    iter = (const unsigned char*)str;
+
+    if (len < 0)
+        len = se_endian_str_len(iter, width);
+
+    end = iter + len;
+
+    new_str_len = se_endian_utf32_len(iter, end, width, big);
+
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar32));
+
+    new_str_iter = se_endian_utf32_fill(iter, end, width, big, new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
+    *new_str_iter = 0;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf32_str_sz(new_str, new_str_len));
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static char* se_safe_utf8_to_endian(const seunichar8* str, ptrdiff_t len, int width, sebool big, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    char* new_str;
+    unsigned char* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(str, len));
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_safe_utf8_endian_len(iter, end, width);
+
+    new_str = SE_MALLOC(new_str_len + width);
+
+    new_str_iter = se_safe_utf8_endian_fill(iter, end, width, big, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    se_endian_put_unit(0, width, big, new_str_iter);
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static char* se_safe_utf16_to_endian(const seunichar16* str, ptrdiff_t len, int width, sebool big, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    char* new_str;
+    unsigned char* new_str_iter;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(str, len));
+
+    if (len < 0)
+        len = se_utf16_str_len_sz(str);
+
+    new_str_len = se_safe_utf16_endian_len(str, str + len, width);
+
+    new_str = SE_MALLOC(new_str_len + width);
+
+    new_str_iter = se_safe_utf16_endian_fill(str, str + len, width, big, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    se_endian_put_unit(0, width, big, new_str_iter);
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static char* se_safe_utf32_to_endian(const seunichar32* str, ptrdiff_t len, int width, sebool big, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    char* new_str;
+    unsigned char* new_str_iter;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf32_str_sz(str, len));
+
+    if (len < 0)
+        len = se_utf32_str_len_sz(str);
+
+    new_str_len = se_safe_utf32_endian_len(str, str + len, width);
+
+    new_str = SE_MALLOC(new_str_len + width);
+
+    new_str_iter = se_safe_utf32_endian_fill(str, str + len, width, big, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    se_endian_put_unit(0, width, big, new_str_iter);
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-16BE.                                                               *
+ *                                                                         *
+ * UTF-16 in big endian, or network, byte order. A supplementary           *
+ * code point takes a surrogate pair of 2 byte units.                      *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API sebool se_is_valid_utf16be_str_sz(const char* str, ptrdiff_t len)
+/*
+ * str:
+ *      Input UTF-16BE string.
+ *
+ * len:
+ *      The byte length of input string.
+ *      If len < 0, then the string ends with a NUL code unit.
+ *
+ * Check whether a UTF-16BE string is well-formed. A string with an
+ * incomplete code unit at the end is not.
+ *
+ * Return:
+ *      TRUE if the string is well-formed.
+ */
+{
+    return se_endian_is_valid_str(str, len, 2, TRUE);
+}
+
+SE_API sebool se_is_valid_utf16be_str(const char* str, int len)
+{
+    return se_is_valid_utf16be_str_sz(str, len);
+}
+
+SE_API seunichar8* se_unsafe_utf16be_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * str:
+ *      Input UTF-16BE string.
+ *
+ * len:
+ *      The byte length of input string.
+ *      If len < 0, then the string ends with a NUL code unit.
+ *
+ * out_len:
+ *      Location to return the length of the output string.
+ *      (Can be NULL to indicate that the result is not needed.)
+ *
+ * Convert a string from UTF-16BE to UTF-8.
+ * Invalid codes are replaced.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_endian_to_utf8(str, len, 2, TRUE, out_len);
+}
+
+SE_API seunichar8* se_unsafe_utf16be_to_safe_utf8(const char* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf16be_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar16* se_unsafe_utf16be_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16BE to UTF-16, as by
+ * se_unsafe_utf16be_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_endian_to_utf16(str, len, 2, TRUE, out_len);
+}
+
+SE_API seunichar16* se_unsafe_utf16be_to_safe_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf16be_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar32* se_unsafe_utf16be_to_safe_utf32_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16BE to UTF-32, as by
+ * se_unsafe_utf16be_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-32 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_endian_to_utf32(str, len, 2, TRUE, out_len);
+}
+
+SE_API seunichar32* se_unsafe_utf16be_to_safe_utf32(const char* str, int len, int* out_len)
+{
+    seunichar32* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf16be_to_safe_utf32_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf8_to_utf16be_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * out_len:
+ *      Location to return the byte length of the output string.
+ *      (Can be NULL to indicate that the result is not needed.)
+ *
+ * Convert a string from UTF-8 to UTF-16BE.
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16BE string, ending with a NUL
+ *      code unit.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf8_to_endian(str, len, 2, TRUE, out_len);
+}
+
+SE_API char* se_safe_utf8_to_utf16be(const seunichar8* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_utf16be_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf16_to_utf16be_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16 to UTF-16BE, as by se_safe_utf8_to_utf16be().
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16BE string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf16_to_endian(str, len, 2, TRUE, out_len);
+}
+
+SE_API char* se_safe_utf16_to_utf16be(const seunichar16* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf16_to_utf16be_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf32_to_utf16be_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-32 to UTF-16BE, as by se_safe_utf8_to_utf16be().
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16BE string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf32_to_endian(str, len, 2, TRUE, out_len);
+}
+
+SE_API char* se_safe_utf32_to_utf16be(const seunichar32* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf32_to_utf16be_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-16LE.                                                               *
+ *                                                                         *
+ * UTF-16 in little endian byte order, as on Windows.                      *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API sebool se_is_valid_utf16le_str_sz(const char* str, ptrdiff_t len)
+/*
+ * Check whether a UTF-16LE string is well-formed, as by
+ * se_is_valid_utf16be_str().
+ */
+{
+    return se_endian_is_valid_str(str, len, 2, FALSE);
+}
+
+SE_API sebool se_is_valid_utf16le_str(const char* str, int len)
+{
+    return se_is_valid_utf16le_str_sz(str, len);
+}
+
+SE_API seunichar8* se_unsafe_utf16le_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16LE to UTF-8, as by
+ * se_unsafe_utf16be_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_endian_to_utf8(str, len, 2, FALSE, out_len);
+}
+
+SE_API seunichar8* se_unsafe_utf16le_to_safe_utf8(const char* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf16le_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar16* se_unsafe_utf16le_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16LE to UTF-16, as by
+ * se_unsafe_utf16be_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_endian_to_utf16(str, len, 2, FALSE, out_len);
+}
+
+SE_API seunichar16* se_unsafe_utf16le_to_safe_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf16le_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar32* se_unsafe_utf16le_to_safe_utf32_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16LE to UTF-32, as by
+ * se_unsafe_utf16be_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-32 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_endian_to_utf32(str, len, 2, FALSE, out_len);
+}
+
+SE_API seunichar32* se_unsafe_utf16le_to_safe_utf32(const char* str, int len, int* out_len)
+{
+    seunichar32* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf16le_to_safe_utf32_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf8_to_utf16le_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-8 to UTF-16LE, as by se_safe_utf8_to_utf16be().
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16LE string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf8_to_endian(str, len, 2, FALSE, out_len);
+}
+
+SE_API char* se_safe_utf8_to_utf16le(const seunichar8* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_utf16le_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf16_to_utf16le_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16 to UTF-16LE, as by se_safe_utf8_to_utf16be().
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16LE string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf16_to_endian(str, len, 2, FALSE, out_len);
+}
+
+SE_API char* se_safe_utf16_to_utf16le(const seunichar16* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf16_to_utf16le_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf32_to_utf16le_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-32 to UTF-16LE, as by se_safe_utf8_to_utf16be().
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16LE string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf32_to_endian(str, len, 2, FALSE, out_len);
+}
+
+SE_API char* se_safe_utf32_to_utf16le(const seunichar32* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf32_to_utf16le_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-32BE.                                                               *
+ *                                                                         *
+ * UTF-32 in big endian byte order.                                        *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API sebool se_is_valid_utf32be_str_sz(const char* str, ptrdiff_t len)
+/*
+ * Check whether a UTF-32BE string is well-formed, as by
+ * se_is_valid_utf16be_str().
+ */
+{
+    return se_endian_is_valid_str(str, len, 4, TRUE);
+}
+
+SE_API sebool se_is_valid_utf32be_str(const char* str, int len)
+{
+    return se_is_valid_utf32be_str_sz(str, len);
+}
+
+SE_API seunichar8* se_unsafe_utf32be_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-32BE to UTF-8, as by
+ * se_unsafe_utf16be_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_endian_to_utf8(str, len, 4, TRUE, out_len);
+}
+
+SE_API seunichar8* se_unsafe_utf32be_to_safe_utf8(const char* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf32be_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar16* se_unsafe_utf32be_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-32BE to UTF-16, as by
+ * se_unsafe_utf16be_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_endian_to_utf16(str, len, 4, TRUE, out_len);
+}
+
+SE_API seunichar16* se_unsafe_utf32be_to_safe_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf32be_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar32* se_unsafe_utf32be_to_safe_utf32_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-32BE to UTF-32, as by
+ * se_unsafe_utf16be_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-32 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_endian_to_utf32(str, len, 4, TRUE, out_len);
+}
+
+SE_API seunichar32* se_unsafe_utf32be_to_safe_utf32(const char* str, int len, int* out_len)
+{
+    seunichar32* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf32be_to_safe_utf32_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf8_to_utf32be_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-8 to UTF-32BE, as by se_safe_utf8_to_utf16be().
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-32BE string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf8_to_endian(str, len, 4, TRUE, out_len);
+}
+
+SE_API char* se_safe_utf8_to_utf32be(const seunichar8* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_utf32be_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf16_to_utf32be_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16 to UTF-32BE, as by se_safe_utf8_to_utf16be().
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-32BE string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf16_to_endian(str, len, 4, TRUE, out_len);
+}
+
+SE_API char* se_safe_utf16_to_utf32be(const seunichar16* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf16_to_utf32be_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf32_to_utf32be_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-32 to UTF-32BE, as by se_safe_utf8_to_utf16be().
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-32BE string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf32_to_endian(str, len, 4, TRUE, out_len);
+}
+
+SE_API char* se_safe_utf32_to_utf32be(const seunichar32* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf32_to_utf32be_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-32LE.                                                               *
+ *                                                                         *
+ * UTF-32 in little endian byte order.                                     *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API sebool se_is_valid_utf32le_str_sz(const char* str, ptrdiff_t len)
+/*
+ * Check whether a UTF-32LE string is well-formed, as by
+ * se_is_valid_utf16be_str().
+ */
+{
+    return se_endian_is_valid_str(str, len, 4, FALSE);
+}
+
+SE_API sebool se_is_valid_utf32le_str(const char* str, int len)
+{
+    return se_is_valid_utf32le_str_sz(str, len);
+}
+
+SE_API seunichar8* se_unsafe_utf32le_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-32LE to UTF-8, as by
+ * se_unsafe_utf16be_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_endian_to_utf8(str, len, 4, FALSE, out_len);
+}
+
+SE_API seunichar8* se_unsafe_utf32le_to_safe_utf8(const char* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf32le_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar16* se_unsafe_utf32le_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-32LE to UTF-16, as by
+ * se_unsafe_utf16be_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_endian_to_utf16(str, len, 4, FALSE, out_len);
+}
+
+SE_API seunichar16* se_unsafe_utf32le_to_safe_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf32le_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar32* se_unsafe_utf32le_to_safe_utf32_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-32LE to UTF-32, as by
+ * se_unsafe_utf16be_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-32 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_endian_to_utf32(str, len, 4, FALSE, out_len);
+}
+
+SE_API seunichar32* se_unsafe_utf32le_to_safe_utf32(const char* str, int len, int* out_len)
+{
+    seunichar32* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf32le_to_safe_utf32_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf8_to_utf32le_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-8 to UTF-32LE, as by se_safe_utf8_to_utf16be().
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-32LE string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf8_to_endian(str, len, 4, FALSE, out_len);
+}
+
+SE_API char* se_safe_utf8_to_utf32le(const seunichar8* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_utf32le_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf16_to_utf32le_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16 to UTF-32LE, as by se_safe_utf8_to_utf16be().
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-32LE string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf16_to_endian(str, len, 4, FALSE, out_len);
+}
+
+SE_API char* se_safe_utf16_to_utf32le(const seunichar16* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf16_to_utf32le_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf32_to_utf32le_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-32 to UTF-32LE, as by se_safe_utf8_to_utf16be().
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-32LE string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf32_to_endian(str, len, 4, FALSE, out_len);
+}
+
+SE_API char* se_safe_utf32_to_utf32le(const seunichar32* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf32_to_utf32le_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
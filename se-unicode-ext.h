@@ -0,0 +1,744 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+#ifndef SE_UNICODE_EXT_H
+#define SE_UNICODE_EXT_H
+
+#ifndef SE_UNICODE_H
+    #include "se-unicode.h"
+#endif
+
+/*
+ * The se-unicode functions that se-unicode.h leaves out, with their types
+ * and constants, for the library itself and for the benchmarks and tools
+ * built with it. Every SE_API function of the library is declared either
+ * in se-unicode.h or here.
+ */
+
+/***************************************************************************
+ *                                                                         *
+ * Unicode string searching, see se-unicode-string.c.                      *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API const seunichar8* se_utf8_str_find_char(const seunichar8* str, int len, seunichar8 c);
+
+SE_API const seunichar16* se_utf16_str_find_char(const seunichar16* str, int len, seunichar16 c);
+
+SE_API const seunichar32* se_utf32_str_find_char(const seunichar32* str, int len, seunichar32 c);
+
+SE_API const seunichar8* se_safe_utf8_str_find_unichar(const seunichar8* str, int len, seunichar c);
+
+SE_API const seunichar16* se_safe_utf16_str_find_unichar(const seunichar16* str, int len, seunichar c);
+
+SE_API const seunichar8* se_utf8_str_find_str(const seunichar8* str, int len, const seunichar8* sub_str, int sub_len);
+
+SE_API const seunichar16* se_utf16_str_find_str(const seunichar16* str, int len, const seunichar16* sub_str, int sub_len);
+
+SE_API const seunichar32* se_utf32_str_find_str(const seunichar32* str, int len, const seunichar32* sub_str, int sub_len);
+
+SE_API const seunichar8* se_safe_utf8_str_find_any(const seunichar8* str, int len, const seunichar8* set, int set_len);
+
+SE_API const seunichar16* se_safe_utf16_str_find_any(const seunichar16* str, int len, const seunichar16* set, int set_len);
+
+SE_API const seunichar32* se_utf32_str_find_any(const seunichar32* str, int len, const seunichar32* set, int set_len);
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-16 code point order comparison, see se-unicode-string.c.            *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API int se_utf16_strcmp_code_point_order(const seunichar16* str1, const seunichar16* str2);
+
+SE_API int se_utf16_strncmp_code_point_order(const seunichar16* str1, const seunichar16* str2, int len);
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-8 character index, see se-unicode-string.c.                         *
+ *                                                                         *
+ ***************************************************************************/
+
+/* Opaque, made by se_utf8_index_new() */
+typedef struct se_utf8_index se_utf8_index;
+
+SE_API se_utf8_index* se_utf8_index_new(const seunichar8* str, int len, int interval);
+
+SE_API void se_utf8_index_free(se_utf8_index* index);
+
+SE_API void se_utf8_index_append(se_utf8_index* index, const seunichar8* str, int len);
+
+SE_API int se_utf8_index_char_count(const se_utf8_index* index);
+
+SE_API const seunichar8* se_utf8_index_offset_to_pointer(const se_utf8_index* index, int offset);
+
+SE_API int se_utf8_index_pointer_to_offset(const se_utf8_index* index, const seunichar8* pos);
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-8 <=> UTF-16 offset translation, see se-unicode-string.c.           *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API int se_safe_utf8_utf16_len(const seunichar8* str, int len);
+
+SE_API int se_safe_utf16_utf8_len(const seunichar16* str, int len);
+
+SE_API int se_safe_utf8_utf16_offset_to_byte_offset(const seunichar8* str, int len, int utf16_offset);
+
+SE_API void se_safe_utf8_byte_offsets_to_utf16_offsets(const seunichar8* str, int len, const int* byte_offsets, int* utf16_offsets, int count);
+
+SE_API void se_safe_utf8_utf16_offsets_to_byte_offsets(const seunichar8* str, int len, const int* utf16_offsets, int* byte_offsets, int count);
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-8 string manipulating, see se-unicode-string.c.                     *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API const seunichar8* se_safe_utf8_str_last_chars(const seunichar8* str, int len, int count);
+
+/***************************************************************************
+ *                                                                         *
+ * Truncation at character boundaries, see se-unicode-string.c.            *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API int se_safe_utf8_str_truncate(const seunichar8* str, int len, int max_len);
+
+SE_API int se_safe_utf8_str_truncate_chars(const seunichar8* str, int len, int max_chars);
+
+SE_API int se_safe_utf16_str_truncate(const seunichar16* str, int len, int max_len);
+
+/***************************************************************************
+ *                                                                         *
+ * Batch conversion, see se-unicode-string.c.                              *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API seunichar16* se_unsafe_utf8_to_safe_utf16_batch(const seunichar8* const* strs, const int* lens, int count, int* offsets, int* out_len);
+
+/***************************************************************************
+ *                                                                         *
+ * ptrdiff_t length variants, see se-unicode-string.c.                     *
+ *                                                                         *
+ ***************************************************************************/
+
+/* The int functions of the same names without _sz wrap these */
+
+SE_API ptrdiff_t se_utf8_str_len_sz(const seunichar8* str);
+
+SE_API ptrdiff_t se_utf16_str_len_sz(const seunichar16* str);
+
+SE_API ptrdiff_t se_utf32_str_len_sz(const seunichar32* str);
+
+SE_API sebool se_is_valid_utf8_str_sz(const seunichar8* str, ptrdiff_t len);
+
+SE_API sebool se_is_valid_utf16_str_sz(const seunichar16* str, ptrdiff_t len);
+
+SE_API sebool se_is_valid_utf32_str_sz(const seunichar32* str, ptrdiff_t len);
+
+SE_API seunichar8* se_unsafe_utf8_str_safe_copy_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_utf16_str_safe_copy_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar32* se_unsafe_utf32_str_safe_copy_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API ptrdiff_t se_safe_utf8_str_char_count_sz(const seunichar8* str, ptrdiff_t len);
+
+SE_API ptrdiff_t se_safe_utf16_str_char_count_sz(const seunichar16* str, ptrdiff_t len);
+
+SE_API ptrdiff_t se_safe_utf32_str_char_count_sz(const seunichar32* str, ptrdiff_t len);
+
+SE_API seunichar16* se_unsafe_utf8_to_safe_utf16_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_utf16_to_safe_utf8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar32* se_unsafe_utf8_to_safe_utf32_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_utf32_to_safe_utf8_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar32* se_unsafe_utf16_to_safe_utf32_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_utf32_to_safe_utf16_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_safe_utf8_to_utf16_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_safe_utf16_to_utf8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar32* se_safe_utf8_to_utf32_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_safe_utf32_to_utf8_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar32* se_safe_utf16_to_utf32_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_safe_utf32_to_utf16_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+/***************************************************************************
+ *                                                                         *
+ * Conversion into caller buffers, see se-unicode-string.c.                *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API ptrdiff_t se_unsafe_utf8_str_safe_copy_into(const seunichar8* str, ptrdiff_t len, seunichar8* buf);
+
+SE_API ptrdiff_t se_unsafe_utf8_to_safe_utf16_into(const seunichar8* str, ptrdiff_t len, seunichar16* buf);
+
+SE_API ptrdiff_t se_unsafe_utf16_to_safe_utf8_into(const seunichar16* str, ptrdiff_t len, seunichar8* buf);
+
+/***************************************************************************
+ *                                                                         *
+ * Memory-mapped files, see se-unicode-file.c.                             *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API int se_is_valid_utf8_file(const char* path);
+
+SE_API int se_is_valid_utf16_file(const char* path);
+
+SE_API int se_is_valid_utf32_file(const char* path);
+
+SE_API int se_unsafe_utf8_file_safe_copy(const char* in_path, const char* out_path);
+
+SE_API int se_unsafe_utf8_file_to_safe_utf16_file(const char* in_path, const char* out_path);
+
+SE_API int se_unsafe_utf16_file_to_safe_utf8_file(const char* in_path, const char* out_path);
+
+/***************************************************************************
+ *                                                                         *
+ * Hot path statistics, see SE_OPT_STATS in se-unicode-string.c.           *
+ *                                                                         *
+ ***************************************************************************/
+
+/* Counted functions, the int and _sz variants share one entry */
+#define SE_STATS_IS_VALID_UTF8              0
+#define SE_STATS_IS_VALID_UTF16             1
+#define SE_STATS_IS_VALID_UTF32             2
+#define SE_STATS_UTF8_SAFE_COPY             3
+#define SE_STATS_UTF16_SAFE_COPY            4
+#define SE_STATS_UTF32_SAFE_COPY            5
+#define SE_STATS_UTF8_CHAR_COUNT            6
+#define SE_STATS_UTF16_CHAR_COUNT           7
+#define SE_STATS_UTF32_CHAR_COUNT           8
+#define SE_STATS_UNSAFE_UTF8_TO_UTF16       9
+#define SE_STATS_UNSAFE_UTF16_TO_UTF8       10
+#define SE_STATS_UNSAFE_UTF8_TO_UTF32       11
+#define SE_STATS_UNSAFE_UTF32_TO_UTF8       12
+#define SE_STATS_UNSAFE_UTF16_TO_UTF32      13
+#define SE_STATS_UNSAFE_UTF32_TO_UTF16      14
+#define SE_STATS_SAFE_UTF8_TO_UTF16         15
+#define SE_STATS_SAFE_UTF16_TO_UTF8         16
+#define SE_STATS_SAFE_UTF8_TO_UTF32         17
+#define SE_STATS_SAFE_UTF32_TO_UTF8         18
+#define SE_STATS_SAFE_UTF16_TO_UTF32        19
+#define SE_STATS_SAFE_UTF32_TO_UTF16        20
+#define SE_STATS_UTF8_SAFE_COPY_INTO        21
+#define SE_STATS_UNSAFE_UTF8_TO_UTF16_INTO  22
+#define SE_STATS_UNSAFE_UTF16_TO_UTF8_INTO  23
+#define SE_STATS_UNSAFE_UTF8_TO_UTF16_BATCH 24
+#define SE_STATS_UTF8_STR_COPY              25
+#define SE_STATS_UTF16_STR_COPY             26
+#define SE_STATS_UTF32_STR_COPY             27
+#define SE_STATS_UTF8_STRDUP                28
+#define SE_STATS_UTF16_STRDUP               29
+#define SE_STATS_UTF32_STRDUP               30
+#define SE_STATS_UTF8_INDEX                 31
+#define SE_STATS_IS_ASCII                   32
+#define SE_STATS_IS_ASCII_UTF16             33
+#define SE_STATS_IS_LATIN1_UTF8             34
+#define SE_STATS_IS_LATIN1_UTF16            35
+#define SE_STATS_LATIN1_TO_UTF8             36
+#define SE_STATS_LATIN1_TO_UTF16            37
+#define SE_STATS_SAFE_UTF8_TO_LATIN1        38
+#define SE_STATS_SAFE_UTF16_TO_LATIN1       39
+#define SE_STATS_LATIN1_TO_UTF8_INTO        40
+#define SE_STATS_LATIN1_TO_UTF16_INTO       41
+#define SE_STATS_SAFE_UTF8_TO_LATIN1_INTO   42
+#define SE_STATS_SAFE_UTF16_TO_LATIN1_INTO  43
+#define SE_STATS_USTR                       44
+#define SE_STATS_FUNCTION_COUNT             45
+
+typedef struct se_stats se_stats;
+
+struct se_stats
+/*
+ * Totals of one counted function, filled by se_stats_snapshot().
+ */
+{
+    const char* name;
+    unsigned long long calls;
+    unsigned long long bytes_in;
+    unsigned long long bytes_out;
+    unsigned long long replacements;
+    unsigned long long allocs;
+    unsigned long long alloc_bytes;
+};
+
+SE_API int se_stats_snapshot(se_stats* stats, int count);
+
+/***************************************************************************
+ *                                                                         *
+ * Allocation tracing, see SE_OPT_ALLOC_TRACE in se-unicode-string.c.      *
+ *                                                                         *
+ ***************************************************************************/
+
+typedef struct se_alloc_record se_alloc_record;
+
+struct se_alloc_record
+/*
+ * One allocation, 16 bytes in native byte order. Sizes above 4 GiB are
+ * saturated to 0xFFFFFFFF.
+ *
+ * function:
+ *      The allocating function, an SE_STATS_* id, see
+ *      se_alloc_trace_function_name().
+ *
+ * input_bytes:
+ *      The input the allocation was sized for.
+ *
+ * requested_bytes:
+ *      The size actually requested, exact for the two-pass conversions.
+ *
+ * worst_case_bytes:
+ *      The size a single pass conversion would have had to request for
+ *      the worst case input of this length. The difference to
+ *      requested_bytes is what the sizing pass saved.
+ */
+{
+    unsigned int function;
+    unsigned int input_bytes;
+    unsigned int requested_bytes;
+    unsigned int worst_case_bytes;
+};
+
+SE_API int se_alloc_trace_read(se_alloc_record* records, int count);
+
+SE_API void se_alloc_trace_reset(void);
+
+SE_API const char* se_alloc_trace_function_name(unsigned int function);
+
+/***************************************************************************
+ *                                                                         *
+ * Latin-1 and ASCII strings, see se-unicode-string.c.                     *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API sebool se_is_ascii_str_sz(const seunichar8* str, ptrdiff_t len);
+
+SE_API sebool se_is_ascii_str(const seunichar8* str, int len);
+
+SE_API sebool se_is_ascii_utf16_str_sz(const seunichar16* str, ptrdiff_t len);
+
+SE_API sebool se_is_ascii_utf16_str(const seunichar16* str, int len);
+
+SE_API sebool se_is_latin1_utf8_str_sz(const seunichar8* str, ptrdiff_t len);
+
+SE_API sebool se_is_latin1_utf8_str(const seunichar8* str, int len);
+
+SE_API sebool se_is_latin1_utf16_str_sz(const seunichar16* str, ptrdiff_t len);
+
+SE_API sebool se_is_latin1_utf16_str(const seunichar16* str, int len);
+
+SE_API seunichar8* se_latin1_to_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_latin1_to_utf8(const char* str, int len, int* out_len);
+
+SE_API ptrdiff_t se_latin1_to_utf8_into(const char* str, ptrdiff_t len, seunichar8* buf);
+
+SE_API seunichar16* se_latin1_to_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_latin1_to_utf16(const char* str, int len, int* out_len);
+
+SE_API ptrdiff_t se_latin1_to_utf16_into(const char* str, ptrdiff_t len, seunichar16* buf);
+
+SE_API char* se_safe_utf8_to_latin1_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf8_to_latin1(const seunichar8* str, int len, int* out_len);
+
+SE_API ptrdiff_t se_safe_utf8_to_latin1_into(const seunichar8* str, ptrdiff_t len, char* buf);
+
+SE_API char* se_safe_utf16_to_latin1_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf16_to_latin1(const seunichar16* str, int len, int* out_len);
+
+SE_API ptrdiff_t se_safe_utf16_to_latin1_into(const seunichar16* str, ptrdiff_t len, char* buf);
+
+/***************************************************************************
+ *                                                                         *
+ * GB18030, see se-unicode-mbcs.c.                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API seunichar8* se_unsafe_gb18030_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_gb18030_to_safe_utf8(const char* str, int len, int* out_len);
+
+SE_API seunichar16* se_unsafe_gb18030_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_gb18030_to_safe_utf16(const char* str, int len, int* out_len);
+
+SE_API char* se_safe_utf8_to_gb18030_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf8_to_gb18030(const seunichar8* str, int len, int* out_len);
+
+SE_API char* se_safe_utf16_to_gb18030_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf16_to_gb18030(const seunichar16* str, int len, int* out_len);
+
+/***************************************************************************
+ *                                                                         *
+ * Shift_JIS, EUC-KR, Big5 and streaming decoding, see se-unicode-mbcs.c.  *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API ptrdiff_t se_unsafe_gb18030_to_safe_utf8_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar8* buf);
+
+SE_API ptrdiff_t se_unsafe_gb18030_to_safe_utf16_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar16* buf);
+
+SE_API seunichar8* se_unsafe_shift_jis_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_shift_jis_to_safe_utf8(const char* str, int len, int* out_len);
+
+SE_API ptrdiff_t se_unsafe_shift_jis_to_safe_utf8_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar8* buf);
+
+SE_API seunichar16* se_unsafe_shift_jis_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_shift_jis_to_safe_utf16(const char* str, int len, int* out_len);
+
+SE_API ptrdiff_t se_unsafe_shift_jis_to_safe_utf16_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar16* buf);
+
+SE_API char* se_safe_utf8_to_shift_jis_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf8_to_shift_jis(const seunichar8* str, int len, int* out_len);
+
+SE_API char* se_safe_utf16_to_shift_jis_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf16_to_shift_jis(const seunichar16* str, int len, int* out_len);
+
+SE_API seunichar8* se_unsafe_euc_kr_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_euc_kr_to_safe_utf8(const char* str, int len, int* out_len);
+
+SE_API ptrdiff_t se_unsafe_euc_kr_to_safe_utf8_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar8* buf);
+
+SE_API seunichar16* se_unsafe_euc_kr_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_euc_kr_to_safe_utf16(const char* str, int len, int* out_len);
+
+SE_API ptrdiff_t se_unsafe_euc_kr_to_safe_utf16_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar16* buf);
+
+SE_API char* se_safe_utf8_to_euc_kr_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf8_to_euc_kr(const seunichar8* str, int len, int* out_len);
+
+SE_API char* se_safe_utf16_to_euc_kr_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf16_to_euc_kr(const seunichar16* str, int len, int* out_len);
+
+SE_API seunichar8* se_unsafe_big5_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_big5_to_safe_utf8(const char* str, int len, int* out_len);
+
+SE_API ptrdiff_t se_unsafe_big5_to_safe_utf8_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar8* buf);
+
+SE_API seunichar16* se_unsafe_big5_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_big5_to_safe_utf16(const char* str, int len, int* out_len);
+
+SE_API ptrdiff_t se_unsafe_big5_to_safe_utf16_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar16* buf);
+
+SE_API char* se_safe_utf8_to_big5_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf8_to_big5(const seunichar8* str, int len, int* out_len);
+
+SE_API char* se_safe_utf16_to_big5_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf16_to_big5(const seunichar16* str, int len, int* out_len);
+
+/***************************************************************************
+ *                                                                         *
+ * Encoding detection, see se-unicode-mbcs.c.                              *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API const char* se_detect_encoding_sz(const char* str, ptrdiff_t len, int* confidence, int* bom_len);
+
+SE_API const char* se_detect_encoding(const char* str, int len, int* confidence, int* bom_len);
+
+SE_API const char* se_detect_file_encoding(const char* path, int* confidence);
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-16BE/LE and UTF-32BE/LE, see se-unicode-endian.c.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API sebool se_is_valid_utf16be_str_sz(const char* str, ptrdiff_t len);
+
+SE_API sebool se_is_valid_utf16be_str(const char* str, int len);
+
+SE_API seunichar8* se_unsafe_utf16be_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_utf16be_to_safe_utf8(const char* str, int len, int* out_len);
+
+SE_API seunichar16* se_unsafe_utf16be_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_utf16be_to_safe_utf16(const char* str, int len, int* out_len);
+
+SE_API seunichar32* se_unsafe_utf16be_to_safe_utf32_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar32* se_unsafe_utf16be_to_safe_utf32(const char* str, int len, int* out_len);
+
+SE_API char* se_safe_utf8_to_utf16be_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf8_to_utf16be(const seunichar8* str, int len, int* out_len);
+
+SE_API char* se_safe_utf16_to_utf16be_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf16_to_utf16be(const seunichar16* str, int len, int* out_len);
+
+SE_API char* se_safe_utf32_to_utf16be_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf32_to_utf16be(const seunichar32* str, int len, int* out_len);
+
+SE_API sebool se_is_valid_utf16le_str_sz(const char* str, ptrdiff_t len);
+
+SE_API sebool se_is_valid_utf16le_str(const char* str, int len);
+
+SE_API seunichar8* se_unsafe_utf16le_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_utf16le_to_safe_utf8(const char* str, int len, int* out_len);
+
+SE_API seunichar16* se_unsafe_utf16le_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_utf16le_to_safe_utf16(const char* str, int len, int* out_len);
+
+SE_API seunichar32* se_unsafe_utf16le_to_safe_utf32_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar32* se_unsafe_utf16le_to_safe_utf32(const char* str, int len, int* out_len);
+
+SE_API char* se_safe_utf8_to_utf16le_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf8_to_utf16le(const seunichar8* str, int len, int* out_len);
+
+SE_API char* se_safe_utf16_to_utf16le_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf16_to_utf16le(const seunichar16* str, int len, int* out_len);
+
+SE_API char* se_safe_utf32_to_utf16le_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf32_to_utf16le(const seunichar32* str, int len, int* out_len);
+
+SE_API sebool se_is_valid_utf32be_str_sz(const char* str, ptrdiff_t len);
+
+SE_API sebool se_is_valid_utf32be_str(const char* str, int len);
+
+SE_API seunichar8* se_unsafe_utf32be_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_utf32be_to_safe_utf8(const char* str, int len, int* out_len);
+
+SE_API seunichar16* se_unsafe_utf32be_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_utf32be_to_safe_utf16(const char* str, int len, int* out_len);
+
+SE_API seunichar32* se_unsafe_utf32be_to_safe_utf32_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar32* se_unsafe_utf32be_to_safe_utf32(const char* str, int len, int* out_len);
+
+SE_API char* se_safe_utf8_to_utf32be_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf8_to_utf32be(const seunichar8* str, int len, int* out_len);
+
+SE_API char* se_safe_utf16_to_utf32be_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf16_to_utf32be(const seunichar16* str, int len, int* out_len);
+
+SE_API char* se_safe_utf32_to_utf32be_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf32_to_utf32be(const seunichar32* str, int len, int* out_len);
+
+SE_API sebool se_is_valid_utf32le_str_sz(const char* str, ptrdiff_t len);
+
+SE_API sebool se_is_valid_utf32le_str(const char* str, int len);
+
+SE_API seunichar8* se_unsafe_utf32le_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_utf32le_to_safe_utf8(const char* str, int len, int* out_len);
+
+SE_API seunichar16* se_unsafe_utf32le_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_utf32le_to_safe_utf16(const char* str, int len, int* out_len);
+
+SE_API seunichar32* se_unsafe_utf32le_to_safe_utf32_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar32* se_unsafe_utf32le_to_safe_utf32(const char* str, int len, int* out_len);
+
+SE_API char* se_safe_utf8_to_utf32le_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf8_to_utf32le(const seunichar8* str, int len, int* out_len);
+
+SE_API char* se_safe_utf16_to_utf32le_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf16_to_utf32le(const seunichar16* str, int len, int* out_len);
+
+SE_API char* se_safe_utf32_to_utf32le_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf32_to_utf32le(const seunichar32* str, int len, int* out_len);
+
+/***************************************************************************
+ *                                                                         *
+ * WTF-8, CESU-8 and Modified UTF-8, see se-unicode-variants.c.            *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API sebool se_is_valid_wtf8_str_sz(const char* str, ptrdiff_t len);
+
+SE_API sebool se_is_valid_wtf8_str(const char* str, int len);
+
+SE_API seunichar16* se_unsafe_wtf8_to_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_wtf8_to_utf16(const char* str, int len, int* out_len);
+
+SE_API seunichar16* se_unsafe_wtf8_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_wtf8_to_safe_utf16(const char* str, int len, int* out_len);
+
+SE_API seunichar8* se_unsafe_wtf8_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_wtf8_to_safe_utf8(const char* str, int len, int* out_len);
+
+SE_API char* se_utf16_to_wtf8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_utf16_to_wtf8(const seunichar16* str, int len, int* out_len);
+
+SE_API sebool se_is_valid_cesu8_str_sz(const char* str, ptrdiff_t len);
+
+SE_API sebool se_is_valid_cesu8_str(const char* str, int len);
+
+SE_API seunichar8* se_unsafe_cesu8_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_cesu8_to_safe_utf8(const char* str, int len, int* out_len);
+
+SE_API seunichar16* se_unsafe_cesu8_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_cesu8_to_safe_utf16(const char* str, int len, int* out_len);
+
+SE_API char* se_safe_utf8_to_cesu8_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf8_to_cesu8(const seunichar8* str, int len, int* out_len);
+
+SE_API char* se_safe_utf16_to_cesu8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf16_to_cesu8(const seunichar16* str, int len, int* out_len);
+
+SE_API sebool se_is_valid_mutf8_str_sz(const char* str, ptrdiff_t len);
+
+SE_API sebool se_is_valid_mutf8_str(const char* str, int len);
+
+SE_API seunichar16* se_unsafe_mutf8_to_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_mutf8_to_utf16(const char* str, int len, int* out_len);
+
+SE_API seunichar16* se_unsafe_mutf8_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar16* se_unsafe_mutf8_to_safe_utf16(const char* str, int len, int* out_len);
+
+SE_API seunichar8* se_unsafe_mutf8_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API seunichar8* se_unsafe_mutf8_to_safe_utf8(const char* str, int len, int* out_len);
+
+SE_API char* se_utf16_to_mutf8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_utf16_to_mutf8(const seunichar16* str, int len, int* out_len);
+
+SE_API char* se_safe_utf8_to_mutf8_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len);
+
+SE_API char* se_safe_utf8_to_mutf8(const seunichar8* str, int len, int* out_len);
+
+/***************************************************************************
+ *                                                                         *
+ * Error policies of the _ex conversions, see se-unicode-string.c.         *
+ *                                                                         *
+ ***************************************************************************/
+
+#define SE_ERROR_REPLACE                    0   /* U+FFFD per ill-formed code unit */
+#define SE_ERROR_MAXIMAL                    1   /* U+FFFD per maximal subpart */
+#define SE_ERROR_SKIP                       2   /* Drop ill-formed code units */
+#define SE_ERROR_STRICT                     3   /* Fail on ill-formed input */
+
+SE_API seunichar8* se_unsafe_utf8_str_safe_copy_ex_sz(const seunichar8* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+
+SE_API seunichar8* se_unsafe_utf8_str_safe_copy_ex(const seunichar8* str, int len, int policy, int* out_len, int* error_offset);
+
+SE_API seunichar16* se_unsafe_utf16_str_safe_copy_ex_sz(const seunichar16* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+
+SE_API seunichar16* se_unsafe_utf16_str_safe_copy_ex(const seunichar16* str, int len, int policy, int* out_len, int* error_offset);
+
+SE_API seunichar32* se_unsafe_utf32_str_safe_copy_ex_sz(const seunichar32* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+
+SE_API seunichar32* se_unsafe_utf32_str_safe_copy_ex(const seunichar32* str, int len, int policy, int* out_len, int* error_offset);
+
+SE_API seunichar16* se_unsafe_utf8_to_safe_utf16_ex_sz(const seunichar8* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+
+SE_API seunichar16* se_unsafe_utf8_to_safe_utf16_ex(const seunichar8* str, int len, int policy, int* out_len, int* error_offset);
+
+SE_API seunichar8* se_unsafe_utf16_to_safe_utf8_ex_sz(const seunichar16* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+
+SE_API seunichar8* se_unsafe_utf16_to_safe_utf8_ex(const seunichar16* str, int len, int policy, int* out_len, int* error_offset);
+
+SE_API seunichar32* se_unsafe_utf8_to_safe_utf32_ex_sz(const seunichar8* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+
+SE_API seunichar32* se_unsafe_utf8_to_safe_utf32_ex(const seunichar8* str, int len, int policy, int* out_len, int* error_offset);
+
+SE_API seunichar8* se_unsafe_utf32_to_safe_utf8_ex_sz(const seunichar32* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+
+SE_API seunichar8* se_unsafe_utf32_to_safe_utf8_ex(const seunichar32* str, int len, int policy, int* out_len, int* error_offset);
+
+SE_API seunichar32* se_unsafe_utf16_to_safe_utf32_ex_sz(const seunichar16* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+
+SE_API seunichar32* se_unsafe_utf16_to_safe_utf32_ex(const seunichar16* str, int len, int policy, int* out_len, int* error_offset);
+
+SE_API seunichar16* se_unsafe_utf32_to_safe_utf16_ex_sz(const seunichar32* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset);
+
+SE_API seunichar16* se_unsafe_utf32_to_safe_utf16_ex(const seunichar32* str, int len, int policy, int* out_len, int* error_offset);
+
+/***************************************************************************
+ *                                                                         *
+ * Reference counted UTF-8 strings, see se-unicode-string.c.               *
+ *                                                                         *
+ ***************************************************************************/
+
+/* Opaque, made by se_ustr_new() */
+typedef struct se_ustr se_ustr;
+
+SE_API se_ustr* se_ustr_new_sz(const seunichar8* str, ptrdiff_t len);
+
+SE_API se_ustr* se_ustr_new(const seunichar8* str, int len);
+
+SE_API se_ustr* se_ustr_ref(se_ustr* s);
+
+SE_API void se_ustr_unref(se_ustr* s);
+
+SE_API se_ustr* se_ustr_slice_sz(se_ustr* s, ptrdiff_t start, ptrdiff_t end);
+
+SE_API se_ustr* se_ustr_slice(se_ustr* s, int start, int end);
+
+SE_API const seunichar8* se_ustr_str(const se_ustr* s);
+
+SE_API ptrdiff_t se_ustr_len_sz(const se_ustr* s);
+
+SE_API int se_ustr_len(const se_ustr* s);
+
+SE_API ptrdiff_t se_ustr_char_count_sz(const se_ustr* s);
+
+SE_API int se_ustr_char_count(const se_ustr* s);
+
+SE_API unsigned int se_ustr_hash(const se_ustr* s);
+
+SE_API sebool se_ustr_is_ascii(const se_ustr* s);
+
+SE_API sebool se_ustr_equal(const se_ustr* s1, const se_ustr* s2);
+
+#endif /* SE_UNICODE_EXT_H */
@@ -0,0 +1,415 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+#ifndef SE_UNICODE_H
+    #include "se-unicode.h"
+#endif
+
+#ifndef SE_UTILS_H
+    #include "se-utils.h"
+#endif
+
+#ifndef SE_UNICODE_EXT_H
+    #include "se-unicode-ext.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Bulk validation and conversion of whole files.
+ *
+ * The input file is mapped read-only and handed to the string routines
+ * as it is, so no read() copy and no heap string is ever made. The output
+ * file is grown to the worst case size of the conversion, mapped shared,
+ * filled by the _into() routines and then truncated to the real length.
+ * The unused tail is never touched, so on file systems with sparse files
+ * it costs no disk space.
+ *
+ * UTF-16 and UTF-32 files are in native byte order, without BOM handling.
+ *
+ * The functions return 0 on success, or -1 with errno set on I/O error.
+ * The validation functions return 1 for a valid file and 0 for an invalid
+ * one.
+ *
+ * The output must be a different file from the input. An output path that
+ * names the input, directly or through a hard link or symlink, fails with
+ * EINVAL and leaves the input untouched: truncating it while it is mapped
+ * would kill the conversion with SIGBUS.
+ */
+
+typedef struct se_file_map se_file_map;
+
+struct se_file_map
+{
+    int fd;
+    void* data;
+    size_t size;
+};
+
+static int se_file_map_input(se_file_map* map, const char* path)
+{
+    struct stat st;
+
+    map->data = 0;
+    map->size = 0;
+
+    map->fd = open(path, O_RDONLY);
+    if (map->fd < 0)
+        return -1;
+
+    if (fstat(map->fd, &st) < 0)
+        goto error;
+
+    if ((unsigned long long) st.st_size > (size_t) PTRDIFF_MAX)
+    {
+        errno = EFBIG;
+        goto error;
+    }
+
+    map->size = (size_t) st.st_size;
+
+    /* mmap() refuses empty mappings, an empty file is simply empty */
+    if (map->size == 0)
+        return 0;
+
+    map->data = mmap(0, map->size, PROT_READ, MAP_PRIVATE, map->fd, 0);
+    if (map->data == MAP_FAILED)
+    {
+        map->data = 0;
+        goto error;
+    }
+
+    madvise(map->data, map->size, MADV_SEQUENTIAL);
+
+    return 0;
+
+error:
+    close(map->fd);
+    map->fd = -1;
+    return -1;
+}
+
+static int se_file_map_output(se_file_map* map, const se_file_map* in, const char* path, size_t max_size)
+/*
+ * Create or truncate the output file, refusing the file that is mapped
+ * as the input. The file is opened without O_TRUNC and only cut after
+ * the check, so a rejected path loses no data.
+ */
+{
+    struct stat in_st;
+    struct stat out_st;
+
+    map->data = 0;
+    map->size = max_size;
+
+    map->fd = open(path, O_RDWR | O_CREAT, 0666);
+    if (map->fd < 0)
+        return -1;
+
+    if (fstat(in->fd, &in_st) < 0 || fstat(map->fd, &out_st) < 0)
+        goto error;
+
+    if (in_st.st_dev == out_st.st_dev && in_st.st_ino == out_st.st_ino)
+    {
+        errno = EINVAL;
+        goto error;
+    }
+
+    if (ftruncate(map->fd, 0) < 0)
+        goto error;
+
+    if (max_size == 0)
+        return 0;
+
+    if (ftruncate(map->fd, (off_t) max_size) < 0)
+        goto error;
+
+    map->data = mmap(0, max_size, PROT_READ | PROT_WRITE, MAP_SHARED, map->fd, 0);
+    if (map->data == MAP_FAILED)
+    {
+        map->data = 0;
+        goto error;
+    }
+
+    madvise(map->data, max_size, MADV_SEQUENTIAL);
+
+    return 0;
+
+error:
+    close(map->fd);
+    map->fd = -1;
+    return -1;
+}
+
+static int se_file_unmap(se_file_map* map)
+{
+    int result;
+
+    result = 0;
+
+    if (map->data && munmap(map->data, map->size) < 0)
+        result = -1;
+
+    if (map->fd >= 0 && close(map->fd) < 0)
+        result = -1;
+
+    map->data = 0;
+    map->fd = -1;
+
+    return result;
+}
+
+static int se_file_finish_output(se_file_map* map, size_t size)
+/*
+ * Unmap the output and cut it to the real length of the conversion.
+ */
+{
+    int result;
+
+    SE_DEBUG_ASSERT(size <= map->size);
+
+    result = 0;
+
+    if (map->data && munmap(map->data, map->size) < 0)
+        result = -1;
+
+    map->data = 0;
+
+    if (result == 0 && ftruncate(map->fd, (off_t) size) < 0)
+        result = -1;
+
+    if (close(map->fd) < 0)
+        result = -1;
+
+    map->fd = -1;
+
+    return result;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Validate Unicode files.                                                 *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API int se_is_valid_utf8_file(const char* path)
+{
+    se_file_map in;
+    sebool valid;
+
+    SE_DEBUG_ASSERT(path);
+
+    if (se_file_map_input(&in, path) < 0)
+        return -1;
+
+    valid = in.size == 0 || se_is_valid_utf8_str_sz((const seunichar8*) in.data, (ptrdiff_t) in.size);
+
+    if (se_file_unmap(&in) < 0)
+        return -1;
+
+    return valid ? 1 : 0;
+}
+
+SE_API int se_is_valid_utf16_file(const char* path)
+{
+    se_file_map in;
+    sebool valid;
+
+    SE_DEBUG_ASSERT(path);
+
+    if (se_file_map_input(&in, path) < 0)
+        return -1;
+
+    /* A trailing odd byte is an incomplete code unit */
+    if (in.size % sizeof(seunichar16))
+        valid = FALSE;
+    else
+        valid = in.size == 0 || se_is_valid_utf16_str_sz((const seunichar16*) in.data, (ptrdiff_t) (in.size / sizeof(seunichar16)));
+
+    if (se_file_unmap(&in) < 0)
+        return -1;
+
+    return valid ? 1 : 0;
+}
+
+SE_API int se_is_valid_utf32_file(const char* path)
+{
+    se_file_map in;
+    sebool valid;
+
+    SE_DEBUG_ASSERT(path);
+
+    if (se_file_map_input(&in, path) < 0)
+        return -1;
+
+    if (in.size % sizeof(seunichar32))
+        valid = FALSE;
+    else
+        valid = in.size == 0 || se_is_valid_utf32_str_sz((const seunichar32*) in.data, (ptrdiff_t) (in.size / sizeof(seunichar32)));
+
+    if (se_file_unmap(&in) < 0)
+        return -1;
+
+    return valid ? 1 : 0;
+}
+
+SE_API const char* se_detect_file_encoding(const char* path, int* confidence)
+/*
+ * Guess the encoding of a file with se_detect_encoding_sz(), or return
+ * NULL with errno set on I/O error.
+ */
+{
+    se_file_map in;
+    const char* name;
+
+    SE_DEBUG_ASSERT(path);
+
+    if (se_file_map_input(&in, path) < 0)
+        return 0;
+
+    name = se_detect_encoding_sz(in.size ? (const char*) in.data : "", (ptrdiff_t) in.size, confidence, 0);
+
+    if (se_file_unmap(&in) < 0)
+        return 0;
+
+    return name;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Validate and convert un-safe Unicode files to safe files.               *
+ * Invalid codes are replaced.                                             *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API int se_unsafe_utf8_file_safe_copy(const char* in_path, const char* out_path)
+{
+    se_file_map in;
+    se_file_map out;
+    ptrdiff_t out_len;
+
+    SE_DEBUG_ASSERT(in_path);
+    SE_DEBUG_ASSERT(out_path);
+
+    if (se_file_map_input(&in, in_path) < 0)
+        return -1;
+
+    if (in.size > (size_t) PTRDIFF_MAX / 3)
+    {
+        se_file_unmap(&in);
+        errno = EFBIG;
+        return -1;
+    }
+
+    if (se_file_map_output(&out, &in, out_path, in.size * 3) < 0)
+    {
+        se_file_unmap(&in);
+        return -1;
+    }
+
+    out_len = 0;
+    if (in.size)
+        out_len = se_unsafe_utf8_str_safe_copy_into((const seunichar8*) in.data, (ptrdiff_t) in.size, (seunichar8*) out.data);
+
+    if (se_file_unmap(&in) < 0)
+    {
+        se_file_finish_output(&out, 0);
+        return -1;
+    }
+
+    return se_file_finish_output(&out, (size_t) out_len);
+}
+
+SE_API int se_unsafe_utf8_file_to_safe_utf16_file(const char* in_path, const char* out_path)
+{
+    se_file_map in;
+    se_file_map out;
+    ptrdiff_t out_len;
+
+    SE_DEBUG_ASSERT(in_path);
+    SE_DEBUG_ASSERT(out_path);
+
+    if (se_file_map_input(&in, in_path) < 0)
+        return -1;
+
+    if (in.size > (size_t) PTRDIFF_MAX / sizeof(seunichar16))
+    {
+        se_file_unmap(&in);
+        errno = EFBIG;
+        return -1;
+    }
+
+    if (se_file_map_output(&out, &in, out_path, in.size * sizeof(seunichar16)) < 0)
+    {
+        se_file_unmap(&in);
+        return -1;
+    }
+
+    out_len = 0;
+    if (in.size)
+        out_len = se_unsafe_utf8_to_safe_utf16_into((const seunichar8*) in.data, (ptrdiff_t) in.size, (seunichar16*) out.data);
+
+    if (se_file_unmap(&in) < 0)
+    {
+        se_file_finish_output(&out, 0);
+        return -1;
+    }
+
+    return se_file_finish_output(&out, (size_t) out_len * sizeof(seunichar16));
+}
+
+SE_API int se_unsafe_utf16_file_to_safe_utf8_file(const char* in_path, const char* out_path)
+{
+    se_file_map in;
+    se_file_map out;
+    ptrdiff_t units;
+    ptrdiff_t out_len;
+
+    SE_DEBUG_ASSERT(in_path);
+    SE_DEBUG_ASSERT(out_path);
+
+    if (se_file_map_input(&in, in_path) < 0)
+        return -1;
+
+    units = (ptrdiff_t) (in.size / sizeof(seunichar16));
+
+    /* One more replacement character for a trailing odd byte */
+    if (units > (PTRDIFF_MAX - 3) / 3)
+    {
+        se_file_unmap(&in);
+        errno = EFBIG;
+        return -1;
+    }
+
+    if (se_file_map_output(&out, &in, out_path, (size_t) units * 3 + 3) < 0)
+    {
+        se_file_unmap(&in);
+        return -1;
+    }
+
+    out_len = 0;
+    if (units)
+        out_len = se_unsafe_utf16_to_safe_utf8_into((const seunichar16*) in.data, units, (seunichar8*) out.data);
+
+    if (in.size % sizeof(seunichar16))
+    {
+        ((unsigned char*) out.data)[out_len++] = 0xEF;
+        ((unsigned char*) out.data)[out_len++] = 0xBF;
+        ((unsigned char*) out.data)[out_len++] = 0xBD;
+    }
+
+    if (se_file_unmap(&in) < 0)
+    {
+        se_file_finish_output(&out, 0);
+        return -1;
+    }
+
+    return se_file_finish_output(&out, (size_t) out_len);
+}
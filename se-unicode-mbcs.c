@@ -0,0 +1,2127 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+#ifndef SE_UNICODE_H
+    #include "se-unicode.h"
+#endif
+
+#ifndef SE_UTILS_H
+    #include "se-utils.h"
+#endif
+
+#ifndef SE_UNICODE_EXT_H
+    #include "se-unicode-ext.h"
+#endif
+
+/*
+ * Conversion between Unicode and the legacy multibyte encodings: GB18030,
+ * Shift_JIS, EUC-KR and Big5.
+ *
+ * Legacy strings are byte strings, taken as un-safe input: a sequence
+ * that is not a character of the encoding is replaced by U+FFFD, and
+ * decoding resumes at its second byte, the same way ill-formed UTF-8 is
+ * replaced by se_unsafe_utf8_to_safe_utf16(). Unicode input must be safe.
+ * A code point without a code in the encoding is replaced by '?'.
+ *
+ * As in se-unicode-string.c, the output length is counted by a first
+ * pass, and the output is allocated at its exact size. ASCII is the same
+ * in all of these encodings, so runs of 16 ASCII characters are copied at
+ * once.
+ *
+ * The _stream functions decode a string that arrives in chunks into a
+ * buffer owned by the caller, without allocating. A character cut at the
+ * end of a chunk is left for the next one.
+ *
+ * The mapping tables are generated by tools/se-mbcs-tables.py.
+ */
+
+/* As in se-unicode-string.c */
+#ifndef SE_OPT_SSE2
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define SE_OPT_SSE2 1
+    #else
+        #define SE_OPT_SSE2 0
+    #endif
+#endif
+
+#if SE_OPT_SSE2
+    #include <emmintrin.h>
+#endif
+
+#define SE_REPLACEMENT_CHAR                 0xFFFD
+#define SE_MBCS_REPLACEMENT_CHAR            '?'
+
+#define SE_IS_HI_SURROGATE(c)       ( (c) >= 0xD800 && (c) < 0xDC00 )
+#define SE_SURROGATE_VALUE(hi, lo)  (seunichar32) ( ((((hi) & 0x3FF) << 10) | ((lo) & 0x3FF)) + 0x10000 )
+
+/***************************************************************************
+ *                                                                         *
+ * Mapping tables.                                                         *
+ *                                                                         *
+ * A double byte code is decoded by a table with one row per lead byte     *
+ * and one column per trail byte of the encoding, found by mapping the     *
+ * bytes, so the bytes that are never used take no room. Single bytes      *
+ * above ASCII that are characters, like the half-width katakana of        *
+ * Shift_JIS, have a table of their own. A code point of the BMP is        *
+ * encoded by a table of the codes of each 256 code point page, where a    *
+ * page only spans from its first to its last mapped code point, and a     *
+ * code below 0x100 is a single byte. Unmapped codes and code points are   *
+ * 0 in all the tables.                                                    *
+ *                                                                         *
+ ***************************************************************************/
+
+typedef struct se_mbcs_page se_mbcs_page;
+
+struct se_mbcs_page
+{
+    unsigned short offset;
+    unsigned char first;
+    unsigned char last;
+};
+
+typedef struct se_gb18030_range se_gb18030_range;
+
+struct se_gb18030_range
+{
+    unsigned short linear;
+    unsigned short code;
+};
+
+typedef struct se_mbcs_codec se_mbcs_codec;
+
+/* The fields are in the order tools/se-mbcs-tables.py writes them */
+struct se_mbcs_codec
+{
+    const unsigned char* rows;          /* Row of each lead byte, or 0xFF */
+    const unsigned char* columns;       /* Column of each trail byte, or 0xFF */
+    int width;                          /* Number of columns */
+    const unsigned short* decode;
+    const unsigned short* single;       /* Bytes 0x80..0xFF, or NULL */
+    const se_mbcs_page* encode_pages;
+    const unsigned short* encode;
+    sebool four_byte;                   /* The four byte codes of GB18030 */
+};
+
+#include "se-unicode-mbcs-tables.h"
+
+static unsigned int se_mbcs_encode_bmp(const se_mbcs_page* pages, const unsigned short* encode, seunichar32 c)
+/*
+ * Return the code of the BMP code point c, lead byte first, or 0 if it has
+ * none.
+ */
+{
+    const se_mbcs_page* page;
+    unsigned int low;
+
+    page = &pages[c >> 8];
+    low = c & 0xFF;
+    if (low < page->first || low > page->last)
+        return 0;
+
+    return encode[page->offset + low - page->first];
+}
+
+/***************************************************************************
+ *                                                                         *
+ * GB18030 four byte codes.                                                *
+ *                                                                         *
+ * The characters of GB18030 that are not ASCII or GBK take four bytes,    *
+ * 0x81..0xFE, 0x30..0x39, 0x81..0xFE and 0x30..0x39, whose linear index   *
+ * counts the four byte codes in order: the BMP code points from 0 in the  *
+ * order of se_gb18030_ranges, and the supplementary code points from      *
+ * SE_GB18030_SUPPLEMENTARY_LINEAR (0x90308130) up.                        *
+ *                                                                         *
+ ***************************************************************************/
+
+#define SE_GB18030_SUPPLEMENTARY_LINEAR     189000
+
+static int se_gb18030_decode_four(const unsigned char* iter, const unsigned char* end, seunichar32* c)
+/*
+ * Decode the four byte code at iter, before end, into *c and return 4.
+ * Return 0 if iter does not start a four byte code.
+ */
+{
+    unsigned int linear;
+    int low;
+    int high;
+    int mid;
+
+    if (end - iter < 4 || iter[0] < 0x81 || iter[0] > 0xFE || iter[1] < 0x30 || iter[1] > 0x39 ||
+        iter[2] < 0x81 || iter[2] > 0xFE || iter[3] < 0x30 || iter[3] > 0x39)
+        return 0;
+
+    linear = (((iter[0] - 0x81) * 10 + iter[1] - 0x30) * 126 + iter[2] - 0x81) * 10 + iter[3] - 0x30;
+
+    if (linear < SE_GB18030_BMP_LINEAR_COUNT)
+    {
+        /* The last range starting at or before linear */
+        low = 0;
+        high = sizeof(se_gb18030_ranges) / sizeof(se_gb18030_ranges[0]) - 1;
+        while (low < high)
+        {
+            mid = (low + high + 1) / 2;
+            if (se_gb18030_ranges[mid].linear <= linear)
+                low = mid;
+            else
+                high = mid - 1;
+        }
+
+        *c = se_gb18030_ranges[low].code + (linear - se_gb18030_ranges[low].linear);
+        return 4;
+    }
+
+    if (linear >= SE_GB18030_SUPPLEMENTARY_LINEAR && linear - SE_GB18030_SUPPLEMENTARY_LINEAR < 0x100000)
+    {
+        *c = linear - SE_GB18030_SUPPLEMENTARY_LINEAR + 0x10000;
+        return 4;
+    }
+
+    return 0;
+}
+
+static int se_gb18030_encode_four(seunichar32 c, unsigned char* buf)
+/*
+ * Encode the code point c, which has no double byte code, into buf as a
+ * four byte code, unless buf is NULL, and return 4.
+ */
+{
+    unsigned int linear;
+    int low;
+    int high;
+    int mid;
+
+    if (c <= 0xFFFF)
+    {
+        /* The last range starting at or before c */
+        low = 0;
+        high = sizeof(se_gb18030_ranges) / sizeof(se_gb18030_ranges[0]) - 1;
+        while (low < high)
+        {
+            mid = (low + high + 1) / 2;
+            if (se_gb18030_ranges[mid].code <= c)
+                low = mid;
+            else
+                high = mid - 1;
+        }
+
+        linear = se_gb18030_ranges[low].linear + (c - se_gb18030_ranges[low].code);
+    }
+    else
+    {
+        linear = c - 0x10000 + SE_GB18030_SUPPLEMENTARY_LINEAR;
+    }
+
+    if (buf)
+    {
+        buf[3] = (unsigned char) (0x30 + linear % 10);
+        linear /= 10;
+        buf[2] = (unsigned char) (0x81 + linear % 126);
+        linear /= 126;
+        buf[1] = (unsigned char) (0x30 + linear % 10);
+        linear /= 10;
+        buf[0] = (unsigned char) (0x81 + linear);
+    }
+
+    return 4;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Characters.                                                             *
+ *                                                                         *
+ ***************************************************************************/
+
+static int se_mbcs_decode_char(const se_mbcs_codec* codec, const unsigned char* iter, const unsigned char* end, seunichar32* c)
+/*
+ * Decode the non-ASCII character at iter, before end, into *c and return
+ * its length in bytes. Return 0 if iter does not start a character.
+ */
+{
+    unsigned int row;
+    unsigned int column;
+
+    row = codec->rows[iter[0]];
+    if (row == 0xFF)
+    {
+        if (codec->single && codec->single[iter[0] - 0x80])
+        {
+            *c = codec->single[iter[0] - 0x80];
+            return 1;
+        }
+        return 0;
+    }
+
+    if (end - iter < 2)
+        return 0;
+
+    column = codec->columns[iter[1]];
+    if (column != 0xFF)
+    {
+        *c = codec->decode[row * codec->width + column];
+        return *c ? 2 : 0;
+    }
+
+    if (codec->four_byte)
+        return se_gb18030_decode_four(iter, end, c);
+
+    return 0;
+}
+
+static sebool se_mbcs_is_cut_char(const se_mbcs_codec* codec, const unsigned char* iter, const unsigned char* end)
+/*
+ * Return whether the bytes from iter to end, which se_mbcs_decode_char()
+ * does not decode, may be a character cut by end.
+ */
+{
+    if (end - iter >= 4 || codec->rows[iter[0]] == 0xFF)
+        return FALSE;
+
+    if (end - iter == 1)
+        return TRUE;
+
+    if (!codec->four_byte || iter[1] < 0x30 || iter[1] > 0x39)
+        return FALSE;
+
+    return end - iter == 2 || (iter[2] >= 0x81 && iter[2] <= 0xFE);
+}
+
+static int se_mbcs_encode_char(const se_mbcs_codec* codec, seunichar32 c, unsigned char* buf)
+/*
+ * Encode the non-ASCII code point c into buf, unless buf is NULL, and
+ * return the length of its code in bytes. A code point without a code is
+ * encoded as SE_MBCS_REPLACEMENT_CHAR.
+ */
+{
+    unsigned int code;
+
+    code = c <= 0xFFFF ? se_mbcs_encode_bmp(codec->encode_pages, codec->encode, c) : 0;
+
+    if (code > 0xFF)
+    {
+        if (buf)
+        {
+            buf[0] = (unsigned char) (code >> 8);
+            buf[1] = (unsigned char) code;
+        }
+        return 2;
+    }
+
+    if (code)
+    {
+        if (buf)
+            buf[0] = (unsigned char) code;
+        return 1;
+    }
+
+    if (codec->four_byte)
+        return se_gb18030_encode_four(c, buf);
+
+    if (buf)
+        buf[0] = SE_MBCS_REPLACEMENT_CHAR;
+    return 1;
+}
+
+static unsigned char* se_mbcs_put_utf8(seunichar32 c, unsigned char* new_str_iter)
+/*
+ * Write the non-ASCII code point c as UTF-8 at new_str_iter, and return
+ * the end of it.
+ */
+{
+    if (c <= 0x7FF)
+    {
+        new_str_iter[0] = (unsigned char) (0xC0 | (c >> 6));
+        new_str_iter[1] = (unsigned char) (0x80 | (c & 0x3F));
+        return new_str_iter + 2;
+    }
+    else if (c <= 0xFFFF)
+    {
+        new_str_iter[0] = (unsigned char) (0xE0 | (c >> 12));
+        new_str_iter[1] = (unsigned char) (0x80 | ((c >> 6) & 0x3F));
+        new_str_iter[2] = (unsigned char) (0x80 | (c & 0x3F));
+        return new_str_iter + 3;
+    }
+    else
+    {
+        new_str_iter[0] = (unsigned char) (0xF0 | (c >> 18));
+        new_str_iter[1] = (unsigned char) (0x80 | ((c >> 12) & 0x3F));
+        new_str_iter[2] = (unsigned char) (0x80 | ((c >> 6) & 0x3F));
+        new_str_iter[3] = (unsigned char) (0x80 | (c & 0x3F));
+        return new_str_iter + 4;
+    }
+}
+
+static const unsigned char* se_mbcs_safe_utf8_next(const unsigned char* iter, seunichar32* c)
+/*
+ * Decode the character at iter of a well-formed UTF-8 string into *c, and
+ * return the start of the next one.
+ */
+{
+    if (iter[0] <= 0x7F)
+    {
+        *c = iter[0];
+        return iter + 1;
+    }
+    else if (iter[0] <= 0xDF)
+    {
+        *c = ((iter[0] & 0x1F) << 6) | (iter[1] & 0x3F);
+        return iter + 2;
+    }
+    else if (iter[0] <= 0xEF)
+    {
+        *c = ((iter[0] & 0x0F) << 12) | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F);
+        return iter + 3;
+    }
+    else
+    {
+        SE_DEBUG_ASSERT(iter[0] <= 0xF4);
+        *c = ((iter[0] & 0x07) << 18) | ((iter[1] & 0x3F) << 12) | ((iter[2] & 0x3F) << 6) | (iter[3] & 0x3F);
+        return iter + 4;
+    }
+}
+
+#if SE_OPT_SSE2
+static sebool se_mbcs_utf16_ascii_16(const seunichar16* iter)
+/*
+ * Return whether the 16 units at iter are all below U+0080.
+ */
+{
+    __m128i units;
+
+    units = _mm_or_si128(_mm_loadu_si128((const __m128i*)iter), _mm_loadu_si128((const __m128i*)(iter + 8)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16((short) 0xFF80)), _mm_setzero_si128())) == 0xFFFF;
+}
+#endif
+
+/***************************************************************************
+ *                                                                         *
+ * Strings.                                                                *
+ *                                                                         *
+ * Each conversion is done by a pair of functions over any of the          *
+ * encodings, one counting the length of the output and one writing it.    *
+ *                                                                         *
+ ***************************************************************************/
+
+static ptrdiff_t se_mbcs_utf8_len(const se_mbcs_codec* codec, const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in bytes of the string from iter to end once
+ * converted to UTF-8.
+ */
+{
+    ptrdiff_t new_str_len;
+    seunichar32 c;
+    int len;
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)iter)))
+                {
+                    new_str_len += 16;
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            new_str_len++;
+            iter++;
+        }
+        else if ((len = se_mbcs_decode_char(codec, iter, end, &c)) != 0)
+        {
+            new_str_len += c <= 0x7FF ? 2 : c <= 0xFFFF ? 3 : 4;
+            iter += len;
+        }
+        else
+        {
+            new_str_len += 3;
+            iter++;
+        }
+    }
+
+    return new_str_len;
+}
+
+static unsigned char* se_mbcs_utf8_fill(const se_mbcs_codec* codec, const unsigned char* iter, const unsigned char* end, const unsigned char** tail, unsigned char* new_str_iter)
+/*
+ * Convert the string from iter to end into new_str_iter, which has room
+ * for se_mbcs_utf8_len() bytes, and return the end of the output.
+ *
+ * If tail is not NULL, a character cut by end is not converted, and the
+ * end of the converted input is returned in *tail.
+ */
+{
+    seunichar32 c;
+    int len;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16)
+                {
+                    __m128i block;
+
+                    block = _mm_loadu_si128((const __m128i*)iter);
+                    if (!_mm_movemask_epi8(block))
+                    {
+                        _mm_storeu_si128((__m128i*)new_str_iter, block);
+                        new_str_iter += 16;
+                        iter += 16;
+                        continue;
+                    }
+                }
+            #endif
+            *new_str_iter++ = *iter++;
+        }
+        else if ((len = se_mbcs_decode_char(codec, iter, end, &c)) != 0)
+        {
+            new_str_iter = se_mbcs_put_utf8(c, new_str_iter);
+            iter += len;
+        }
+        else
+        {
+            if (tail && se_mbcs_is_cut_char(codec, iter, end))
+                break;
+
+            new_str_iter = se_mbcs_put_utf8(SE_REPLACEMENT_CHAR, new_str_iter);
+            iter++;
+        }
+    }
+
+    if (tail)
+        *tail = iter;
+
+    return new_str_iter;
+}
+
+static ptrdiff_t se_mbcs_utf16_len(const se_mbcs_codec* codec, const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in UTF-16 units of the string from iter to end once
+ * converted to UTF-16.
+ */
+{
+    ptrdiff_t new_str_len;
+    seunichar32 c;
+    int len;
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)iter)))
+                {
+                    new_str_len += 16;
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            new_str_len++;
+            iter++;
+        }
+        else if ((len = se_mbcs_decode_char(codec, iter, end, &c)) != 0)
+        {
+            new_str_len += c >= 0x10000 ? 2 : 1;
+            iter += len;
+        }
+        else
+        {
+            new_str_len++;
+            iter++;
+        }
+    }
+
+    return new_str_len;
+}
+
+static seunichar16* se_mbcs_utf16_fill(const se_mbcs_codec* codec, const unsigned char* iter, const unsigned char* end, const unsigned char** tail, seunichar16* new_str_iter)
+/*
+ * Convert the string from iter to end into new_str_iter, which has room
+ * for se_mbcs_utf16_len() units, and return the end of the output, as by
+ * se_mbcs_utf8_fill().
+ */
+{
+    seunichar32 c;
+    int len;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16)
+                {
+                    __m128i block;
+
+                    block = _mm_loadu_si128((const __m128i*)iter);
+                    if (!_mm_movemask_epi8(block))
+                    {
+                        _mm_storeu_si128((__m128i*)new_str_iter, _mm_unpacklo_epi8(block, _mm_setzero_si128()));
+                        _mm_storeu_si128((__m128i*)(new_str_iter + 8), _mm_unpackhi_epi8(block, _mm_setzero_si128()));
+                        new_str_iter += 16;
+                        iter += 16;
+                        continue;
+                    }
+                }
+            #endif
+            *new_str_iter++ = *iter++;
+        }
+        else if ((len = se_mbcs_decode_char(codec, iter, end, &c)) != 0)
+        {
+            if (c >= 0x10000)
+            {
+                c -= 0x10000;
+                new_str_iter[0] = (seunichar16) (0xD800 | (c >> 10));
+                new_str_iter[1] = (seunichar16) (0xDC00 | (c & 0x3FF));
+                new_str_iter += 2;
+            }
+            else
+            {
+                *new_str_iter++ = (seunichar16) c;
+            }
+            iter += len;
+        }
+        else
+        {
+            if (tail && se_mbcs_is_cut_char(codec, iter, end))
+                break;
+
+            *new_str_iter++ = SE_REPLACEMENT_CHAR;
+            iter++;
+        }
+    }
+
+    if (tail)
+        *tail = iter;
+
+    return new_str_iter;
+}
+
+static ptrdiff_t se_safe_utf8_mbcs_len(const se_mbcs_codec* codec, const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in bytes of the well-formed UTF-8 string from iter to
+ * end once converted to the encoding.
+ */
+{
+    ptrdiff_t new_str_len;
+    seunichar32 c;
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)iter)))
+                {
+                    new_str_len += 16;
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            new_str_len++;
+            iter++;
+        }
+        else
+        {
+            iter = se_mbcs_safe_utf8_next(iter, &c);
+            new_str_len += se_mbcs_encode_char(codec, c, 0);
+        }
+    }
+
+    return new_str_len;
+}
+
+static unsigned char* se_safe_utf8_mbcs_fill(const se_mbcs_codec* codec, const unsigned char* iter, const unsigned char* end, unsigned char* new_str_iter)
+/*
+ * Convert the well-formed UTF-8 string from iter to end into new_str_iter,
+ * which has room for se_safe_utf8_mbcs_len() bytes, and return the end of
+ * the output.
+ */
+{
+    seunichar32 c;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16)
+                {
+                    __m128i block;
+
+                    block = _mm_loadu_si128((const __m128i*)iter);
+                    if (!_mm_movemask_epi8(block))
+                    {
+                        _mm_storeu_si128((__m128i*)new_str_iter, block);
+                        new_str_iter += 16;
+                        iter += 16;
+                        continue;
+                    }
+                }
+            #endif
+            *new_str_iter++ = *iter++;
+        }
+        else
+        {
+            iter = se_mbcs_safe_utf8_next(iter, &c);
+            new_str_iter += se_mbcs_encode_char(codec, c, new_str_iter);
+        }
+    }
+
+    return new_str_iter;
+}
+
+static ptrdiff_t se_safe_utf16_mbcs_len(const se_mbcs_codec* codec, const seunichar16* iter, const seunichar16* end)
+/*
+ * Return the length in bytes of the well-formed UTF-16 string from iter to
+ * end once converted to the encoding.
+ */
+{
+    ptrdiff_t new_str_len;
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && se_mbcs_utf16_ascii_16(iter))
+                {
+                    new_str_len += 16;
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            new_str_len++;
+            iter++;
+        }
+        else if (SE_IS_HI_SURROGATE(iter[0]))
+        {
+            new_str_len += se_mbcs_encode_char(codec, SE_SURROGATE_VALUE(iter[0], iter[1]), 0);
+            iter += 2;
+        }
+        else
+        {
+            new_str_len += se_mbcs_encode_char(codec, iter[0], 0);
+            iter++;
+        }
+    }
+
+    return new_str_len;
+}
+
+static unsigned char* se_safe_utf16_mbcs_fill(const se_mbcs_codec* codec, const seunichar16* iter, const seunichar16* end, unsigned char* new_str_iter)
+/*
+ * Convert the well-formed UTF-16 string from iter to end into
+ * new_str_iter, which has room for se_safe_utf16_mbcs_len() bytes, and
+ * return the end of the output.
+ */
+{
+    seunichar32 c;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && se_mbcs_utf16_ascii_16(iter))
+                {
+                    _mm_storeu_si128((__m128i*)new_str_iter, _mm_packus_epi16(_mm_loadu_si128((const __m128i*)iter), _mm_loadu_si128((const __m128i*)(iter + 8))));
+                    new_str_iter += 16;
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            *new_str_iter++ = (unsigned char) *iter++;
+        }
+        else
+        {
+            if (SE_IS_HI_SURROGATE(iter[0]))
+            {
+                c = SE_SURROGATE_VALUE(iter[0], iter[1]);
+                iter += 2;
+            }
+            else
+            {
+                c = iter[0];
+                iter++;
+            }
+            new_str_iter += se_mbcs_encode_char(codec, c, new_str_iter);
+        }
+    }
+
+    return new_str_iter;
+}
+
+static seunichar8* se_mbcs_to_utf8(const se_mbcs_codec* codec, const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    seunichar8* new_str;
+    unsigned char* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz((const seunichar8*)str);
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_mbcs_utf8_len(codec, iter, end);
+
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar8));
+
+    new_str_iter = se_mbcs_utf8_fill(codec, iter, end, 0, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    *new_str_iter = 0;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(new_str, new_str_len));
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static seunichar16* se_mbcs_to_utf16(const se_mbcs_codec* codec, const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    seunichar16* new_str;
+    seunichar16* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz((const seunichar8*)str);
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_mbcs_utf16_len(codec, iter, end);
+
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar16));
+
+    new_str_iter = se_mbcs_utf16_fill(codec, iter, end, 0, new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
+    *new_str_iter = 0;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(new_str, new_str_len));
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static char* se_safe_utf8_to_mbcs(const se_mbcs_codec* codec, const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    char* new_str;
+    unsigned char* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(str, len));
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_safe_utf8_mbcs_len(codec, iter, end);
+
+    new_str = SE_MALLOC(new_str_len + 1);
+
+    new_str_iter = se_safe_utf8_mbcs_fill(codec, iter, end, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    *new_str_iter = 0;
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static char* se_safe_utf16_to_mbcs(const se_mbcs_codec* codec, const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    char* new_str;
+    unsigned char* new_str_iter;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(str, len));
+
+    if (len < 0)
+        len = se_utf16_str_len_sz(str);
+
+    new_str_len = se_safe_utf16_mbcs_len(codec, str, str + len);
+
+    new_str = SE_MALLOC(new_str_len + 1);
+
+    new_str_iter = se_safe_utf16_mbcs_fill(codec, str, str + len, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    *new_str_iter = 0;
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static ptrdiff_t se_mbcs_to_utf8_stream(const se_mbcs_codec* codec, const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar8* buf)
+{
+    const unsigned char* iter;
+    const unsigned char* tail;
+    unsigned char* buf_end;
+
+    SE_DEBUG_ASSERT(str);
+    SE_DEBUG_ASSERT(buf);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz((const seunichar8*)str);
+
+    iter = (const unsigned char*)str;
+    tail = iter + len;
+    buf_end = se_mbcs_utf8_fill(codec, iter, iter + len, flush ? 0 : &tail, (unsigned char*)buf);
+
+    SE_DEBUG_ASSERT(iter + len - tail < 4);
+
+    if (in_len)
+        *in_len = tail - iter;
+
+    return buf_end - (unsigned char*)buf;
+}
+
+static ptrdiff_t se_mbcs_to_utf16_stream(const se_mbcs_codec* codec, const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar16* buf)
+{
+    const unsigned char* iter;
+    const unsigned char* tail;
+    seunichar16* buf_end;
+
+    SE_DEBUG_ASSERT(str);
+    SE_DEBUG_ASSERT(buf);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz((const seunichar8*)str);
+
+    iter = (const unsigned char*)str;
+    tail = iter + len;
+    buf_end = se_mbcs_utf16_fill(codec, iter, iter + len, flush ? 0 : &tail, buf);
+
+    SE_DEBUG_ASSERT(iter + len - tail < 4);
+
+    if (in_len)
+        *in_len = tail - iter;
+
+    return buf_end - buf;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * GB18030.                                                                *
+ *                                                                         *
+ * GB18030 encodes every code point, and includes GBK and GB2312. ASCII    *
+ * takes one byte. The GBK characters take two bytes, a lead 0x81..0xFE    *
+ * and a trail 0x40..0x7E or 0x80..0xFE, and all the other characters      *
+ * take four bytes.                                                        *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API seunichar8* se_unsafe_gb18030_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * str:
+ *      Input GB18030 encoded string.
+ *
+ * len:
+ *      The byte length of input string.
+ *      If len < 0, then the string is NUL terminated.
+ *
+ * out_len:
+ *      Location to return the length of the output string.
+ *      (Can be NULL to indicate that the result is not needed.)
+ *
+ * Convert a string from GB18030, or GBK or GB2312, to UTF-8.
+ * Invalid codes are replaced.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_mbcs_to_utf8(&se_gb18030_codec, str, len, out_len);
+}
+
+SE_API seunichar8* se_unsafe_gb18030_to_safe_utf8(const char* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_gb18030_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_unsafe_gb18030_to_safe_utf8_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar8* buf)
+/*
+ * str:
+ *      A chunk of a GB18030 encoded string.
+ *
+ * len:
+ *      The byte length of the chunk.
+ *      If len < 0, then the chunk is NUL terminated.
+ *
+ * flush:
+ *      Whether the chunk ends the string. If not, a character cut at
+ *      the end of the chunk is not converted.
+ *
+ * in_len:
+ *      Location to return the number of bytes converted. The bytes
+ *      after them, at most 3, start the next chunk.
+ *      (Can be NULL to indicate that the result is not needed.)
+ *
+ * buf:
+ *      The output buffer, with room for at least 3 * len bytes.
+ *
+ * Convert a chunk of a string as by se_unsafe_gb18030_to_safe_utf8()
+ * into a buffer owned by the caller. The output is not NUL terminated.
+ *
+ * Return:
+ *      The byte length of the output.
+ */
+{
+    return se_mbcs_to_utf8_stream(&se_gb18030_codec, str, len, flush, in_len, buf);
+}
+
+SE_API seunichar16* se_unsafe_gb18030_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from GB18030 to UTF-16, as by
+ * se_unsafe_gb18030_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_mbcs_to_utf16(&se_gb18030_codec, str, len, out_len);
+}
+
+SE_API seunichar16* se_unsafe_gb18030_to_safe_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_gb18030_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_unsafe_gb18030_to_safe_utf16_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar16* buf)
+/*
+ * buf:
+ *      The output buffer, with room for at least len UTF-16 units.
+ *
+ * Convert a chunk of a string from GB18030 to UTF-16, as by
+ * se_unsafe_gb18030_to_safe_utf8_stream().
+ *
+ * Return:
+ *      The length in UTF-16 units of the output.
+ */
+{
+    return se_mbcs_to_utf16_stream(&se_gb18030_codec, str, len, flush, in_len, buf);
+}
+
+SE_API char* se_safe_utf8_to_gb18030_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-8 to GB18030.
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated GB18030 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf8_to_mbcs(&se_gb18030_codec, str, len, out_len);
+}
+
+SE_API char* se_safe_utf8_to_gb18030(const seunichar8* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_gb18030_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf16_to_gb18030_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16 to GB18030.
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated GB18030 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf16_to_mbcs(&se_gb18030_codec, str, len, out_len);
+}
+
+SE_API char* se_safe_utf16_to_gb18030(const seunichar16* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf16_to_gb18030_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Shift_JIS.                                                              *
+ *                                                                         *
+ * Shift_JIS encodes JIS X 0208. ASCII takes one byte, the half-width      *
+ * katakana one byte 0xA1..0xDF, and the other characters two bytes, a     *
+ * lead 0x81..0x9F or 0xE0..0xEA and a trail 0x40..0x7E or 0x80..0xFC.     *
+ * 0x5C and 0x7E are taken as ASCII, not as the yen sign and overline of   *
+ * JIS X 0201.                                                             *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API seunichar8* se_unsafe_shift_jis_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from Shift_JIS to UTF-8, as by
+ * se_unsafe_gb18030_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_mbcs_to_utf8(&se_shift_jis_codec, str, len, out_len);
+}
+
+SE_API seunichar8* se_unsafe_shift_jis_to_safe_utf8(const char* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_shift_jis_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_unsafe_shift_jis_to_safe_utf8_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar8* buf)
+/*
+ * Convert a chunk of a string from Shift_JIS to UTF-8, as by
+ * se_unsafe_gb18030_to_safe_utf8_stream().
+ *
+ * Return:
+ *      The byte length of the output.
+ */
+{
+    return se_mbcs_to_utf8_stream(&se_shift_jis_codec, str, len, flush, in_len, buf);
+}
+
+SE_API seunichar16* se_unsafe_shift_jis_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from Shift_JIS to UTF-16, as by
+ * se_unsafe_gb18030_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_mbcs_to_utf16(&se_shift_jis_codec, str, len, out_len);
+}
+
+SE_API seunichar16* se_unsafe_shift_jis_to_safe_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_shift_jis_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_unsafe_shift_jis_to_safe_utf16_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar16* buf)
+/*
+ * Convert a chunk of a string from Shift_JIS to UTF-16, as by
+ * se_unsafe_gb18030_to_safe_utf16_stream().
+ *
+ * Return:
+ *      The length in UTF-16 units of the output.
+ */
+{
+    return se_mbcs_to_utf16_stream(&se_shift_jis_codec, str, len, flush, in_len, buf);
+}
+
+SE_API char* se_safe_utf8_to_shift_jis_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-8 to Shift_JIS.
+ * Assuming the input string is well-formed.
+ * Code points without a code are replaced by '?'.
+ *
+ * Return:
+ *      A pointer to a newly allocated Shift_JIS string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf8_to_mbcs(&se_shift_jis_codec, str, len, out_len);
+}
+
+SE_API char* se_safe_utf8_to_shift_jis(const seunichar8* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_shift_jis_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf16_to_shift_jis_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16 to Shift_JIS, as by se_safe_utf8_to_shift_jis().
+ *
+ * Return:
+ *      A pointer to a newly allocated Shift_JIS string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf16_to_mbcs(&se_shift_jis_codec, str, len, out_len);
+}
+
+SE_API char* se_safe_utf16_to_shift_jis(const seunichar16* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf16_to_shift_jis_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * EUC-KR.                                                                 *
+ *                                                                         *
+ * EUC-KR encodes KS X 1001. ASCII takes one byte, and the other           *
+ * characters two bytes, a lead and a trail 0xA1..0xFE. The Hangul         *
+ * syllables outside KS X 1001 have no code: the eight byte sequences of   *
+ * its annex are neither decoded nor encoded.                              *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API seunichar8* se_unsafe_euc_kr_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from EUC-KR to UTF-8, as by
+ * se_unsafe_gb18030_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_mbcs_to_utf8(&se_euc_kr_codec, str, len, out_len);
+}
+
+SE_API seunichar8* se_unsafe_euc_kr_to_safe_utf8(const char* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_euc_kr_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_unsafe_euc_kr_to_safe_utf8_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar8* buf)
+/*
+ * Convert a chunk of a string from EUC-KR to UTF-8, as by
+ * se_unsafe_gb18030_to_safe_utf8_stream().
+ *
+ * Return:
+ *      The byte length of the output.
+ */
+{
+    return se_mbcs_to_utf8_stream(&se_euc_kr_codec, str, len, flush, in_len, buf);
+}
+
+SE_API seunichar16* se_unsafe_euc_kr_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from EUC-KR to UTF-16, as by
+ * se_unsafe_gb18030_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_mbcs_to_utf16(&se_euc_kr_codec, str, len, out_len);
+}
+
+SE_API seunichar16* se_unsafe_euc_kr_to_safe_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_euc_kr_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_unsafe_euc_kr_to_safe_utf16_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar16* buf)
+/*
+ * Convert a chunk of a string from EUC-KR to UTF-16, as by
+ * se_unsafe_gb18030_to_safe_utf16_stream().
+ *
+ * Return:
+ *      The length in UTF-16 units of the output.
+ */
+{
+    return se_mbcs_to_utf16_stream(&se_euc_kr_codec, str, len, flush, in_len, buf);
+}
+
+SE_API char* se_safe_utf8_to_euc_kr_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-8 to EUC-KR.
+ * Assuming the input string is well-formed.
+ * Code points without a code are replaced by '?'.
+ *
+ * Return:
+ *      A pointer to a newly allocated EUC-KR string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf8_to_mbcs(&se_euc_kr_codec, str, len, out_len);
+}
+
+SE_API char* se_safe_utf8_to_euc_kr(const seunichar8* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_euc_kr_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf16_to_euc_kr_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16 to EUC-KR, as by se_safe_utf8_to_euc_kr().
+ *
+ * Return:
+ *      A pointer to a newly allocated EUC-KR string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf16_to_mbcs(&se_euc_kr_codec, str, len, out_len);
+}
+
+SE_API char* se_safe_utf16_to_euc_kr(const seunichar16* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf16_to_euc_kr_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Big5.                                                                   *
+ *                                                                         *
+ * ASCII takes one byte, and the other characters of Big5 two bytes, a     *
+ * lead 0xA1..0xF9 and a trail 0x40..0x7E or 0xA1..0xFE. The extensions of *
+ * the vendors, like HKSCS, are not included. Four code points have two    *
+ * codes each, and are encoded as the second.                              *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API seunichar8* se_unsafe_big5_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from Big5 to UTF-8, as by
+ * se_unsafe_gb18030_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_mbcs_to_utf8(&se_big5_codec, str, len, out_len);
+}
+
+SE_API seunichar8* se_unsafe_big5_to_safe_utf8(const char* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_big5_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_unsafe_big5_to_safe_utf8_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar8* buf)
+/*
+ * Convert a chunk of a string from Big5 to UTF-8, as by
+ * se_unsafe_gb18030_to_safe_utf8_stream().
+ *
+ * Return:
+ *      The byte length of the output.
+ */
+{
+    return se_mbcs_to_utf8_stream(&se_big5_codec, str, len, flush, in_len, buf);
+}
+
+SE_API seunichar16* se_unsafe_big5_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from Big5 to UTF-16, as by
+ * se_unsafe_gb18030_to_safe_utf8().
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_mbcs_to_utf16(&se_big5_codec, str, len, out_len);
+}
+
+SE_API seunichar16* se_unsafe_big5_to_safe_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_big5_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_unsafe_big5_to_safe_utf16_stream(const char* str, ptrdiff_t len, sebool flush, ptrdiff_t* in_len, seunichar16* buf)
+/*
+ * Convert a chunk of a string from Big5 to UTF-16, as by
+ * se_unsafe_gb18030_to_safe_utf16_stream().
+ *
+ * Return:
+ *      The length in UTF-16 units of the output.
+ */
+{
+    return se_mbcs_to_utf16_stream(&se_big5_codec, str, len, flush, in_len, buf);
+}
+
+SE_API char* se_safe_utf8_to_big5_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-8 to Big5.
+ * Assuming the input string is well-formed.
+ * Code points without a code are replaced by '?'.
+ *
+ * Return:
+ *      A pointer to a newly allocated Big5 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf8_to_mbcs(&se_big5_codec, str, len, out_len);
+}
+
+SE_API char* se_safe_utf8_to_big5(const seunichar8* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_big5_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf16_to_big5_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16 to Big5, as by se_safe_utf8_to_big5().
+ *
+ * Return:
+ *      A pointer to a newly allocated Big5 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf16_to_mbcs(&se_big5_codec, str, len, out_len);
+}
+
+SE_API char* se_safe_utf16_to_big5(const seunichar16* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf16_to_big5_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Encoding detection.                                                     *
+ *                                                                         *
+ * Only a prefix of SE_DETECT_PREFIX_LEN bytes is looked at. A byte order  *
+ * mark settles the encoding. Otherwise one pass counts the NUL bytes at   *
+ * each position modulo 4, which give away UTF-16 and UTF-32 text with     *
+ * ASCII in it, and the bytes above ASCII. Text with bytes above ASCII and *
+ * without NULs is UTF-8 if se_is_valid_utf8_str() takes it. Else both     *
+ * byte orders of UTF-16 are scored by se_detect_utf16(), and the better   *
+ * one competes with the legacy encodings, as scored by se_detect_score(), *
+ * and with ISO-8859-1, as scored by se_detect_latin1(). The confidence   *
+ * of such a guess is capped when few bytes are above ASCII.               *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SE_DETECT_PREFIX_LEN
+    #define SE_DETECT_PREFIX_LEN    65536
+#endif
+
+/* ASCII letters and the space */
+#define SE_DETECT_IS_LATIN(b)       ( (((b) | 0x20) >= 'a' && ((b) | 0x20) <= 'z') || (b) == ' ' )
+
+typedef struct se_detect_counts se_detect_counts;
+
+struct se_detect_counts
+{
+    ptrdiff_t zeros[4];                 /* NUL bytes at each offset modulo 4 */
+    ptrdiff_t high;                     /* Bytes 0x80..0xFF */
+    ptrdiff_t trail;                    /* Bytes 0x80..0xBF */
+};
+
+#if SE_OPT_SSE2
+static int se_detect_popcount16(unsigned int mask)
+{
+    mask = mask - ((mask >> 1) & 0x5555);
+    mask = (mask & 0x3333) + ((mask >> 2) & 0x3333);
+    mask = (mask + (mask >> 4)) & 0x0F0F;
+    return (mask + (mask >> 8)) & 0x1F;
+}
+#endif
+
+static void se_detect_count_bytes(const unsigned char* iter, const unsigned char* end, se_detect_counts* counts)
+/*
+ * Count the bytes from iter to end into counts. The offsets are relative
+ * to iter.
+ */
+{
+    const unsigned char* start;
+    int i;
+
+    start = iter;
+
+    for (i = 0; i < 4; i++)
+        counts->zeros[i] = 0;
+    counts->high = 0;
+    counts->trail = 0;
+
+    #if SE_OPT_SSE2
+        while (end - iter >= 16)
+        {
+            __m128i block;
+            unsigned int zeros;
+            unsigned int high;
+
+            block = _mm_loadu_si128((const __m128i*)iter);
+            zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_setzero_si128()));
+            high = _mm_movemask_epi8(block);
+
+            if (zeros)
+            {
+                for (i = 0; i < 4; i++)
+                    counts->zeros[i] += se_detect_popcount16(zeros & (0x1111 << i));
+            }
+
+            if (high)
+            {
+                /* 0x80..0xBF are the signed bytes below -64 */
+                counts->high += se_detect_popcount16(high);
+                counts->trail += se_detect_popcount16(_mm_movemask_epi8(_mm_cmplt_epi8(block, _mm_set1_epi8(-64))));
+            }
+
+            iter += 16;
+        }
+    #endif
+
+    while (iter < end)
+    {
+        if (iter[0] == 0)
+            counts->zeros[(iter - start) & 3]++;
+        else if (iter[0] >= 0x80)
+        {
+            counts->high++;
+            if (iter[0] <= 0xBF)
+                counts->trail++;
+        }
+        iter++;
+    }
+}
+
+static const unsigned char* se_detect_utf8_cut(const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the start of the UTF-8 sequence cut by end, or end if there is
+ * none, for a prefix of a longer string.
+ */
+{
+    const unsigned char* lead;
+    int need;
+
+    lead = end;
+    while (lead > iter && end - lead < 3 && (lead[-1] & 0xC0) == 0x80)
+        lead--;
+
+    if (lead == iter || lead[-1] < 0xC0)
+        return end;
+
+    lead--;
+    need = lead[0] >= 0xF0 ? 4 : lead[0] >= 0xE0 ? 3 : 2;
+
+    return end - lead < need ? lead : end;
+}
+
+static int se_detect_score(const se_mbcs_codec* codec, const unsigned char* iter, const unsigned char* end)
+/*
+ * Return how well the text from iter to end decodes in the encoding, from
+ * 0 to 100.
+ *
+ * The score is the share of the non-ASCII characters that decode, times
+ * the share that look like text of the encoding. The encodings that share
+ * the byte ranges of EUC are told apart by what the text decodes to: the
+ * Japanese kana for Shift_JIS, the Hangul syllables for EUC-KR, trail
+ * bytes below 0xA1 for Big5, and for GB18030 codes inside the EUC ranges
+ * or of four bytes, which other text seldom has by chance. The other codes
+ * of two bytes above ASCII, where GBK has most Traditional Chinese, count
+ * half, as CJK in UTF-16 reads as these too.
+ * Code points of the Private Use Area do not count as decoded.
+ */
+{
+    ptrdiff_t chars;
+    ptrdiff_t invalid;
+    ptrdiff_t kana;
+    ptrdiff_t hangul;
+    ptrdiff_t euc;
+    ptrdiff_t gbk;
+    ptrdiff_t four;
+    ptrdiff_t typical;
+    seunichar32 c;
+    int len;
+
+    chars = 0;
+    invalid = 0;
+    kana = 0;
+    hangul = 0;
+    euc = 0;
+    gbk = 0;
+    four = 0;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)iter)))
+                {
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            iter++;
+        }
+        else if ((len = se_mbcs_decode_char(codec, iter, end, &c)) != 0 && !(c >= 0xE000 && c <= 0xF8FF))
+        {
+            chars++;
+            if (c >= 0x3040 && c <= 0x30FF)
+                kana++;
+            else if (c >= 0xAC00 && c <= 0xD7A3)
+                hangul++;
+            if (len == 2 && iter[0] >= 0xA1 && iter[1] >= 0xA1)
+                euc++;
+            else if (len == 2 && iter[1] >= 0x80)
+                gbk++;
+            else if (len == 4)
+                four++;
+            iter += len;
+        }
+        else
+        {
+            /* The prefix may cut the last character */
+            if (se_mbcs_is_cut_char(codec, iter, end))
+                break;
+            invalid++;
+            iter++;
+        }
+    }
+
+    if (chars == 0)
+        return 0;
+
+    if (codec == &se_shift_jis_codec)
+        typical = chars / 2 + kana * 5;
+    else if (codec == &se_euc_kr_codec)
+        typical = hangul * 5 / 4;
+    else if (codec == &se_big5_codec)
+        typical = chars / 2 + (chars - euc) * 2;
+    else
+        typical = euc + four + gbk / 2;
+
+    if (typical > chars)
+        typical = chars;
+
+    return (int) (100 * typical / (chars + invalid));
+}
+
+static int se_detect_utf16(const unsigned char* iter, const unsigned char* end, sebool big_endian)
+/*
+ * Return how well the text from iter to end reads as UTF-16 of the byte
+ * order, from 0 to 100.
+ *
+ * The score is the share of the units that are in the blocks common in
+ * text, CJK ideographs and punctuation, kana, Hangul syllables and full
+ * width forms, or that are well paired surrogates. ASCII units only count
+ * half: a CJK character at a multiple of 256 reads as ASCII in the wrong
+ * byte order, and ASCII heavy UTF-16 is already told by its NUL bytes.
+ * Units of two ASCII letters or spaces do not count, as Latin text reads
+ * as CJK in either byte order.
+ *
+ * CJK text without NUL bytes, or with few of them from such characters,
+ * has no other tell of its byte order. The other order reads as a mix of
+ * unpaired surrogates, private use characters and rare blocks.
+ */
+{
+    ptrdiff_t units;
+    ptrdiff_t weight;
+    unsigned int c;
+    unsigned int next;
+    int hi;
+    int lo;
+
+    units = (end - iter) / 2;
+    if (units == 0)
+        return 0;
+
+    end = iter + units * 2;
+    hi = big_endian ? 0 : 1;
+    lo = 1 - hi;
+
+    weight = 0;
+    while (iter < end)
+    {
+        c = (unsigned int) iter[hi] << 8 | iter[lo];
+        iter += 2;
+
+        if (c < 0x80)
+        {
+            if ((c >= 0x20 && c < 0x7F) || c == 0x09 || c == 0x0A || c == 0x0D)
+                weight += 1;
+        }
+        else if (SE_DETECT_IS_LATIN(c >> 8) && SE_DETECT_IS_LATIN(c & 0xFF))
+        {
+            /* Latin text */
+        }
+        else if ((c >= 0x3000 && c <= 0x30FF) || (c >= 0x4E00 && c <= 0x9FFF) || (c >= 0xAC00 && c <= 0xD7A3) || (c >= 0xFF00 && c <= 0xFFEF))
+        {
+            weight += 2;
+        }
+        else if (c >= 0xD800 && c <= 0xDBFF && iter < end)
+        {
+            next = (unsigned int) iter[hi] << 8 | iter[lo];
+            if (next >= 0xDC00 && next <= 0xDFFF)
+            {
+                weight += 4;
+                iter += 2;
+            }
+        }
+    }
+
+    return (int) (100 * weight / (units * 2));
+}
+
+static int se_detect_latin1(const unsigned char* iter, const unsigned char* end)
+/*
+ * Return how well the text from iter to end reads as ISO-8859-1, from 0
+ * to 100.
+ *
+ * The score is the share of the letters above ASCII, 0xC0..0xFF but for
+ * the signs 0xD7 and 0xF7, that are alone or in pairs next to an ASCII
+ * letter, as the accented letters inside the words of Western European
+ * languages. The letters of the CJK encodings come in longer runs of
+ * bytes above ASCII. The other bytes above ASCII are symbols, and the C1
+ * controls where windows-1252 has its quotes and dashes, and count for
+ * neither side. Text of these languages is mostly ASCII, so text with
+ * more than one byte in 6 above ASCII scores 0.
+ */
+{
+    const unsigned char* start;
+    const unsigned char* run;
+    ptrdiff_t high;
+    ptrdiff_t letters;
+    ptrdiff_t typical;
+    ptrdiff_t run_letters;
+    unsigned int before;
+    unsigned int after;
+
+    start = iter;
+    high = 0;
+    letters = 0;
+    typical = 0;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)iter)))
+                {
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            iter++;
+            continue;
+        }
+
+        run = iter;
+        run_letters = 0;
+        while (iter < end && iter[0] >= 0x80)
+        {
+            if (iter[0] >= 0xC0 && iter[0] != 0xD7 && iter[0] != 0xF7)
+                run_letters++;
+            iter++;
+        }
+        high += iter - run;
+        letters += run_letters;
+
+        before = run > start ? run[-1] | 0x20 : 0;
+        after = iter < end ? iter[0] | 0x20 : 0;
+        if (iter - run <= 2 && ((before >= 'a' && before <= 'z') || (after >= 'a' && after <= 'z')))
+            typical += run_letters;
+    }
+
+    if (letters == 0 || high * 6 > end - start)
+        return 0;
+
+    return (int) (100 * typical / letters);
+}
+
+static int se_detect_high_side(const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the offset modulo 2 of the bytes that look like the high bytes
+ * of UTF-16 in the text from iter to end, or -1 if neither side does.
+ *
+ * The high bytes of UTF-16 text take few values, the blocks of its
+ * scripts and 0 for ASCII, and the low bytes take many. The NUL bytes of
+ * UTF-16 are mostly high bytes, but the few of CJK text without ASCII
+ * are the low bytes of the characters at multiples of 256. Both sides of
+ * text in other encodings take about as many values.
+ */
+{
+    unsigned char seen[2][256];
+    int values[2];
+    ptrdiff_t i;
+
+    for (i = 0; i < 256; i++)
+    {
+        seen[0][i] = 0;
+        seen[1][i] = 0;
+    }
+    values[0] = 0;
+    values[1] = 0;
+
+    for (i = 0; i < end - iter; i++)
+    {
+        if (!seen[i & 1][iter[i]])
+        {
+            seen[i & 1][iter[i]] = 1;
+            values[i & 1]++;
+        }
+    }
+
+    if (values[0] * 2 <= values[1])
+        return 0;
+    if (values[1] * 2 <= values[0])
+        return 1;
+
+    return -1;
+}
+
+SE_API const char* se_detect_encoding_sz(const char* str, ptrdiff_t len, int* confidence, int* bom_len)
+/*
+ * str:
+ *      The start of a text of unknown encoding.
+ *
+ * len:
+ *      The byte length of the text.
+ *      If len < 0, then the text is NUL terminated.
+ *
+ * confidence:
+ *      Location to return how sure the guess is, from 0 to 100.
+ *      (Can be NULL to indicate that the result is not needed.)
+ *
+ * bom_len:
+ *      Location to return the byte length of the byte order mark, which
+ *      is 0 if there is none.
+ *      (Can be NULL to indicate that the result is not needed.)
+ *
+ * Guess the encoding of a text from its first SE_DETECT_PREFIX_LEN
+ * bytes. The candidates are ASCII, UTF-8, UTF-16 and UTF-32 of either
+ * byte order, the legacy encodings of se-unicode-mbcs.c and ISO-8859-1,
+ * which se_latin1_to_utf8() converts. A guess from fewer than 16 bytes
+ * above ASCII has a low confidence.
+ *
+ * Return:
+ *      The IANA name of the encoding: "US-ASCII", "UTF-8", "UTF-16LE",
+ *      "UTF-16BE", "UTF-32LE", "UTF-32BE", "GB18030", "Shift_JIS",
+ *      "EUC-KR", "Big5" or "ISO-8859-1". Text of ASCII characters other
+ *      than NUL is "US-ASCII", and an empty text is "UTF-8".
+ */
+{
+    static const struct
+    {
+        const char* name;
+        const se_mbcs_codec* codec;
+    }
+    legacy[] =
+    {
+        /* In the order that wins ties, GB18030 decodes almost anything */
+        { "Shift_JIS", &se_shift_jis_codec },
+        { "EUC-KR", &se_euc_kr_codec },
+        { "Big5", &se_big5_codec },
+        { "GB18030", &se_gb18030_codec },
+    };
+
+    const unsigned char* iter;
+    const unsigned char* end;
+    se_detect_counts counts;
+    const char* name;
+    ptrdiff_t pairs;
+    ptrdiff_t quads;
+    ptrdiff_t odd;
+    ptrdiff_t even;
+    ptrdiff_t nuls;
+    int high;
+    int score;
+    int best;
+    int le;
+    int be;
+    int bom;
+    int i;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz((const seunichar8*)str);
+
+    iter = (const unsigned char*)str;
+    end = iter + (len < SE_DETECT_PREFIX_LEN ? len : SE_DETECT_PREFIX_LEN);
+
+    name = 0;
+    best = 100;
+    bom = 0;
+
+    if (len >= 4 && iter[0] == 0xFF && iter[1] == 0xFE && iter[2] == 0 && iter[3] == 0)
+        name = "UTF-32LE", bom = 4;
+    else if (len >= 4 && iter[0] == 0 && iter[1] == 0 && iter[2] == 0xFE && iter[3] == 0xFF)
+        name = "UTF-32BE", bom = 4;
+    else if (len >= 4 && iter[0] == 0x84 && iter[1] == 0x31 && iter[2] == 0x95 && iter[3] == 0x33)
+        name = "GB18030", bom = 4;
+    else if (len >= 3 && iter[0] == 0xEF && iter[1] == 0xBB && iter[2] == 0xBF)
+        name = "UTF-8", bom = 3;
+    else if (len >= 2 && iter[0] == 0xFF && iter[1] == 0xFE)
+        name = "UTF-16LE", bom = 2;
+    else if (len >= 2 && iter[0] == 0xFE && iter[1] == 0xFF)
+        name = "UTF-16BE", bom = 2;
+    else if (len == 0)
+        name = "UTF-8";
+
+    if (!name)
+    {
+        se_detect_count_bytes(iter, end, &counts);
+
+        quads = (end - iter) / 4;
+        pairs = (end - iter) / 2;
+        odd = counts.zeros[1] + counts.zeros[3];
+        even = counts.zeros[0] + counts.zeros[2];
+
+        /*
+         * The two high bytes of a BMP code point in UTF-32 are 0, and so is
+         * the high byte of ASCII in UTF-16. Other text has no NUL bytes, so
+         * NULs all on one side are enough for UTF-16, as are a fair share
+         * of them on one side. se_detect_high_side() tells which side the
+         * high bytes are on, as CJK characters at multiples of 256 give
+         * NULs on the other side.
+         */
+        high = -1;
+        nuls = odd > even ? odd : even;
+        if (odd == 0 || even == 0 || (nuls * 4 >= pairs && (odd + even - nuls) * 8 <= nuls))
+        {
+            if (odd + even > 0)
+                high = se_detect_high_side(iter, end);
+            if (high < 0 && nuls * 4 >= pairs)
+                high = odd > even;
+        }
+
+        if (quads > 0 && counts.zeros[2] >= quads && counts.zeros[3] >= quads && counts.zeros[0] < quads)
+            name = "UTF-32LE";
+        else if (quads > 0 && counts.zeros[0] >= quads && counts.zeros[1] >= quads && counts.zeros[3] < quads)
+            name = "UTF-32BE";
+        else if (high >= 0)
+        {
+            name = high ? "UTF-16LE" : "UTF-16BE";
+            if (high == (odd > even))
+            {
+                /* Like the lead bytes of UTF-8 below, a few NULs are enough */
+                best = (int) (50 + 50 * nuls / pairs);
+                if (best < 90 && (odd == 0 || even == 0))
+                    best = nuls < 6 ? (int) (60 + 5 * nuls) : 90;
+            }
+            else
+            {
+                best = se_detect_utf16(iter, end, !high);
+            }
+        }
+        else if (counts.high == 0 && odd + even == 0)
+        {
+            name = "US-ASCII";
+        }
+        else if (odd + even == 0 && se_is_valid_utf8_str_sz((const seunichar8*)iter, (len > end - iter ? se_detect_utf8_cut(iter, end) : end) - iter))
+        {
+            /* Legacy text is seldom valid UTF-8 beyond a few characters */
+            name = "UTF-8";
+            if (counts.high - counts.trail < 8)
+                best = (int) (60 + 5 * (counts.high - counts.trail));
+        }
+        else
+        {
+            /*
+             * The better byte order of UTF-16 must stand out from the other
+             * one, as text of any single byte script reads as CJK in both.
+             * It then has to beat the legacy encodings, which win ties: the
+             * double byte codes of GB18030 and Shift_JIS are in the CJK and
+             * Hangul blocks when read as UTF-16BE. ISO-8859-1 wins ties with
+             * the legacy encodings, which decode most Latin text to some
+             * characters.
+             */
+            best = -1;
+            for (i = 0; i < (int) (sizeof(legacy) / sizeof(legacy[0])); i++)
+            {
+                score = se_detect_score(legacy[i].codec, iter, end);
+                if (score > best)
+                {
+                    name = legacy[i].name;
+                    best = score;
+                }
+            }
+
+            score = se_detect_latin1(iter, end);
+            if (score > 0 && score >= best)
+            {
+                name = "ISO-8859-1";
+                best = score;
+            }
+
+            le = se_detect_utf16(iter, end, FALSE);
+            be = se_detect_utf16(iter, end, TRUE);
+            if (le >= be + 15 && le > best)
+            {
+                name = "UTF-16LE";
+                best = le;
+            }
+            else if (be >= le + 15 && be > best)
+            {
+                name = "UTF-16BE";
+                best = be;
+            }
+
+            /* A handful of characters fit too many encodings */
+            if (counts.high < 16 && best > 5 * counts.high)
+                best = (int) (5 * counts.high);
+
+            /* Valid UTF-8 with NUL bytes in it, which are not UTF-16 */
+            if (odd + even > 0 && best < 50 && se_is_valid_utf8_str_sz((const seunichar8*)iter, (len > end - iter ? se_detect_utf8_cut(iter, end) : end) - iter))
+            {
+                name = "UTF-8";
+                best = 50;
+            }
+        }
+    }
+
+    if (confidence)
+        *confidence = best > 100 ? 100 : best;
+
+    if (bom_len)
+        *bom_len = bom;
+
+    return name;
+}
+
+SE_API const char* se_detect_encoding(const char* str, int len, int* confidence, int* bom_len)
+{
+    return se_detect_encoding_sz(str, len, confidence, bom_len);
+}
@@ -12,6 +12,10 @@
     #include "se-utils.h"
 #endif
 
+#ifndef SE_UNICODE_EXT_H
+    #include "se-unicode-ext.h"
+#endif
+
 /*
 
 From Unicode Standard:
@@ -67,6 +71,9 @@ List of noncharacters
 #define SE_REPLACEMENT_CHAR_UTF8_2_CODE     0xBF
 #define SE_REPLACEMENT_CHAR_UTF8_3_CODE     0xBD
 
+/* Replacement for characters above U+00FF in Latin-1 strings */
+#define SE_LATIN1_REPLACEMENT_CHAR          '?'
+
 #define SE_IS_VALID_SCALAR_VALUE(c) ( (c) < 0xD800 || ((c) >= 0xE000 && (c) < 0x110000) )
 #define SE_IS_NONCHARACTER(c)       ( ((c) >= 0xFDD0 && (c) < 0xFDF0) || ((c) < 0x110000 && ((c) & 0xFFFE) != 0xFFFE) );
 
@@ -75,289 +82,760 @@ List of noncharacters
 #define SE_IS_LO_SURROGATE(c)       ( (c) >= 0xDC00 && (c) < 0xE000 )
 #define SE_SURROGATE_VALUE(hi, lo)  (seunichar32) ( ((((hi) & 0x3FF) << 10) | ((lo) & 0x3FF)) + 0x10000 )
 
-#define VALIDATE(exp)               if (!(exp)) return FALSE
-#define VALIDATE1(exp)              if (!(exp)) goto ill_formed_1
-#define VALIDATE2(exp)              if (!(exp)) goto ill_formed_2
+/*
+ * SSE2 is part of the x86-64 baseline, so the vectorized code paths are
+ * enabled by default wherever the compiler targets it. Define SE_OPT_SSE2
+ * to 0 to force the portable code paths.
+ */
+#ifndef SE_OPT_SSE2
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define SE_OPT_SSE2 1
+    #else
+        #define SE_OPT_SSE2 0
+    #endif
+#endif
 
-SE_API sebool se_unichar_is_valid(seunichar c)
-{
-    return SE_IS_VALID_SCALAR_VALUE(c);
-}
+#if SE_OPT_SSE2
+    #include <emmintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#endif
 
-SE_API sebool se_unichar_is_surrogate(seunichar c)
+#if SE_OPT_SSE2
+static int se_bit_scan_forward(unsigned int mask)
 {
-    return SE_IS_SURROGATE(c);
-}
+    #if defined(__GNUC__)
 
-SE_API sebool se_unichar_is_hi_surrogate(seunichar c)
-{
-    return SE_IS_HI_SURROGATE(c);
-}
+        return __builtin_ctz(mask);
 
-SE_API sebool se_unichar_is_lo_surrogate(seunichar c)
-{
-    return SE_IS_LO_SURROGATE(c);
+    #elif defined(_MSC_VER)
+
+        unsigned long index;
+
+        _BitScanForward(&index, mask);
+        return (int) index;
+
+    #else
+
+        int index = 0;
+
+        while (!(mask & 1))
+        {
+            mask >>= 1;
+            index++;
+        }
+        return index;
+
+    #endif
 }
 
-SE_API sebool se_unichar_is_noncharacter(seunichar c)
+static int se_bit_count(unsigned int mask)
 {
-    return SE_IS_NONCHARACTER(c);
+    #if defined(__GNUC__)
+
+        return __builtin_popcount(mask);
+
+    #else
+
+        int count = 0;
+
+        while (mask)
+        {
+            mask &= mask - 1;
+            count++;
+        }
+        return count;
+
+    #endif
 }
+#endif
 
 /***************************************************************************
  *                                                                         *
- * Unicode character convertion.                                           *
+ * Hot path statistics.                                                    *
  *                                                                         *
- * For un-safe characters.                                                 *
+ * Define SE_OPT_STATS to 1 to count, per function, the calls, the bytes   *
+ * read and written, the replacement characters emitted and the            *
+ * allocations made. Counters live in per-thread blocks, so the hot paths  *
+ * never share a cache line; se_stats_snapshot() sums all threads.         *
  *                                                                         *
  ***************************************************************************/
 
-SE_API int se_unsafe_unichar_to_utf8(seunichar c, seunichar8* buf)
+#ifndef SE_OPT_STATS
+    #define SE_OPT_STATS 0
+#endif
+
+#ifndef SE_OPT_ALLOC_TRACE
+    #define SE_OPT_ALLOC_TRACE 0
+#endif
+
+/* Indexed by the SE_STATS_* ids of se-unicode-ext.h */
+#if SE_OPT_STATS || SE_OPT_ALLOC_TRACE
+static const char* const se_stats_names[SE_STATS_FUNCTION_COUNT] =
 {
-    int len;
+    "se_is_valid_utf8_str",
+    "se_is_valid_utf16_str",
+    "se_is_valid_utf32_str",
+    "se_unsafe_utf8_str_safe_copy",
+    "se_unsafe_utf16_str_safe_copy",
+    "se_unsafe_utf32_str_safe_copy",
+    "se_safe_utf8_str_char_count",
+    "se_safe_utf16_str_char_count",
+    "se_safe_utf32_str_char_count",
+    "se_unsafe_utf8_to_safe_utf16",
+    "se_unsafe_utf16_to_safe_utf8",
+    "se_unsafe_utf8_to_safe_utf32",
+    "se_unsafe_utf32_to_safe_utf8",
+    "se_unsafe_utf16_to_safe_utf32",
+    "se_unsafe_utf32_to_safe_utf16",
+    "se_safe_utf8_to_utf16",
+    "se_safe_utf16_to_utf8",
+    "se_safe_utf8_to_utf32",
+    "se_safe_utf32_to_utf8",
+    "se_safe_utf16_to_utf32",
+    "se_safe_utf32_to_utf16",
+    "se_unsafe_utf8_str_safe_copy_into",
+    "se_unsafe_utf8_to_safe_utf16_into",
+    "se_unsafe_utf16_to_safe_utf8_into",
+    "se_unsafe_utf8_to_safe_utf16_batch",
+    "se_utf8_str_copy",
+    "se_utf16_str_copy",
+    "se_utf32_str_copy",
+    "se_utf8_strdup",
+    "se_utf16_strdup",
+    "se_utf32_strdup",
+    "se_utf8_index",
+    "se_is_ascii_str",
+    "se_is_ascii_utf16_str",
+    "se_is_latin1_utf8_str",
+    "se_is_latin1_utf16_str",
+    "se_latin1_to_utf8",
+    "se_latin1_to_utf16",
+    "se_safe_utf8_to_latin1",
+    "se_safe_utf16_to_latin1",
+    "se_latin1_to_utf8_into",
+    "se_latin1_to_utf16_into",
+    "se_safe_utf8_to_latin1_into",
+    "se_safe_utf16_to_latin1_into",
+    "se_ustr",
+};
+#endif
 
-    if (!SE_IS_VALID_SCALAR_VALUE(c))
-    {
-        if (buf)
-        {
-            buf[0] = SE_REPLACEMENT_CHAR_UTF8_1;
-            buf[1] = SE_REPLACEMENT_CHAR_UTF8_2;
-            buf[2] = SE_REPLACEMENT_CHAR_UTF8_3;
-        }
-        len = 3;
-    }
-    else if (c < 0x80)
-    {
-        if (buf)
-        {
-            buf[0] = (seunichar8) c;
-        }
-        len = 1;
-    }
-    else if (c < 0x800)
-    {
-        if (buf)
-        {
-            buf[1] = (seunichar8) ((c & 0x3F) | 0x80);
-            buf[0] = (seunichar8) ((c >> 6) | 0xC0);
-        }
-        len = 2;
-    }
-    else if (c < 0x10000)
-    {
-        if (buf)
-        {
-            buf[2] = (seunichar8) ((c & 0x3F) | 0x80);
-            c >>= 6;
-            buf[1] = (seunichar8) ((c & 0x3F) | 0x80);
-            buf[0] = (seunichar8) ((c >> 6) | 0xE0);
-        }
-        len = 3;
-    }
-    else
-    {
-        if (buf)
-        {
-            buf[3] = (seunichar8) ((c & 0x3F) | 0x80);
-            c >>= 6;
-            buf[2] = (seunichar8) ((c & 0x3F) | 0x80);
-            c >>= 6;
-            buf[1] = (seunichar8) ((c & 0x3F) | 0x80);
-            buf[0] = (seunichar8) ((c >> 6) | 0xF0);
-        }
-        len = 4;
-    }
+#if SE_OPT_STATS
 
-    #if SE_OPT_DEBUG
-        if (buf)
-        {
-            SE_DEBUG_ASSERT(se_is_valid_utf8_str(buf, len));
-        }
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define SE_THREAD_LOCAL __declspec(thread)
+    #else
+        #define SE_THREAD_LOCAL __thread
     #endif
 
-    return len;
-}
+    #define SE_CACHE_LINE_SIZE 64
 
-SE_API int se_unsafe_unichar_to_utf16(seunichar c, seunichar16* buf)
-{
-    int len;
+    typedef struct se_stats_counter se_stats_counter;
 
-    if (!SE_IS_VALID_SCALAR_VALUE(c))
+    struct se_stats_counter
     {
-        if (buf)
-        {
-            buf[0] = SE_REPLACEMENT_CHAR;
-        }
-        len = 1;
-    }
-    else if (c < 0x10000)
+        unsigned long long calls;
+        unsigned long long bytes_in;
+        unsigned long long bytes_out;
+        unsigned long long replacements;
+        unsigned long long allocs;
+        unsigned long long alloc_bytes;
+        unsigned long long pad[2];
+    };
+
+    typedef struct se_stats_block se_stats_block;
+
+    struct se_stats_block
     {
-        if (buf)
-        {
-            buf[0] = (seunichar16) c;
-        }
-        len = 1;
-    }
-    else
+        se_stats_counter counters[SE_STATS_FUNCTION_COUNT];
+        se_stats_block* next;
+        unsigned long long replacements;
+    };
+
+    /* All blocks ever created, blocks of exited threads are kept so totals never go back */
+    static se_stats_block* volatile se_stats_blocks;
+
+    static SE_THREAD_LOCAL se_stats_block* se_stats_local;
+
+    static se_stats_block* se_stats_new_block(void)
+    /*
+     * Create and publish the block of the calling thread. The block is
+     * aligned to a cache line and never freed, and is not allocated with
+     * SE_MALLOC so it does not show in the counters.
+     */
     {
-        if (buf)
-        {
-            c -= 0x10000;
-            buf[1] = (seunichar16) ((c & 0x3FF) | 0xDC00);
-            buf[0] = (seunichar16) ((c >> 10) | 0xD800);
-        }
-        len = 2;
-    }
+        char* raw;
+        se_stats_block* block;
 
-    #if SE_OPT_DEBUG
-        if (buf)
-        {
-            SE_DEBUG_ASSERT(se_is_valid_utf16_str(buf, len));
-        }
-    #endif
+        raw = (char*) calloc(1, sizeof(se_stats_block) + SE_CACHE_LINE_SIZE);
+        if (!raw)
+            return 0;
 
-    return len;
-}
+        block = (se_stats_block*) (raw + SE_CACHE_LINE_SIZE - (size_t) raw % SE_CACHE_LINE_SIZE);
 
-SE_API seunichar32 se_unsafe_utf8_get_char(const seunichar8* str)
-{
-    const unsigned char* iter;
+        #if defined(_MSC_VER)
+            do
+                block->next = se_stats_blocks;
+            while (_InterlockedCompareExchangePointer((void* volatile*) &se_stats_blocks, block, block->next) != block->next);
+        #else
+            do
+                block->next = se_stats_blocks;
+            while (!__sync_bool_compare_and_swap(&se_stats_blocks, block->next, block));
+        #endif
 
-    SE_DEBUG_ASSERT(str);
+        se_stats_local = block;
 
-    iter = (const unsigned char*)str;
-    if (iter[0] <= 0x7F)
-    {
-        return iter[0];
-    }
-    else if (iter[0] >= 0xC2 && iter[0] <= 0xDF)
-    {
-        if (iter[1] >= 0x80 && iter[1] <= 0xBF)
-        {
-            return (seunichar32) ( ((iter[0] & 0x1F) << 6) | (iter[1] & 0x3F) );
-        }
-    }
-    else if (iter[0] == 0xE0)
-    {
-        if (iter[1] >= 0xA0 && iter[1] <= 0xBF &&
-            iter[2] >= 0x80 && iter[2] <= 0xBF)
-        {
-            return (seunichar32) ( ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
-        }
-    }
-    else if (iter[0] >= 0xE1 && iter[0] <= 0xEC)
-    {
-        if (iter[1] >= 0x80 && iter[1] <= 0xBF &&
-            iter[2] >= 0x80 && iter[2] <= 0xBF)
-        {
-            return (seunichar32) ( ((iter[0] & 0x0F) << 12) | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
-        }
+        return block;
     }
-    else if (iter[0] == 0xED)
+
+    static se_stats_block* se_stats_block_get(void)
     {
-        if (iter[1] >= 0x80 && iter[1] <= 0x9F &&
-            iter[2] >= 0x80 && iter[2] <= 0xBF)
-        {
-            return (seunichar32) ( 0xD000 | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
-        }
+        if (se_stats_local)
+            return se_stats_local;
+
+        return se_stats_new_block();
     }
-    else if (iter[0] >= 0xEE && iter[0] <= 0xEF)
+
+    static void se_stats_count(int id, ptrdiff_t bytes_in, ptrdiff_t bytes_out, int replacements)
     {
-        if (iter[1] >= 0x80 && iter[1] <= 0xBF &&
-            iter[2] >= 0x80 && iter[2] <= 0xBF)
+        se_stats_block* block;
+        se_stats_counter* counter;
+
+        block = se_stats_block_get();
+        if (!block)
+            return;
+
+        counter = &block->counters[id];
+        counter->calls++;
+        counter->bytes_in += bytes_in;
+        counter->bytes_out += bytes_out;
+
+        if (replacements)
         {
-            return (seunichar32) ( ((iter[0] & 0x0F) << 12) | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
+            counter->replacements += block->replacements;
+            block->replacements = 0;
         }
     }
-    else if (iter[0] == 0xF0)
+
+    static void se_stats_alloc(int id, size_t size)
     {
-        if (iter[1] >= 0x90 && iter[1] <= 0xBF &&
-            iter[2] >= 0x80 && iter[2] <= 0xBF &&
-            iter[3] >= 0x80 && iter[3] <= 0xBF)
-        {
-            return (seunichar32) ( ((iter[1] & 0x3F) << 12) | ((iter[2] & 0x3F) << 6) | (iter[3] & 0x3F) );
-        }
+        se_stats_block* block;
+
+        block = se_stats_block_get();
+        if (!block)
+            return;
+
+        block->counters[id].allocs++;
+        block->counters[id].alloc_bytes += size;
     }
-    else if (iter[0] >= 0xF1 && iter[0] <= 0xF3)
+
+    static void se_stats_enter(void)
     {
-        if (iter[1] >= 0x80 && iter[1] <= 0xBF &&
-            iter[2] >= 0x80 && iter[2] <= 0xBF &&
-            iter[3] >= 0x80 && iter[3] <= 0xBF)
-        {
-            return (seunichar32) ( ((iter[0] & 7) << 18) | ((iter[1] & 0x3F) << 12) | ((iter[2] & 0x3F) << 6) | (iter[3] & 0x3F) );
-        }
+        se_stats_block* block;
+
+        block = se_stats_block_get();
+        if (block)
+            block->replacements = 0;
     }
-    else if (iter[0] == 0xF4)
+
+    static void se_stats_replaced(void)
     {
-        if (iter[1] >= 0x80 && iter[1] <= 0x8F &&
-            iter[2] >= 0x80 && iter[2] <= 0xBF &&
-            iter[3] >= 0x80 && iter[3] <= 0xBF)
-        {
-            return (seunichar32) ( 0x100000 | ((iter[1] & 0x3F) << 12) | ((iter[2] & 0x3F) << 6) | (iter[3] & 0x3F) );
-        }
+        se_stats_block* block;
+
+        block = se_stats_block_get();
+        if (block)
+            block->replacements++;
     }
 
-    return SE_REPLACEMENT_CHAR;
-}
+    /*
+     * SE_STATS_ENTER() starts a conversion, whose replacement characters
+     * are then noted by SE_STATS_REPLACED() and added to its counter by
+     * SE_STATS_LEAVE(). SE_STATS_COUNT() counts a call that emits nothing.
+     */
+    #define SE_STATS_ENTER()                            se_stats_enter()
+    #define SE_STATS_REPLACED()                         se_stats_replaced()
+    #define SE_STATS_LEAVE(id, bytes_in, bytes_out)     se_stats_count(id, bytes_in, bytes_out, 1)
+    #define SE_STATS_COUNT(id, bytes_in)                se_stats_count(id, bytes_in, 0, 0)
+    #define SE_STATS_ALLOC(id, size)                    se_stats_alloc(id, size)
 
-SE_API seunichar32 se_unsafe_utf16_get_char(const seunichar16* str)
+#else
+
+    /* Byte counts are still evaluated, so variables kept only for them stay used */
+    #define SE_STATS_ENTER()                            ((void) 0)
+    #define SE_STATS_REPLACED()                         ((void) 0)
+    #define SE_STATS_LEAVE(id, bytes_in, bytes_out)     ((void) (bytes_in), (void) (bytes_out))
+    #define SE_STATS_COUNT(id, bytes_in)                ((void) (bytes_in))
+    #define SE_STATS_ALLOC(id, size)                    ((void) 0)
+
+#endif
+
+SE_API int se_stats_snapshot(se_stats* stats, int count)
+/*
+ * stats:
+ *      An array of count entries, receiving the totals of every counted
+ *      function over all threads since the start of the process.
+ *
+ * The counters of running threads are read without locking, so a total
+ * may miss the latest calls but is never torn on 64-bit targets.
+ *
+ * Return:
+ *      The number of counted functions, or 0 when the library is built
+ *      without SE_OPT_STATS.
+ */
 {
-    #if SE_OPT_SURROGATE
+    #if SE_OPT_STATS
 
-        SE_DEBUG_ASSERT(str);
+        se_stats_block* block;
+        int i;
 
-        if (SE_IS_HI_SURROGATE(str[0]))
+        for (i = 0; i < count && i < SE_STATS_FUNCTION_COUNT; i++)
         {
-            if (SE_IS_LO_SURROGATE(str[1]))
-                return SE_SURROGATE_VALUE(str[0], str[1]);
-        }
-        else if (SE_IS_LO_SURROGATE(str[0]))
-        {
-            return SE_REPLACEMENT_CHAR;
-        }
-        else
-        {
-            return str[0];
+            memset(&stats[i], 0, sizeof(se_stats));
+            stats[i].name = se_stats_names[i];
+
+            for (block = se_stats_blocks; block; block = block->next)
+            {
+                stats[i].calls += block->counters[i].calls;
+                stats[i].bytes_in += block->counters[i].bytes_in;
+                stats[i].bytes_out += block->counters[i].bytes_out;
+                stats[i].replacements += block->counters[i].replacements;
+                stats[i].allocs += block->counters[i].allocs;
+                stats[i].alloc_bytes += block->counters[i].alloc_bytes;
+            }
         }
 
-        return SE_REPLACEMENT_CHAR;
+        return SE_STATS_FUNCTION_COUNT;
 
     #else
 
-        SE_DEBUG_ASSERT(str);
+        (void) stats;
+        (void) count;
 
-        return *str;
+        return 0;
 
     #endif
 }
 
 /***************************************************************************
  *                                                                         *
- * Unicode character convertion.                                           *
+ * Allocation tracing.                                                     *
  *                                                                         *
- * For safe characters.                                                    *
+ * Define SE_OPT_ALLOC_TRACE to 1 to record every allocation made by the   *
+ * library in a ring buffer of SE_ALLOC_TRACE_SIZE records, to be read     *
+ * back with se_alloc_trace_read() after a load test.                      *
  *                                                                         *
  ***************************************************************************/
 
-SE_API int se_safe_unichar_to_utf8(seunichar c, seunichar8* buf)
+#ifndef SE_ALLOC_TRACE_SIZE
+    #define SE_ALLOC_TRACE_SIZE 4096    /* Must be a power of 2 */
+#endif
+
+#if SE_OPT_ALLOC_TRACE
+
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+
+    static se_alloc_record se_alloc_trace_ring[SE_ALLOC_TRACE_SIZE];
+
+    /* Number of records ever written, the next record goes to its slot */
+    static volatile long se_alloc_trace_next;
+
+    static unsigned int se_alloc_trace_saturate(size_t size)
+    {
+        return size > 0xFFFFFFFF ? 0xFFFFFFFF : (unsigned int) size;
+    }
+
+    static void se_alloc_trace(int id, size_t input_bytes, size_t requested_bytes, size_t worst_case_bytes)
+    {
+        se_alloc_record* record;
+        long slot;
+
+        #if defined(_MSC_VER)
+            slot = _InterlockedExchangeAdd(&se_alloc_trace_next, 1);
+        #else
+            slot = __sync_fetch_and_add(&se_alloc_trace_next, 1);
+        #endif
+
+        record = &se_alloc_trace_ring[slot & (SE_ALLOC_TRACE_SIZE - 1)];
+        record->function = id;
+        record->input_bytes = se_alloc_trace_saturate(input_bytes);
+        record->requested_bytes = se_alloc_trace_saturate(requested_bytes);
+        record->worst_case_bytes = se_alloc_trace_saturate(worst_case_bytes);
+    }
+
+    #define SE_TRACE_ALLOC(id, input_bytes, requested_bytes, worst_case_bytes) \
+        se_alloc_trace(id, input_bytes, requested_bytes, worst_case_bytes)
+
+#else
+
+    #define SE_TRACE_ALLOC(id, input_bytes, requested_bytes, worst_case_bytes) ((void) 0)
+
+#endif
+
+SE_API int se_alloc_trace_read(se_alloc_record* records, int count)
 /*
- * c:
- *      Input Unicode character code.
+ * records:
+ *      An array of count records, receiving the latest allocations,
+ *      oldest first. The array can be written to a file as it is.
  *
- * buf:
- *      Pointer to an UTF-8 string buffer for return output string.
- *      (Can be NULL to indicate that the result is not needed.)
- * 
- * Convert a single character into UTF-8. Output buffer must have at
- * least 4 bytes of space. Returns the number of bytes in the
- * result.
+ * Records written while reading may be torn, so read after the load.
+ *
+ * Return:
+ *      The number of records returned, 0 when the library is built
+ *      without SE_OPT_ALLOC_TRACE.
  */
 {
-    int len;
+    #if SE_OPT_ALLOC_TRACE
 
-    SE_DEBUG_ASSERT(SE_IS_VALID_SCALAR_VALUE(c));
+        long next;
+        long first;
+        long i;
 
-    if (c < 0x80)
+        next = se_alloc_trace_next;
+
+        first = next - count;
+        if (first < next - SE_ALLOC_TRACE_SIZE)
+            first = next - SE_ALLOC_TRACE_SIZE;
+        if (first < 0)
+            first = 0;
+
+        for (i = first; i < next; i++)
+            records[i - first] = se_alloc_trace_ring[i & (SE_ALLOC_TRACE_SIZE - 1)];
+
+        return (int) (next - first);
+
+    #else
+
+        (void) records;
+        (void) count;
+
+        return 0;
+
+    #endif
+}
+
+SE_API void se_alloc_trace_reset(void)
+{
+    #if SE_OPT_ALLOC_TRACE
+        se_alloc_trace_next = 0;
+    #endif
+}
+
+SE_API const char* se_alloc_trace_function_name(unsigned int function)
+{
+    #if SE_OPT_STATS || SE_OPT_ALLOC_TRACE
+        if (function < SE_STATS_FUNCTION_COUNT)
+            return se_stats_names[function];
+    #else
+        (void) function;
+    #endif
+
+    return 0;
+}
+
+#define VALIDATE(exp)               if (!(exp)) return FALSE
+#define VALIDATE1(exp)              if (!(exp)) goto ill_formed_1
+#define VALIDATE2(exp)              if (!(exp)) goto ill_formed_2
+
+SE_API sebool se_unichar_is_valid(seunichar c)
+{
+    return SE_IS_VALID_SCALAR_VALUE(c);
+}
+
+SE_API sebool se_unichar_is_surrogate(seunichar c)
+{
+    return SE_IS_SURROGATE(c);
+}
+
+SE_API sebool se_unichar_is_hi_surrogate(seunichar c)
+{
+    return SE_IS_HI_SURROGATE(c);
+}
+
+SE_API sebool se_unichar_is_lo_surrogate(seunichar c)
+{
+    return SE_IS_LO_SURROGATE(c);
+}
+
+SE_API sebool se_unichar_is_noncharacter(seunichar c)
+{
+    return SE_IS_NONCHARACTER(c);
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Table driven UTF-8 decoding.                                            *
+ *                                                                         *
+ * With SE_OPT_UTF8_DFA, UTF-8 is validated and decoded by a finite        *
+ * automaton: every byte is mapped to one of 12 classes, and the class and *
+ * the current state select the next state. A byte costs the same table    *
+ * lookups whatever the script, where the ladder of lead byte tests        *
+ * mispredicts on text mixing sequence lengths; only runs of 8 ASCII bytes *
+ * are taken at once. The automaton is the scalar engine by default when   *
+ * the SSE2 paths are off. Both engines replace ill-formed codes the same  *
+ * way.                                                                    *
+ *                                                                         *
+ * The sizing and filling passes of the un-safe UTF-8 conversions only run *
+ * on the automaton with SE_OPT_UTF8_DFA_CONVERT. They measured slower     *
+ * than the ladder on everything but ASCII, up to 3 times on CJK text,     *
+ * which has a single sequence length the ladder predicts well, so they    *
+ * keep the ladder by default.                                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SE_OPT_UTF8_DFA
+    #if SE_OPT_SSE2
+        #define SE_OPT_UTF8_DFA 0
+    #else
+        #define SE_OPT_UTF8_DFA 1
+    #endif
+#endif
+
+#if !defined(SE_OPT_UTF8_DFA_CONVERT) || !SE_OPT_UTF8_DFA
+    #undef SE_OPT_UTF8_DFA_CONVERT
+    #define SE_OPT_UTF8_DFA_CONVERT 0
+#endif
+
+#if SE_OPT_UTF8_DFA
+
+#define SE_UTF8_DFA_CLASS_COUNT     12
+
+/*
+ * States. A state is the position of its 6 bit field in the transition
+ * rows, and the states above SE_UTF8_DFA_REJECT wait for trail bytes.
+ */
+#define SE_UTF8_DFA_ACCEPT          0
+#define SE_UTF8_DFA_REJECT          6
+#define SE_UTF8_DFA_TRAIL_1         12      /* Any trail byte, then accept */
+#define SE_UTF8_DFA_TRAIL_2         18      /* Any trail byte, then TRAIL_1 */
+#define SE_UTF8_DFA_TRAIL_3         24      /* Any trail byte, then TRAIL_2 */
+#define SE_UTF8_DFA_E0              30      /* A0..BF, then TRAIL_1 */
+#define SE_UTF8_DFA_ED              36      /* 80..9F, then TRAIL_1 */
+#define SE_UTF8_DFA_F0              42      /* 90..BF, then TRAIL_2 */
+#define SE_UTF8_DFA_F4              48      /* 80..8F, then TRAIL_2 */
+
+/*
+ * 1 in the accept state and 0 in any other. Written as arithmetic so the
+ * compiler keeps the loops below free of branches on the state.
+ */
+#define SE_UTF8_DFA_ACCEPTED(state) ( ((state) - 1) >> 8 & 1 )
+
+/* The transitions of a byte class, from each state in turn */
+#define SE_UTF8_DFA_ROW(accept, trail_1, trail_2, trail_3, e0, ed, f0, f4)     \
+    ( ((unsigned long long) (accept) << SE_UTF8_DFA_ACCEPT) |                   \
+      ((unsigned long long) SE_UTF8_DFA_REJECT << SE_UTF8_DFA_REJECT) |         \
+      ((unsigned long long) (trail_1) << SE_UTF8_DFA_TRAIL_1) |                 \
+      ((unsigned long long) (trail_2) << SE_UTF8_DFA_TRAIL_2) |                 \
+      ((unsigned long long) (trail_3) << SE_UTF8_DFA_TRAIL_3) |                 \
+      ((unsigned long long) (e0) << SE_UTF8_DFA_E0) |                           \
+      ((unsigned long long) (ed) << SE_UTF8_DFA_ED) |                           \
+      ((unsigned long long) (f0) << SE_UTF8_DFA_F0) |                           \
+      ((unsigned long long) (f4) << SE_UTF8_DFA_F4) )
+
+static const unsigned char se_utf8_dfa_class[256] =
+{
+    /* 00..7F: ASCII */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+
+    /* 80..8F, 90..9F, A0..BF: trail bytes, split where second bytes are */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+
+    /* C0..C1: never valid, C2..DF: 2 bytes */
+    4, 4, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+
+    /* E0, E1..EC, ED, EE..EF: 3 bytes */
+    6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 7,
+
+    /* F0, F1..F3, F4: 4 bytes, F5..FF: never valid */
+    9, 10, 10, 10, 11, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4
+};
+
+/*
+ * The transition table, one row per byte class. Packing the next states of
+ * a class in one word leaves a single shift on the chain from one byte to
+ * the next, the loads only depend on the bytes.
+ */
+#define ACC SE_UTF8_DFA_ACCEPT
+#define REJ SE_UTF8_DFA_REJECT
+#define TR1 SE_UTF8_DFA_TRAIL_1
+#define TR2 SE_UTF8_DFA_TRAIL_2
+#define TR3 SE_UTF8_DFA_TRAIL_3
+
+static const unsigned long long se_utf8_dfa_transition[SE_UTF8_DFA_CLASS_COUNT] =
+{
+    /*                                          accept              trail 1 trail 2 trail 3 E0   ED   F0   F4  */
+    /* 00..7F */            SE_UTF8_DFA_ROW(    ACC,                REJ,    REJ,    REJ,    REJ, REJ, REJ, REJ),
+    /* 80..8F */            SE_UTF8_DFA_ROW(    REJ,                ACC,    TR1,    TR2,    REJ, TR1, REJ, TR2),
+    /* 90..9F */            SE_UTF8_DFA_ROW(    REJ,                ACC,    TR1,    TR2,    REJ, TR1, TR2, REJ),
+    /* A0..BF */            SE_UTF8_DFA_ROW(    REJ,                ACC,    TR1,    TR2,    TR1, REJ, TR2, REJ),
+    /* C0..C1 */            SE_UTF8_DFA_ROW(    REJ,                REJ,    REJ,    REJ,    REJ, REJ, REJ, REJ),
+    /* C2..DF */            SE_UTF8_DFA_ROW(    TR1,                REJ,    REJ,    REJ,    REJ, REJ, REJ, REJ),
+    /* E0 */                SE_UTF8_DFA_ROW(    SE_UTF8_DFA_E0,     REJ,    REJ,    REJ,    REJ, REJ, REJ, REJ),
+    /* E1..EC, EE..EF */    SE_UTF8_DFA_ROW(    TR2,                REJ,    REJ,    REJ,    REJ, REJ, REJ, REJ),
+    /* ED */                SE_UTF8_DFA_ROW(    SE_UTF8_DFA_ED,     REJ,    REJ,    REJ,    REJ, REJ, REJ, REJ),
+    /* F0 */                SE_UTF8_DFA_ROW(    SE_UTF8_DFA_F0,     REJ,    REJ,    REJ,    REJ, REJ, REJ, REJ),
+    /* F1..F3 */            SE_UTF8_DFA_ROW(    TR3,                REJ,    REJ,    REJ,    REJ, REJ, REJ, REJ),
+    /* F4 */                SE_UTF8_DFA_ROW(    SE_UTF8_DFA_F4,     REJ,    REJ,    REJ,    REJ, REJ, REJ, REJ)
+};
+
+#undef ACC
+#undef REJ
+#undef TR1
+#undef TR2
+#undef TR3
+
+/*
+ * The bits of a byte of each class that belong to the code point. Trail
+ * bytes only get here once a lead byte was accepted, and lead bytes only
+ * in the accept state.
+ */
+static const unsigned char se_utf8_dfa_mask[SE_UTF8_DFA_CLASS_COUNT] =
+{
+    0x7F, 0x3F, 0x3F, 0x3F, 0, 0x1F, 0x0F, 0x0F, 0x0F, 0x07, 0x07, 0x07
+};
+
+static unsigned int se_utf8_dfa_next(unsigned int state, unsigned int byte)
+/*
+ * Return the state the automaton moves to from state on byte.
+ */
+{
+    return (unsigned int) (se_utf8_dfa_transition[se_utf8_dfa_class[byte]] >> state) & 63;
+}
+
+static unsigned int se_utf8_dfa_step(unsigned int state, unsigned int byte, seunichar32* code)
+/*
+ * As se_utf8_dfa_next(), and gather the code point in *code. It is complete
+ * once the state returned is SE_UTF8_DFA_ACCEPT. The bits gathered so far
+ * are dropped in the accept state with a mask rather than a branch.
+ */
+{
+    *code = ((*code << 6) & ((seunichar32) SE_UTF8_DFA_ACCEPTED(state) - 1)) | (byte & se_utf8_dfa_mask[se_utf8_dfa_class[byte]]);
+    return se_utf8_dfa_next(state, byte);
+}
+
+static sebool se_utf8_dfa_ascii_8(const unsigned char* iter)
+/*
+ * Return whether the 8 bytes at iter are ASCII. The loops below take such
+ * runs at once in the accept state, and test the state last, so text
+ * without ASCII runs does not branch on it.
+ */
+{
+    unsigned long long word;
+
+    memcpy(&word, iter, 8);
+    return !(word & 0x8080808080808080ULL);
+}
+
+#if SE_OPT_UTF8_DFA_CONVERT
+
+static const unsigned char* se_utf8_dfa_lead(const unsigned char* last, unsigned int prev, unsigned int state)
+/*
+ * Return the lead byte of a sequence the automaton failed on, where last
+ * is the last byte fed to it, moving it from prev to state. The sequence
+ * is either rejected by last, or truncated by the end of the string.
+ *
+ * The loops only keep the state, as the lead byte is only needed to
+ * resume at the byte after it: the sequence is a lead byte and the trail
+ * bytes before last.
+ */
+{
+    if (prev == SE_UTF8_DFA_ACCEPT)
+        return last;
+
+    if (state == SE_UTF8_DFA_REJECT)
+        last--;
+
+    while ((*last & 0xC0) == 0x80)
+        last--;
+
+    return last;
+}
+
+static ptrdiff_t se_utf8_dfa_len(const unsigned char* iter, const unsigned char* end, const unsigned char* units, ptrdiff_t replaced)
+/*
+ * Return the length of the output of a conversion of the UTF-8 string from
+ * iter to end. units gives per byte class the length counted for a byte,
+ * so the bytes of a sequence add up to its output length, and replaced is
+ * the length of a replacement character.
+ *
+ * As with the ladder, an ill-formed or truncated sequence is replaced by
+ * one character and decoding resumes at the byte after its lead byte.
+ */
+{
+    const unsigned char* lead;
+    unsigned int prev;
+    unsigned int state;
+    ptrdiff_t len;
+
+    len = 0;
+    state = SE_UTF8_DFA_ACCEPT;
+    while (iter < end)
+    {
+        if (end - iter >= 8 && se_utf8_dfa_ascii_8(iter) && state == SE_UTF8_DFA_ACCEPT)
+        {
+            len += 8 * units[0];
+            iter += 8;
+            continue;
+        }
+        prev = state;
+        state = se_utf8_dfa_next(state, *iter);
+        len += units[se_utf8_dfa_class[*iter++]];
+        if (state == SE_UTF8_DFA_REJECT || (iter == end && state != SE_UTF8_DFA_ACCEPT))
+        {
+            lead = se_utf8_dfa_lead(iter - 1, prev, state);
+            while (iter > lead)
+                len -= units[se_utf8_dfa_class[*--iter]];
+            len += replaced;
+            iter++;
+            state = SE_UTF8_DFA_ACCEPT;
+        }
+    }
+
+    return len;
+}
+
+#endif
+
+#endif
+
+/***************************************************************************
+ *                                                                         *
+ * Unicode character convertion.                                           *
+ *                                                                         *
+ * For un-safe characters.                                                 *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API int se_unsafe_unichar_to_utf8(seunichar c, seunichar8* buf)
+{
+    int len;
+
+    if (!SE_IS_VALID_SCALAR_VALUE(c))
+    {
+        if (buf)
+        {
+            buf[0] = SE_REPLACEMENT_CHAR_UTF8_1;
+            buf[1] = SE_REPLACEMENT_CHAR_UTF8_2;
+            buf[2] = SE_REPLACEMENT_CHAR_UTF8_3;
+        }
+        len = 3;
+    }
+    else if (c < 0x80)
     {
         if (buf)
         {
@@ -409,13 +887,19 @@ SE_API int se_safe_unichar_to_utf8(seunichar c, seunichar8* buf)
     return len;
 }
 
-SE_API int se_safe_unichar_to_utf16(seunichar c, seunichar16* buf)
+SE_API int se_unsafe_unichar_to_utf16(seunichar c, seunichar16* buf)
 {
     int len;
 
-    SE_DEBUG_ASSERT(SE_IS_VALID_SCALAR_VALUE(c));
-
-    if (c < 0x10000)
+    if (!SE_IS_VALID_SCALAR_VALUE(c))
+    {
+        if (buf)
+        {
+            buf[0] = SE_REPLACEMENT_CHAR;
+        }
+        len = 1;
+    }
+    else if (c < 0x10000)
     {
         if (buf)
         {
@@ -444,7 +928,26 @@ SE_API int se_safe_unichar_to_utf16(seunichar c, seunichar16* buf)
     return len;
 }
 
-SE_API seunichar32 se_safe_utf8_get_char(const seunichar8* str)
+#if SE_OPT_UTF8_DFA
+SE_API seunichar32 se_unsafe_utf8_get_char(const seunichar8* str)
+{
+    const unsigned char* iter;
+    unsigned int state;
+    seunichar32 c;
+
+    SE_DEBUG_ASSERT(str);
+
+    /* The NUL terminator rejects a truncated sequence */
+    c = 0;
+    iter = (const unsigned char*)str;
+    state = se_utf8_dfa_step(SE_UTF8_DFA_ACCEPT, *iter, &c);
+    while (state > SE_UTF8_DFA_REJECT)
+        state = se_utf8_dfa_step(state, *++iter, &c);
+
+    return state == SE_UTF8_DFA_ACCEPT ? c : SE_REPLACEMENT_CHAR;
+}
+#else
+SE_API seunichar32 se_unsafe_utf8_get_char(const seunichar8* str)
 {
     const unsigned char* iter;
 
@@ -457,26 +960,271 @@ SE_API seunichar32 se_safe_utf8_get_char(const seunichar8* str)
     }
     else if (iter[0] >= 0xC2 && iter[0] <= 0xDF)
     {
-        SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0xBF);
-        return (seunichar32) ( ((iter[0] & 0x1F) << 6) | (iter[1] & 0x3F) );
+        if (iter[1] >= 0x80 && iter[1] <= 0xBF)
+        {
+            return (seunichar32) ( ((iter[0] & 0x1F) << 6) | (iter[1] & 0x3F) );
+        }
     }
     else if (iter[0] == 0xE0)
     {
-        SE_DEBUG_ASSERT(iter[1] >= 0xA0 && iter[1] <= 0xBF);
-        SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
-        return (seunichar32) ( ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
+        if (iter[1] >= 0xA0 && iter[1] <= 0xBF &&
+            iter[2] >= 0x80 && iter[2] <= 0xBF)
+        {
+            return (seunichar32) ( ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
+        }
     }
     else if (iter[0] >= 0xE1 && iter[0] <= 0xEC)
     {
-        SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0xBF);
-        SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
-        return (seunichar32) ( ((iter[0] & 0x0F) << 12) | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
+        if (iter[1] >= 0x80 && iter[1] <= 0xBF &&
+            iter[2] >= 0x80 && iter[2] <= 0xBF)
+        {
+            return (seunichar32) ( ((iter[0] & 0x0F) << 12) | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
+        }
     }
     else if (iter[0] == 0xED)
     {
-        SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0x9F);
-        SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
-        return (seunichar32) ( 0xD000 | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
+        if (iter[1] >= 0x80 && iter[1] <= 0x9F &&
+            iter[2] >= 0x80 && iter[2] <= 0xBF)
+        {
+            return (seunichar32) ( 0xD000 | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
+        }
+    }
+    else if (iter[0] >= 0xEE && iter[0] <= 0xEF)
+    {
+        if (iter[1] >= 0x80 && iter[1] <= 0xBF &&
+            iter[2] >= 0x80 && iter[2] <= 0xBF)
+        {
+            return (seunichar32) ( ((iter[0] & 0x0F) << 12) | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
+        }
+    }
+    else if (iter[0] == 0xF0)
+    {
+        if (iter[1] >= 0x90 && iter[1] <= 0xBF &&
+            iter[2] >= 0x80 && iter[2] <= 0xBF &&
+            iter[3] >= 0x80 && iter[3] <= 0xBF)
+        {
+            return (seunichar32) ( ((iter[1] & 0x3F) << 12) | ((iter[2] & 0x3F) << 6) | (iter[3] & 0x3F) );
+        }
+    }
+    else if (iter[0] >= 0xF1 && iter[0] <= 0xF3)
+    {
+        if (iter[1] >= 0x80 && iter[1] <= 0xBF &&
+            iter[2] >= 0x80 && iter[2] <= 0xBF &&
+            iter[3] >= 0x80 && iter[3] <= 0xBF)
+        {
+            return (seunichar32) ( ((iter[0] & 7) << 18) | ((iter[1] & 0x3F) << 12) | ((iter[2] & 0x3F) << 6) | (iter[3] & 0x3F) );
+        }
+    }
+    else if (iter[0] == 0xF4)
+    {
+        if (iter[1] >= 0x80 && iter[1] <= 0x8F &&
+            iter[2] >= 0x80 && iter[2] <= 0xBF &&
+            iter[3] >= 0x80 && iter[3] <= 0xBF)
+        {
+            return (seunichar32) ( 0x100000 | ((iter[1] & 0x3F) << 12) | ((iter[2] & 0x3F) << 6) | (iter[3] & 0x3F) );
+        }
+    }
+
+    return SE_REPLACEMENT_CHAR;
+}
+#endif
+
+SE_API seunichar32 se_unsafe_utf16_get_char(const seunichar16* str)
+{
+    #if SE_OPT_SURROGATE
+
+        SE_DEBUG_ASSERT(str);
+
+        if (SE_IS_HI_SURROGATE(str[0]))
+        {
+            if (SE_IS_LO_SURROGATE(str[1]))
+                return SE_SURROGATE_VALUE(str[0], str[1]);
+        }
+        else if (SE_IS_LO_SURROGATE(str[0]))
+        {
+            return SE_REPLACEMENT_CHAR;
+        }
+        else
+        {
+            return str[0];
+        }
+
+        return SE_REPLACEMENT_CHAR;
+
+    #else
+
+        SE_DEBUG_ASSERT(str);
+
+        return *str;
+
+    #endif
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Unicode character convertion.                                           *
+ *                                                                         *
+ * For safe characters.                                                    *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API int se_safe_unichar_to_utf8(seunichar c, seunichar8* buf)
+/*
+ * c:
+ *      Input Unicode character code.
+ *
+ * buf:
+ *      Pointer to an UTF-8 string buffer for return output string.
+ *      (Can be NULL to indicate that the result is not needed.)
+ * 
+ * Convert a single character into UTF-8. Output buffer must have at
+ * least 4 bytes of space. Returns the number of bytes in the
+ * result.
+ */
+{
+    int len;
+
+    SE_DEBUG_ASSERT(SE_IS_VALID_SCALAR_VALUE(c));
+
+    if (c < 0x80)
+    {
+        if (buf)
+        {
+            buf[0] = (seunichar8) c;
+        }
+        len = 1;
+    }
+    else if (c < 0x800)
+    {
+        if (buf)
+        {
+            buf[1] = (seunichar8) ((c & 0x3F) | 0x80);
+            buf[0] = (seunichar8) ((c >> 6) | 0xC0);
+        }
+        len = 2;
+    }
+    else if (c < 0x10000)
+    {
+        if (buf)
+        {
+            buf[2] = (seunichar8) ((c & 0x3F) | 0x80);
+            c >>= 6;
+            buf[1] = (seunichar8) ((c & 0x3F) | 0x80);
+            buf[0] = (seunichar8) ((c >> 6) | 0xE0);
+        }
+        len = 3;
+    }
+    else
+    {
+        if (buf)
+        {
+            buf[3] = (seunichar8) ((c & 0x3F) | 0x80);
+            c >>= 6;
+            buf[2] = (seunichar8) ((c & 0x3F) | 0x80);
+            c >>= 6;
+            buf[1] = (seunichar8) ((c & 0x3F) | 0x80);
+            buf[0] = (seunichar8) ((c >> 6) | 0xF0);
+        }
+        len = 4;
+    }
+
+    #if SE_OPT_DEBUG
+        if (buf)
+        {
+            SE_DEBUG_ASSERT(se_is_valid_utf8_str(buf, len));
+        }
+    #endif
+
+    return len;
+}
+
+SE_API int se_safe_unichar_to_utf16(seunichar c, seunichar16* buf)
+{
+    int len;
+
+    SE_DEBUG_ASSERT(SE_IS_VALID_SCALAR_VALUE(c));
+
+    if (c < 0x10000)
+    {
+        if (buf)
+        {
+            buf[0] = (seunichar16) c;
+        }
+        len = 1;
+    }
+    else
+    {
+        if (buf)
+        {
+            c -= 0x10000;
+            buf[1] = (seunichar16) ((c & 0x3FF) | 0xDC00);
+            buf[0] = (seunichar16) ((c >> 10) | 0xD800);
+        }
+        len = 2;
+    }
+
+    #if SE_OPT_DEBUG
+        if (buf)
+        {
+            SE_DEBUG_ASSERT(se_is_valid_utf16_str(buf, len));
+        }
+    #endif
+
+    return len;
+}
+
+#if SE_OPT_UTF8_DFA
+SE_API seunichar32 se_safe_utf8_get_char(const seunichar8* str)
+{
+    const unsigned char* iter;
+    unsigned int state;
+    seunichar32 c;
+
+    SE_DEBUG_ASSERT(str);
+
+    c = 0;
+    iter = (const unsigned char*)str;
+    state = se_utf8_dfa_step(SE_UTF8_DFA_ACCEPT, *iter, &c);
+    while (state > SE_UTF8_DFA_REJECT)
+        state = se_utf8_dfa_step(state, *++iter, &c);
+
+    SE_DEBUG_ASSERT(state == SE_UTF8_DFA_ACCEPT);
+    return c;
+}
+#else
+SE_API seunichar32 se_safe_utf8_get_char(const seunichar8* str)
+{
+    const unsigned char* iter;
+
+    SE_DEBUG_ASSERT(str);
+
+    iter = (const unsigned char*)str;
+    if (iter[0] <= 0x7F)
+    {
+        return iter[0];
+    }
+    else if (iter[0] >= 0xC2 && iter[0] <= 0xDF)
+    {
+        SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0xBF);
+        return (seunichar32) ( ((iter[0] & 0x1F) << 6) | (iter[1] & 0x3F) );
+    }
+    else if (iter[0] == 0xE0)
+    {
+        SE_DEBUG_ASSERT(iter[1] >= 0xA0 && iter[1] <= 0xBF);
+        SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
+        return (seunichar32) ( ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
+    }
+    else if (iter[0] >= 0xE1 && iter[0] <= 0xEC)
+    {
+        SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0xBF);
+        SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
+        return (seunichar32) ( ((iter[0] & 0x0F) << 12) | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
+    }
+    else if (iter[0] == 0xED)
+    {
+        SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0x9F);
+        SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
+        return (seunichar32) ( 0xD000 | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F) );
     }
     else if (iter[0] >= 0xEE && iter[0] <= 0xEF)
     {
@@ -507,6 +1255,7 @@ SE_API seunichar32 se_safe_utf8_get_char(const seunichar8* str)
         return (seunichar32) ( 0x100000 | ((iter[1] & 0x3F) << 12) | ((iter[2] & 0x3F) << 6) | (iter[3] & 0x3F) );
     }
 }
+#endif
 
 #if SE_OPT_SURROGATE
 SE_API seunichar32 se_safe_utf16_get_char(const seunichar16* str)
@@ -535,14 +1284,26 @@ SE_API seunichar32 se_safe_utf16_get_char(const seunichar16* str)
  *                                                                         *
  ***************************************************************************/
 
-SE_API int se_utf8_str_len(const seunichar8* str)
+/*
+ * The _sz variants of the length, validation, character counting and
+ * conversion functions take and return ptrdiff_t lengths, so strings of
+ * 2 GB and more can be processed in a single call on 64-bit platforms.
+ * The int functions are wrappers around them.
+ */
+
+SE_API ptrdiff_t se_utf8_str_len_sz(const seunichar8* str)
 {
     SE_DEBUG_ASSERT(str);
 
     return strlen(str);
 }
 
-SE_API int se_utf16_str_len(const seunichar16* str)
+SE_API int se_utf8_str_len(const seunichar8* str)
+{
+    return (int) se_utf8_str_len_sz(str);
+}
+
+SE_API ptrdiff_t se_utf16_str_len_sz(const seunichar16* str)
 {
     const seunichar16* iter;
 
@@ -555,7 +1316,12 @@ SE_API int se_utf16_str_len(const seunichar16* str)
     return iter - str;
 }
 
-SE_API int se_utf32_str_len(const seunichar32* str)
+SE_API int se_utf16_str_len(const seunichar16* str)
+{
+    return (int) se_utf16_str_len_sz(str);
+}
+
+SE_API ptrdiff_t se_utf32_str_len_sz(const seunichar32* str)
 {
     const seunichar32* iter;
 
@@ -568,6 +1334,11 @@ SE_API int se_utf32_str_len(const seunichar32* str)
     return iter - str;
 }
 
+SE_API int se_utf32_str_len(const seunichar32* str)
+{
+    return (int) se_utf32_str_len_sz(str);
+}
+
 /***************************************************************************
  *                                                                         *
  * Unicode string validation.                                              *
@@ -576,18 +1347,35 @@ SE_API int se_utf32_str_len(const seunichar32* str)
  *                                                                         *
  ***************************************************************************/
 
-SE_API sebool se_is_valid_utf8_str(const seunichar8* str, int len)
+#if SE_OPT_UTF8_DFA
+static sebool se_utf8_is_valid(const unsigned char* iter, const unsigned char* end)
+/*
+ * Return whether the UTF-8 string from iter to end is well-formed.
+ */
 {
-    const unsigned char* iter;
-    const unsigned char* end;
-
-    SE_DEBUG_ASSERT(str);
+    unsigned int state;
 
-    if (len < 0)
-        len = se_utf8_str_len(str);
+    state = SE_UTF8_DFA_ACCEPT;
+    while (iter < end)
+    {
+        if (end - iter >= 8 && se_utf8_dfa_ascii_8(iter) && state == SE_UTF8_DFA_ACCEPT)
+        {
+            iter += 8;
+            continue;
+        }
+        state = se_utf8_dfa_next(state, *iter++);
+        if (state == SE_UTF8_DFA_REJECT)
+            return FALSE;
+    }
 
-    iter = (const unsigned char*)str;
-    end = iter + len;
+    return state == SE_UTF8_DFA_ACCEPT;
+}
+#else
+static sebool se_utf8_is_valid(const unsigned char* iter, const unsigned char* end)
+/*
+ * Return whether the UTF-8 string from iter to end is well-formed.
+ */
+{
     while (iter < end)
     {
         if (iter[0] <= 0x7F)
@@ -714,8 +1502,32 @@ SE_API sebool se_is_valid_utf8_str(const seunichar8* str, int len)
 
     return TRUE;
 }
+#endif
 
-SE_API sebool se_is_valid_utf16_str(const seunichar16* str, int len)
+SE_API sebool se_is_valid_utf8_str_sz(const seunichar8* str, ptrdiff_t len)
+{
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    SE_STATS_COUNT(SE_STATS_IS_VALID_UTF8, len * sizeof(seunichar8));
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    return se_utf8_is_valid(iter, end);
+}
+
+SE_API sebool se_is_valid_utf8_str(const seunichar8* str, int len)
+{
+    return se_is_valid_utf8_str_sz(str, len);
+}
+
+SE_API sebool se_is_valid_utf16_str_sz(const seunichar16* str, ptrdiff_t len)
 {
     #if SE_OPT_SURROGATE
 
@@ -726,7 +1538,9 @@ SE_API sebool se_is_valid_utf16_str(const seunichar16* str, int len)
             len = 0;
 
         if (len < 0)
-            len = se_utf16_str_len(str);
+            len = se_utf16_str_len_sz(str);
+
+        SE_STATS_COUNT(SE_STATS_IS_VALID_UTF16, len * sizeof(seunichar16));
 
         iter = str;
         end = iter + len;
@@ -757,14 +1571,21 @@ SE_API sebool se_is_valid_utf16_str(const seunichar16* str, int len)
     #endif
 }
 
-SE_API sebool se_is_valid_utf32_str(const seunichar32* str, int len)
+SE_API sebool se_is_valid_utf16_str(const seunichar16* str, int len)
 {
-    int i;
+    return se_is_valid_utf16_str_sz(str, len);
+}
+
+SE_API sebool se_is_valid_utf32_str_sz(const seunichar32* str, ptrdiff_t len)
+{
+    ptrdiff_t i;
 
     SE_DEBUG_ASSERT(str);
 
     if (len < 0)
-        len = se_utf32_str_len(str);
+        len = se_utf32_str_len_sz(str);
+
+    SE_STATS_COUNT(SE_STATS_IS_VALID_UTF32, len * sizeof(seunichar32));
 
     for (i = 0; i < len; i++)
     {
@@ -774,6 +1595,11 @@ SE_API sebool se_is_valid_utf32_str(const seunichar32* str, int len)
     return TRUE;
 }
 
+SE_API sebool se_is_valid_utf32_str(const seunichar32* str, int len)
+{
+    return se_is_valid_utf32_str_sz(str, len);
+}
+
 /***************************************************************************
  *                                                                         *
  * Copy Unicode string without validation.                                 *
@@ -790,6 +1616,8 @@ SE_API seunichar8* se_utf8_str_copy(const seunichar8* str, int len)
     SE_DEBUG_ASSERT(len >= 0);
 
     new_str = SE_MALLOC((len + 1) * sizeof(seunichar8));
+    SE_STATS_ALLOC(SE_STATS_UTF8_STR_COPY, (len + 1) * sizeof(seunichar8));
+    SE_TRACE_ALLOC(SE_STATS_UTF8_STR_COPY, len * sizeof(seunichar8), (len + 1) * sizeof(seunichar8), (len + 1) * sizeof(seunichar8));
     memcpy(new_str, str, len * sizeof(seunichar8));
     new_str[len] = 0;
 
@@ -804,6 +1632,8 @@ SE_API seunichar16* se_utf16_str_copy(const seunichar16* str, int len)
     SE_DEBUG_ASSERT(len >= 0);
 
     new_str = SE_MALLOC((len + 1) * sizeof(seunichar16));
+    SE_STATS_ALLOC(SE_STATS_UTF16_STR_COPY, (len + 1) * sizeof(seunichar16));
+    SE_TRACE_ALLOC(SE_STATS_UTF16_STR_COPY, len * sizeof(seunichar16), (len + 1) * sizeof(seunichar16), (len + 1) * sizeof(seunichar16));
     memcpy(new_str, str, len * sizeof(seunichar16));
     new_str[len] = 0;
 
@@ -818,6 +1648,8 @@ SE_API seunichar32* se_utf32_str_copy(const seunichar32* str, int len)
     SE_DEBUG_ASSERT(len >= 0);
 
     new_str = SE_MALLOC((len + 1) * sizeof(seunichar32));
+    SE_STATS_ALLOC(SE_STATS_UTF32_STR_COPY, (len + 1) * sizeof(seunichar32));
+    SE_TRACE_ALLOC(SE_STATS_UTF32_STR_COPY, len * sizeof(seunichar32), (len + 1) * sizeof(seunichar32), (len + 1) * sizeof(seunichar32));
     memcpy(new_str, str, len * sizeof(seunichar32));
     new_str[len] = 0;
 
@@ -834,23 +1666,71 @@ SE_API seunichar32* se_utf32_str_copy(const seunichar32* str, int len)
  *                                                                         *
  ***************************************************************************/
 
-SE_API seunichar8* se_unsafe_utf8_str_safe_copy(const seunichar8* str, int len, int* out_len)
+#if SE_OPT_UTF8_DFA_CONVERT
+static ptrdiff_t se_unsafe_utf8_safe_copy_len(const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in bytes of the UTF-8 string from iter to end, once
+ * ill-formed codes are replaced.
+ */
 {
-    int new_str_len;
-    seunichar8* new_str;
-    unsigned char* new_str_iter;
-    const unsigned char* iter;
-    const unsigned char* end;
+    static const unsigned char units[SE_UTF8_DFA_CLASS_COUNT] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
 
-    SE_DEBUG_ASSERT(str);
+    return se_utf8_dfa_len(iter, end, units, 3);
+}
 
-    if (len < 0)
-        len = se_utf8_str_len(str);
+static unsigned char* se_unsafe_utf8_safe_copy_fill(const unsigned char* iter, const unsigned char* end, unsigned char* new_str_iter)
+/*
+ * Copy the UTF-8 string from iter to end into new_str_iter, replacing
+ * ill-formed codes, and return the end of the output. The output needs
+ * at most 3 bytes per input byte.
+ *
+ * Bytes are copied as they are fed to the automaton, and taken back if
+ * their sequence fails.
+ */
+{
+    const unsigned char* lead;
+    unsigned int prev;
+    unsigned int state;
+
+    state = SE_UTF8_DFA_ACCEPT;
+    while (iter < end)
+    {
+        if (end - iter >= 8 && se_utf8_dfa_ascii_8(iter) && state == SE_UTF8_DFA_ACCEPT)
+        {
+            memcpy(new_str_iter, iter, 8);
+            new_str_iter += 8;
+            iter += 8;
+            continue;
+        }
+        prev = state;
+        state = se_utf8_dfa_next(state, *iter);
+        *new_str_iter++ = *iter++;
+        if (state == SE_UTF8_DFA_REJECT || (iter == end && state != SE_UTF8_DFA_ACCEPT))
+        {
+            SE_STATS_REPLACED();
+            lead = se_utf8_dfa_lead(iter - 1, prev, state);
+            new_str_iter -= iter - lead;
+            *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_1_CODE;
+            *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_2_CODE;
+            *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_3_CODE;
+            iter = lead + 1;
+            state = SE_UTF8_DFA_ACCEPT;
+        }
+    }
+
+    return new_str_iter;
+}
+#else
+static ptrdiff_t se_unsafe_utf8_safe_copy_len(const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in bytes of the UTF-8 string from iter to end, once
+ * ill-formed codes are replaced.
+ */
+{
+    ptrdiff_t new_str_len;
 
     new_str_len = 0;
 
-    iter = (const unsigned char*)str;
-    end = iter + len;
     while (iter < end)
     {
         if (iter[0] <= 0x7F)
@@ -932,10 +1812,16 @@ ill_formed_1:
         }
     }
 
-    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar8));
-    new_str_iter = (unsigned char*)new_str;
+    return new_str_len;
+}
 
-    iter = (const unsigned char*)str;
+static unsigned char* se_unsafe_utf8_safe_copy_fill(const unsigned char* iter, const unsigned char* end, unsigned char* new_str_iter)
+/*
+ * Copy the UTF-8 string from iter to end into new_str_iter, replacing
+ * ill-formed codes, and return the end of the output. The output needs
+ * at most 3 bytes per input byte.
+ */
+{
     while (iter < end)
     {
         if (iter[0] <= 0x7F)
@@ -1021,6 +1907,7 @@ ill_formed_1:
         else
         {
 ill_formed_2:
+            SE_STATS_REPLACED();
             *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_1_CODE;
             *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_2_CODE;
             *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_3_CODE;
@@ -1028,10 +1915,42 @@ ill_formed_2:
         }
     }
 
+    return new_str_iter;
+}
+#endif
+
+SE_API seunichar8* se_unsafe_utf8_str_safe_copy_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    seunichar8* new_str;
+    unsigned char* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    SE_STATS_ENTER();
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_unsafe_utf8_safe_copy_len(iter, end);
+
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar8));
+    SE_STATS_ALLOC(SE_STATS_UTF8_SAFE_COPY, (new_str_len + 1) * sizeof(seunichar8));
+    SE_TRACE_ALLOC(SE_STATS_UTF8_SAFE_COPY, len, (new_str_len + 1) * sizeof(seunichar8), (len * 3 + 1) * sizeof(seunichar8));
+
+    new_str_iter = se_unsafe_utf8_safe_copy_fill(iter, end, (unsigned char*)new_str);
+
     SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf8_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_UTF8_SAFE_COPY, len * sizeof(seunichar8), new_str_len * sizeof(seunichar8));
 
     if (out_len)
         *out_len = new_str_len;
@@ -1039,16 +1958,63 @@ ill_formed_2:
     return new_str;
 }
 
-SE_API seunichar16* se_unsafe_utf16_str_safe_copy(const seunichar16* str, int len, int* out_len)
+SE_API seunichar8* se_unsafe_utf8_str_safe_copy(const seunichar8* str, int len, int* out_len)
 {
-    int new_str_len;
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf8_str_safe_copy_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_unsafe_utf8_str_safe_copy_into(const seunichar8* str, ptrdiff_t len, seunichar8* buf)
+/*
+ * buf:
+ *      The output buffer, with room for at least 3 * len bytes.
+ *
+ * Copy as by se_unsafe_utf8_str_safe_copy() into a buffer owned by the
+ * caller, so large inputs can be written straight to a pre-sized sink.
+ * The output is not NUL terminated.
+ *
+ * Return:
+ *      The length in bytes of the output.
+ */
+{
+    const unsigned char* iter;
+    unsigned char* buf_end;
+
+    SE_DEBUG_ASSERT(str);
+    SE_DEBUG_ASSERT(buf);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    SE_STATS_ENTER();
+
+    iter = (const unsigned char*)str;
+    buf_end = se_unsafe_utf8_safe_copy_fill(iter, iter + len, (unsigned char*)buf);
+
+    SE_STATS_LEAVE(SE_STATS_UTF8_SAFE_COPY_INTO, len, buf_end - (unsigned char*)buf);
+
+    return buf_end - (unsigned char*)buf;
+}
+
+SE_API seunichar16* se_unsafe_utf16_str_safe_copy_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
     seunichar16* new_str;
     seunichar16* new_str_iter;
     const seunichar16* iter;
     const seunichar16* end;
 
     if (len < 0)
-        len = se_utf16_str_len(str);
+        len = se_utf16_str_len_sz(str);
+
+    SE_STATS_ENTER();
 
     new_str_len = 0;
 
@@ -1072,6 +2038,9 @@ ill_formed_1:
     }
 
     new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar16));
+    SE_STATS_ALLOC(SE_STATS_UTF16_SAFE_COPY, (new_str_len + 1) * sizeof(seunichar16));
+    SE_TRACE_ALLOC(SE_STATS_UTF16_SAFE_COPY, len * sizeof(seunichar16), (new_str_len + 1) * sizeof(seunichar16), (len + 1) * sizeof(seunichar16));
+
     new_str_iter = new_str;
 
     iter = str;
@@ -1087,6 +2056,7 @@ ill_formed_1:
         else if (SE_IS_LO_SURROGATE(iter[0]))
         {
 ill_formed_2:
+            SE_STATS_REPLACED();
             *new_str_iter++ = SE_REPLACEMENT_CHAR;
             iter++;
         }
@@ -1099,7 +2069,9 @@ ill_formed_2:
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf16_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_UTF16_SAFE_COPY, len * sizeof(seunichar16), new_str_len * sizeof(seunichar16));
 
     if (out_len)
         *out_len = new_str_len;
@@ -1107,27 +2079,52 @@ ill_formed_2:
     return new_str;
 }
 
-SE_API seunichar32* se_unsafe_utf32_str_safe_copy(const seunichar32* str, int len, int* out_len)
+SE_API seunichar16* se_unsafe_utf16_str_safe_copy(const seunichar16* str, int len, int* out_len)
 {
-    int i;
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf16_str_safe_copy_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar32* se_unsafe_utf32_str_safe_copy_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t i;
     seunichar32* new_str;
 
     SE_DEBUG_ASSERT(str);
 
     if (len < 0)
-        len = se_utf32_str_len(str);
+        len = se_utf32_str_len_sz(str);
+
+    SE_STATS_ENTER();
 
     new_str = SE_MALLOC((len + 1) * sizeof(seunichar32));
+    SE_STATS_ALLOC(SE_STATS_UTF32_SAFE_COPY, (len + 1) * sizeof(seunichar32));
+    SE_TRACE_ALLOC(SE_STATS_UTF32_SAFE_COPY, len * sizeof(seunichar32), (len + 1) * sizeof(seunichar32), (len + 1) * sizeof(seunichar32));
+
     for (i = 0; i < len; i++)
     {
         if (SE_IS_VALID_SCALAR_VALUE(str[i]))
+        {
             new_str[i] = str[i];
+        }
         else
+        {
+            SE_STATS_REPLACED();
             new_str[i] = SE_REPLACEMENT_CHAR;
+        }
     }
     new_str[len] = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf32_str(new_str, len));
+    SE_DEBUG_ASSERT(se_is_valid_utf32_str_sz(new_str, len));
+
+    SE_STATS_LEAVE(SE_STATS_UTF32_SAFE_COPY, len * sizeof(seunichar32), len * sizeof(seunichar32));
 
     if (out_len)
         *out_len = len;
@@ -1135,6 +2132,150 @@ SE_API seunichar32* se_unsafe_utf32_str_safe_copy(const seunichar32* str, int le
     return new_str;
 }
 
+SE_API seunichar32* se_unsafe_utf32_str_safe_copy(const seunichar32* str, int len, int* out_len)
+{
+    seunichar32* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf32_str_safe_copy_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+/*
+ * Characters of a well-formed UTF-8 string are counted by counting the
+ * bytes which are not continuation bytes (10xxxxxx). As signed chars,
+ * these are exactly the bytes greater than (char) 0xBF.
+ */
+static ptrdiff_t se_utf8_count_lead_bytes(const unsigned char* iter, const unsigned char* end)
+{
+    ptrdiff_t count;
+
+    count = 0;
+
+    #if SE_OPT_SSE2
+    {
+        __m128i cont_max;
+        __m128i acc;
+        __m128i sums;
+        int blocks;
+
+        cont_max = _mm_set1_epi8((char) 0xBF);
+        while (end - iter >= 16)
+        {
+            /* Byte lanes of acc can count up to 255 blocks before overflow. */
+            blocks = (int) ((end - iter) / 16);
+            if (blocks > 255)
+                blocks = 255;
+
+            acc = _mm_setzero_si128();
+            while (blocks--)
+            {
+                acc = _mm_sub_epi8(acc, _mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)iter), cont_max));
+                iter += 16;
+            }
+
+            sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+            count += _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+        }
+    }
+    #endif
+
+    while (iter < end)
+    {
+        if ((*iter & 0xC0) != 0x80)
+            count++;
+        iter++;
+    }
+
+    return count;
+}
+
+static const unsigned char* se_utf8_skip_chars(const unsigned char* iter, const unsigned char* end, int count)
+/*
+ * Skip count characters forward from a character boundary of a
+ * well-formed UTF-8 string, stopping at end. If end is NULL, the caller
+ * guarantees that there are count characters after iter. No byte beyond
+ * the last skipped character is read, so the string need not be NUL
+ * terminated.
+ */
+{
+    SE_DEBUG_ASSERT(count >= 0);
+    SE_DEBUG_ASSERT(!end || iter <= end);
+
+    #if SE_OPT_SSE2
+        if (count > 16)
+        {
+            __m128i cont_max;
+
+            /*
+             * While more than 16 characters are left, the next 16 bytes
+             * are all part of the string. A block may end in the middle
+             * of a character, whose trailing bytes are skipped below.
+             */
+            cont_max = _mm_set1_epi8((char) 0xBF);
+            while (count > 16 && (!end || end - iter >= 16))
+            {
+                count -= se_bit_count(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)iter), cont_max)));
+                iter += 16;
+            }
+
+            while ((!end || iter < end) && (*iter & 0xC0) == 0x80)
+                iter++;
+        }
+    #endif
+
+    while (count > 0 && (!end || iter < end))
+    {
+        iter = (const unsigned char*)se_safe_utf8_next_char((const seunichar8*)iter);
+        count--;
+    }
+
+    return iter;
+}
+
+static const unsigned char* se_utf8_rewind_chars(const unsigned char* start, const unsigned char* iter, int count)
+/*
+ * Step count characters backward from a character boundary of a
+ * well-formed UTF-8 string, stopping at start. If start is NULL, the
+ * caller guarantees that there are count characters before iter.
+ */
+{
+    SE_DEBUG_ASSERT(count >= 0);
+    SE_DEBUG_ASSERT(!start || start <= iter);
+
+    #if SE_OPT_SSE2
+    {
+        __m128i cont_max;
+
+        /*
+         * Count the lead bytes of the 16 bytes before iter while more
+         * than 16 characters are left, so iter never moves past the
+         * wanted character. It may stop in the middle of a character,
+         * the loop below then finds the lead byte.
+         */
+        cont_max = _mm_set1_epi8((char) 0xBF);
+        while (count > 16 && (!start || iter - start >= 16))
+        {
+            count -= se_bit_count(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)(iter - 16)), cont_max)));
+            iter -= 16;
+        }
+    }
+    #endif
+
+    while (count > 0 && (!start || iter > start))
+    {
+        iter--;
+        if ((*iter & 0xC0) != 0x80)
+            count--;
+    }
+
+    return iter;
+}
+
 /***************************************************************************
  *                                                                         *
  * Unicode string length in characters.                                    *
@@ -1143,7 +2284,7 @@ SE_API seunichar32* se_unsafe_utf32_str_safe_copy(const seunichar32* str, int le
  *                                                                         *
  ***************************************************************************/
 
-SE_API int se_safe_utf8_str_char_count(const seunichar8* str, int len)
+SE_API ptrdiff_t se_safe_utf8_str_char_count_sz(const seunichar8* str, ptrdiff_t len)
 /*
  * str:
  *      Pointer to the start of a UTF-8 encoded string.
@@ -1158,47 +2299,35 @@ SE_API int se_safe_utf8_str_char_count(const seunichar8* str, int len)
  *      The length of the string in characters.
  */
 {
-    int char_count;
-    const unsigned char* iter;
-    const unsigned char* end;
-
-    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(str, len));
 
     if (str && len < 0)
-        len = se_utf8_str_len(str);
+        len = se_utf8_str_len_sz(str);
 
-    char_count = 0;
+    SE_STATS_COUNT(SE_STATS_UTF8_CHAR_COUNT, len * sizeof(seunichar8));
 
-    iter = (const unsigned char*)str;
-    end = iter + len;
-    while (iter < end)
-    {
-        if (*iter <= 0x7F)
-            iter++;
-        else if (*iter >= 0xC2 && *iter <= 0xDF)
-            iter += 2;
-        else if (*iter >= 0xE0 && *iter <= 0xEF)
-            iter += 3;
-        else /* *iter >= 0xF0 && *iter <= 0xF4 */
-            iter += 4;
-        char_count++;
-    }
+    return se_utf8_count_lead_bytes((const unsigned char*)str, (const unsigned char*)str + len);
+}
 
-    return char_count;
+SE_API int se_safe_utf8_str_char_count(const seunichar8* str, int len)
+{
+    return (int) se_safe_utf8_str_char_count_sz(str, len);
 }
 
-SE_API int se_safe_utf16_str_char_count(const seunichar16* str, int len)
+SE_API ptrdiff_t se_safe_utf16_str_char_count_sz(const seunichar16* str, ptrdiff_t len)
 {
     #if SE_OPT_SURROGATE
 
-        int char_count;
+        ptrdiff_t char_count;
         const seunichar16* iter;
         const seunichar16* end;
 
-        SE_DEBUG_ASSERT(se_is_valid_utf16_str(str, len));
+        SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(str, len));
 
         if (str && len < 0)
-            len = se_utf16_str_len(str);
+            len = se_utf16_str_len_sz(str);
+
+        SE_STATS_COUNT(SE_STATS_UTF16_CHAR_COUNT, len * sizeof(seunichar16));
 
         char_count = 0;
 
@@ -1217,24 +2346,36 @@ SE_API int se_safe_utf16_str_char_count(const seunichar16* str, int len)
 
     #else
 
-        SE_DEBUG_ASSERT(se_is_valid_utf16_str(str, len));
+        SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(str, len));
 
         if (str && len < 0)
-            return se_utf16_str_len(str);
+            return se_utf16_str_len_sz(str);
         else
             return len;
 
     #endif
 }
 
-SE_API int se_safe_utf32_str_char_count(const seunichar32* str, int len)
+SE_API int se_safe_utf16_str_char_count(const seunichar16* str, int len)
+{
+    return (int) se_safe_utf16_str_char_count_sz(str, len);
+}
+
+SE_API ptrdiff_t se_safe_utf32_str_char_count_sz(const seunichar32* str, ptrdiff_t len)
 {
-    SE_DEBUG_ASSERT(se_is_valid_utf32_str(str, len));
+    SE_DEBUG_ASSERT(se_is_valid_utf32_str_sz(str, len));
 
     if (len < 0)
-        return se_utf32_str_len(str);
-    else
-        return len;
+        len = se_utf32_str_len_sz(str);
+
+    SE_STATS_COUNT(SE_STATS_UTF32_CHAR_COUNT, len * sizeof(seunichar32));
+
+    return len;
+}
+
+SE_API int se_safe_utf32_str_char_count(const seunichar32* str, int len)
+{
+    return (int) se_safe_utf32_str_char_count_sz(str, len);
 }
 
 /***************************************************************************
@@ -1247,28 +2388,89 @@ SE_API int se_safe_utf32_str_char_count(const seunichar32* str, int len)
  *                                                                         *
  ***************************************************************************/
 
-SE_API seunichar16* se_unsafe_utf8_to_safe_utf16(const seunichar8* str, int len, int* out_len)
+#if SE_OPT_UTF8_DFA_CONVERT
+static ptrdiff_t se_unsafe_utf8_utf16_len(const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in UTF-16 units of the UTF-8 string from iter to end,
+ * once ill-formed codes are replaced.
+ */
 {
-    int new_str_len;
-    seunichar16* new_str;
-    seunichar16* new_str_iter;
-    const unsigned char* iter;
-    const unsigned char* end;
+    static const unsigned char units[SE_UTF8_DFA_CLASS_COUNT] = { 1, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2 };
+
+    return se_utf8_dfa_len(iter, end, units, 1);
+}
+
+static seunichar16* se_unsafe_utf8_utf16_fill(const unsigned char* iter, const unsigned char* end, seunichar16* new_str_iter)
+/*
+ * Convert the UTF-8 string from iter to end into new_str_iter, which has
+ * room for se_unsafe_utf8_utf16_len() units, and return the end of the
+ * output.
+ */
+{
+    const unsigned char* lead;
+    int i;
+    unsigned int prev;
+    unsigned int state;
     seunichar32 c;
 
-    SE_DEBUG_ASSERT(str);
+    c = 0;
+    state = SE_UTF8_DFA_ACCEPT;
+    while (iter < end)
+    {
+        if (end - iter >= 8 && se_utf8_dfa_ascii_8(iter) && state == SE_UTF8_DFA_ACCEPT)
+        {
+            for (i = 0; i < 8; i++)
+                *new_str_iter++ = *iter++;
+            continue;
+        }
+        prev = state;
+        state = se_utf8_dfa_step(state, *iter++, &c);
+        if (c >= 0x10000 && state == SE_UTF8_DFA_ACCEPT)
+        {
+            new_str_iter += se_safe_unichar_to_utf16(c, new_str_iter);
+        }
+        else
+        {
+            /* Written ahead of the end of the sequence, kept if accepted */
+            *new_str_iter = (seunichar16) c;
+            new_str_iter += SE_UTF8_DFA_ACCEPTED(state);
+        }
+        if (state == SE_UTF8_DFA_REJECT || (iter == end && state != SE_UTF8_DFA_ACCEPT))
+        {
+            SE_STATS_REPLACED();
+            lead = se_utf8_dfa_lead(iter - 1, prev, state);
+            *new_str_iter++ = SE_REPLACEMENT_CHAR;
+            iter = lead + 1;
+            state = SE_UTF8_DFA_ACCEPT;
+        }
+    }
 
-    if (len < 0)
-        len = se_utf8_str_len(str);
+    return new_str_iter;
+}
+#else
+static ptrdiff_t se_unsafe_utf8_utf16_len(const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in UTF-16 units of the UTF-8 string from iter to end,
+ * once ill-formed codes are replaced. Runs of 16 ASCII bytes are handled
+ * at once.
+ */
+{
+    ptrdiff_t new_str_len;
 
     new_str_len = 0;
 
-    iter = (const unsigned char*)str;
-    end = iter + len;
     while (iter < end)
     {
         if (iter[0] <= 0x7F)
         {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)iter)))
+                {
+                    new_str_len += 16;
+                    iter += 16;
+                    continue;
+                }
+            #endif
             new_str_len++;
             iter++;
         }
@@ -1346,14 +2548,38 @@ ill_formed_1:
         }
     }
 
-    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar16));
-    new_str_iter = new_str;
+    return new_str_len;
+}
+
+static seunichar16* se_unsafe_utf8_utf16_fill(const unsigned char* iter, const unsigned char* end, seunichar16* new_str_iter)
+/*
+ * Convert the UTF-8 string from iter to end into new_str_iter, which has
+ * room for se_unsafe_utf8_utf16_len() units, and return the end of the
+ * output. Runs of 16 ASCII bytes are widened at once.
+ */
+{
+    seunichar32 c;
 
-    iter = (const unsigned char*)str;
     while (iter < end)
     {
         if (iter[0] <= 0x7F)
         {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16)
+                {
+                    __m128i block;
+
+                    block = _mm_loadu_si128((const __m128i*)iter);
+                    if (!_mm_movemask_epi8(block))
+                    {
+                        _mm_storeu_si128((__m128i*)new_str_iter, _mm_unpacklo_epi8(block, _mm_setzero_si128()));
+                        _mm_storeu_si128((__m128i*)(new_str_iter + 8), _mm_unpackhi_epi8(block, _mm_setzero_si128()));
+                        new_str_iter += 16;
+                        iter += 16;
+                        continue;
+                    }
+                }
+            #endif
             *new_str_iter++ = *iter++;
         }
         else if (iter[0] >= 0xC2 && iter[0] <= 0xDF)
@@ -1428,15 +2654,48 @@ ill_formed_1:
         else
         {
 ill_formed_2:
+            SE_STATS_REPLACED();
             *new_str_iter++ = SE_REPLACEMENT_CHAR;
             iter++;
         }
     }
 
+    return new_str_iter;
+}
+#endif
+
+SE_API seunichar16* se_unsafe_utf8_to_safe_utf16_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    seunichar16* new_str;
+    seunichar16* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    SE_STATS_ENTER();
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_unsafe_utf8_utf16_len(iter, end);
+
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar16));
+    SE_STATS_ALLOC(SE_STATS_UNSAFE_UTF8_TO_UTF16, (new_str_len + 1) * sizeof(seunichar16));
+    SE_TRACE_ALLOC(SE_STATS_UNSAFE_UTF8_TO_UTF16, len, (new_str_len + 1) * sizeof(seunichar16), (len + 1) * sizeof(seunichar16));
+
+    new_str_iter = se_unsafe_utf8_utf16_fill(iter, end, new_str);
+
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf16_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_UNSAFE_UTF8_TO_UTF16, len * sizeof(seunichar8), new_str_len * sizeof(seunichar16));
 
     if (out_len)
         *out_len = new_str_len;
@@ -1444,79 +2703,232 @@ ill_formed_2:
     return new_str;
 }
 
-SE_API seunichar8* se_unsafe_utf16_to_safe_utf8(const seunichar16* str, int len, int* out_len)
+SE_API seunichar16* se_unsafe_utf8_to_safe_utf16(const seunichar8* str, int len, int* out_len)
 {
-    int new_str_len;
-    seunichar8* new_str;
-    seunichar8* new_str_iter;
-    const seunichar16* iter;
-    const seunichar16* end;
-    seunichar c;
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf8_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_unsafe_utf8_to_safe_utf16_into(const seunichar8* str, ptrdiff_t len, seunichar16* buf)
+/*
+ * buf:
+ *      The output buffer, with room for at least len UTF-16 units.
+ *
+ * Convert as by se_unsafe_utf8_to_safe_utf16() into a buffer owned by the
+ * caller. The output is not NUL terminated.
+ *
+ * Return:
+ *      The length in UTF-16 units of the output.
+ */
+{
+    const unsigned char* iter;
+    seunichar16* buf_end;
 
     SE_DEBUG_ASSERT(str);
+    SE_DEBUG_ASSERT(buf);
 
     if (len < 0)
-        len = se_utf16_str_len(str);
+        len = se_utf8_str_len_sz(str);
+
+    SE_STATS_ENTER();
+
+    iter = (const unsigned char*)str;
+    buf_end = se_unsafe_utf8_utf16_fill(iter, iter + len, buf);
+
+    SE_STATS_LEAVE(SE_STATS_UNSAFE_UTF8_TO_UTF16_INTO, len, (buf_end - buf) * sizeof(seunichar16));
+
+    return buf_end - buf;
+}
+
+SE_API seunichar16* se_unsafe_utf8_to_safe_utf16_batch(const seunichar8* const* strs, const int* lens, int count, int* offsets, int* out_len)
+/*
+ * strs:
+ *      An array of count UTF-8 strings.
+ *
+ * lens:
+ *      The byte lengths of the strings. A negative length, or a NULL
+ *      array, means the strings are NUL terminated.
+ *
+ * offsets:
+ *      An array of count + 1 integers, returning the offset in UTF-16
+ *      units of each converted string in the output. The last entry is
+ *      the total length.
+ *
+ * out_len:
+ *      Location to return the length of the output string.
+ *      (Can be NULL to indicate that the result is not needed.)
+ *
+ * Convert many short strings as by se_unsafe_utf8_to_safe_utf16() with a
+ * single allocation. The converted strings are stored back to back, the
+ * output is NUL terminated once at the end.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    int i;
+    int len;
+    int new_str_len;
+    ptrdiff_t in_len;
+    seunichar16* new_str;
+    seunichar16* new_str_iter;
+    const unsigned char* iter;
 
+    SE_DEBUG_ASSERT(count >= 0);
+    SE_DEBUG_ASSERT(offsets);
+
+    SE_STATS_ENTER();
+
+    /*
+     * The sizing pass keeps the byte length of each string in offsets[i],
+     * so NUL terminated strings are measured only once. The fill pass
+     * replaces it with the output offset.
+     */
     new_str_len = 0;
+    in_len = 0;
+    for (i = 0; i < count; i++)
+    {
+        SE_DEBUG_ASSERT(strs[i]);
+
+        len = lens ? lens[i] : -1;
+        if (len < 0)
+            len = se_utf8_str_len(strs[i]);
+
+        iter = (const unsigned char*)strs[i];
+        offsets[i] = len;
+        new_str_len += (int) se_unsafe_utf8_utf16_len(iter, iter + len);
+        in_len += len;
+    }
+    offsets[count] = new_str_len;
+
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar16));
+    SE_STATS_ALLOC(SE_STATS_UNSAFE_UTF8_TO_UTF16_BATCH, (new_str_len + 1) * sizeof(seunichar16));
+    SE_TRACE_ALLOC(SE_STATS_UNSAFE_UTF8_TO_UTF16_BATCH, in_len, (new_str_len + 1) * sizeof(seunichar16), (in_len + 1) * sizeof(seunichar16));
+
+    new_str_iter = new_str;
+
+    for (i = 0; i < count; i++)
+    {
+        len = offsets[i];
+        offsets[i] = (int) (new_str_iter - new_str);
+
+        iter = (const unsigned char*)strs[i];
+        new_str_iter = se_unsafe_utf8_utf16_fill(iter, iter + len, new_str_iter);
+    }
+
+    SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
+
+    *new_str_iter = 0;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_UNSAFE_UTF8_TO_UTF16_BATCH, in_len, new_str_len * sizeof(seunichar16));
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static seunichar8* se_unsafe_utf16_utf8_fill(const seunichar16* iter, const seunichar16* end, seunichar8* new_str_iter)
+/*
+ * Convert the UTF-16 string from iter to end into new_str_iter, replacing
+ * ill-formed codes, and return the end of the output. The output needs
+ * at most 3 bytes per input unit.
+ */
+{
+    seunichar c;
 
-    iter = str;
-    end = iter + len;
     while (iter < end)
     {
         if (SE_IS_HI_SURROGATE(iter[0]))
         {
-            VALIDATE1(iter + 2 <= end);
-            VALIDATE1(SE_IS_LO_SURROGATE(iter[1]));
-            new_str_len += 4;
+            VALIDATE2(iter + 2 <= end);
+            VALIDATE2(SE_IS_LO_SURROGATE(iter[1]));
+            c = SE_SURROGATE_VALUE(iter[0], iter[1]);
+            new_str_iter += se_safe_unichar_to_utf8(c, new_str_iter);
             iter += 2;
         }
         else if (SE_IS_LO_SURROGATE(iter[0]))
         {
-ill_formed_1:
-            new_str_len += 3;
+ill_formed_2:
+            SE_STATS_REPLACED();
+            *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_1;
+            *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_2;
+            *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_3;
             iter++;
         }
         else
         {
-            new_str_len += se_safe_unichar_to_utf8(iter[0], 0);
+            new_str_iter += se_safe_unichar_to_utf8(iter[0], new_str_iter);
             iter++;
         }
     }
 
-    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar8));
-    new_str_iter = new_str;
+    return new_str_iter;
+}
+
+SE_API seunichar8* se_unsafe_utf16_to_safe_utf8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    seunichar8* new_str;
+    seunichar8* new_str_iter;
+    const seunichar16* iter;
+    const seunichar16* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf16_str_len_sz(str);
+
+    SE_STATS_ENTER();
+
+    new_str_len = 0;
 
     iter = str;
+    end = iter + len;
     while (iter < end)
     {
         if (SE_IS_HI_SURROGATE(iter[0]))
         {
-            VALIDATE2(iter + 2 <= end);
-            VALIDATE2(SE_IS_LO_SURROGATE(iter[1]));
-            c = SE_SURROGATE_VALUE(iter[0], iter[1]);
-            new_str_iter += se_safe_unichar_to_utf8(c, new_str_iter);
+            VALIDATE1(iter + 2 <= end);
+            VALIDATE1(SE_IS_LO_SURROGATE(iter[1]));
+            new_str_len += 4;
             iter += 2;
         }
         else if (SE_IS_LO_SURROGATE(iter[0]))
         {
-ill_formed_2:
-            *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_1;
-            *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_2;
-            *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_3;
+ill_formed_1:
+            new_str_len += 3;
             iter++;
         }
         else
         {
-            new_str_iter += se_safe_unichar_to_utf8(iter[0], new_str_iter);
+            new_str_len += se_safe_unichar_to_utf8(iter[0], 0);
             iter++;
         }
     }
 
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar8));
+    SE_STATS_ALLOC(SE_STATS_UNSAFE_UTF16_TO_UTF8, (new_str_len + 1) * sizeof(seunichar8));
+    SE_TRACE_ALLOC(SE_STATS_UNSAFE_UTF16_TO_UTF8, len * sizeof(seunichar16), (new_str_len + 1) * sizeof(seunichar8), (len * 3 + 1) * sizeof(seunichar8));
+
+    new_str_iter = se_unsafe_utf16_utf8_fill(str, end, new_str);
+
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf8_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_UNSAFE_UTF16_TO_UTF8, len * sizeof(seunichar16), new_str_len * sizeof(seunichar8));
 
     if (out_len)
         *out_len = new_str_len;
@@ -1524,31 +2936,120 @@ ill_formed_2:
     return new_str;
 }
 
-SE_API seunichar32* se_unsafe_utf8_to_safe_utf32(const seunichar8* str, int len, int* out_len)
+SE_API seunichar8* se_unsafe_utf16_to_safe_utf8(const seunichar16* str, int len, int* out_len)
 {
-    int new_str_len;
-    seunichar32* new_str;
-    seunichar32* new_str_iter;
-    const unsigned char* iter;
-    const unsigned char* end;
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf16_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_unsafe_utf16_to_safe_utf8_into(const seunichar16* str, ptrdiff_t len, seunichar8* buf)
+/*
+ * buf:
+ *      The output buffer, with room for at least 3 * len bytes.
+ *
+ * Convert as by se_unsafe_utf16_to_safe_utf8() into a buffer owned by the
+ * caller. The output is not NUL terminated.
+ *
+ * Return:
+ *      The length in bytes of the output.
+ */
+{
+    seunichar8* buf_end;
 
     SE_DEBUG_ASSERT(str);
+    SE_DEBUG_ASSERT(buf);
 
     if (len < 0)
-        len = se_utf8_str_len(str);
+        len = se_utf16_str_len_sz(str);
 
-    new_str_len = 0;
+    SE_STATS_ENTER();
 
-    iter = (const unsigned char*)str;
-    end = iter + len;
-    while (iter < end)
-    {
-        if (iter[0] <= 0x7F)
-        {
-            iter++;
-        }
-        else if (iter[0] >= 0xC2 && iter[0] <= 0xDF)
-        {
+    buf_end = se_unsafe_utf16_utf8_fill(str, str + len, buf);
+
+    SE_STATS_LEAVE(SE_STATS_UNSAFE_UTF16_TO_UTF8_INTO, len * sizeof(seunichar16), buf_end - buf);
+
+    return buf_end - buf;
+}
+
+#if SE_OPT_UTF8_DFA_CONVERT
+static ptrdiff_t se_unsafe_utf8_utf32_len(const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in characters of the UTF-8 string from iter to end,
+ * once ill-formed codes are replaced.
+ */
+{
+    static const unsigned char units[SE_UTF8_DFA_CLASS_COUNT] = { 1, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1 };
+
+    return se_utf8_dfa_len(iter, end, units, 1);
+}
+
+static seunichar32* se_unsafe_utf8_utf32_fill(const unsigned char* iter, const unsigned char* end, seunichar32* new_str_iter)
+/*
+ * Convert the UTF-8 string from iter to end into new_str_iter, which has
+ * room for se_unsafe_utf8_utf32_len() characters, and return the end of
+ * the output.
+ */
+{
+    const unsigned char* lead;
+    int i;
+    unsigned int prev;
+    unsigned int state;
+    seunichar32 c;
+
+    c = 0;
+    state = SE_UTF8_DFA_ACCEPT;
+    while (iter < end)
+    {
+        if (end - iter >= 8 && se_utf8_dfa_ascii_8(iter) && state == SE_UTF8_DFA_ACCEPT)
+        {
+            for (i = 0; i < 8; i++)
+                *new_str_iter++ = *iter++;
+            continue;
+        }
+        prev = state;
+        state = se_utf8_dfa_step(state, *iter++, &c);
+
+        /* Written ahead of the end of the sequence, kept if accepted */
+        *new_str_iter = c;
+        new_str_iter += SE_UTF8_DFA_ACCEPTED(state);
+        if (state == SE_UTF8_DFA_REJECT || (iter == end && state != SE_UTF8_DFA_ACCEPT))
+        {
+            SE_STATS_REPLACED();
+            lead = se_utf8_dfa_lead(iter - 1, prev, state);
+            *new_str_iter++ = SE_REPLACEMENT_CHAR;
+            iter = lead + 1;
+            state = SE_UTF8_DFA_ACCEPT;
+        }
+    }
+
+    return new_str_iter;
+}
+#else
+static ptrdiff_t se_unsafe_utf8_utf32_len(const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in characters of the UTF-8 string from iter to end,
+ * once ill-formed codes are replaced.
+ */
+{
+    ptrdiff_t new_str_len;
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            iter++;
+        }
+        else if (iter[0] >= 0xC2 && iter[0] <= 0xDF)
+        {
             VALIDATE1(iter + 2 <= end);
             VALIDATE1(iter[1] >= 0x80 && iter[1] <= 0xBF);
             iter += 2;
@@ -1613,10 +3114,16 @@ ill_formed_1:
         new_str_len++;
     }
 
-    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar32));
-    new_str_iter = new_str;
+    return new_str_len;
+}
 
-    iter = (const unsigned char*)str;
+static seunichar32* se_unsafe_utf8_utf32_fill(const unsigned char* iter, const unsigned char* end, seunichar32* new_str_iter)
+/*
+ * Convert the UTF-8 string from iter to end into new_str_iter, which has
+ * room for se_unsafe_utf8_utf32_len() characters, and return the end of
+ * the output.
+ */
+{
     while (iter < end)
     {
         if (iter[0] <= 0x7F)
@@ -1692,15 +3199,48 @@ ill_formed_1:
         else
         {
 ill_formed_2:
+            SE_STATS_REPLACED();
             *new_str_iter++ = SE_REPLACEMENT_CHAR;
             iter++;
         }
     }
 
+    return new_str_iter;
+}
+#endif
+
+SE_API seunichar32* se_unsafe_utf8_to_safe_utf32_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    seunichar32* new_str;
+    seunichar32* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    SE_STATS_ENTER();
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_unsafe_utf8_utf32_len(iter, end);
+
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar32));
+    SE_STATS_ALLOC(SE_STATS_UNSAFE_UTF8_TO_UTF32, (new_str_len + 1) * sizeof(seunichar32));
+    SE_TRACE_ALLOC(SE_STATS_UNSAFE_UTF8_TO_UTF32, len, (new_str_len + 1) * sizeof(seunichar32), (len + 1) * sizeof(seunichar32));
+
+    new_str_iter = se_unsafe_utf8_utf32_fill(iter, end, new_str);
+
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf32_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf32_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_UNSAFE_UTF8_TO_UTF32, len * sizeof(seunichar8), new_str_len * sizeof(seunichar32));
 
     if (out_len)
         *out_len = new_str_len;
@@ -1708,17 +3248,32 @@ ill_formed_2:
     return new_str;
 }
 
-SE_API seunichar8* se_unsafe_utf32_to_safe_utf8(const seunichar32* str, int len, int* out_len)
+SE_API seunichar32* se_unsafe_utf8_to_safe_utf32(const seunichar8* str, int len, int* out_len)
 {
-    int i;
-    int new_str_len;
+    seunichar32* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf8_to_safe_utf32_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar8* se_unsafe_utf32_to_safe_utf8_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t i;
+    ptrdiff_t new_str_len;
     seunichar8* new_str;
     seunichar8* new_str_iter;
 
     SE_DEBUG_ASSERT(str);
 
     if (len < 0)
-        len = se_utf32_str_len(str);
+        len = se_utf32_str_len_sz(str);
+
+    SE_STATS_ENTER();
 
     new_str_len = 0;
 
@@ -1731,6 +3286,9 @@ SE_API seunichar8* se_unsafe_utf32_to_safe_utf8(const seunichar32* str, int len,
     }
 
     new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar8));
+    SE_STATS_ALLOC(SE_STATS_UNSAFE_UTF32_TO_UTF8, (new_str_len + 1) * sizeof(seunichar8));
+    SE_TRACE_ALLOC(SE_STATS_UNSAFE_UTF32_TO_UTF8, len * sizeof(seunichar32), (new_str_len + 1) * sizeof(seunichar8), (len * 4 + 1) * sizeof(seunichar8));
+
     new_str_iter = new_str;
 
     for (i = 0; i < len; i++)
@@ -1741,6 +3299,7 @@ SE_API seunichar8* se_unsafe_utf32_to_safe_utf8(const seunichar32* str, int len,
         }
         else
         {
+            SE_STATS_REPLACED();
             *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_1;
             *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_2;
             *new_str_iter++ = SE_REPLACEMENT_CHAR_UTF8_3;
@@ -1750,7 +3309,9 @@ SE_API seunichar8* se_unsafe_utf32_to_safe_utf8(const seunichar32* str, int len,
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf8_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_UNSAFE_UTF32_TO_UTF8, len * sizeof(seunichar32), new_str_len * sizeof(seunichar8));
 
     if (out_len)
         *out_len = new_str_len;
@@ -1758,9 +3319,22 @@ SE_API seunichar8* se_unsafe_utf32_to_safe_utf8(const seunichar32* str, int len,
     return new_str;
 }
 
-SE_API seunichar32* se_unsafe_utf16_to_safe_utf32(const seunichar16* str, int len, int* out_len)
+SE_API seunichar8* se_unsafe_utf32_to_safe_utf8(const seunichar32* str, int len, int* out_len)
 {
-    int new_str_len;
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf32_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar32* se_unsafe_utf16_to_safe_utf32_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
     seunichar32* new_str;
     seunichar32* new_str_iter;
     const seunichar16* iter;
@@ -1769,7 +3343,9 @@ SE_API seunichar32* se_unsafe_utf16_to_safe_utf32(const seunichar16* str, int le
     SE_DEBUG_ASSERT(str);
 
     if (len < 0)
-        len = se_utf16_str_len(str);
+        len = se_utf16_str_len_sz(str);
+
+    SE_STATS_ENTER();
 
     new_str_len = 0;
 
@@ -1792,6 +3368,9 @@ ill_formed_1:
     }
 
     new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar32));
+    SE_STATS_ALLOC(SE_STATS_UNSAFE_UTF16_TO_UTF32, (new_str_len + 1) * sizeof(seunichar32));
+    SE_TRACE_ALLOC(SE_STATS_UNSAFE_UTF16_TO_UTF32, len * sizeof(seunichar16), (new_str_len + 1) * sizeof(seunichar32), (len + 1) * sizeof(seunichar32));
+
     new_str_iter = new_str;
 
     iter = str;
@@ -1807,6 +3386,7 @@ ill_formed_1:
         else if (SE_IS_LO_SURROGATE(iter[0]))
         {
 ill_formed_2:
+            SE_STATS_REPLACED();
             *new_str_iter++ = SE_REPLACEMENT_CHAR;
             iter++;
         }
@@ -1819,7 +3399,9 @@ ill_formed_2:
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf32_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf32_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_UNSAFE_UTF16_TO_UTF32, len * sizeof(seunichar16), new_str_len * sizeof(seunichar32));
 
     if (out_len)
         *out_len = new_str_len;
@@ -1827,17 +3409,32 @@ ill_formed_2:
     return new_str;
 }
 
-SE_API seunichar16* se_unsafe_utf32_to_safe_utf16(const seunichar32* str, int len, int* out_len)
+SE_API seunichar32* se_unsafe_utf16_to_safe_utf32(const seunichar16* str, int len, int* out_len)
 {
-    int i;
-    int new_str_len;
+    seunichar32* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf16_to_safe_utf32_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar16* se_unsafe_utf32_to_safe_utf16_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t i;
+    ptrdiff_t new_str_len;
     seunichar16* new_str;
     seunichar16* new_str_iter;
 
     SE_DEBUG_ASSERT(str);
 
     if (len < 0)
-        len = se_utf32_str_len(str);
+        len = se_utf32_str_len_sz(str);
+
+    SE_STATS_ENTER();
 
     new_str_len = 0;
 
@@ -1850,20 +3447,30 @@ SE_API seunichar16* se_unsafe_utf32_to_safe_utf16(const seunichar32* str, int le
     }
 
     new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar16));
+    SE_STATS_ALLOC(SE_STATS_UNSAFE_UTF32_TO_UTF16, (new_str_len + 1) * sizeof(seunichar16));
+    SE_TRACE_ALLOC(SE_STATS_UNSAFE_UTF32_TO_UTF16, len * sizeof(seunichar32), (new_str_len + 1) * sizeof(seunichar16), (len * 2 + 1) * sizeof(seunichar16));
+
     new_str_iter = new_str;
 
     for (i = 0; i < len; i++)
     {
         if (SE_IS_VALID_SCALAR_VALUE(str[i]))
+        {
             new_str_iter += se_safe_unichar_to_utf16(str[i], new_str_iter);
+        }
         else
+        {
+            SE_STATS_REPLACED();
             *new_str_iter++ = SE_REPLACEMENT_CHAR;
+        }
     }
 
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf16_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_UNSAFE_UTF32_TO_UTF16, len * sizeof(seunichar32), new_str_len * sizeof(seunichar16));
 
     if (out_len)
         *out_len = new_str_len;
@@ -1871,6 +3478,19 @@ SE_API seunichar16* se_unsafe_utf32_to_safe_utf16(const seunichar32* str, int le
     return new_str;
 }
 
+SE_API seunichar16* se_unsafe_utf32_to_safe_utf16(const seunichar32* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_utf32_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
 /***************************************************************************
  *                                                                         *
  * Safe Unicode string converting.                                         *
@@ -1880,19 +3500,21 @@ SE_API seunichar16* se_unsafe_utf32_to_safe_utf16(const seunichar32* str, int le
  *                                                                         *
  ***************************************************************************/
 
-SE_API seunichar16* se_safe_utf8_to_utf16(const seunichar8* str, int len, int* out_len)
+SE_API seunichar16* se_safe_utf8_to_utf16_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
 {
-    int new_str_len;
+    ptrdiff_t new_str_len;
     seunichar16* new_str;
     seunichar16* new_str_iter;
     const unsigned char* iter;
     const unsigned char* end;
     seunichar32 c;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(str, len));
 
     if (len < 0)
-        len = se_utf8_str_len(str);
+        len = se_utf8_str_len_sz(str);
+
+    SE_STATS_ENTER();
 
     new_str_len = 0;
 
@@ -1924,6 +3546,9 @@ SE_API seunichar16* se_safe_utf8_to_utf16(const seunichar8* str, int len, int* o
     }
 
     new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar16));
+    SE_STATS_ALLOC(SE_STATS_SAFE_UTF8_TO_UTF16, (new_str_len + 1) * sizeof(seunichar16));
+    SE_TRACE_ALLOC(SE_STATS_SAFE_UTF8_TO_UTF16, len, (new_str_len + 1) * sizeof(seunichar16), (len + 1) * sizeof(seunichar16));
+
     new_str_iter = new_str;
 
     iter = (const unsigned char*)str;
@@ -1955,7 +3580,9 @@ SE_API seunichar16* se_safe_utf8_to_utf16(const seunichar8* str, int len, int* o
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf16_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_SAFE_UTF8_TO_UTF16, len * sizeof(seunichar8), new_str_len * sizeof(seunichar16));
 
     if (out_len)
         *out_len = new_str_len;
@@ -1963,19 +3590,34 @@ SE_API seunichar16* se_safe_utf8_to_utf16(const seunichar8* str, int len, int* o
     return new_str;
 }
 
-SE_API seunichar8* se_safe_utf16_to_utf8(const seunichar16* str, int len, int* out_len)
+SE_API seunichar16* se_safe_utf8_to_utf16(const seunichar8* str, int len, int* out_len)
 {
-    int new_str_len;
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar8* se_safe_utf16_to_utf8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
     seunichar8* new_str;
     seunichar8* new_str_iter;
     const seunichar16* iter;
     const seunichar16* end;
     seunichar c;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf16_str(str, len));
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(str, len));
 
     if (len < 0)
-        len = se_utf16_str_len(str);
+        len = se_utf16_str_len_sz(str);
+
+    SE_STATS_ENTER();
 
     new_str_len = 0;
 
@@ -1997,6 +3639,9 @@ SE_API seunichar8* se_safe_utf16_to_utf8(const seunichar16* str, int len, int* o
     }
 
     new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar8));
+    SE_STATS_ALLOC(SE_STATS_SAFE_UTF16_TO_UTF8, (new_str_len + 1) * sizeof(seunichar8));
+    SE_TRACE_ALLOC(SE_STATS_SAFE_UTF16_TO_UTF8, len * sizeof(seunichar16), (new_str_len + 1) * sizeof(seunichar8), (len * 3 + 1) * sizeof(seunichar8));
+
     new_str_iter = new_str;
 
     iter = str;
@@ -2018,7 +3663,9 @@ SE_API seunichar8* se_safe_utf16_to_utf8(const seunichar16* str, int len, int* o
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf8_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_SAFE_UTF16_TO_UTF8, len * sizeof(seunichar16), new_str_len * sizeof(seunichar8));
 
     if (out_len)
         *out_len = new_str_len;
@@ -2026,7 +3673,20 @@ SE_API seunichar8* se_safe_utf16_to_utf8(const seunichar16* str, int len, int* o
     return new_str;
 }
 
-SE_API seunichar32* se_safe_utf8_to_utf32(const seunichar8* str, int len, int* out_len)
+SE_API seunichar8* se_safe_utf16_to_utf8(const seunichar16* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf16_to_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar32* se_safe_utf8_to_utf32_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
 /*
  * str:
  *      Input UTF-8 encoded string.
@@ -2047,16 +3707,18 @@ SE_API seunichar32* se_safe_utf8_to_utf32(const seunichar8* str, int len, int* o
  *      This string must be freed by caller.
  */
 {
-    int new_str_len;
+    ptrdiff_t new_str_len;
     seunichar32* new_str;
     seunichar32* new_str_iter;
     const unsigned char* iter;
     const unsigned char* end;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(str, len));
 
     if (len < 0)
-        len = se_utf8_str_len(str);
+        len = se_utf8_str_len_sz(str);
+
+    SE_STATS_ENTER();
 
     new_str_len = 0;
 
@@ -2076,6 +3738,9 @@ SE_API seunichar32* se_safe_utf8_to_utf32(const seunichar8* str, int len, int* o
     }
 
     new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar32));
+    SE_STATS_ALLOC(SE_STATS_SAFE_UTF8_TO_UTF32, (new_str_len + 1) * sizeof(seunichar32));
+    SE_TRACE_ALLOC(SE_STATS_SAFE_UTF8_TO_UTF32, len, (new_str_len + 1) * sizeof(seunichar32), (len + 1) * sizeof(seunichar32));
+
     new_str_iter = new_str;
 
     iter = (const unsigned char*)str;
@@ -2105,7 +3770,9 @@ SE_API seunichar32* se_safe_utf8_to_utf32(const seunichar8* str, int len, int* o
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf32_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf32_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_SAFE_UTF8_TO_UTF32, len * sizeof(seunichar8), new_str_len * sizeof(seunichar32));
 
     if (out_len)
         *out_len = new_str_len;
@@ -2113,23 +3780,40 @@ SE_API seunichar32* se_safe_utf8_to_utf32(const seunichar8* str, int len, int* o
     return new_str;
 }
 
-SE_API seunichar8* se_safe_utf32_to_utf8(const seunichar32* str, int len, int* out_len)
+SE_API seunichar32* se_safe_utf8_to_utf32(const seunichar8* str, int len, int* out_len)
 {
-    int i;
-    int new_str_len;
+    seunichar32* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_utf32_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar8* se_safe_utf32_to_utf8_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t i;
+    ptrdiff_t new_str_len;
     seunichar8* new_str;
     seunichar8* new_str_iter;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf32_str(str, len));
+    SE_DEBUG_ASSERT(se_is_valid_utf32_str_sz(str, len));
 
     if (len < 0)
-        len = se_utf32_str_len(str);
+        len = se_utf32_str_len_sz(str);
+
+    SE_STATS_ENTER();
 
     new_str_len = 0;
     for (i = 0; i < len; i++)
         new_str_len += se_safe_unichar_to_utf8(str[i], 0);
 
     new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar8));
+    SE_STATS_ALLOC(SE_STATS_SAFE_UTF32_TO_UTF8, (new_str_len + 1) * sizeof(seunichar8));
+    SE_TRACE_ALLOC(SE_STATS_SAFE_UTF32_TO_UTF8, len * sizeof(seunichar32), (new_str_len + 1) * sizeof(seunichar8), (len * 4 + 1) * sizeof(seunichar8));
 
     new_str_iter = new_str;
     for (i = 0; i < len; i++)
@@ -2138,7 +3822,9 @@ SE_API seunichar8* se_safe_utf32_to_utf8(const seunichar32* str, int len, int* o
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf8_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_SAFE_UTF32_TO_UTF8, len * sizeof(seunichar32), new_str_len * sizeof(seunichar8));
 
     if (out_len)
         *out_len = new_str_len;
@@ -2146,18 +3832,33 @@ SE_API seunichar8* se_safe_utf32_to_utf8(const seunichar32* str, int len, int* o
     return new_str;
 }
 
-SE_API seunichar32* se_safe_utf16_to_utf32(const seunichar16* str, int len, int* out_len)
+SE_API seunichar8* se_safe_utf32_to_utf8(const seunichar32* str, int len, int* out_len)
 {
-    int new_str_len;
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf32_to_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar32* se_safe_utf16_to_utf32_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
     seunichar32* new_str;
     seunichar32* new_str_iter;
     const seunichar16* iter;
     const seunichar16* end;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf16_str(str, len));
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(str, len));
 
     if (len < 0)
-        len = se_utf16_str_len(str);
+        len = se_utf16_str_len_sz(str);
+
+    SE_STATS_ENTER();
 
     new_str_len = 0;
 
@@ -2173,6 +3874,9 @@ SE_API seunichar32* se_safe_utf16_to_utf32(const seunichar16* str, int len, int*
     }
 
     new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar32));
+    SE_STATS_ALLOC(SE_STATS_SAFE_UTF16_TO_UTF32, (new_str_len + 1) * sizeof(seunichar32));
+    SE_TRACE_ALLOC(SE_STATS_SAFE_UTF16_TO_UTF32, len * sizeof(seunichar16), (new_str_len + 1) * sizeof(seunichar32), (len + 1) * sizeof(seunichar32));
+
     new_str_iter = new_str;
 
     iter = str;
@@ -2192,7 +3896,9 @@ SE_API seunichar32* se_safe_utf16_to_utf32(const seunichar16* str, int len, int*
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf32_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf32_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_SAFE_UTF16_TO_UTF32, len * sizeof(seunichar16), new_str_len * sizeof(seunichar32));
 
     if (out_len)
         *out_len = new_str_len;
@@ -2200,23 +3906,40 @@ SE_API seunichar32* se_safe_utf16_to_utf32(const seunichar16* str, int len, int*
     return new_str;
 }
 
-SE_API seunichar16* se_safe_utf32_to_utf16(const seunichar32* str, int len, int* out_len)
+SE_API seunichar32* se_safe_utf16_to_utf32(const seunichar16* str, int len, int* out_len)
 {
-    int i;
-    int new_str_len;
+    seunichar32* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf16_to_utf32_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar16* se_safe_utf32_to_utf16_sz(const seunichar32* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t i;
+    ptrdiff_t new_str_len;
     seunichar16* new_str;
     seunichar16* new_str_iter;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf32_str(str, len));
+    SE_DEBUG_ASSERT(se_is_valid_utf32_str_sz(str, len));
 
     if (len < 0)
-        len = se_utf32_str_len(str);
+        len = se_utf32_str_len_sz(str);
+
+    SE_STATS_ENTER();
 
     new_str_len = 0;
     for (i = 0; i < len; i++)
         new_str_len += se_safe_unichar_to_utf16(str[i], 0);
 
     new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar16));
+    SE_STATS_ALLOC(SE_STATS_SAFE_UTF32_TO_UTF16, (new_str_len + 1) * sizeof(seunichar16));
+    SE_TRACE_ALLOC(SE_STATS_SAFE_UTF32_TO_UTF16, len * sizeof(seunichar32), (new_str_len + 1) * sizeof(seunichar16), (len * 2 + 1) * sizeof(seunichar16));
 
     new_str_iter = new_str;
     for (i = 0; i < len; i++)
@@ -2225,7 +3948,9 @@ SE_API seunichar16* se_safe_utf32_to_utf16(const seunichar32* str, int len, int*
     SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
     *new_str_iter = 0;
 
-    SE_DEBUG_ASSERT(se_is_valid_utf16_str(new_str, new_str_len));
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_SAFE_UTF32_TO_UTF16, len * sizeof(seunichar32), new_str_len * sizeof(seunichar16));
 
     if (out_len)
         *out_len = new_str_len;
@@ -2233,231 +3958,3175 @@ SE_API seunichar16* se_safe_utf32_to_utf16(const seunichar32* str, int len, int*
     return new_str;
 }
 
-#undef VALIDATE2
-#undef VALIDATE1
-#undef VALIDATE
+SE_API seunichar16* se_safe_utf32_to_utf16(const seunichar32* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf32_to_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
 
 /***************************************************************************
  *                                                                         *
- * UTF-8 string manipulating.                                              *
+ * Error policies.                                                         *
+ *                                                                         *
+ * The _ex conversions take a policy for ill-formed input:                 *
+ *                                                                         *
+ *   SE_ERROR_REPLACE   One U+FFFD for each ill-formed code unit, as the   *
+ *                      plain conversions do.                              *
+ *   SE_ERROR_MAXIMAL   One U+FFFD for each maximal subpart of an          *
+ *                      ill-formed sequence, as the WHATWG Encoding        *
+ *                      Standard does.                                     *
+ *   SE_ERROR_SKIP      Ill-formed code units are dropped.                 *
+ *   SE_ERROR_STRICT    The conversion fails at the first ill-formed code  *
+ *                      unit.                                              *
+ *                                                                         *
+ * Well-formed input goes through the plain conversion, so the policy      *
+ * only costs a validation pass, and nothing at all for SE_ERROR_REPLACE.  *
+ *                                                                         *
+ * The SE_ERROR_* constants are in se-unicode-ext.h.                       *
  *                                                                         *
  ***************************************************************************/
 
-SE_API int se_utf8_strcmp_ignore_ascii_case(const char* s1, const char* s2)
+#define SE_ILL_FORMED                       ((seunichar32) -1)
+
+static ptrdiff_t se_policy_decode(const void* str, int width, ptrdiff_t i, ptrdiff_t len, seunichar32* c)
+/*
+ * Decode the character at unit i of str, a string of len units of width
+ * bytes, into c and return its length in units. For an ill-formed code, c
+ * is SE_ILL_FORMED and the length is that of its maximal subpart, the
+ * longest prefix of a well-formed sequence.
+ */
 {
-    const unsigned char* p1;
-    const unsigned char* p2;
-    int c1;
-    int c2;
+    const unsigned char* s8;
+    const seunichar16* s16;
+    seunichar32 u;
+    unsigned char lo;
+    unsigned char hi;
+    int n;
+    int k;
+
+    if (width == 1)
+    {
+        s8 = (const unsigned char*)str + i;
+        if (s8[0] <= 0x7F)
+        {
+            *c = s8[0];
+            return 1;
+        }
 
-    SE_DEBUG_ASSERT(s1);
-    SE_DEBUG_ASSERT(s2);
+        if (s8[0] >= 0xC2 && s8[0] <= 0xDF)
+            n = 2;
+        else if (s8[0] >= 0xE0 && s8[0] <= 0xEF)
+            n = 3;
+        else if (s8[0] >= 0xF0 && s8[0] <= 0xF4)
+            n = 4;
+        else
+        {
+            *c = SE_ILL_FORMED;
+            return 1;
+        }
 
-    if (s1 == s2)
-        return 0;
+        /* Only the second byte has a narrower range, see the table at the top */
+        lo = s8[0] == 0xE0 ? 0xA0 : s8[0] == 0xF0 ? 0x90 : 0x80;
+        hi = s8[0] == 0xED ? 0x9F : s8[0] == 0xF4 ? 0x8F : 0xBF;
+        u = s8[0] & (0x7F >> n);
+        for (k = 1; k < n; k++)
+        {
+            if (i + k >= len || s8[k] < lo || s8[k] > hi)
+            {
+                *c = SE_ILL_FORMED;
+                return k;
+            }
+            u = (u << 6) | (s8[k] & 0x3F);
+            lo = 0x80;
+            hi = 0xBF;
+        }
+        *c = u;
+        return n;
+    }
+    else if (width == 2)
+    {
+        s16 = (const seunichar16*)str + i;
+        if (SE_IS_HI_SURROGATE(s16[0]) && i + 1 < len && SE_IS_LO_SURROGATE(s16[1]))
+        {
+            *c = SE_SURROGATE_VALUE(s16[0], s16[1]);
+            return 2;
+        }
+        *c = SE_IS_SURROGATE(s16[0]) ? SE_ILL_FORMED : s16[0];
+        return 1;
+    }
+    else
+    {
+        u = ((const seunichar32*)str)[i];
+        *c = SE_IS_VALID_SCALAR_VALUE(u) ? u : SE_ILL_FORMED;
+        return 1;
+    }
+}
 
-    p1 = (const unsigned char*)s1;
-    p2 = (const unsigned char*)s2;
+static int se_policy_encode(seunichar32 c, int width, void* buf, ptrdiff_t out)
+/*
+ * Write c at unit out of buf, a string of width-byte units, and return
+ * the units it takes. buf can be NULL to only count them.
+ */
+{
+    if (width == 1)
+        return se_safe_unichar_to_utf8(c, buf ? (seunichar8*)buf + out : 0);
 
-    while ( (*p1) && (*p2) )
+    if (width == 2)
+        return se_safe_unichar_to_utf16(c, buf ? (seunichar16*)buf + out : 0);
+
+    if (buf)
+        ((seunichar32*)buf)[out] = c;
+
+    return 1;
+}
+
+static ptrdiff_t se_policy_error_offset(const void* str, int width, ptrdiff_t len, int policy, ptrdiff_t* error_offset)
+/*
+ * Return the offset in units of the first ill-formed code of str, or -1
+ * if there is none, and store it in error_offset if given. The scan is
+ * skipped when neither the policy nor the caller needs it.
+ */
+{
+    ptrdiff_t offset;
+    ptrdiff_t i;
+    ptrdiff_t n;
+    seunichar32 c;
+
+    offset = -1;
+
+    if (policy != SE_ERROR_REPLACE || error_offset)
     {
-        if ( (*p1 >= 'A') && (*p1 <= 'Z') )
-            c1 = *p1 - 'A' + 'a';
-        else
-            c1 = *p1;
+        i = 0;
+        while (i < len)
+        {
+            #if SE_OPT_SSE2
+                if (width == 1 && len - i >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)((const unsigned char*)str + i))))
+                {
+                    i += 16;
+                    continue;
+                }
+            #endif
+            n = se_policy_decode(str, width, i, len, &c);
+            if (c == SE_ILL_FORMED)
+            {
+                offset = i;
+                break;
+            }
+            i += n;
+        }
+    }
 
-        if ( (*p2 >= 'A') && (*p2 <= 'Z') )
-            c2 = *p2 - 'A' + 'a';
-        else
-            c2 = *p2;
+    if (error_offset)
+        *error_offset = offset;
 
-        if (c1 != c2)
-            return c1 - c2;
+    return offset;
+}
 
-        p1++;
-        p2++;
+static ptrdiff_t se_policy_convert(const void* str, int width, ptrdiff_t len, int policy, void* buf, int buf_width)
+/*
+ * Convert str, a string of len units of width bytes, into buf, a string
+ * of buf_width-byte units, handling ill-formed codes by policy, and
+ * return the length in units of the output. buf can be NULL to only
+ * count them.
+ */
+{
+    ptrdiff_t new_str_len;
+    ptrdiff_t i;
+    ptrdiff_t n;
+    seunichar32 c;
+    #if SE_OPT_SSE2
+        int k;
+    #endif
+
+    SE_DEBUG_ASSERT(policy != SE_ERROR_STRICT);
+
+    new_str_len = 0;
+
+    i = 0;
+    while (i < len)
+    {
+        #if SE_OPT_SSE2
+            if (width == 1 && len - i >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)((const unsigned char*)str + i))))
+            {
+                if (buf)
+                {
+                    for (k = 0; k < 16; k++)
+                        se_policy_encode(((const unsigned char*)str)[i + k], buf_width, buf, new_str_len + k);
+                }
+                new_str_len += 16;
+                i += 16;
+                continue;
+            }
+        #endif
+        n = se_policy_decode(str, width, i, len, &c);
+        if (c == SE_ILL_FORMED)
+        {
+            if (policy == SE_ERROR_SKIP)
+            {
+                i += n;
+                continue;
+            }
+            if (policy == SE_ERROR_REPLACE)
+                n = 1;
+            c = SE_REPLACEMENT_CHAR;
+        }
+        new_str_len += se_policy_encode(c, buf_width, buf, new_str_len);
+        i += n;
     }
 
-    c1 = *p1;
-    c2 = *p2;
-    return c1 - c2;
+    return new_str_len;
 }
 
-SE_API int se_utf8_strcmp_n_ignore_ascii_case(const char* s1, const char* s2, int n)
+static void* se_policy_convert_str(const void* str, int width, ptrdiff_t len, int policy, int new_str_width, ptrdiff_t* out_len)
+/*
+ * Return a new NUL terminated string of new_str_width-byte units
+ * converted from str by se_policy_convert().
+ */
 {
-    const unsigned char* p1;
-    const unsigned char* p2;
-    int c1;
-    int c2;
+    ptrdiff_t new_str_len;
+    unsigned char* new_str;
+    unsigned char* new_str_iter;
 
-    if (s1 == s2)
-        return 0;
+    new_str_len = se_policy_convert(str, width, len, policy, 0, new_str_width);
 
-    SE_DEBUG_ASSERT(s1);
-    SE_DEBUG_ASSERT(s2);
+    new_str = SE_MALLOC((new_str_len + 1) * new_str_width);
 
-    p1 = (const unsigned char*)s1;
-    p2 = (const unsigned char*)s2;
+    new_str_iter = new_str + se_policy_convert(str, width, len, policy, new_str, new_str_width) * new_str_width;
 
-    while ( (n > 0) && (*p1) && (*p2) )
-    {
-        if ( (*p1 >= 'A') && (*p1 <= 'Z') )
-            c1 = *p1 - 'A' + 'a';
-        else
-            c1 = *p1;
+    SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len * new_str_width);
+    memset(new_str_iter, 0, new_str_width);
 
-        if ( (*p2 >= 'A') && (*p2 <= 'Z') )
-            c2 = *p2 - 'A' + 'a';
-        else
-            c2 = *p2;
+    if (out_len)
+        *out_len = new_str_len;
 
-        if (c1 != c2)
-            return c1 - c2;
+    return new_str;
+}
 
-        p1++;
-        p2++;
-        n--;
-    }
+SE_API seunichar8* se_unsafe_utf8_str_safe_copy_ex_sz(const seunichar8* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset)
+/*
+ * policy:
+ *      How ill-formed codes are handled, one of SE_ERROR_REPLACE,
+ *      SE_ERROR_MAXIMAL, SE_ERROR_SKIP and SE_ERROR_STRICT.
+ *
+ * error_offset:
+ *      Returns the offset in code units of the first ill-formed code, or
+ *      -1 if the string is well-formed. Can be NULL.
+ *
+ * Copy as by se_unsafe_utf8_str_safe_copy(), handling ill-formed codes by
+ * policy. An ill-formed string is rejected by SE_ERROR_STRICT before
+ * anything is allocated or converted.
+ *
+ * Return:
+ *      The new string, or NULL if policy is SE_ERROR_STRICT and the string
+ *      is ill-formed.
+ */
+{
+    SE_DEBUG_ASSERT(str);
 
-    if (n > 0)
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    if (se_policy_error_offset(str, 1, len, policy, error_offset) < 0 || policy == SE_ERROR_REPLACE)
+        return se_unsafe_utf8_str_safe_copy_sz(str, len, out_len);
+
+    if (policy == SE_ERROR_STRICT)
     {
-        c1 = *p1;
-        c2 = *p2;
-        return c1 - c2;
+        if (out_len)
+            *out_len = 0;
+        return 0;
     }
-    else
+
+    return se_policy_convert_str(str, 1, len, policy, sizeof(seunichar8), out_len);
+}
+
+SE_API seunichar8* se_unsafe_utf8_str_safe_copy_ex(const seunichar8* str, int len, int policy, int* out_len, int* error_offset)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+    ptrdiff_t offset;
+
+    new_str = se_unsafe_utf8_str_safe_copy_ex_sz(str, len, policy, &new_str_len, &offset);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    if (error_offset)
+        *error_offset = (int) offset;
+
+    return new_str;
+}
+
+SE_API seunichar16* se_unsafe_utf16_str_safe_copy_ex_sz(const seunichar16* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset)
+/*
+ * Copy as by se_unsafe_utf16_str_safe_copy(), handling ill-formed codes by
+ * policy, see se_unsafe_utf8_str_safe_copy_ex_sz().
+ */
+{
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf16_str_len_sz(str);
+
+    if (se_policy_error_offset(str, 2, len, policy, error_offset) < 0 || policy == SE_ERROR_REPLACE)
+        return se_unsafe_utf16_str_safe_copy_sz(str, len, out_len);
+
+    if (policy == SE_ERROR_STRICT)
     {
+        if (out_len)
+            *out_len = 0;
         return 0;
     }
+
+    return se_policy_convert_str(str, 2, len, policy, sizeof(seunichar16), out_len);
 }
 
-SE_API int se_utf8_strcmp_ignore_space_and_ascii_case(const char* s1, const char* s2)
+SE_API seunichar16* se_unsafe_utf16_str_safe_copy_ex(const seunichar16* str, int len, int policy, int* out_len, int* error_offset)
 {
-    const unsigned char* p1;
-    const unsigned char* p2;
-    int c1;
-    int c2;
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+    ptrdiff_t offset;
 
-    SE_DEBUG_ASSERT(s1);
-    SE_DEBUG_ASSERT(s2);
+    new_str = se_unsafe_utf16_str_safe_copy_ex_sz(str, len, policy, &new_str_len, &offset);
 
-    if (s1 == s2)
-        return 0;
+    if (out_len)
+        *out_len = (int) new_str_len;
 
-    p1 = (const unsigned char*)s1;
-    p2 = (const unsigned char*)s2;
+    if (error_offset)
+        *error_offset = (int) offset;
 
-    while ( (*p1) && (*p2) )
-    {
-        while (*p1 == ' ')
-            p1++;
-        if ( (*p1 >= 'A') && (*p1 <= 'Z') )
-            c1 = *p1 - 'A' + 'a';
-        else
-            c1 = *p1;
+    return new_str;
+}
 
-        while (*p2 == ' ')
-            p2++;
-        if ( (*p2 >= 'A') && (*p2 <= 'Z') )
-            c2 = *p2 - 'A' + 'a';
-        else
-            c2 = *p2;
+SE_API seunichar32* se_unsafe_utf32_str_safe_copy_ex_sz(const seunichar32* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset)
+/*
+ * Copy as by se_unsafe_utf32_str_safe_copy(), handling ill-formed codes by
+ * policy, see se_unsafe_utf8_str_safe_copy_ex_sz().
+ */
+{
+    SE_DEBUG_ASSERT(str);
 
-        if (c1 != c2)
-            return c1 - c2;
+    if (len < 0)
+        len = se_utf32_str_len_sz(str);
 
-        p1++;
-        p2++;
+    if (se_policy_error_offset(str, 4, len, policy, error_offset) < 0 || policy == SE_ERROR_REPLACE)
+        return se_unsafe_utf32_str_safe_copy_sz(str, len, out_len);
+
+    if (policy == SE_ERROR_STRICT)
+    {
+        if (out_len)
+            *out_len = 0;
+        return 0;
     }
 
-    c1 = *p1;
-    c2 = *p2;
-    return c1 - c2;
+    return se_policy_convert_str(str, 4, len, policy, sizeof(seunichar32), out_len);
 }
 
-SE_API const char* se_utf8_strstr_ignore_space_and_ascii_case(const char* s1, const char* s2)
+SE_API seunichar32* se_unsafe_utf32_str_safe_copy_ex(const seunichar32* str, int len, int policy, int* out_len, int* error_offset)
 {
-    SE_DEBUG_ASSERT(s1);
-    SE_DEBUG_ASSERT(s2);
+    seunichar32* new_str;
+    ptrdiff_t new_str_len;
+    ptrdiff_t offset;
 
-    if (s1 == s2)
-        return s1;
+    new_str = se_unsafe_utf32_str_safe_copy_ex_sz(str, len, policy, &new_str_len, &offset);
 
-    while (*s1)
-    {
-        int c1;
-        int c2;
-        const unsigned char* p1;
-        const unsigned char* p2;
+    if (out_len)
+        *out_len = (int) new_str_len;
 
-        p1 = (const unsigned char*)s1;
-        p2 = (const unsigned char*)s2;
+    if (error_offset)
+        *error_offset = (int) offset;
 
-        for (;;)
-        {
-            while (*p1 == ' ')
-                p1++;
-            if ( (*p1 >= 'A') && (*p1 <= 'Z') )
-                c1 = *p1 - 'A' + 'a';
-            else
-                c1 = *p1;
+    return new_str;
+}
 
-            while (*p2 == ' ')
-                p2++;
-            if ( (*p2 >= 'A') && (*p2 <= 'Z') )
-                c2 = *p2 - 'A' + 'a';
-            else
-                c2 = *p2;
+SE_API seunichar16* se_unsafe_utf8_to_safe_utf16_ex_sz(const seunichar8* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset)
+/*
+ * Convert as by se_unsafe_utf8_to_safe_utf16(), handling ill-formed codes
+ * by policy, see se_unsafe_utf8_str_safe_copy_ex_sz().
+ */
+{
+    SE_DEBUG_ASSERT(str);
 
-            if (c1 == 0 || c2 == 0)
-                break;
-            if (c1 != c2)
-                break;
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
 
-            p1++;
-            p2++;
-        }
-        if (c1 == c2)
-            return s1;
+    if (se_policy_error_offset(str, 1, len, policy, error_offset) < 0 || policy == SE_ERROR_REPLACE)
+        return se_unsafe_utf8_to_safe_utf16_sz(str, len, out_len);
 
-        s1++;
+    if (policy == SE_ERROR_STRICT)
+    {
+        if (out_len)
+            *out_len = 0;
+        return 0;
     }
 
-    return 0;
+    return se_policy_convert_str(str, 1, len, policy, sizeof(seunichar16), out_len);
 }
 
-SE_API unsigned int se_utf8_str_hash(const seunichar8* str)
+SE_API seunichar16* se_unsafe_utf8_to_safe_utf16_ex(const seunichar8* str, int len, int policy, int* out_len, int* error_offset)
 {
-    const unsigned char* p;
-    unsigned int h;
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+    ptrdiff_t offset;
 
-    SE_DEBUG_ASSERT(str);
+    new_str = se_unsafe_utf8_to_safe_utf16_ex_sz(str, len, policy, &new_str_len, &offset);
 
-    p = (const unsigned char*)str;
+    if (out_len)
+        *out_len = (int) new_str_len;
 
-    h = *p;
-    p++;
+    if (error_offset)
+        *error_offset = (int) offset;
 
-    if (h)
+    return new_str;
+}
+
+SE_API seunichar8* se_unsafe_utf16_to_safe_utf8_ex_sz(const seunichar16* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset)
+/*
+ * Convert as by se_unsafe_utf16_to_safe_utf8(), handling ill-formed codes
+ * by policy, see se_unsafe_utf8_str_safe_copy_ex_sz().
+ */
+{
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf16_str_len_sz(str);
+
+    if (se_policy_error_offset(str, 2, len, policy, error_offset) < 0 || policy == SE_ERROR_REPLACE)
+        return se_unsafe_utf16_to_safe_utf8_sz(str, len, out_len);
+
+    if (policy == SE_ERROR_STRICT)
+    {
+        if (out_len)
+            *out_len = 0;
+        return 0;
+    }
+
+    return se_policy_convert_str(str, 2, len, policy, sizeof(seunichar8), out_len);
+}
+
+SE_API seunichar8* se_unsafe_utf16_to_safe_utf8_ex(const seunichar16* str, int len, int policy, int* out_len, int* error_offset)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+    ptrdiff_t offset;
+
+    new_str = se_unsafe_utf16_to_safe_utf8_ex_sz(str, len, policy, &new_str_len, &offset);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    if (error_offset)
+        *error_offset = (int) offset;
+
+    return new_str;
+}
+
+SE_API seunichar32* se_unsafe_utf8_to_safe_utf32_ex_sz(const seunichar8* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset)
+/*
+ * Convert as by se_unsafe_utf8_to_safe_utf32(), handling ill-formed codes
+ * by policy, see se_unsafe_utf8_str_safe_copy_ex_sz().
+ */
+{
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    if (se_policy_error_offset(str, 1, len, policy, error_offset) < 0 || policy == SE_ERROR_REPLACE)
+        return se_unsafe_utf8_to_safe_utf32_sz(str, len, out_len);
+
+    if (policy == SE_ERROR_STRICT)
+    {
+        if (out_len)
+            *out_len = 0;
+        return 0;
+    }
+
+    return se_policy_convert_str(str, 1, len, policy, sizeof(seunichar32), out_len);
+}
+
+SE_API seunichar32* se_unsafe_utf8_to_safe_utf32_ex(const seunichar8* str, int len, int policy, int* out_len, int* error_offset)
+{
+    seunichar32* new_str;
+    ptrdiff_t new_str_len;
+    ptrdiff_t offset;
+
+    new_str = se_unsafe_utf8_to_safe_utf32_ex_sz(str, len, policy, &new_str_len, &offset);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    if (error_offset)
+        *error_offset = (int) offset;
+
+    return new_str;
+}
+
+SE_API seunichar8* se_unsafe_utf32_to_safe_utf8_ex_sz(const seunichar32* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset)
+/*
+ * Convert as by se_unsafe_utf32_to_safe_utf8(), handling ill-formed codes
+ * by policy, see se_unsafe_utf8_str_safe_copy_ex_sz().
+ */
+{
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf32_str_len_sz(str);
+
+    if (se_policy_error_offset(str, 4, len, policy, error_offset) < 0 || policy == SE_ERROR_REPLACE)
+        return se_unsafe_utf32_to_safe_utf8_sz(str, len, out_len);
+
+    if (policy == SE_ERROR_STRICT)
+    {
+        if (out_len)
+            *out_len = 0;
+        return 0;
+    }
+
+    return se_policy_convert_str(str, 4, len, policy, sizeof(seunichar8), out_len);
+}
+
+SE_API seunichar8* se_unsafe_utf32_to_safe_utf8_ex(const seunichar32* str, int len, int policy, int* out_len, int* error_offset)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+    ptrdiff_t offset;
+
+    new_str = se_unsafe_utf32_to_safe_utf8_ex_sz(str, len, policy, &new_str_len, &offset);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    if (error_offset)
+        *error_offset = (int) offset;
+
+    return new_str;
+}
+
+SE_API seunichar32* se_unsafe_utf16_to_safe_utf32_ex_sz(const seunichar16* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset)
+/*
+ * Convert as by se_unsafe_utf16_to_safe_utf32(), handling ill-formed codes
+ * by policy, see se_unsafe_utf8_str_safe_copy_ex_sz().
+ */
+{
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf16_str_len_sz(str);
+
+    if (se_policy_error_offset(str, 2, len, policy, error_offset) < 0 || policy == SE_ERROR_REPLACE)
+        return se_unsafe_utf16_to_safe_utf32_sz(str, len, out_len);
+
+    if (policy == SE_ERROR_STRICT)
+    {
+        if (out_len)
+            *out_len = 0;
+        return 0;
+    }
+
+    return se_policy_convert_str(str, 2, len, policy, sizeof(seunichar32), out_len);
+}
+
+SE_API seunichar32* se_unsafe_utf16_to_safe_utf32_ex(const seunichar16* str, int len, int policy, int* out_len, int* error_offset)
+{
+    seunichar32* new_str;
+    ptrdiff_t new_str_len;
+    ptrdiff_t offset;
+
+    new_str = se_unsafe_utf16_to_safe_utf32_ex_sz(str, len, policy, &new_str_len, &offset);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    if (error_offset)
+        *error_offset = (int) offset;
+
+    return new_str;
+}
+
+SE_API seunichar16* se_unsafe_utf32_to_safe_utf16_ex_sz(const seunichar32* str, ptrdiff_t len, int policy, ptrdiff_t* out_len, ptrdiff_t* error_offset)
+/*
+ * Convert as by se_unsafe_utf32_to_safe_utf16(), handling ill-formed codes
+ * by policy, see se_unsafe_utf8_str_safe_copy_ex_sz().
+ */
+{
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf32_str_len_sz(str);
+
+    if (se_policy_error_offset(str, 4, len, policy, error_offset) < 0 || policy == SE_ERROR_REPLACE)
+        return se_unsafe_utf32_to_safe_utf16_sz(str, len, out_len);
+
+    if (policy == SE_ERROR_STRICT)
+    {
+        if (out_len)
+            *out_len = 0;
+        return 0;
+    }
+
+    return se_policy_convert_str(str, 4, len, policy, sizeof(seunichar16), out_len);
+}
+
+SE_API seunichar16* se_unsafe_utf32_to_safe_utf16_ex(const seunichar32* str, int len, int policy, int* out_len, int* error_offset)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+    ptrdiff_t offset;
+
+    new_str = se_unsafe_utf32_to_safe_utf16_ex_sz(str, len, policy, &new_str_len, &offset);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    if (error_offset)
+        *error_offset = (int) offset;
+
+    return new_str;
+}
+
+#undef SE_ILL_FORMED
+
+#undef VALIDATE2
+#undef VALIDATE1
+#undef VALIDATE
+
+/***************************************************************************
+ *                                                                         *
+ * Latin-1 and ASCII strings.                                              *
+ *                                                                         *
+ * A Latin-1 (ISO-8859-1) string is a byte string where each byte is the   *
+ * code point of a character from U+0000 to U+00FF, so any byte string is  *
+ * a valid Latin-1 string. Characters above U+00FF have no Latin-1 form    *
+ * and are replaced by '?'.                                                *
+ *                                                                         *
+ ***************************************************************************/
+
+static sebool se_utf16_units_fit(const seunichar16* iter, const seunichar16* end, seunichar16 mask)
+/*
+ * Return whether no unit of the UTF-16 string from iter to end has any of
+ * the bits of mask set.
+ */
+{
+    #if SE_OPT_SSE2
+    {
+        __m128i high_bits;
+
+        high_bits = _mm_set1_epi16((short) mask);
+        while (end - iter >= 8)
+        {
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i*)iter), high_bits), _mm_setzero_si128())) != 0xFFFF)
+                return FALSE;
+            iter += 8;
+        }
+    }
+    #endif
+
+    while (iter < end)
+    {
+        if (*iter & mask)
+            return FALSE;
+        iter++;
+    }
+
+    return TRUE;
+}
+
+static ptrdiff_t se_latin1_utf8_len(const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in bytes of the Latin-1 string from iter to end once
+ * converted to UTF-8: one byte per character, and one more for each
+ * character above U+007F.
+ */
+{
+    ptrdiff_t new_str_len;
+
+    new_str_len = end - iter;
+
+    #if SE_OPT_SSE2
+        while (end - iter >= 16)
+        {
+            new_str_len += se_bit_count(_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)iter)));
+            iter += 16;
+        }
+    #endif
+
+    while (iter < end)
+        new_str_len += *iter++ >> 7;
+
+    return new_str_len;
+}
+
+static unsigned char* se_latin1_utf8_fill(const unsigned char* iter, const unsigned char* end, unsigned char* new_str_iter)
+/*
+ * Convert the Latin-1 string from iter to end into new_str_iter, which has
+ * room for se_latin1_utf8_len() bytes and one more, and return the end of
+ * the output. ASCII is copied 16 bytes at a time.
+ */
+{
+    #if SE_OPT_SSE2
+    {
+        __m128i block;
+        unsigned int c;
+        int i;
+
+        while (end - iter >= 16)
+        {
+            block = _mm_loadu_si128((const __m128i*)iter);
+            if (!_mm_movemask_epi8(block))
+            {
+                _mm_storeu_si128((__m128i*)new_str_iter, block);
+                new_str_iter += 16;
+                iter += 16;
+                continue;
+            }
+
+            /*
+             * Both bytes are always written, and the second one is only
+             * kept for characters above U+007F, so there are no branches
+             * to mispredict on mixed text. The extra byte is what the
+             * room for one more byte is for.
+             */
+            for (i = 0; i < 16; i++)
+            {
+                c = iter[i];
+                new_str_iter[0] = (unsigned char) ( c <= 0x7F ? c : 0xC0 | (c >> 6) );
+                new_str_iter[1] = (unsigned char) ( 0x80 | (c & 0x3F) );
+                new_str_iter += 1 + (c >> 7);
+            }
+            iter += 16;
+        }
+    }
+    #endif
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            *new_str_iter++ = *iter++;
+        }
+        else
+        {
+            *new_str_iter++ = (unsigned char) ( 0xC0 | (iter[0] >> 6) );
+            *new_str_iter++ = (unsigned char) ( 0x80 | (iter[0] & 0x3F) );
+            iter++;
+        }
+    }
+
+    return new_str_iter;
+}
+
+static seunichar16* se_latin1_utf16_fill(const unsigned char* iter, const unsigned char* end, seunichar16* new_str_iter)
+/*
+ * Convert the Latin-1 string from iter to end into new_str_iter, which has
+ * room for one unit per byte, and return the end of the output.
+ */
+{
+    #if SE_OPT_SSE2
+    {
+        __m128i block;
+
+        while (end - iter >= 16)
+        {
+            block = _mm_loadu_si128((const __m128i*)iter);
+            _mm_storeu_si128((__m128i*)new_str_iter, _mm_unpacklo_epi8(block, _mm_setzero_si128()));
+            _mm_storeu_si128((__m128i*)(new_str_iter + 8), _mm_unpackhi_epi8(block, _mm_setzero_si128()));
+            new_str_iter += 16;
+            iter += 16;
+        }
+    }
+    #endif
+
+    while (iter < end)
+        *new_str_iter++ = *iter++;
+
+    return new_str_iter;
+}
+
+static unsigned char* se_safe_utf8_latin1_fill(const unsigned char* iter, const unsigned char* end, unsigned char* new_str_iter)
+/*
+ * Convert the well-formed UTF-8 string from iter to end into new_str_iter,
+ * which has room for one byte per character, and return the end of the
+ * output. Runs of 16 ASCII bytes are copied at once.
+ */
+{
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16)
+                {
+                    __m128i block;
+
+                    block = _mm_loadu_si128((const __m128i*)iter);
+                    if (!_mm_movemask_epi8(block))
+                    {
+                        _mm_storeu_si128((__m128i*)new_str_iter, block);
+                        new_str_iter += 16;
+                        iter += 16;
+                        continue;
+                    }
+                }
+            #endif
+            *new_str_iter++ = *iter++;
+        }
+        else if (iter[0] <= 0xC3)
+        {
+            SE_DEBUG_ASSERT(iter[0] >= 0xC2);
+            *new_str_iter++ = (unsigned char) ( ((iter[0] & 0x1F) << 6) | (iter[1] & 0x3F) );
+            iter += 2;
+        }
+        else
+        {
+            SE_STATS_REPLACED();
+            *new_str_iter++ = SE_LATIN1_REPLACEMENT_CHAR;
+            if (iter[0] <= 0xDF)
+                iter += 2;
+            else if (iter[0] <= 0xEF)
+                iter += 3;
+            else
+                iter += 4;
+        }
+    }
+
+    return new_str_iter;
+}
+
+static ptrdiff_t se_safe_utf16_latin1_len(const seunichar16* iter, const seunichar16* end)
+/*
+ * Return the length in bytes of the well-formed UTF-16 string from iter to
+ * end once converted to Latin-1, which is its length in characters.
+ */
+{
+    #if SE_OPT_SURROGATE
+
+        ptrdiff_t new_str_len;
+
+        new_str_len = end - iter;
+
+        #if SE_OPT_SSE2
+        {
+            __m128i surrogate_mask;
+            __m128i lo_surrogate_bits;
+            __m128i block;
+
+            /* Each unit sets two bits of the mask */
+            surrogate_mask = _mm_set1_epi16((short) 0xFC00);
+            lo_surrogate_bits = _mm_set1_epi16((short) 0xDC00);
+            while (end - iter >= 8)
+            {
+                block = _mm_loadu_si128((const __m128i*)iter);
+                new_str_len -= se_bit_count(_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(block, surrogate_mask), lo_surrogate_bits))) / 2;
+                iter += 8;
+            }
+        }
+        #endif
+
+        while (iter < end)
+        {
+            if (SE_IS_LO_SURROGATE(*iter))
+                new_str_len--;
+            iter++;
+        }
+
+        return new_str_len;
+
+    #else
+
+        return end - iter;
+
+    #endif
+}
+
+static unsigned char* se_safe_utf16_latin1_fill(const seunichar16* iter, const seunichar16* end, unsigned char* new_str_iter)
+/*
+ * Convert the well-formed UTF-16 string from iter to end into
+ * new_str_iter, which has room for se_safe_utf16_latin1_len() bytes, and
+ * return the end of the output. Runs of 16 units up to U+00FF are
+ * narrowed at once.
+ */
+{
+    while (iter < end)
+    {
+        if (iter[0] <= 0xFF)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16)
+                {
+                    __m128i low;
+                    __m128i high;
+
+                    low = _mm_loadu_si128((const __m128i*)iter);
+                    high = _mm_loadu_si128((const __m128i*)(iter + 8));
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(low, high), _mm_set1_epi16((short) 0xFF00)), _mm_setzero_si128())) == 0xFFFF)
+                    {
+                        _mm_storeu_si128((__m128i*)new_str_iter, _mm_packus_epi16(low, high));
+                        new_str_iter += 16;
+                        iter += 16;
+                        continue;
+                    }
+                }
+            #endif
+            *new_str_iter++ = (unsigned char) *iter++;
+        }
+        else
+        {
+            SE_STATS_REPLACED();
+            *new_str_iter++ = SE_LATIN1_REPLACEMENT_CHAR;
+            #if SE_OPT_SURROGATE
+                if (SE_IS_HI_SURROGATE(iter[0]))
+                    iter++;
+            #endif
+            iter++;
+        }
+    }
+
+    return new_str_iter;
+}
+
+SE_API sebool se_is_ascii_str_sz(const seunichar8* str, ptrdiff_t len)
+/*
+ * Return whether every byte of str is below 0x80. An ASCII string is the
+ * same string in UTF-8 and in Latin-1, and can be used as either as is.
+ */
+{
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    SE_STATS_COUNT(SE_STATS_IS_ASCII, len * sizeof(seunichar8));
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    #if SE_OPT_SSE2
+        while (end - iter >= 16)
+        {
+            if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)iter)))
+                return FALSE;
+            iter += 16;
+        }
+    #endif
+
+    while (iter < end)
+    {
+        if (*iter > 0x7F)
+            return FALSE;
+        iter++;
+    }
+
+    return TRUE;
+}
+
+SE_API sebool se_is_ascii_str(const seunichar8* str, int len)
+{
+    return se_is_ascii_str_sz(str, len);
+}
+
+SE_API sebool se_is_ascii_utf16_str_sz(const seunichar16* str, ptrdiff_t len)
+/*
+ * Return whether every unit of str is below U+0080.
+ */
+{
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf16_str_len_sz(str);
+
+    SE_STATS_COUNT(SE_STATS_IS_ASCII_UTF16, len * sizeof(seunichar16));
+
+    return se_utf16_units_fit(str, str + len, 0xFF80);
+}
+
+SE_API sebool se_is_ascii_utf16_str(const seunichar16* str, int len)
+{
+    return se_is_ascii_utf16_str_sz(str, len);
+}
+
+SE_API sebool se_is_latin1_utf8_str_sz(const seunichar8* str, ptrdiff_t len)
+/*
+ * Return whether str is a well-formed UTF-8 string of characters up to
+ * U+00FF, which se_safe_utf8_to_latin1() converts without replacing any.
+ * Such a string is made of ASCII bytes and of C2 or C3 bytes, each
+ * followed by a continuation byte.
+ */
+{
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    SE_STATS_COUNT(SE_STATS_IS_LATIN1_UTF8, len * sizeof(seunichar8));
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    #if SE_OPT_SSE2
+    {
+        __m128i block;
+        unsigned int high;
+        unsigned int leads;
+        unsigned int trails;
+        unsigned int carry;
+
+        /*
+         * Bit i of leads is set for a C2 or C3 byte, bit i of trails for a
+         * continuation byte. The block is valid when its bytes above 0x7F
+         * are all leads or trails, and the trails are the leads shifted by
+         * one byte. carry is the lead ending the previous block.
+         */
+        carry = 0;
+        while (end - iter >= 16)
+        {
+            block = _mm_loadu_si128((const __m128i*)iter);
+            high = (unsigned int) _mm_movemask_epi8(block);
+            if (high | carry)
+            {
+                leads = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(block, _mm_set1_epi8((char) 0xFE)), _mm_set1_epi8((char) 0xC2)));
+                trails = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(block, _mm_set1_epi8((char) 0xC0)), _mm_set1_epi8((char) 0x80)));
+                if (high & ~(leads | trails))
+                    return FALSE;
+                if (trails != (((leads << 1) | carry) & 0xFFFF))
+                    return FALSE;
+                carry = leads >> 15;
+            }
+            iter += 16;
+        }
+
+        /* A lead ending the last block is checked again below */
+        iter -= carry;
+    }
+    #endif
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            iter++;
+        }
+        else if ((iter[0] & 0xFE) == 0xC2 && end - iter >= 2 && (iter[1] & 0xC0) == 0x80)
+        {
+            iter += 2;
+        }
+        else
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+SE_API sebool se_is_latin1_utf8_str(const seunichar8* str, int len)
+{
+    return se_is_latin1_utf8_str_sz(str, len);
+}
+
+SE_API sebool se_is_latin1_utf16_str_sz(const seunichar16* str, ptrdiff_t len)
+/*
+ * Return whether every unit of str is below U+0100, so that
+ * se_safe_utf16_to_latin1() converts it without replacing any character.
+ */
+{
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf16_str_len_sz(str);
+
+    SE_STATS_COUNT(SE_STATS_IS_LATIN1_UTF16, len * sizeof(seunichar16));
+
+    return se_utf16_units_fit(str, str + len, 0xFF00);
+}
+
+SE_API sebool se_is_latin1_utf16_str(const seunichar16* str, int len)
+{
+    return se_is_latin1_utf16_str_sz(str, len);
+}
+
+SE_API seunichar8* se_latin1_to_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * str:
+ *      Input Latin-1 encoded string.
+ *
+ * len:
+ *      The byte length of input string.
+ *      If len < 0, then the string is NUL terminated.
+ *
+ * out_len:
+ *      Location to return the length of the output string.
+ *      (Can be NULL to indicate that the result is not needed.)
+ *
+ * Convert a string from Latin-1 to UTF-8.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    ptrdiff_t new_str_len;
+    seunichar8* new_str;
+    unsigned char* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz((const seunichar8*)str);
+
+    SE_STATS_ENTER();
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_latin1_utf8_len(iter, end);
+
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar8));
+    SE_STATS_ALLOC(SE_STATS_LATIN1_TO_UTF8, (new_str_len + 1) * sizeof(seunichar8));
+    SE_TRACE_ALLOC(SE_STATS_LATIN1_TO_UTF8, len, (new_str_len + 1) * sizeof(seunichar8), (len * 2 + 1) * sizeof(seunichar8));
+
+    new_str_iter = se_latin1_utf8_fill(iter, end, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    *new_str_iter = 0;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(new_str, new_str_len));
+
+    SE_STATS_LEAVE(SE_STATS_LATIN1_TO_UTF8, len, new_str_len * sizeof(seunichar8));
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar8* se_latin1_to_utf8(const char* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_latin1_to_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_latin1_to_utf8_into(const char* str, ptrdiff_t len, seunichar8* buf)
+/*
+ * buf:
+ *      The output buffer, with room for at least 2 * len bytes.
+ *
+ * Convert as by se_latin1_to_utf8() into a buffer owned by the caller.
+ * The output is not NUL terminated.
+ *
+ * Return:
+ *      The length in bytes of the output.
+ */
+{
+    const unsigned char* iter;
+    unsigned char* buf_end;
+
+    SE_DEBUG_ASSERT(str);
+    SE_DEBUG_ASSERT(buf);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz((const seunichar8*)str);
+
+    SE_STATS_ENTER();
+
+    iter = (const unsigned char*)str;
+    buf_end = se_latin1_utf8_fill(iter, iter + len, (unsigned char*)buf);
+
+    SE_STATS_LEAVE(SE_STATS_LATIN1_TO_UTF8_INTO, len, buf_end - (unsigned char*)buf);
+
+    return buf_end - (unsigned char*)buf;
+}
+
+SE_API seunichar16* se_latin1_to_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from Latin-1 to UTF-16, one unit per byte.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    seunichar16* new_str;
+    seunichar16* new_str_iter;
+    const unsigned char* iter;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz((const seunichar8*)str);
+
+    SE_STATS_ENTER();
+
+    new_str = SE_MALLOC((len + 1) * sizeof(seunichar16));
+    SE_STATS_ALLOC(SE_STATS_LATIN1_TO_UTF16, (len + 1) * sizeof(seunichar16));
+    SE_TRACE_ALLOC(SE_STATS_LATIN1_TO_UTF16, len, (len + 1) * sizeof(seunichar16), (len + 1) * sizeof(seunichar16));
+
+    iter = (const unsigned char*)str;
+    new_str_iter = se_latin1_utf16_fill(iter, iter + len, new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - new_str == len);
+    *new_str_iter = 0;
+
+    SE_STATS_LEAVE(SE_STATS_LATIN1_TO_UTF16, len, len * sizeof(seunichar16));
+
+    if (out_len)
+        *out_len = len;
+
+    return new_str;
+}
+
+SE_API seunichar16* se_latin1_to_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_latin1_to_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_latin1_to_utf16_into(const char* str, ptrdiff_t len, seunichar16* buf)
+/*
+ * buf:
+ *      The output buffer, with room for at least len UTF-16 units.
+ *
+ * Convert as by se_latin1_to_utf16() into a buffer owned by the caller.
+ * The output is not NUL terminated.
+ *
+ * Return:
+ *      The length in UTF-16 units of the output, which is len.
+ */
+{
+    const unsigned char* iter;
+
+    SE_DEBUG_ASSERT(str);
+    SE_DEBUG_ASSERT(buf);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz((const seunichar8*)str);
+
+    SE_STATS_ENTER();
+
+    iter = (const unsigned char*)str;
+    se_latin1_utf16_fill(iter, iter + len, buf);
+
+    SE_STATS_LEAVE(SE_STATS_LATIN1_TO_UTF16_INTO, len, len * sizeof(seunichar16));
+
+    return len;
+}
+
+SE_API char* se_safe_utf8_to_latin1_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-8 to Latin-1, replacing each character above
+ * U+00FF by '?'. Assuming the input string is well-formed.
+ * se_is_latin1_utf8_str() tells whether any character would be replaced.
+ *
+ * Return:
+ *      A pointer to a newly allocated Latin-1 string.
+ *      This string must be freed by caller.
+ */
+{
+    ptrdiff_t new_str_len;
+    char* new_str;
+    unsigned char* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(str, len));
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    SE_STATS_ENTER();
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_utf8_count_lead_bytes(iter, end);
+
+    new_str = SE_MALLOC(new_str_len + 1);
+    SE_STATS_ALLOC(SE_STATS_SAFE_UTF8_TO_LATIN1, new_str_len + 1);
+    SE_TRACE_ALLOC(SE_STATS_SAFE_UTF8_TO_LATIN1, len * sizeof(seunichar8), new_str_len + 1, len + 1);
+
+    new_str_iter = se_safe_utf8_latin1_fill(iter, end, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    *new_str_iter = 0;
+
+    SE_STATS_LEAVE(SE_STATS_SAFE_UTF8_TO_LATIN1, len * sizeof(seunichar8), new_str_len);
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf8_to_latin1(const seunichar8* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_latin1_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_safe_utf8_to_latin1_into(const seunichar8* str, ptrdiff_t len, char* buf)
+/*
+ * buf:
+ *      The output buffer, with room for at least len bytes.
+ *
+ * Convert as by se_safe_utf8_to_latin1() into a buffer owned by the
+ * caller. The output is not NUL terminated.
+ *
+ * Return:
+ *      The length in bytes of the output.
+ */
+{
+    const unsigned char* iter;
+    unsigned char* buf_end;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(str, len));
+    SE_DEBUG_ASSERT(buf);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    SE_STATS_ENTER();
+
+    iter = (const unsigned char*)str;
+    buf_end = se_safe_utf8_latin1_fill(iter, iter + len, (unsigned char*)buf);
+
+    SE_STATS_LEAVE(SE_STATS_SAFE_UTF8_TO_LATIN1_INTO, len * sizeof(seunichar8), buf_end - (unsigned char*)buf);
+
+    return buf_end - (unsigned char*)buf;
+}
+
+SE_API char* se_safe_utf16_to_latin1_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16 to Latin-1, replacing each character above
+ * U+00FF by '?'. Assuming the input string is well-formed.
+ * se_is_latin1_utf16_str() tells whether any character would be replaced.
+ *
+ * Return:
+ *      A pointer to a newly allocated Latin-1 string.
+ *      This string must be freed by caller.
+ */
+{
+    ptrdiff_t new_str_len;
+    char* new_str;
+    unsigned char* new_str_iter;
+    const seunichar16* end;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(str, len));
+
+    if (len < 0)
+        len = se_utf16_str_len_sz(str);
+
+    SE_STATS_ENTER();
+
+    end = str + len;
+
+    new_str_len = se_safe_utf16_latin1_len(str, end);
+
+    new_str = SE_MALLOC(new_str_len + 1);
+    SE_STATS_ALLOC(SE_STATS_SAFE_UTF16_TO_LATIN1, new_str_len + 1);
+    SE_TRACE_ALLOC(SE_STATS_SAFE_UTF16_TO_LATIN1, len * sizeof(seunichar16), new_str_len + 1, len + 1);
+
+    new_str_iter = se_safe_utf16_latin1_fill(str, end, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    *new_str_iter = 0;
+
+    SE_STATS_LEAVE(SE_STATS_SAFE_UTF16_TO_LATIN1, len * sizeof(seunichar16), new_str_len);
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf16_to_latin1(const seunichar16* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf16_to_latin1_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API ptrdiff_t se_safe_utf16_to_latin1_into(const seunichar16* str, ptrdiff_t len, char* buf)
+/*
+ * buf:
+ *      The output buffer, with room for at least len bytes.
+ *
+ * Convert as by se_safe_utf16_to_latin1() into a buffer owned by the
+ * caller. The output is not NUL terminated.
+ *
+ * Return:
+ *      The length in bytes of the output.
+ */
+{
+    unsigned char* buf_end;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str_sz(str, len));
+    SE_DEBUG_ASSERT(buf);
+
+    if (len < 0)
+        len = se_utf16_str_len_sz(str);
+
+    SE_STATS_ENTER();
+
+    buf_end = se_safe_utf16_latin1_fill(str, str + len, (unsigned char*)buf);
+
+    SE_STATS_LEAVE(SE_STATS_SAFE_UTF16_TO_LATIN1_INTO, len * sizeof(seunichar16), buf_end - (unsigned char*)buf);
+
+    return buf_end - (unsigned char*)buf;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-8 string manipulating.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API int se_utf8_strcmp_ignore_ascii_case(const char* s1, const char* s2)
+{
+    const unsigned char* p1;
+    const unsigned char* p2;
+    int c1;
+    int c2;
+
+    SE_DEBUG_ASSERT(s1);
+    SE_DEBUG_ASSERT(s2);
+
+    if (s1 == s2)
+        return 0;
+
+    p1 = (const unsigned char*)s1;
+    p2 = (const unsigned char*)s2;
+
+    while ( (*p1) && (*p2) )
+    {
+        if ( (*p1 >= 'A') && (*p1 <= 'Z') )
+            c1 = *p1 - 'A' + 'a';
+        else
+            c1 = *p1;
+
+        if ( (*p2 >= 'A') && (*p2 <= 'Z') )
+            c2 = *p2 - 'A' + 'a';
+        else
+            c2 = *p2;
+
+        if (c1 != c2)
+            return c1 - c2;
+
+        p1++;
+        p2++;
+    }
+
+    c1 = *p1;
+    c2 = *p2;
+    return c1 - c2;
+}
+
+SE_API int se_utf8_strcmp_n_ignore_ascii_case(const char* s1, const char* s2, int n)
+{
+    const unsigned char* p1;
+    const unsigned char* p2;
+    int c1;
+    int c2;
+
+    if (s1 == s2)
+        return 0;
+
+    SE_DEBUG_ASSERT(s1);
+    SE_DEBUG_ASSERT(s2);
+
+    p1 = (const unsigned char*)s1;
+    p2 = (const unsigned char*)s2;
+
+    while ( (n > 0) && (*p1) && (*p2) )
+    {
+        if ( (*p1 >= 'A') && (*p1 <= 'Z') )
+            c1 = *p1 - 'A' + 'a';
+        else
+            c1 = *p1;
+
+        if ( (*p2 >= 'A') && (*p2 <= 'Z') )
+            c2 = *p2 - 'A' + 'a';
+        else
+            c2 = *p2;
+
+        if (c1 != c2)
+            return c1 - c2;
+
+        p1++;
+        p2++;
+        n--;
+    }
+
+    if (n > 0)
+    {
+        c1 = *p1;
+        c2 = *p2;
+        return c1 - c2;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+SE_API int se_utf8_strcmp_ignore_space_and_ascii_case(const char* s1, const char* s2)
+{
+    const unsigned char* p1;
+    const unsigned char* p2;
+    int c1;
+    int c2;
+
+    SE_DEBUG_ASSERT(s1);
+    SE_DEBUG_ASSERT(s2);
+
+    if (s1 == s2)
+        return 0;
+
+    p1 = (const unsigned char*)s1;
+    p2 = (const unsigned char*)s2;
+
+    while ( (*p1) && (*p2) )
+    {
+        while (*p1 == ' ')
+            p1++;
+        if ( (*p1 >= 'A') && (*p1 <= 'Z') )
+            c1 = *p1 - 'A' + 'a';
+        else
+            c1 = *p1;
+
+        while (*p2 == ' ')
+            p2++;
+        if ( (*p2 >= 'A') && (*p2 <= 'Z') )
+            c2 = *p2 - 'A' + 'a';
+        else
+            c2 = *p2;
+
+        if (c1 != c2)
+            return c1 - c2;
+
+        p1++;
+        p2++;
+    }
+
+    c1 = *p1;
+    c2 = *p2;
+    return c1 - c2;
+}
+
+SE_API const char* se_utf8_strstr_ignore_space_and_ascii_case(const char* s1, const char* s2)
+{
+    SE_DEBUG_ASSERT(s1);
+    SE_DEBUG_ASSERT(s2);
+
+    if (s1 == s2)
+        return s1;
+
+    while (*s1)
+    {
+        int c1;
+        int c2;
+        const unsigned char* p1;
+        const unsigned char* p2;
+
+        p1 = (const unsigned char*)s1;
+        p2 = (const unsigned char*)s2;
+
+        for (;;)
+        {
+            while (*p1 == ' ')
+                p1++;
+            if ( (*p1 >= 'A') && (*p1 <= 'Z') )
+                c1 = *p1 - 'A' + 'a';
+            else
+                c1 = *p1;
+
+            while (*p2 == ' ')
+                p2++;
+            if ( (*p2 >= 'A') && (*p2 <= 'Z') )
+                c2 = *p2 - 'A' + 'a';
+            else
+                c2 = *p2;
+
+            if (c1 == 0 || c2 == 0)
+                break;
+            if (c1 != c2)
+                break;
+
+            p1++;
+            p2++;
+        }
+        if (c1 == c2)
+            return s1;
+
+        s1++;
+    }
+
+    return 0;
+}
+
+SE_API unsigned int se_utf8_str_hash(const seunichar8* str)
+{
+    const unsigned char* p;
+    unsigned int h;
+
+    SE_DEBUG_ASSERT(str);
+
+    p = (const unsigned char*)str;
+
+    h = *p;
+    p++;
+
+    if (h)
+    {
+        while (*p)
+        {
+            h = (h << 5) - h + *p;
+            p++;
+        }
+    }
+
+    return h;
+}
+
+SE_API char* se_utf8_strdup(const seunichar8* str)
+{
+    seunichar8* new_str;
+
+    if (str)
+    {
+        int bytes = se_utf8_str_len(str) + 1;
+        new_str = SE_MALLOC(bytes);
+        SE_STATS_ALLOC(SE_STATS_UTF8_STRDUP, bytes);
+        SE_TRACE_ALLOC(SE_STATS_UTF8_STRDUP, bytes, bytes, bytes);
+        memcpy(new_str, str, bytes);
+    }
+    else
+    {
+        new_str = 0;
+    }
+
+    return new_str;
+}
+
+SE_API char* se_utf8_strdup_n(const seunichar8* str, int len)
+{
+    seunichar8* new_str;
+
+    if (str)
+    {
+        SE_DEBUG_ASSERT(len >= 0);
+        new_str = SE_MALLOC(len + 1);
+        SE_STATS_ALLOC(SE_STATS_UTF8_STRDUP, len + 1);
+        SE_TRACE_ALLOC(SE_STATS_UTF8_STRDUP, len, len + 1, len + 1);
+        memcpy(new_str, str, len);
+        new_str[len] = 0;
+    }
+    else
+    {
+        new_str = 0;
+    }
+
+    return new_str;
+}
+
+SE_API const seunichar8* se_safe_utf8_next_char(const seunichar8* str)
+{
+    static const unsigned char SE_UTF8_SKIP[256] =
+    {
+        /* 0x00 - 0x0F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+        /* 0x10 - 0x1F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+        /* 0x20 - 0x2F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+        /* 0x30 - 0x3F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+        /* 0x40 - 0x4F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+        /* 0x50 - 0x5F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+        /* 0x60 - 0x6F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+        /* 0x70 - 0x7F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+        /* 0x80 - 0x8F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+        /* 0x90 - 0x9F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+        /* 0xA0 - 0xAF */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+        /* 0xB0 - 0xBF */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+        /* 0xC0 - 0xCF */ 1,1,2,2, 2,2,2,2, 2,2,2,2, 2,2,2,2,
+        /* 0xD0 - 0xDF */ 2,2,2,2, 2,2,2,2, 2,2,2,2, 2,2,2,2,
+        /* 0xE0 - 0xEF */ 3,3,3,3, 3,3,3,3, 3,3,3,3, 3,3,3,3,
+        /* 0xF0 - 0xFF */ 4,4,4,4, 4,1,1,1, 1,1,1,1, 1,1,1,1
+    };
+
+    #if SE_OPT_DEBUG
+
+        const unsigned char* iter;
+        const seunichar8* p1;
+        const seunichar8* p2;
+
+        SE_DEBUG_ASSERT(str);
+
+        iter = (const unsigned char*)str;
+        if (iter[0] <= 0x7F)
+        {
+            p1 = str + 1;
+        }
+        else if (iter[0] >= 0xC2 && iter[0] <= 0xDF)
+        {
+            SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0xBF);
+            p1 = str + 2;
+        }
+        else if (iter[0] == 0xE0)
+        {
+            SE_DEBUG_ASSERT(iter[1] >= 0xA0 && iter[1] <= 0xBF);
+            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
+            p1 = str + 3;
+        }
+        else if (iter[0] >= 0xE1 && iter[0] <= 0xEC)
+        {
+            SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0xBF);
+            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
+            p1 = str + 3;
+        }
+        else if (iter[0] == 0xED)
+        {
+            SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0x9F);
+            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
+            p1 = str + 3;
+        }
+        else if (iter[0] >= 0xEE && iter[0] <= 0xEF)
+        {
+            SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0xBF);
+            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
+            p1 = str + 3;
+        }
+        else if (iter[0] == 0xF0)
+        {
+            SE_DEBUG_ASSERT(iter[1] >= 0x90 && iter[1] <= 0xBF);
+            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
+            SE_DEBUG_ASSERT(iter[3] >= 0x80 && iter[3] <= 0xBF);
+            p1 = str + 4;
+        }
+        else if (iter[0] >= 0xF1 && iter[0] <= 0xF3)
+        {
+            SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0xBF);
+            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
+            SE_DEBUG_ASSERT(iter[3] >= 0x80 && iter[3] <= 0xBF);
+            p1 = str + 4;
+        }
+        else if (iter[0] == 0xF4)
+        {
+            SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0x8F);
+            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
+            SE_DEBUG_ASSERT(iter[3] >= 0x80 && iter[3] <= 0xBF);
+            p1 = str + 4;
+        }
+        else
+        {
+            SE_DEBUG_ASSERT(FALSE);
+            p1 = str + 1;
+        }
+
+        p2 = str + SE_UTF8_SKIP[*(unsigned char*)str];
+
+        SE_DEBUG_ASSERT(p1 == p2);
+
+        return p1;
+
+    #else
+
+        return str + SE_UTF8_SKIP[*(unsigned char*)str];
+
+    #endif
+}
+
+SE_API const seunichar8* se_safe_utf8_prev_char(const seunichar8* str)
+{
+#if SE_OPT_DEBUG
+
+    const seunichar8* p = str;
+
+    for (;;)
+    {
+        str--;
+        if ((*(const unsigned char*)str & 0xc0) != 0x80)
+            break;
+    }
+
+    SE_DEBUG_ASSERT(se_safe_utf8_next_char(str) == p);
+
+    return str;
+
+#else
+
+    for (;;)
+    {
+        str--;
+        if ((*(const unsigned char*)str & 0xc0) != 0x80)
+            break;
+    }
+
+    return str;
+
+#endif
+}
+
+SE_API const seunichar8* se_safe_utf8_offset_to_pointer(const seunichar8* str, int offset)
+/*
+ * str: a UTF-8 encoded string
+ * offset: a character offset within str
+ * 
+ * Converts from an integer character offset to a pointer to a position
+ * within the string.
+ * 
+ * This function allows to pass a negative offset to
+ * step backwards. Both directions scan 16 bytes per step, so it is
+ * worth stepping backwards from the end if offset is in the last half
+ * of the string.
+ * 
+ * Return: the resulting pointer
+ */
+{
+    if (offset > 0) 
+    {
+        str = (const seunichar8*)se_utf8_skip_chars((const unsigned char*)str, 0, offset);
+    }
+    else
+    {
+        str = (const seunichar8*)se_utf8_rewind_chars(0, (const unsigned char*)str, -offset);
+    }
+
+    return str;
+}
+
+SE_API const seunichar8* se_safe_utf8_str_last_chars(const seunichar8* str, int len, int count)
+/*
+ * str: a UTF-8 encoded string
+ * len: the byte length of str, or -1 if it is NUL terminated
+ * count: the number of characters to keep
+ *
+ * Finds the start of the last count characters of str, scanning
+ * backwards from the end. If str is shorter, str is returned.
+ *
+ * Return: a pointer to the tail of str
+ */
+{
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+    SE_DEBUG_ASSERT(count >= 0);
+
+    if (len < 0)
+        len = se_utf8_str_len(str);
+
+    return (const seunichar8*)se_utf8_rewind_chars((const unsigned char*)str, (const unsigned char*)str + len, count);
+}
+
+SE_API int se_safe_utf8_str_truncate(const seunichar8* str, int len, int max_len)
+/*
+ * str: a UTF-8 encoded string
+ * len: the byte length of str, or -1 if it is NUL terminated
+ * max_len: the maximum byte length of the result
+ *
+ * Finds the longest prefix of str which is at most max_len bytes long
+ * and does not split a character. At most 3 bytes before max_len are
+ * examined. Nothing is copied, str and the result describe the prefix.
+ *
+ * Return: the byte length of the prefix
+ */
+{
+    const unsigned char* iter;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+    SE_DEBUG_ASSERT(max_len >= 0);
+
+    if (len < 0)
+        len = se_utf8_str_len(str);
+
+    if (len <= max_len)
+        return len;
+
+    iter = (const unsigned char*)str + max_len;
+    while ((*iter & 0xC0) == 0x80)
+        iter--;
+
+    return (int) (iter - (const unsigned char*)str);
+}
+
+SE_API int se_safe_utf8_str_truncate_chars(const seunichar8* str, int len, int max_chars)
+/*
+ * str: a UTF-8 encoded string
+ * len: the byte length of str, or -1 if it is NUL terminated
+ * max_chars: the maximum number of characters of the result
+ *
+ * Finds the prefix of str made of its first max_chars characters,
+ * counting 16 bytes per step. Nothing is copied, str and the result
+ * describe the prefix.
+ *
+ * Return: the byte length of the prefix
+ */
+{
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+    SE_DEBUG_ASSERT(max_chars >= 0);
+
+    if (len < 0)
+        len = se_utf8_str_len(str);
+
+    /* A string has no more characters than bytes. */
+    if (len <= max_chars)
+        return len;
+
+    return (int) (se_utf8_skip_chars((const unsigned char*)str, (const unsigned char*)str + len, max_chars) -
+                  (const unsigned char*)str);
+}
+
+SE_API int se_safe_utf8_pointer_to_offset(const seunichar8* str, const seunichar8* pos)
+/*
+ * str: a UTF-8 encoded string
+ * pos: a pointer to a position within str
+ * 
+ * Converts from a pointer to position within a string to a integer
+ * character offset.
+ *
+ * This function allows pos to be before str, and returns
+ * a negative offset in this case.
+ * 
+ * Return: the resulting character offset
+ */
+{
+    if (pos < str) 
+        return (int) -se_utf8_count_lead_bytes((const unsigned char*)pos, (const unsigned char*)str);
+    else
+        return (int) se_utf8_count_lead_bytes((const unsigned char*)str, (const unsigned char*)pos);
+}
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-8 character index.                                                  *
+ *                                                                         *
+ * A side index over a safe UTF-8 string which records the byte offset     *
+ * of every N-th character, so that converting between character offsets  *
+ * and pointers does not walk the string from its start.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#define SE_UTF8_INDEX_DEFAULT_INTERVAL      128
+
+struct se_utf8_index
+{
+    const seunichar8* str;          /* Indexed string, not owned */
+    int len;                        /* Byte length of str */
+    int char_count;                 /* Character length of str */
+    int interval;                   /* Characters between two checkpoints */
+    int checkpoint_count;
+    int checkpoint_capacity;
+    int* checkpoints;               /* Byte offset of character i * interval */
+};
+
+static void se_utf8_index_add_checkpoint(se_utf8_index* index, int offset)
+{
+    int* checkpoints;
+
+    if (index->checkpoint_count == index->checkpoint_capacity)
+    {
+        index->checkpoint_capacity *= 2;
+        checkpoints = SE_MALLOC(index->checkpoint_capacity * sizeof(int));
+        SE_STATS_ALLOC(SE_STATS_UTF8_INDEX, index->checkpoint_capacity * sizeof(int));
+        SE_TRACE_ALLOC(SE_STATS_UTF8_INDEX, index->len, index->checkpoint_capacity * sizeof(int), index->checkpoint_capacity * sizeof(int));
+        memcpy(checkpoints, index->checkpoints, index->checkpoint_count * sizeof(int));
+        SE_FREE(index->checkpoints);
+        index->checkpoints = checkpoints;
+    }
+
+    index->checkpoints[index->checkpoint_count++] = offset;
+}
+
+static void se_utf8_index_scan(se_utf8_index* index, int from)
+/*
+ * Count the characters of str from byte offset from (a character
+ * boundary) to the end, recording a checkpoint at every interval-th one.
+ */
+{
+    const unsigned char* start;
+    const unsigned char* iter;
+    const unsigned char* end;
+    int char_count;
+    int next_checkpoint;
+
+    start = (const unsigned char*)index->str;
+    iter = start + from;
+    end = start + index->len;
+    char_count = index->char_count;
+    next_checkpoint = index->checkpoint_count * index->interval;
+
+    #if SE_OPT_SSE2
+    {
+        __m128i cont_max;
+        unsigned int mask;
+        unsigned int lead_mask;
+        int lead_count;
+        int skip;
+
+        cont_max = _mm_set1_epi8((char) 0xBF);
+        while (iter + 16 <= end)
+        {
+            mask = _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)iter), cont_max));
+            lead_count = se_bit_count(mask);
+            while (next_checkpoint < char_count + lead_count)
+            {
+                lead_mask = mask;
+                for (skip = next_checkpoint - char_count; skip > 0; skip--)
+                    lead_mask &= lead_mask - 1;
+                se_utf8_index_add_checkpoint(index, (int) (iter - start) + se_bit_scan_forward(lead_mask));
+                next_checkpoint += index->interval;
+            }
+            char_count += lead_count;
+            iter += 16;
+        }
+    }
+    #endif
+
+    while (iter < end)
+    {
+        if ((*iter & 0xC0) != 0x80)
+        {
+            if (char_count == next_checkpoint)
+            {
+                se_utf8_index_add_checkpoint(index, (int) (iter - start));
+                next_checkpoint += index->interval;
+            }
+            char_count++;
+        }
+        iter++;
+    }
+
+    index->char_count = char_count;
+}
+
+SE_API se_utf8_index* se_utf8_index_new(const seunichar8* str, int len, int interval)
+/*
+ * str:
+ *      A well-formed UTF-8 string. It is not copied and must stay valid
+ *      as long as the index is used.
+ *
+ * len:
+ *      The byte length of str.
+ *      If len < 0, then the string is NUL terminated.
+ *
+ * interval:
+ *      The number of characters between two checkpoints, or 0 for the
+ *      default. Lookups walk at most interval characters, the index
+ *      takes about 4 / interval bytes per character.
+ *
+ * Return:
+ *      A newly allocated index, which must be freed with
+ *      se_utf8_index_free().
+ */
+{
+    se_utf8_index* index;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+    SE_DEBUG_ASSERT(interval >= 0);
+
+    if (len < 0)
+        len = se_utf8_str_len(str);
+
+    if (interval <= 0)
+        interval = SE_UTF8_INDEX_DEFAULT_INTERVAL;
+
+    index = SE_MALLOC(sizeof(se_utf8_index));
+    SE_STATS_ALLOC(SE_STATS_UTF8_INDEX, sizeof(se_utf8_index));
+    SE_TRACE_ALLOC(SE_STATS_UTF8_INDEX, len, sizeof(se_utf8_index), sizeof(se_utf8_index));
+    index->str = str;
+    index->len = len;
+    index->char_count = 0;
+    index->interval = interval;
+
+    /* There are never more characters than bytes. */
+    index->checkpoint_capacity = len / interval + 1;
+    index->checkpoints = SE_MALLOC(index->checkpoint_capacity * sizeof(int));
+    SE_STATS_ALLOC(SE_STATS_UTF8_INDEX, index->checkpoint_capacity * sizeof(int));
+    SE_TRACE_ALLOC(SE_STATS_UTF8_INDEX, len, index->checkpoint_capacity * sizeof(int), index->checkpoint_capacity * sizeof(int));
+    index->checkpoints[0] = 0;
+    index->checkpoint_count = 1;
+
+    se_utf8_index_scan(index, 0);
+
+    return index;
+}
+
+SE_API void se_utf8_index_free(se_utf8_index* index)
+{
+    if (index)
+    {
+        SE_FREE(index->checkpoints);
+        SE_FREE(index);
+    }
+}
+
+SE_API void se_utf8_index_append(se_utf8_index* index, const seunichar8* str, int len)
+/*
+ * Update the index after text was appended to the indexed string.
+ * str and len describe the whole string after the append, str may differ
+ * from the previous one if the buffer was reallocated. Only the appended
+ * bytes are scanned.
+ */
+{
+    int old_len;
+
+    SE_DEBUG_ASSERT(index);
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+
+    if (len < 0)
+        len = se_utf8_str_len(str);
+
+    SE_DEBUG_ASSERT(len >= index->len);
+
+    old_len = index->len;
+    index->str = str;
+    index->len = len;
+
+    se_utf8_index_scan(index, old_len);
+}
+
+SE_API int se_utf8_index_char_count(const se_utf8_index* index)
+{
+    SE_DEBUG_ASSERT(index);
+
+    return index->char_count;
+}
+
+SE_API const seunichar8* se_utf8_index_offset_to_pointer(const se_utf8_index* index, int offset)
+/*
+ * Converts a character offset to a pointer into the indexed string.
+ * A negative offset counts from the end of the string.
+ */
+{
+    int checkpoint;
+
+    SE_DEBUG_ASSERT(index);
+
+    if (offset < 0)
+        offset += index->char_count;
+
+    SE_DEBUG_ASSERT(offset >= 0 && offset <= index->char_count);
+
+    checkpoint = offset / index->interval;
+    if (checkpoint >= index->checkpoint_count)
+        checkpoint = index->checkpoint_count - 1;
+
+    return (const seunichar8*)se_utf8_skip_chars((const unsigned char*)index->str + index->checkpoints[checkpoint],
+                                                 0, offset - checkpoint * index->interval);
+}
+
+SE_API int se_utf8_index_pointer_to_offset(const se_utf8_index* index, const seunichar8* pos)
+/*
+ * Converts a pointer to a character boundary within the indexed string
+ * to a character offset.
+ */
+{
+    int byte_offset;
+    int low;
+    int high;
+    int middle;
+
+    SE_DEBUG_ASSERT(index);
+    SE_DEBUG_ASSERT(pos >= index->str && pos <= index->str + index->len);
+
+    byte_offset = (int) (pos - index->str);
+
+    low = 0;
+    high = index->checkpoint_count - 1;
+    while (low < high)
+    {
+        middle = (low + high + 1) / 2;
+        if (index->checkpoints[middle] <= byte_offset)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+
+    return low * index->interval +
+           (int) se_utf8_count_lead_bytes((const unsigned char*)index->str + index->checkpoints[low], (const unsigned char*)pos);
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Reference counted UTF-8 strings.                                        *
+ *                                                                         *
+ * An se_ustr is an immutable, well-formed UTF-8 string whose byte length, *
+ * character count, hash and ASCII flag are computed once when it is made, *
+ * so querying them afterwards costs nothing. The header and the bytes     *
+ * share one allocation. A slice shares the bytes of the string it is cut  *
+ * from, and keeps that string alive.                                      *
+ *                                                                         *
+ * Strings are never modified after they are made, so they can be read     *
+ * and passed between threads freely. Only the reference count changes,    *
+ * and it is updated atomically.                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+struct se_ustr
+{
+    volatile long ref_count;
+    se_ustr* owner;                 /* String holding the bytes of a slice, else NULL */
+    const seunichar8* str;          /* The bytes, NUL terminated unless a slice */
+    ptrdiff_t len;                  /* Byte length of str */
+    ptrdiff_t char_count;           /* Character length of str */
+    unsigned int hash;              /* As by se_utf8_str_hash() */
+    sebool is_ascii;
+    seunichar8 bytes[1];            /* Inline bytes, len + 1 of them, unless a slice */
+};
+
+static void se_ustr_init(se_ustr* s, se_ustr* owner, const seunichar8* str, ptrdiff_t len, sebool is_ascii)
+/*
+ * Fill in s for the well-formed UTF-8 string str of len bytes, computing
+ * its cached values. If is_ascii is set, str is known to be ASCII and its
+ * characters are not counted.
+ */
+{
+    const unsigned char* iter;
+    const unsigned char* end;
+    unsigned int h;
+
+    s->ref_count = 1;
+    s->owner = owner;
+    s->str = str;
+    s->len = len;
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    if (is_ascii)
+    {
+        s->char_count = len;
+        s->is_ascii = TRUE;
+    }
+    else
+    {
+        /* Continuation bytes only occur in non-ASCII characters */
+        s->char_count = se_utf8_count_lead_bytes(iter, end);
+        s->is_ascii = s->char_count == len;
+    }
+
+    /*
+     * The same hash as se_utf8_str_hash(), but over len bytes. Four steps
+     * of h = h * 31 + byte are folded into one, which shortens the chain
+     * of dependent multiplies.
+     */
+    h = 0;
+    if (iter < end)
+    {
+        h = *iter++;
+        while (end - iter >= 4)
+        {
+            h = h * 923521u + iter[0] * 29791u + iter[1] * 961u + iter[2] * 31u + iter[3];
+            iter += 4;
+        }
+        while (iter < end)
+            h = (h << 5) - h + *iter++;
+    }
+    s->hash = h;
+}
+
+SE_API se_ustr* se_ustr_new_sz(const seunichar8* str, ptrdiff_t len)
+/*
+ * str:
+ *      Input UTF-8 encoded string, which may be ill-formed.
+ *
+ * len:
+ *      The byte length of input string.
+ *      If len < 0, then the string is NUL terminated.
+ *
+ * Make a string from a copy of str, in which ill-formed codes are
+ * replaced as by se_unsafe_utf8_str_safe_copy().
+ *
+ * Return:
+ *      A new string with a reference count of 1, to be released with
+ *      se_ustr_unref().
+ */
+{
+    ptrdiff_t new_str_len;
+    se_ustr* s;
+    unsigned char* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_unsafe_utf8_safe_copy_len(iter, end);
+
+    s = SE_MALLOC(offsetof(se_ustr, bytes) + new_str_len + 1);
+    SE_STATS_ALLOC(SE_STATS_USTR, offsetof(se_ustr, bytes) + new_str_len + 1);
+    SE_TRACE_ALLOC(SE_STATS_USTR, len, offsetof(se_ustr, bytes) + new_str_len + 1, offsetof(se_ustr, bytes) + len * 3 + 1);
+
+    new_str_iter = se_unsafe_utf8_safe_copy_fill(iter, end, (unsigned char*)s->bytes);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)s->bytes == new_str_len);
+    *new_str_iter = 0;
+
+    se_ustr_init(s, 0, s->bytes, new_str_len, FALSE);
+
+    return s;
+}
+
+SE_API se_ustr* se_ustr_new(const seunichar8* str, int len)
+{
+    return se_ustr_new_sz(str, len);
+}
+
+SE_API se_ustr* se_ustr_ref(se_ustr* s)
+/*
+ * Add a reference to s, and return s.
+ */
+{
+    SE_DEBUG_ASSERT(s);
+    SE_DEBUG_ASSERT(s->ref_count > 0);
+
+    #if defined(_MSC_VER)
+        _InterlockedIncrement(&s->ref_count);
+    #else
+        __sync_add_and_fetch(&s->ref_count, 1);
+    #endif
+
+    return s;
+}
+
+SE_API void se_ustr_unref(se_ustr* s)
+/*
+ * Release a reference to s, freeing it with the last one. A slice also
+ * releases the string it was cut from.
+ */
+{
+    long ref_count;
+
+    if (!s)
+        return;
+
+    SE_DEBUG_ASSERT(s->ref_count > 0);
+
+    #if defined(_MSC_VER)
+        ref_count = _InterlockedDecrement(&s->ref_count);
+    #else
+        ref_count = __sync_sub_and_fetch(&s->ref_count, 1);
+    #endif
+
+    if (ref_count == 0)
+    {
+        se_ustr_unref(s->owner);
+        SE_FREE(s);
+    }
+}
+
+SE_API se_ustr* se_ustr_slice_sz(se_ustr* s, ptrdiff_t start, ptrdiff_t end)
+/*
+ * start, end:
+ *      Byte offsets of the slice in s, both on character boundaries.
+ *      0 <= start <= end <= the length of s.
+ *
+ * Make a string of the bytes of s from start to end, without copying
+ * them. The hash of the slice is computed here, and so is its character
+ * count unless s is ASCII, when the count is the length of the slice and
+ * no byte is scanned for it.
+ *
+ * Return:
+ *      A new reference, to be released with se_ustr_unref(). It is s
+ *      itself when the slice is the whole string. The bytes of a slice
+ *      are not NUL terminated.
+ */
+{
+    se_ustr* slice;
+    se_ustr* owner;
+
+    SE_DEBUG_ASSERT(s);
+    SE_DEBUG_ASSERT(start >= 0 && start <= end && end <= s->len);
+    SE_DEBUG_ASSERT(start == s->len || ((unsigned char)s->str[start] & 0xC0) != 0x80);
+    SE_DEBUG_ASSERT(end == s->len || ((unsigned char)s->str[end] & 0xC0) != 0x80);
+
+    if (start == 0 && end == s->len)
+        return se_ustr_ref(s);
+
+    /* Slices of slices share the bytes of the original string */
+    owner = s->owner ? s->owner : s;
+
+    slice = SE_MALLOC(sizeof(se_ustr));
+    SE_STATS_ALLOC(SE_STATS_USTR, sizeof(se_ustr));
+    SE_TRACE_ALLOC(SE_STATS_USTR, end - start, sizeof(se_ustr), sizeof(se_ustr));
+
+    se_ustr_init(slice, se_ustr_ref(owner), s->str + start, end - start, s->is_ascii);
+
+    return slice;
+}
+
+SE_API se_ustr* se_ustr_slice(se_ustr* s, int start, int end)
+{
+    return se_ustr_slice_sz(s, start, end);
+}
+
+SE_API const seunichar8* se_ustr_str(const se_ustr* s)
+/*
+ * Return the bytes of s, which stay valid as long as s is referenced.
+ *
+ * Only strings made by se_ustr_new() are NUL terminated. The bytes of a
+ * slice run on into the rest of the string it was cut from, so they must
+ * be passed with se_ustr_len_sz() as the length, and never to a function
+ * that reads up to a NUL, such as se_utf8_str_hash(), or that is given a
+ * length < 0.
+ */
+{
+    SE_DEBUG_ASSERT(s);
+
+    return s->str;
+}
+
+SE_API ptrdiff_t se_ustr_len_sz(const se_ustr* s)
+{
+    SE_DEBUG_ASSERT(s);
+
+    return s->len;
+}
+
+SE_API int se_ustr_len(const se_ustr* s)
+{
+    return (int) se_ustr_len_sz(s);
+}
+
+SE_API ptrdiff_t se_ustr_char_count_sz(const se_ustr* s)
+{
+    SE_DEBUG_ASSERT(s);
+
+    return s->char_count;
+}
+
+SE_API int se_ustr_char_count(const se_ustr* s)
+{
+    return (int) se_ustr_char_count_sz(s);
+}
+
+SE_API unsigned int se_ustr_hash(const se_ustr* s)
+/*
+ * Return the hash of s, equal to se_utf8_str_hash() of its bytes when
+ * they contain no NUL.
+ */
+{
+    SE_DEBUG_ASSERT(s);
+
+    return s->hash;
+}
+
+SE_API sebool se_ustr_is_ascii(const se_ustr* s)
+{
+    SE_DEBUG_ASSERT(s);
+
+    return s->is_ascii;
+}
+
+SE_API sebool se_ustr_equal(const se_ustr* s1, const se_ustr* s2)
+/*
+ * Return whether s1 and s2 hold the same bytes. Strings of different
+ * lengths or hashes are told apart without reading their bytes.
+ */
+{
+    SE_DEBUG_ASSERT(s1);
+    SE_DEBUG_ASSERT(s2);
+
+    if (s1 == s2)
+        return TRUE;
+
+    if (s1->len != s2->len || s1->hash != s2->hash)
+        return FALSE;
+
+    return memcmp(s1->str, s2->str, s1->len) == 0;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-8 <=> UTF-16 offset translation.                                    *
+ *                                                                         *
+ * For safe strings only.                                                  *
+ *                                                                         *
+ ***************************************************************************/
+
+/*
+ * A UTF-8 character takes one UTF-16 unit for each lead byte, plus one
+ * more if the lead byte is F0..F4. Both are counted per byte lane: as
+ * signed chars, lead bytes are greater than (char) 0xBF and 4 byte lead
+ * bytes are the negative ones greater than (char) 0xEF.
+ */
+static int se_utf8_count_utf16_units(const unsigned char* iter, const unsigned char* end)
+{
+    int count;
+
+    count = 0;
+
+    #if SE_OPT_SSE2
+    {
+        __m128i cont_max;
+        __m128i lead3_max;
+        __m128i zero;
+        __m128i block;
+        __m128i acc;
+        __m128i sums;
+        int blocks;
+
+        cont_max = _mm_set1_epi8((char) 0xBF);
+        lead3_max = _mm_set1_epi8((char) 0xEF);
+        zero = _mm_setzero_si128();
+        while (end - iter >= 16)
+        {
+            /* Each block adds up to 2 per byte lane. */
+            blocks = (int) ((end - iter) / 16);
+            if (blocks > 127)
+                blocks = 127;
+
+            acc = zero;
+            while (blocks--)
+            {
+                block = _mm_loadu_si128((const __m128i*)iter);
+                acc = _mm_sub_epi8(acc, _mm_cmpgt_epi8(block, cont_max));
+                acc = _mm_sub_epi8(acc, _mm_and_si128(_mm_cmpgt_epi8(block, lead3_max), _mm_cmplt_epi8(block, zero)));
+                iter += 16;
+            }
+
+            sums = _mm_sad_epu8(acc, zero);
+            count += _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+        }
+    }
+    #endif
+
+    while (iter < end)
+    {
+        if (*iter >= 0xF0)
+            count += 2;
+        else if ((*iter & 0xC0) != 0x80)
+            count++;
+        iter++;
+    }
+
+    return count;
+}
+
+static const unsigned char* se_utf8_skip_utf16_units(const unsigned char* iter, const unsigned char* end, int* unit_count)
+/*
+ * Skip whole characters from iter while they add up to no more than
+ * *unit_count UTF-16 units, and return the number of units actually
+ * skipped in *unit_count. It is one less than asked if the requested
+ * offset would split a surrogate pair.
+ */
+{
+    int remaining;
+
+    remaining = *unit_count;
+
+    #if SE_OPT_SSE2
+    {
+        __m128i cont_max;
+        __m128i lead3_max;
+        __m128i block;
+        int block_units;
+
+        /*
+         * A block can be skipped if all characters starting in it fit in
+         * the remaining units. Continuation bytes of the last character
+         * may follow the block, they are skipped afterwards.
+         */
+        cont_max = _mm_set1_epi8((char) 0xBF);
+        lead3_max = _mm_set1_epi8((char) 0xEF);
+        while (end - iter >= 16)
+        {
+            block = _mm_loadu_si128((const __m128i*)iter);
+            block_units = se_bit_count(_mm_movemask_epi8(_mm_cmpgt_epi8(block, cont_max))) +
+                          se_bit_count(_mm_movemask_epi8(_mm_cmpgt_epi8(block, lead3_max)) & _mm_movemask_epi8(block));
+            if (block_units > remaining)
+                break;
+            remaining -= block_units;
+            iter += 16;
+        }
+
+        while (iter < end && (*iter & 0xC0) == 0x80)
+            iter++;
+    }
+    #endif
+
+    while (iter < end)
+    {
+        if (*iter >= 0xF0)
+        {
+            if (remaining < 2)
+                break;
+            remaining -= 2;
+            iter += 4;
+        }
+        else
+        {
+            if (remaining < 1)
+                break;
+            remaining--;
+            iter = (const unsigned char*)se_safe_utf8_next_char((const seunichar8*)iter);
+        }
+    }
+
+    *unit_count -= remaining;
+
+    return iter;
+}
+
+static int se_utf16_count_utf8_units(const seunichar16* iter, const seunichar16* end)
+{
+    int count;
+
+    count = 0;
+
+    #if SE_OPT_SSE2
+    {
+        __m128i ascii_max;
+        __m128i two_max;
+        __m128i surrogate_mask;
+        __m128i surrogate_bits;
+        __m128i zero;
+        __m128i ones;
+        __m128i block;
+        __m128i units;
+        __m128i acc;
+        __m128i sums;
+
+        /*
+         * Every unit starts at 3 bytes, minus one if it is below U+0080,
+         * minus one if it is below U+0800, minus one if it is a surrogate
+         * (a pair takes 4 bytes). Lanes are widened to 32 bits by
+         * _mm_madd_epi16 before they can overflow.
+         */
+        ascii_max = _mm_set1_epi16(0x7F);
+        two_max = _mm_set1_epi16(0x7FF);
+        surrogate_mask = _mm_set1_epi16((short) 0xF800);
+        surrogate_bits = _mm_set1_epi16((short) 0xD800);
+        zero = _mm_setzero_si128();
+        ones = _mm_set1_epi16(1);
+        acc = zero;
+        while (end - iter >= 8)
+        {
+            block = _mm_loadu_si128((const __m128i*)iter);
+            units = _mm_set1_epi16(3);
+            units = _mm_add_epi16(units, _mm_cmpeq_epi16(_mm_subs_epu16(block, ascii_max), zero));
+            units = _mm_add_epi16(units, _mm_cmpeq_epi16(_mm_subs_epu16(block, two_max), zero));
+            units = _mm_add_epi16(units, _mm_cmpeq_epi16(_mm_and_si128(block, surrogate_mask), surrogate_bits));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(units, ones));
+            iter += 8;
+        }
+
+        sums = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+        sums = _mm_add_epi32(sums, _mm_srli_si128(sums, 4));
+        count += _mm_cvtsi128_si32(sums);
+    }
+    #endif
+
+    while (iter < end)
+    {
+        if (*iter < 0x80)
+            count++;
+        else if (*iter < 0x800 || SE_IS_SURROGATE(*iter))
+            count += 2;
+        else
+            count += 3;
+        iter++;
+    }
+
+    return count;
+}
+
+SE_API int se_safe_utf8_utf16_len(const seunichar8* str, int len)
+/*
+ * str:
+ *      Input UTF-8 encoded string.
+ *
+ * len:
+ *      The byte length of input string.
+ *      If len < 0, then the string is NUL terminated.
+ *
+ * Return:
+ *      The number of UTF-16 units needed to encode str, which is also
+ *      the UTF-16 offset of the byte offset len.
+ */
+{
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+
+    if (len < 0)
+        len = se_utf8_str_len(str);
+
+    return se_utf8_count_utf16_units((const unsigned char*)str, (const unsigned char*)str + len);
+}
+
+SE_API int se_safe_utf16_utf8_len(const seunichar16* str, int len)
+/*
+ * Return the number of bytes needed to encode str in UTF-8, which is also
+ * the UTF-8 byte offset of the UTF-16 offset len.
+ */
+{
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str(str, len));
+
+    if (len < 0)
+        len = se_utf16_str_len(str);
+
+    return se_utf16_count_utf8_units(str, str + len);
+}
+
+SE_API int se_safe_utf8_utf16_offset_to_byte_offset(const seunichar8* str, int len, int utf16_offset)
+/*
+ * str:
+ *      Input UTF-8 encoded string.
+ *
+ * len:
+ *      The byte length of input string.
+ *      If len < 0, then the string is NUL terminated.
+ *
+ * utf16_offset:
+ *      An offset in UTF-16 units, as if str was encoded in UTF-16.
+ *
+ * Return:
+ *      The corresponding byte offset in str. An offset in the middle of
+ *      a surrogate pair maps to the start of the character, an offset
+ *      past the end maps to len.
+ */
+{
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+    SE_DEBUG_ASSERT(utf16_offset >= 0);
+
+    if (len < 0)
+        len = se_utf8_str_len(str);
+
+    return (int) (se_utf8_skip_utf16_units((const unsigned char*)str, (const unsigned char*)str + len, &utf16_offset) -
+                  (const unsigned char*)str);
+}
+
+SE_API void se_safe_utf8_byte_offsets_to_utf16_offsets(const seunichar8* str, int len, const int* byte_offsets, int* utf16_offsets, int count)
+/*
+ * Convert count byte offsets into str, sorted in ascending order, to
+ * UTF-16 offsets in a single pass over str.
+ */
+{
+    const unsigned char* iter;
+    int utf16_offset;
+    int i;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+
+    if (len < 0)
+        len = se_utf8_str_len(str);
+
+    iter = (const unsigned char*)str;
+    utf16_offset = 0;
+    for (i = 0; i < count; i++)
+    {
+        SE_DEBUG_ASSERT(byte_offsets[i] >= (int) (iter - (const unsigned char*)str));
+        SE_DEBUG_ASSERT(byte_offsets[i] <= len);
+
+        utf16_offset += se_utf8_count_utf16_units(iter, (const unsigned char*)str + byte_offsets[i]);
+        iter = (const unsigned char*)str + byte_offsets[i];
+        utf16_offsets[i] = utf16_offset;
+    }
+}
+
+SE_API void se_safe_utf8_utf16_offsets_to_byte_offsets(const seunichar8* str, int len, const int* utf16_offsets, int* byte_offsets, int count)
+/*
+ * Convert count UTF-16 offsets, sorted in ascending order, to byte
+ * offsets into str in a single pass over str. Offsets are mapped as by
+ * se_safe_utf8_utf16_offset_to_byte_offset().
+ */
+{
+    const unsigned char* iter;
+    const unsigned char* end;
+    int utf16_offset;
+    int unit_count;
+    int i;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+
+    if (len < 0)
+        len = se_utf8_str_len(str);
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+    utf16_offset = 0;
+    for (i = 0; i < count; i++)
+    {
+        SE_DEBUG_ASSERT(i == 0 || utf16_offsets[i] >= utf16_offsets[i - 1]);
+
+        unit_count = utf16_offsets[i] - utf16_offset;
+        if (unit_count > 0)
+        {
+            iter = se_utf8_skip_utf16_units(iter, end, &unit_count);
+            utf16_offset += unit_count;
+        }
+        byte_offsets[i] = (int) (iter - (const unsigned char*)str);
+    }
+}
+
+/***************************************************************************
+ *                                                                         *
+ * UTF-16 string manipulating.                                             *
+ *                                                                         *
+ ***************************************************************************/
+
+/*
+ * Map a UTF-16 code unit so that comparing mapped units orders strings by
+ * code point: surrogates (supplementary characters) move above
+ * U+E000..U+FFFF. Units below U+D800 are unchanged.
+ */
+#define SE_UTF16_CODE_POINT_ORDER(c)    ( (c) >= 0xE000 ? (c) - 0x800 : ((c) >= 0xD800 ? (c) + 0x2000 : (c)) )
+
+/*
+ * Reading a whole vector past the end of a NUL terminated string is only
+ * safe if it does not cross into the next page, 4K being the smallest
+ * page size of any supported platform.
+ */
+#define SE_PAGE_SIZE                    4096
+#define SE_CROSSES_PAGE(p, bytes)       ( ((size_t)(p) & (SE_PAGE_SIZE - 1)) > SE_PAGE_SIZE - (bytes) )
+
+/* Such reads are intended, keep AddressSanitizer from reporting them. */
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))
+    #define SE_NO_SANITIZE_ADDRESS      __attribute__((no_sanitize_address))
+#else
+    #define SE_NO_SANITIZE_ADDRESS
+#endif
+
+SE_NO_SANITIZE_ADDRESS
+static int se_utf16_mismatch(const seunichar16* str1, const seunichar16* str2, int len)
+/*
+ * Return the index of the first unit where str1 and str2 differ or str1
+ * ends, looking at no more than len units (len < 0 means no limit).
+ * Return len if the first len units are equal.
+ */
+{
+    int i;
+
+    SE_DEBUG_ASSERT(str1);
+    SE_DEBUG_ASSERT(str2);
+
+    i = 0;
+
+    #if SE_OPT_SSE2
+    {
+        __m128i a;
+        __m128i b;
+        int mask;
+
+        while (len < 0 || len - i >= 8)
+        {
+            if (SE_CROSSES_PAGE(str1 + i, 16) || SE_CROSSES_PAGE(str2 + i, 16))
+            {
+                if (str1[i] != str2[i] || !str1[i])
+                    return i;
+                i++;
+                continue;
+            }
+
+            a = _mm_loadu_si128((const __m128i*)(str1 + i));
+            b = _mm_loadu_si128((const __m128i*)(str2 + i));
+            mask = (~_mm_movemask_epi8(_mm_cmpeq_epi16(a, b)) & 0xFFFF) |
+                   _mm_movemask_epi8(_mm_cmpeq_epi16(a, _mm_setzero_si128()));
+            if (mask)
+                return i + (se_bit_scan_forward(mask) >> 1);
+            i += 8;
+        }
+    }
+    #endif
+
+    while (len < 0 || i < len)
+    {
+        if (str1[i] != str2[i] || !str1[i])
+            return i;
+        i++;
+    }
+
+    return i;
+}
+
+SE_API int se_utf16_strcmp(const seunichar16* str1, const seunichar16* str2)
+{
+    int i;
+
+    SE_DEBUG_ASSERT(str1);
+    SE_DEBUG_ASSERT(str2);
+
+    i = se_utf16_mismatch(str1, str2, -1);
+
+    return str1[i] - str2[i];
+}
+
+SE_API int se_utf16_strncmp(const seunichar16* str1, const seunichar16* str2, int len)
+{
+    int i;
+
+    if (len <= 0)
+        return 0;
+
+    SE_DEBUG_ASSERT(str1);
+    SE_DEBUG_ASSERT(str2);
+
+    i = se_utf16_mismatch(str1, str2, len);
+
+    if (i < len)
+        return str1[i] - str2[i];
+    else
+        return 0;
+}
+
+SE_API int se_utf16_strcmp_code_point_order(const seunichar16* str1, const seunichar16* str2)
+/*
+ * Compare two UTF-16 strings in code point order.
+ *
+ * se_utf16_strcmp() compares code units, which sorts supplementary
+ * characters before U+E000..U+FFFF. This function gives the same order
+ * as comparing the UTF-8 or UTF-32 forms of the strings, so keys sorted
+ * in either encoding agree without being converted. Only the first
+ * mismatching units are fixed up, the common prefix is compared as fast
+ * as se_utf16_strcmp().
+ */
+{
+    int i;
+    int c1;
+    int c2;
+
+    SE_DEBUG_ASSERT(str1);
+    SE_DEBUG_ASSERT(str2);
+
+    i = se_utf16_mismatch(str1, str2, -1);
+    c1 = str1[i];
+    c2 = str2[i];
+
+    return SE_UTF16_CODE_POINT_ORDER(c1) - SE_UTF16_CODE_POINT_ORDER(c2);
+}
+
+SE_API int se_utf16_strncmp_code_point_order(const seunichar16* str1, const seunichar16* str2, int len)
+{
+    int i;
+    int c1;
+    int c2;
+
+    if (len <= 0)
+        return 0;
+
+    SE_DEBUG_ASSERT(str1);
+    SE_DEBUG_ASSERT(str2);
+
+    i = se_utf16_mismatch(str1, str2, len);
+    if (i == len)
+        return 0;
+
+    c1 = str1[i];
+    c2 = str2[i];
+
+    return SE_UTF16_CODE_POINT_ORDER(c1) - SE_UTF16_CODE_POINT_ORDER(c2);
+}
+
+SE_API seunichar16* se_utf16_strdup(const seunichar16* str)
+{
+    seunichar16* new_str;
+
+    if (str)
+    {
+        int bytes = (se_utf16_str_len(str) + 1) * sizeof(seunichar16);
+        new_str = SE_MALLOC(bytes);
+        SE_STATS_ALLOC(SE_STATS_UTF16_STRDUP, bytes);
+        SE_TRACE_ALLOC(SE_STATS_UTF16_STRDUP, bytes, bytes, bytes);
+        memcpy(new_str, str, bytes);
+    }
+    else
+    {
+        new_str = 0;
+    }
+
+    return new_str;
+}
+
+SE_API seunichar16* se_utf16_strdup_n(const seunichar16* str, int len)
+{
+    seunichar16* new_str;
+
+    if (str)
+    {
+        SE_DEBUG_ASSERT(len >= 0);
+        new_str = SE_MALLOC((len + 1) * sizeof(seunichar16));
+        SE_STATS_ALLOC(SE_STATS_UTF16_STRDUP, (len + 1) * sizeof(seunichar16));
+        SE_TRACE_ALLOC(SE_STATS_UTF16_STRDUP, len * sizeof(seunichar16), (len + 1) * sizeof(seunichar16), (len + 1) * sizeof(seunichar16));
+        memcpy(new_str, str, len * sizeof(seunichar16));
+        new_str[len] = 0;
+    }
+    else
+    {
+        new_str = 0;
+    }
+
+    return new_str;
+}
+
+SE_API int se_safe_utf16_str_truncate(const seunichar16* str, int len, int max_len)
+/*
+ * Finds the longest prefix of str which is at most max_len units long
+ * and does not split a surrogate pair. Nothing is copied, str and the
+ * result describe the prefix.
+ */
+{
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str(str, len));
+    SE_DEBUG_ASSERT(max_len >= 0);
+
+    if (len < 0)
+        len = se_utf16_str_len(str);
+
+    if (len <= max_len)
+        return len;
+
+    if (max_len > 0 && SE_IS_HI_SURROGATE(str[max_len - 1]))
+        return max_len - 1;
+    else
+        return max_len;
+}
+
+#if SE_OPT_SURROGATE
+SE_API const seunichar16* se_safe_utf16_next_char(const seunichar16* str)
+{
+    SE_DEBUG_ASSERT(str);
+
+    if (SE_IS_HI_SURROGATE(str[0]))
+    {
+        SE_DEBUG_ASSERT(SE_IS_LO_SURROGATE(str[1]));
+        return str + 2;
+    }
+    else
+    {
+        SE_DEBUG_ASSERT(!SE_IS_LO_SURROGATE(str[0]));
+        SE_DEBUG_ASSERT(SE_IS_VALID_SCALAR_VALUE(str[0]));
+        return str + 1;
+    }
+}
+#endif
+
+#if SE_OPT_SURROGATE
+SE_API const seunichar16* se_safe_utf16_prev_char(const seunichar16* str)
+{
+    SE_DEBUG_ASSERT(str);
+
+    if (SE_IS_LO_SURROGATE(str[-1]))
+    {
+        SE_DEBUG_ASSERT(SE_IS_HI_SURROGATE(str[-2]));
+        return str - 2;
+    }
+    else
+    {
+        SE_DEBUG_ASSERT(!SE_IS_HI_SURROGATE(str[-1]));
+        SE_DEBUG_ASSERT(SE_IS_VALID_SCALAR_VALUE(str[-1]));
+        return str - 1;
+    }
+}
+#endif
+
+#if SE_OPT_SURROGATE
+SE_API const seunichar16* se_safe_utf16_offset_to_pointer(const seunichar16* str, int offset)
+{
+    if (offset > 0) 
+    {
+        while (offset)
+        {
+            str = se_safe_utf16_next_char(str);
+            offset--;
+        }
+    }
+    else
+    {
+        while (offset)
+        {
+            str = se_safe_utf16_prev_char(str);
+            offset++;
+        }
+    }
+
+    return str;
+}
+#endif
+
+#if SE_OPT_SURROGATE
+SE_API int se_safe_utf16_pointer_to_offset(const seunichar16* str, const seunichar16* pos)
+{
+    int offset = 0;    
+
+    if (pos < str) 
+    {
+        while (pos < str)
+        {
+            pos = se_safe_utf16_next_char(pos);
+            offset--;
+        }
+    }
+    else
     {
-        while (*p)
+        while (str < pos)
         {
-            h = (h << 5) - h + *p;
-            p++;
+            str = se_safe_utf16_next_char(str);
+            offset++;
         }
     }
 
-    return h;
+    return offset;
 }
+#endif
 
-SE_API char* se_utf8_strdup(const seunichar8* str)
+/***************************************************************************
+ *                                                                         *
+ * UTF-32 string manipulating.                                             *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API seunichar32* se_utf32_strdup(const seunichar32* str)
 {
-    seunichar8* new_str;
+    seunichar32* new_str;
 
     if (str)
     {
-        int bytes = se_utf8_str_len(str) + 1;
+        int bytes = (se_utf32_str_len(str) + 1) * sizeof(seunichar32);
         new_str = SE_MALLOC(bytes);
+        SE_STATS_ALLOC(SE_STATS_UTF32_STRDUP, bytes);
+        SE_TRACE_ALLOC(SE_STATS_UTF32_STRDUP, bytes, bytes, bytes);
         memcpy(new_str, str, bytes);
     }
     else
@@ -2468,15 +7137,17 @@ SE_API char* se_utf8_strdup(const seunichar8* str)
     return new_str;
 }
 
-SE_API char* se_utf8_strdup_n(const seunichar8* str, int len)
+SE_API seunichar32* se_utf32_strdup_n(const seunichar32* str, int len)
 {
-    seunichar8* new_str;
+    seunichar32* new_str;
 
     if (str)
     {
         SE_DEBUG_ASSERT(len >= 0);
-        new_str = SE_MALLOC(len + 1);
-        memcpy(new_str, str, len);
+        new_str = SE_MALLOC((len + 1) * sizeof(seunichar32));
+        SE_STATS_ALLOC(SE_STATS_UTF32_STRDUP, (len + 1) * sizeof(seunichar32));
+        SE_TRACE_ALLOC(SE_STATS_UTF32_STRDUP, len * sizeof(seunichar32), (len + 1) * sizeof(seunichar32), (len + 1) * sizeof(seunichar32));
+        memcpy(new_str, str, len * sizeof(seunichar32));
         new_str[len] = 0;
     }
     else
@@ -2487,418 +7158,590 @@ SE_API char* se_utf8_strdup_n(const seunichar8* str, int len)
     return new_str;
 }
 
-SE_API const seunichar8* se_safe_utf8_next_char(const seunichar8* str)
+/***************************************************************************
+ *                                                                         *
+ * Unicode string searching.                                               *
+ *                                                                         *
+ * Lengths are in code units, a negative length means NUL terminated.      *
+ * Functions return a pointer to the first match, or NULL if not found.    *
+ *                                                                         *
+ ***************************************************************************/
+
+static const unsigned char* se_utf8_find_units(const unsigned char* iter, const unsigned char* end, const unsigned char* units, int unit_count)
 {
-    static const unsigned char SE_UTF8_SKIP[256] =
-    {
-        /* 0x00 - 0x0F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
-        /* 0x10 - 0x1F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
-        /* 0x20 - 0x2F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
-        /* 0x30 - 0x3F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
-        /* 0x40 - 0x4F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
-        /* 0x50 - 0x5F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
-        /* 0x60 - 0x6F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
-        /* 0x70 - 0x7F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
-        /* 0x80 - 0x8F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
-        /* 0x90 - 0x9F */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
-        /* 0xA0 - 0xAF */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
-        /* 0xB0 - 0xBF */ 1,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
-        /* 0xC0 - 0xCF */ 1,1,2,2, 2,2,2,2, 2,2,2,2, 2,2,2,2,
-        /* 0xD0 - 0xDF */ 2,2,2,2, 2,2,2,2, 2,2,2,2, 2,2,2,2,
-        /* 0xE0 - 0xEF */ 3,3,3,3, 3,3,3,3, 3,3,3,3, 3,3,3,3,
-        /* 0xF0 - 0xFF */ 4,4,4,4, 4,1,1,1, 1,1,1,1, 1,1,1,1
-    };
+    const unsigned char* last;
 
-    #if SE_OPT_DEBUG
+    SE_DEBUG_ASSERT(unit_count > 0);
 
-        const unsigned char* iter;
-        const seunichar8* p1;
-        const seunichar8* p2;
+    if (end - iter < unit_count)
+        return 0;
 
-        SE_DEBUG_ASSERT(str);
+    if (unit_count == 1)
+        return memchr(iter, units[0], end - iter);
 
-        iter = (const unsigned char*)str;
-        if (iter[0] <= 0x7F)
-        {
-            p1 = str + 1;
-        }
-        else if (iter[0] >= 0xC2 && iter[0] <= 0xDF)
-        {
-            SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0xBF);
-            p1 = str + 2;
-        }
-        else if (iter[0] == 0xE0)
-        {
-            SE_DEBUG_ASSERT(iter[1] >= 0xA0 && iter[1] <= 0xBF);
-            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
-            p1 = str + 3;
-        }
-        else if (iter[0] >= 0xE1 && iter[0] <= 0xEC)
-        {
-            SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0xBF);
-            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
-            p1 = str + 3;
-        }
-        else if (iter[0] == 0xED)
-        {
-            SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0x9F);
-            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
-            p1 = str + 3;
-        }
-        else if (iter[0] >= 0xEE && iter[0] <= 0xEF)
-        {
-            SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0xBF);
-            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
-            p1 = str + 3;
-        }
-        else if (iter[0] == 0xF0)
-        {
-            SE_DEBUG_ASSERT(iter[1] >= 0x90 && iter[1] <= 0xBF);
-            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
-            SE_DEBUG_ASSERT(iter[3] >= 0x80 && iter[3] <= 0xBF);
-            p1 = str + 4;
-        }
-        else if (iter[0] >= 0xF1 && iter[0] <= 0xF3)
-        {
-            SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0xBF);
-            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
-            SE_DEBUG_ASSERT(iter[3] >= 0x80 && iter[3] <= 0xBF);
-            p1 = str + 4;
-        }
-        else if (iter[0] == 0xF4)
-        {
-            SE_DEBUG_ASSERT(iter[1] >= 0x80 && iter[1] <= 0x8F);
-            SE_DEBUG_ASSERT(iter[2] >= 0x80 && iter[2] <= 0xBF);
-            SE_DEBUG_ASSERT(iter[3] >= 0x80 && iter[3] <= 0xBF);
-            p1 = str + 4;
-        }
-        else
-        {
-            SE_DEBUG_ASSERT(FALSE);
-            p1 = str + 1;
+    last = end - unit_count;
+
+    #if SE_OPT_SSE2
+    {
+        __m128i first_unit;
+        __m128i last_unit;
+        __m128i hits;
+        unsigned int mask;
+        int i;
+
+        /*
+         * Compare the first and the last unit of the needle at 16
+         * candidate positions at once, and only verify the rest where
+         * both of them match.
+         */
+        first_unit = _mm_set1_epi8((char) units[0]);
+        last_unit = _mm_set1_epi8((char) units[unit_count - 1]);
+        while (iter + 16 <= last + 1)
+        {
+            hits = _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)iter), first_unit),
+                                 _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(iter + unit_count - 1)), last_unit));
+            mask = _mm_movemask_epi8(hits);
+            while (mask)
+            {
+                i = se_bit_scan_forward(mask);
+                if (memcmp(iter + i + 1, units + 1, unit_count - 2) == 0)
+                    return iter + i;
+                mask &= mask - 1;
+            }
+            iter += 16;
         }
+    }
+    #endif
 
-        p2 = str + SE_UTF8_SKIP[*(unsigned char*)str];
+    while (iter <= last)
+    {
+        iter = memchr(iter, units[0], last - iter + 1);
+        if (!iter)
+            return 0;
+        if (memcmp(iter + 1, units + 1, unit_count - 1) == 0)
+            return iter;
+        iter++;
+    }
 
-        SE_DEBUG_ASSERT(p1 == p2);
+    return 0;
+}
 
-        return p1;
+static const seunichar16* se_utf16_find_unit(const seunichar16* iter, const seunichar16* end, seunichar16 c)
+{
+    #if SE_OPT_SSE2
+    {
+        __m128i needle;
+        int mask;
 
-    #else
+        needle = _mm_set1_epi16((short) c);
+        while (iter + 8 <= end)
+        {
+            mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)iter), needle));
+            if (mask)
+                return iter + (se_bit_scan_forward(mask) >> 1);
+            iter += 8;
+        }
+    }
+    #endif
 
-        return str + SE_UTF8_SKIP[*(unsigned char*)str];
+    while (iter < end)
+    {
+        if (*iter == c)
+            return iter;
+        iter++;
+    }
 
-    #endif
+    return 0;
 }
 
-SE_API const seunichar8* se_safe_utf8_prev_char(const seunichar8* str)
+static const seunichar16* se_utf16_find_units(const seunichar16* iter, const seunichar16* end, const seunichar16* units, int unit_count)
 {
-#if SE_OPT_DEBUG
+    const seunichar16* last;
 
-    const seunichar8* p = str;
-
-    for (;;)
-    {
-        str--;
-        if ((*(const unsigned char*)str & 0xc0) != 0x80)
-            break;
-    }
+    SE_DEBUG_ASSERT(unit_count > 0);
 
-    SE_DEBUG_ASSERT(se_safe_utf8_next_char(str) == p);
+    if (end - iter < unit_count)
+        return 0;
 
-    return str;
+    if (unit_count == 1)
+        return se_utf16_find_unit(iter, end, units[0]);
 
-#else
+    last = end - unit_count;
 
-    for (;;)
+    #if SE_OPT_SSE2
     {
-        str--;
-        if ((*(const unsigned char*)str & 0xc0) != 0x80)
-            break;
+        __m128i first_unit;
+        __m128i last_unit;
+        __m128i hits;
+        unsigned int mask;
+        int i;
+
+        first_unit = _mm_set1_epi16((short) units[0]);
+        last_unit = _mm_set1_epi16((short) units[unit_count - 1]);
+        while (iter + 8 <= last + 1)
+        {
+            hits = _mm_and_si128(_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)iter), first_unit),
+                                 _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(iter + unit_count - 1)), last_unit));
+            mask = _mm_movemask_epi8(hits);
+            while (mask)
+            {
+                i = se_bit_scan_forward(mask) >> 1;
+                if (memcmp(iter + i + 1, units + 1, (unit_count - 2) * sizeof(seunichar16)) == 0)
+                    return iter + i;
+                mask &= ~(3u << (i * 2));
+            }
+            iter += 8;
+        }
     }
+    #endif
 
-    return str;
+    while (iter <= last)
+    {
+        iter = se_utf16_find_unit(iter, last + 1, units[0]);
+        if (!iter)
+            return 0;
+        if (memcmp(iter + 1, units + 1, (unit_count - 1) * sizeof(seunichar16)) == 0)
+            return iter;
+        iter++;
+    }
 
-#endif
+    return 0;
 }
 
-SE_API const seunichar8* se_safe_utf8_offset_to_pointer(const seunichar8* str, int offset)
-/*
- * str: a UTF-8 encoded string
- * offset: a character offset within str
- * 
- * Converts from an integer character offset to a pointer to a position
- * within the string.
- * 
- * This function allows to pass a negative offset to
- * step backwards. It is usually worth stepping backwards from the end
- * instead of forwards if offset is in the last fourth of the string, 
- * since moving forward is about 3 times faster than moving backward.
- * 
- * Return: the resulting pointer
- */
+static const seunichar32* se_utf32_find_unit(const seunichar32* iter, const seunichar32* end, seunichar32 c)
 {
-    if (offset > 0) 
+    #if SE_OPT_SSE2
     {
-        while (offset)
+        __m128i needle;
+        int mask;
+
+        needle = _mm_set1_epi32((int) c);
+        while (iter + 4 <= end)
         {
-            str = se_safe_utf8_next_char(str);
-            offset--;
+            mask = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)iter), needle));
+            if (mask)
+                return iter + (se_bit_scan_forward(mask) >> 2);
+            iter += 4;
         }
     }
-    else
+    #endif
+
+    while (iter < end)
     {
-        while (offset)
-        {
-            str = se_safe_utf8_prev_char(str);
-            offset++;
-        }
+        if (*iter == c)
+            return iter;
+        iter++;
     }
 
-    return str;
+    return 0;
 }
 
-SE_API int se_safe_utf8_pointer_to_offset(const seunichar8* str, const seunichar8* pos)
-/*
- * str: a UTF-8 encoded string
- * pos: a pointer to a position within str
- * 
- * Converts from a pointer to position within a string to a integer
- * character offset.
- *
- * This function allows pos to be before str, and returns
- * a negative offset in this case.
- * 
- * Return: the resulting character offset
- */
+static const seunichar32* se_utf32_find_units(const seunichar32* iter, const seunichar32* end, const seunichar32* units, int unit_count)
 {
-    int offset = 0;    
+    const seunichar32* last;
 
-    if (pos < str) 
+    SE_DEBUG_ASSERT(unit_count > 0);
+
+    if (end - iter < unit_count)
+        return 0;
+
+    if (unit_count == 1)
+        return se_utf32_find_unit(iter, end, units[0]);
+
+    last = end - unit_count;
+
+    #if SE_OPT_SSE2
     {
-        while (pos < str)
-        {
-            pos = se_safe_utf8_next_char(pos);
-            offset--;
+        __m128i first_unit;
+        __m128i last_unit;
+        __m128i hits;
+        unsigned int mask;
+        int i;
+
+        first_unit = _mm_set1_epi32((int) units[0]);
+        last_unit = _mm_set1_epi32((int) units[unit_count - 1]);
+        while (iter + 4 <= last + 1)
+        {
+            hits = _mm_and_si128(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)iter), first_unit),
+                                 _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(iter + unit_count - 1)), last_unit));
+            mask = _mm_movemask_epi8(hits);
+            while (mask)
+            {
+                i = se_bit_scan_forward(mask) >> 2;
+                if (memcmp(iter + i + 1, units + 1, (unit_count - 2) * sizeof(seunichar32)) == 0)
+                    return iter + i;
+                mask &= ~(0xFu << (i * 4));
+            }
+            iter += 4;
         }
     }
-    else
+    #endif
+
+    while (iter <= last)
     {
-        while (str < pos)
-        {
-            str = se_safe_utf8_next_char(str);
-            offset++;
-        }
+        iter = se_utf32_find_unit(iter, last + 1, units[0]);
+        if (!iter)
+            return 0;
+        if (memcmp(iter + 1, units + 1, (unit_count - 1) * sizeof(seunichar32)) == 0)
+            return iter;
+        iter++;
     }
 
-    return offset;
+    return 0;
+}
+
+SE_API const seunichar8* se_utf8_str_find_char(const seunichar8* str, int len, seunichar8 c)
+/*
+ * str:
+ *      The UTF-8 string to search.
+ *
+ * len:
+ *      The byte length of str.
+ *      If len < 0, then the string is NUL terminated.
+ *
+ * c:
+ *      The code unit to look for. A match is only guaranteed to be at
+ *      a character boundary if c is an ASCII character, use
+ *      se_safe_utf8_str_find_unichar() to look for other characters.
+ *
+ * Return:
+ *      A pointer to the first occurrence of c, or NULL if not found.
+ */
+{
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len(str);
+
+    return memchr(str, (unsigned char) c, len);
 }
 
-/***************************************************************************
- *                                                                         *
- * UTF-16 string manipulating.                                             *
- *                                                                         *
- ***************************************************************************/
+SE_API const seunichar16* se_utf16_str_find_char(const seunichar16* str, int len, seunichar16 c)
+{
+    SE_DEBUG_ASSERT(str);
 
-SE_API int se_utf16_strcmp(const seunichar16* str1, const seunichar16* str2)
+    if (len < 0)
+        len = se_utf16_str_len(str);
+
+    return se_utf16_find_unit(str, str + len, c);
+}
+
+SE_API const seunichar32* se_utf32_str_find_char(const seunichar32* str, int len, seunichar32 c)
 {
-    SE_DEBUG_ASSERT(str1);
-    SE_DEBUG_ASSERT(str2);
+    SE_DEBUG_ASSERT(str);
 
-    while (*str1 && *str2 && *str1 == *str2)
-    {
-        str1++;
-        str2++;
-    }
+    if (len < 0)
+        len = se_utf32_str_len(str);
 
-    return *str1 - *str2;
+    return se_utf32_find_unit(str, str + len, c);
 }
 
-SE_API int se_utf16_strncmp(const seunichar16* str1, const seunichar16* str2, int len)
+SE_API const seunichar8* se_safe_utf8_str_find_unichar(const seunichar8* str, int len, seunichar c)
+/*
+ * Encode c as UTF-8 and search for it in a well-formed UTF-8 string.
+ * Since UTF-8 is self-synchronizing, the match is always at a character
+ * boundary.
+ */
 {
-    if (len <= 0)
-        return 0;
+    seunichar8 buf[4];
 
-    SE_DEBUG_ASSERT(str1);
-    SE_DEBUG_ASSERT(str2);
+    SE_DEBUG_ASSERT(str);
 
-    while (len && *str1 && *str2 && *str1 == *str2)
-    {
-        len--;
-        str1++;
-        str2++;
-    }
+    if (len < 0)
+        len = se_utf8_str_len(str);
 
-    if (len)
-        return *str1 - *str2;
-    else
-        return 0;
+    return (const seunichar8*) se_utf8_find_units((const unsigned char*)str, (const unsigned char*)str + len,
+                                                  (const unsigned char*)buf, se_safe_unichar_to_utf8(c, buf));
 }
 
-SE_API seunichar16* se_utf16_strdup(const seunichar16* str)
+SE_API const seunichar16* se_safe_utf16_str_find_unichar(const seunichar16* str, int len, seunichar c)
 {
-    seunichar16* new_str;
+    seunichar16 buf[2];
 
-    if (str)
-    {
-        int bytes = (se_utf16_str_len(str) + 1) * sizeof(seunichar16);
-        new_str = SE_MALLOC(bytes);
-        memcpy(new_str, str, bytes);
-    }
-    else
-    {
-        new_str = 0;
-    }
+    SE_DEBUG_ASSERT(str);
 
-    return new_str;
+    if (len < 0)
+        len = se_utf16_str_len(str);
+
+    return se_utf16_find_units(str, str + len, buf, se_safe_unichar_to_utf16(c, buf));
 }
 
-SE_API seunichar16* se_utf16_strdup_n(const seunichar16* str, int len)
+SE_API const seunichar8* se_utf8_str_find_str(const seunichar8* str, int len, const seunichar8* sub_str, int sub_len)
+/*
+ * Search for the first occurrence of sub_str in str. If both strings are
+ * well-formed, the match is always at a character boundary.
+ *
+ * An empty sub_str matches at the start of str.
+ */
 {
-    seunichar16* new_str;
+    SE_DEBUG_ASSERT(str);
+    SE_DEBUG_ASSERT(sub_str);
 
-    if (str)
-    {
-        SE_DEBUG_ASSERT(len >= 0);
-        new_str = SE_MALLOC((len + 1) * sizeof(seunichar16));
-        memcpy(new_str, str, len * sizeof(seunichar16));
-        new_str[len] = 0;
-    }
-    else
-    {
-        new_str = 0;
-    }
+    if (len < 0)
+        len = se_utf8_str_len(str);
 
-    return new_str;
+    if (sub_len < 0)
+        sub_len = se_utf8_str_len(sub_str);
+
+    if (sub_len == 0)
+        return str;
+
+    return (const seunichar8*) se_utf8_find_units((const unsigned char*)str, (const unsigned char*)str + len,
+                                                  (const unsigned char*)sub_str, sub_len);
 }
 
-#if SE_OPT_SURROGATE
-SE_API const seunichar16* se_safe_utf16_next_char(const seunichar16* str)
+SE_API const seunichar16* se_utf16_str_find_str(const seunichar16* str, int len, const seunichar16* sub_str, int sub_len)
 {
     SE_DEBUG_ASSERT(str);
+    SE_DEBUG_ASSERT(sub_str);
 
-    if (SE_IS_HI_SURROGATE(str[0]))
-    {
-        SE_DEBUG_ASSERT(SE_IS_LO_SURROGATE(str[1]));
-        return str + 2;
-    }
-    else
-    {
-        SE_DEBUG_ASSERT(!SE_IS_LO_SURROGATE(str[0]));
-        SE_DEBUG_ASSERT(SE_IS_VALID_SCALAR_VALUE(str[0]));
-        return str + 1;
-    }
+    if (len < 0)
+        len = se_utf16_str_len(str);
+
+    if (sub_len < 0)
+        sub_len = se_utf16_str_len(sub_str);
+
+    if (sub_len == 0)
+        return str;
+
+    return se_utf16_find_units(str, str + len, sub_str, sub_len);
 }
-#endif
 
-#if SE_OPT_SURROGATE
-SE_API const seunichar16* se_safe_utf16_prev_char(const seunichar16* str)
+SE_API const seunichar32* se_utf32_str_find_str(const seunichar32* str, int len, const seunichar32* sub_str, int sub_len)
 {
     SE_DEBUG_ASSERT(str);
+    SE_DEBUG_ASSERT(sub_str);
 
-    if (SE_IS_LO_SURROGATE(str[-1]))
-    {
-        SE_DEBUG_ASSERT(SE_IS_HI_SURROGATE(str[-2]));
-        return str - 2;
-    }
-    else
-    {
-        SE_DEBUG_ASSERT(!SE_IS_HI_SURROGATE(str[-1]));
-        SE_DEBUG_ASSERT(SE_IS_VALID_SCALAR_VALUE(str[-1]));
-        return str - 1;
-    }
+    if (len < 0)
+        len = se_utf32_str_len(str);
+
+    if (sub_len < 0)
+        sub_len = se_utf32_str_len(sub_str);
+
+    if (sub_len == 0)
+        return str;
+
+    return se_utf32_find_units(str, str + len, sub_str, sub_len);
 }
-#endif
 
-#if SE_OPT_SURROGATE
-SE_API const seunichar16* se_safe_utf16_offset_to_pointer(const seunichar16* str, int offset)
+SE_API const seunichar8* se_safe_utf8_str_find_any(const seunichar8* str, int len, const seunichar8* set, int set_len)
+/*
+ * str:
+ *      The well-formed UTF-8 string to search.
+ *
+ * set:
+ *      A well-formed UTF-8 string holding the characters to look for.
+ *
+ * Return:
+ *      A pointer to the first character of str which is also in set,
+ *      or NULL if there is none.
+ */
 {
-    if (offset > 0) 
+    const unsigned char* iter;
+    const unsigned char* end;
+    const unsigned char* next;
+    const unsigned char* set_iter;
+    const unsigned char* set_end;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str(str, len));
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str(set, set_len));
+
+    if (len < 0)
+        len = se_utf8_str_len(str);
+
+    if (set_len < 0)
+        set_len = se_utf8_str_len(set);
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+    set_end = (const unsigned char*)set + set_len;
+
+    for (set_iter = (const unsigned char*)set; set_iter < set_end; set_iter++)
     {
-        while (offset)
+        if (*set_iter > 0x7F)
+            break;
+    }
+
+    #if SE_OPT_SSE2
+        /*
+         * A small ASCII set is matched against 16 bytes at once. Lead and
+         * continuation bytes never equal an ASCII byte, so a match is
+         * always at a character boundary.
+         */
+        if (set_iter == set_end && set_len <= 16)
         {
-            str = se_safe_utf16_next_char(str);
-            offset--;
+            __m128i units[16];
+            __m128i block;
+            __m128i hits;
+            int mask;
+            int i;
+
+            for (i = 0; i < set_len; i++)
+                units[i] = _mm_set1_epi8(set[i]);
+
+            while (iter + 16 <= end)
+            {
+                block = _mm_loadu_si128((const __m128i*)iter);
+                hits = _mm_setzero_si128();
+                for (i = 0; i < set_len; i++)
+                    hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, units[i]));
+                mask = _mm_movemask_epi8(hits);
+                if (mask)
+                    return (const seunichar8*)iter + se_bit_scan_forward(mask);
+                iter += 16;
+            }
         }
-    }
-    else
+    #endif
+
+    if (set_iter == set_end)
     {
-        while (offset)
+        while (iter < end)
         {
-            str = se_safe_utf16_prev_char(str);
-            offset++;
+            if (memchr(set, *iter, set_len))
+                return (const seunichar8*)iter;
+            iter++;
         }
+
+        return 0;
     }
 
-    return str;
+    while (iter < end)
+    {
+        next = (const unsigned char*)se_safe_utf8_next_char((const seunichar8*)iter);
+        if (se_utf8_find_units((const unsigned char*)set, set_end, iter, next - iter))
+            return (const seunichar8*)iter;
+        iter = next;
+    }
+
+    return 0;
 }
-#endif
 
-#if SE_OPT_SURROGATE
-SE_API int se_safe_utf16_pointer_to_offset(const seunichar16* str, const seunichar16* pos)
+SE_API const seunichar16* se_safe_utf16_str_find_any(const seunichar16* str, int len, const seunichar16* set, int set_len)
 {
-    int offset = 0;    
+    const seunichar16* iter;
+    const seunichar16* end;
+    const seunichar16* set_iter;
+    const seunichar16* set_end;
 
-    if (pos < str) 
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str(str, len));
+    SE_DEBUG_ASSERT(se_is_valid_utf16_str(set, set_len));
+
+    if (len < 0)
+        len = se_utf16_str_len(str);
+
+    if (set_len < 0)
+        set_len = se_utf16_str_len(set);
+
+    iter = str;
+    end = iter + len;
+    set_end = set + set_len;
+
+    for (set_iter = set; set_iter < set_end; set_iter++)
     {
-        while (pos < str)
+        if (SE_IS_SURROGATE(*set_iter))
+            break;
+    }
+
+    #if SE_OPT_SSE2
+        /*
+         * A small set without surrogates is matched against 8 units at
+         * once. It can never match half of a surrogate pair.
+         */
+        if (set_iter == set_end && set_len <= 8)
         {
-            pos = se_safe_utf16_next_char(pos);
-            offset--;
+            __m128i units[8];
+            __m128i block;
+            __m128i hits;
+            int mask;
+            int i;
+
+            for (i = 0; i < set_len; i++)
+                units[i] = _mm_set1_epi16((short) set[i]);
+
+            while (iter + 8 <= end)
+            {
+                block = _mm_loadu_si128((const __m128i*)iter);
+                hits = _mm_setzero_si128();
+                for (i = 0; i < set_len; i++)
+                    hits = _mm_or_si128(hits, _mm_cmpeq_epi16(block, units[i]));
+                mask = _mm_movemask_epi8(hits);
+                if (mask)
+                    return iter + (se_bit_scan_forward(mask) >> 1);
+                iter += 8;
+            }
         }
-    }
-    else
+    #endif
+
+    while (iter < end)
     {
-        while (str < pos)
+        if (SE_IS_HI_SURROGATE(iter[0]))
         {
-            str = se_safe_utf16_next_char(str);
-            offset++;
+            if (se_utf16_find_units(set, set_end, iter, 2))
+                return iter;
+            iter += 2;
+        }
+        else
+        {
+            if (se_utf16_find_unit(set, set_end, iter[0]))
+                return iter;
+            iter++;
         }
     }
 
-    return offset;
+    return 0;
 }
-#endif
-
-/***************************************************************************
- *                                                                         *
- * UTF-32 string manipulating.                                             *
- *                                                                         *
- ***************************************************************************/
 
-SE_API seunichar32* se_utf32_strdup(const seunichar32* str)
+SE_API const seunichar32* se_utf32_str_find_any(const seunichar32* str, int len, const seunichar32* set, int set_len)
 {
-    seunichar32* new_str;
+    const seunichar32* iter;
+    const seunichar32* end;
+    const seunichar32* set_end;
 
-    if (str)
-    {
-        int bytes = (se_utf32_str_len(str) + 1) * sizeof(seunichar16);
-        new_str = SE_MALLOC(bytes);
-        memcpy(new_str, str, bytes);
-    }
-    else
-    {
-        new_str = 0;
-    }
+    SE_DEBUG_ASSERT(str);
+    SE_DEBUG_ASSERT(set);
 
-    return new_str;
-}
+    if (len < 0)
+        len = se_utf32_str_len(str);
 
-SE_API seunichar32* se_utf32_strdup_n(const seunichar32* str, int len)
-{
-    seunichar32* new_str;
+    if (set_len < 0)
+        set_len = se_utf32_str_len(set);
 
-    if (str)
-    {
-        SE_DEBUG_ASSERT(len >= 0);
-        new_str = SE_MALLOC((len + 1) * sizeof(seunichar32));
-        memcpy(new_str, str, len * sizeof(seunichar32));
-        new_str[len] = 0;
-    }
-    else
+    iter = str;
+    end = iter + len;
+    set_end = set + set_len;
+
+    #if SE_OPT_SSE2
+        if (set_len <= 8)
+        {
+            __m128i units[8];
+            __m128i block;
+            __m128i hits;
+            int mask;
+            int i;
+
+            for (i = 0; i < set_len; i++)
+                units[i] = _mm_set1_epi32((int) set[i]);
+
+            while (iter + 4 <= end)
+            {
+                block = _mm_loadu_si128((const __m128i*)iter);
+                hits = _mm_setzero_si128();
+                for (i = 0; i < set_len; i++)
+                    hits = _mm_or_si128(hits, _mm_cmpeq_epi32(block, units[i]));
+                mask = _mm_movemask_epi8(hits);
+                if (mask)
+                    return iter + (se_bit_scan_forward(mask) >> 2);
+                iter += 4;
+            }
+        }
+    #endif
+
+    while (iter < end)
     {
-        new_str = 0;
+        if (se_utf32_find_unit(set, set_end, iter[0]))
+            return iter;
+        iter++;
     }
 
-    return new_str;
+    return 0;
 }
@@ -0,0 +1,1258 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+#ifndef SE_UNICODE_H
+    #include "se-unicode.h"
+#endif
+
+#ifndef SE_UTILS_H
+    #include "se-utils.h"
+#endif
+
+#ifndef SE_UNICODE_EXT_H
+    #include "se-unicode-ext.h"
+#endif
+
+/*
+ * Conversion between Unicode and the variants of UTF-8 used for interop:
+ *
+ *   - WTF-8 is UTF-8 that can also hold lone surrogates, as 3 byte
+ *     sequences, so any string of 16 bit units, like a Windows file name,
+ *     converts to it and back without loss. A surrogate pair must be
+ *     encoded as a 4 byte sequence, as in UTF-8.
+ *
+ *   - CESU-8 encodes each UTF-16 unit on its own, so a supplementary code
+ *     point takes two 3 byte sequences, one per surrogate. Lone surrogates
+ *     and 4 byte sequences are ill-formed.
+ *
+ *   - Modified UTF-8, as used by Java and JNI, is CESU-8 that can also
+ *     hold lone surrogates, and that encodes U+0000 as 0xC0 0x80, so it
+ *     never contains a NUL byte.
+ *
+ * Input in a variant is un-safe: an ill-formed sequence is replaced by
+ * U+FFFD and decoding resumes at its second byte, as in
+ * se_unsafe_utf8_to_safe_utf16(). The conversions to UTF-16 without
+ * "safe" in their names keep lone surrogates, and the conversions from
+ * UTF-16 without "safe" take any string of 16 bit units. The others
+ * replace lone surrogates, or take well-formed input.
+ *
+ * Well-formed UTF-8 is also WTF-8, so there is no conversion to WTF-8
+ * from UTF-8.
+ *
+ * As in se-unicode-string.c, the output length is counted by a first
+ * pass, and the output is allocated at its exact size. ASCII is the same
+ * in all the variants, except for U+0000 in Modified UTF-8, so runs of 16
+ * ASCII characters are copied at once.
+ */
+
+/* As in se-unicode-string.c */
+#ifndef SE_OPT_SSE2
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define SE_OPT_SSE2 1
+    #else
+        #define SE_OPT_SSE2 0
+    #endif
+#endif
+
+#if SE_OPT_SSE2
+    #include <emmintrin.h>
+#endif
+
+#define SE_REPLACEMENT_CHAR                 0xFFFD
+
+#define SE_IS_SURROGATE(c)          ( (c) >= 0xD800 && (c) < 0xE000 )
+#define SE_IS_HI_SURROGATE(c)       ( (c) >= 0xD800 && (c) < 0xDC00 )
+#define SE_IS_LO_SURROGATE(c)       ( (c) >= 0xDC00 && (c) < 0xE000 )
+#define SE_SURROGATE_VALUE(hi, lo)  (seunichar32) ( ((((hi) & 0x3FF) << 10) | ((lo) & 0x3FF)) + 0x10000 )
+
+#define SE_WTF8                     0
+#define SE_CESU8                    1
+#define SE_MUTF8                    2
+
+/***************************************************************************
+ *                                                                         *
+ * Characters.                                                             *
+ *                                                                         *
+ ***************************************************************************/
+
+static int se_variant_decode_char(int variant, const unsigned char* iter, const unsigned char* end, seunichar32* c)
+/*
+ * Decode the non-ASCII character at iter into *c, which is a lone
+ * surrogate where the variant has them, and return its byte length, or 0
+ * if it is ill-formed.
+ */
+{
+    seunichar32 lo;
+
+    if (iter[0] == 0xC0 && variant == SE_MUTF8)
+    {
+        if (end - iter < 2 || iter[1] != 0x80)
+            return 0;
+        *c = 0;
+        return 2;
+    }
+    else if (iter[0] >= 0xC2 && iter[0] <= 0xDF)
+    {
+        if (end - iter < 2 || (iter[1] & 0xC0) != 0x80)
+            return 0;
+        *c = ((iter[0] & 0x1F) << 6) | (iter[1] & 0x3F);
+        return 2;
+    }
+    else if (iter[0] >= 0xE0 && iter[0] <= 0xEF)
+    {
+        if (end - iter < 3 || (iter[1] & 0xC0) != 0x80 || (iter[2] & 0xC0) != 0x80 || (iter[0] == 0xE0 && iter[1] < 0xA0))
+            return 0;
+        *c = ((iter[0] & 0x0F) << 12) | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F);
+
+        if (!SE_IS_SURROGATE(*c))
+            return 3;
+
+        /* A surrogate pair is two sequences in CESU-8, and one in WTF-8 */
+        if (SE_IS_HI_SURROGATE(*c) && end - iter >= 6 && iter[3] == 0xED && iter[4] >= 0xB0 && iter[4] <= 0xBF && (iter[5] & 0xC0) == 0x80)
+        {
+            if (variant == SE_WTF8)
+                return 0;
+            lo = 0xD000 | ((iter[4] & 0x3F) << 6) | (iter[5] & 0x3F);
+            *c = SE_SURROGATE_VALUE(*c, lo);
+            return 6;
+        }
+
+        return variant == SE_CESU8 ? 0 : 3;
+    }
+    else if (iter[0] >= 0xF0 && iter[0] <= 0xF4 && variant == SE_WTF8)
+    {
+        if (end - iter < 4 || (iter[1] & 0xC0) != 0x80 || (iter[2] & 0xC0) != 0x80 || (iter[3] & 0xC0) != 0x80)
+            return 0;
+        if ((iter[0] == 0xF0 && iter[1] < 0x90) || (iter[0] == 0xF4 && iter[1] > 0x8F))
+            return 0;
+        *c = ((iter[0] & 0x07) << 18) | ((iter[1] & 0x3F) << 12) | ((iter[2] & 0x3F) << 6) | (iter[3] & 0x3F);
+        return 4;
+    }
+
+    return 0;
+}
+
+static int se_variant_encode_char(int variant, seunichar32 c, unsigned char* buf)
+/*
+ * Write the non-ASCII code point or lone surrogate c at buf, if it is not
+ * NULL, and return its byte length.
+ */
+{
+    if (c == 0)
+    {
+        SE_DEBUG_ASSERT(variant == SE_MUTF8);
+        if (buf)
+        {
+            buf[0] = 0xC0;
+            buf[1] = 0x80;
+        }
+        return 2;
+    }
+    else if (c <= 0x7FF)
+    {
+        if (buf)
+        {
+            buf[0] = (unsigned char) (0xC0 | (c >> 6));
+            buf[1] = (unsigned char) (0x80 | (c & 0x3F));
+        }
+        return 2;
+    }
+    else if (c <= 0xFFFF)
+    {
+        if (buf)
+        {
+            buf[0] = (unsigned char) (0xE0 | (c >> 12));
+            buf[1] = (unsigned char) (0x80 | ((c >> 6) & 0x3F));
+            buf[2] = (unsigned char) (0x80 | (c & 0x3F));
+        }
+        return 3;
+    }
+    else if (variant == SE_WTF8)
+    {
+        if (buf)
+        {
+            buf[0] = (unsigned char) (0xF0 | (c >> 18));
+            buf[1] = (unsigned char) (0x80 | ((c >> 12) & 0x3F));
+            buf[2] = (unsigned char) (0x80 | ((c >> 6) & 0x3F));
+            buf[3] = (unsigned char) (0x80 | (c & 0x3F));
+        }
+        return 4;
+    }
+    else
+    {
+        if (buf)
+        {
+            se_variant_encode_char(variant, 0xD800 | ((c - 0x10000) >> 10), buf);
+            se_variant_encode_char(variant, 0xDC00 | (c & 0x3FF), buf + 3);
+        }
+        return 6;
+    }
+}
+
+static const unsigned char* se_variant_safe_utf8_next(const unsigned char* iter, seunichar32* c)
+/*
+ * Decode the character at iter of a well-formed UTF-8 string into *c, and
+ * return the start of the next one.
+ */
+{
+    if (iter[0] <= 0x7F)
+    {
+        *c = iter[0];
+        return iter + 1;
+    }
+    else if (iter[0] <= 0xDF)
+    {
+        *c = ((iter[0] & 0x1F) << 6) | (iter[1] & 0x3F);
+        return iter + 2;
+    }
+    else if (iter[0] <= 0xEF)
+    {
+        *c = ((iter[0] & 0x0F) << 12) | ((iter[1] & 0x3F) << 6) | (iter[2] & 0x3F);
+        return iter + 3;
+    }
+    else
+    {
+        SE_DEBUG_ASSERT(iter[0] <= 0xF4);
+        *c = ((iter[0] & 0x07) << 18) | ((iter[1] & 0x3F) << 12) | ((iter[2] & 0x3F) << 6) | (iter[3] & 0x3F);
+        return iter + 4;
+    }
+}
+
+static const seunichar16* se_variant_utf16_next(const seunichar16* iter, const seunichar16* end, seunichar32* c)
+/*
+ * Decode the character at iter of a UTF-16 string into *c, which is a
+ * lone surrogate if the string is ill-formed there, and return the start
+ * of the next one.
+ */
+{
+    if (SE_IS_HI_SURROGATE(iter[0]) && iter + 1 < end && SE_IS_LO_SURROGATE(iter[1]))
+    {
+        *c = SE_SURROGATE_VALUE(iter[0], iter[1]);
+        return iter + 2;
+    }
+
+    *c = iter[0];
+    return iter + 1;
+}
+
+#if SE_OPT_SSE2
+static sebool se_variant_ascii_16(int variant, __m128i block)
+/*
+ * Return whether the 16 bytes of block are the same in the variant as in
+ * ASCII.
+ */
+{
+    if (_mm_movemask_epi8(block))
+        return FALSE;
+
+    return variant != SE_MUTF8 || !_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_setzero_si128()));
+}
+
+static sebool se_variant_utf16_ascii_16(int variant, const seunichar16* iter, __m128i* block)
+/*
+ * Pack the 16 units at iter into *block and return whether they are the
+ * same in the variant as in ASCII.
+ */
+{
+    __m128i lo;
+    __m128i hi;
+
+    lo = _mm_loadu_si128((const __m128i*)iter);
+    hi = _mm_loadu_si128((const __m128i*)(iter + 8));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(lo, hi), _mm_set1_epi16((short) 0xFF80)), _mm_setzero_si128())) != 0xFFFF)
+        return FALSE;
+
+    *block = _mm_packus_epi16(lo, hi);
+
+    return se_variant_ascii_16(variant, *block);
+}
+#endif
+
+/***************************************************************************
+ *                                                                         *
+ * Strings.                                                                *
+ *                                                                         *
+ * Each conversion is done by a pair of functions over any of the          *
+ * variants, one counting the length of the output and one writing it.     *
+ * The UTF-16 outputs keep lone surrogates if keep is TRUE.                *
+ *                                                                         *
+ ***************************************************************************/
+
+static sebool se_variant_is_valid(int variant, const unsigned char* iter, const unsigned char* end)
+{
+    seunichar32 c;
+    int len;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && se_variant_ascii_16(variant, _mm_loadu_si128((const __m128i*)iter)))
+                {
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            if (iter[0] == 0 && variant == SE_MUTF8)
+                return FALSE;
+            iter++;
+        }
+        else if ((len = se_variant_decode_char(variant, iter, end, &c)) != 0)
+        {
+            iter += len;
+        }
+        else
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static ptrdiff_t se_variant_utf8_len(int variant, const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in bytes of the string from iter to end once
+ * converted to UTF-8, lone surrogates replaced.
+ */
+{
+    ptrdiff_t new_str_len;
+    seunichar32 c;
+    int len;
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && se_variant_ascii_16(variant, _mm_loadu_si128((const __m128i*)iter)))
+                {
+                    new_str_len += 16;
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            new_str_len += iter[0] == 0 && variant == SE_MUTF8 ? 3 : 1;
+            iter++;
+        }
+        else if ((len = se_variant_decode_char(variant, iter, end, &c)) != 0)
+        {
+            new_str_len += c <= 0x7F ? 1 : c <= 0x7FF ? 2 : c <= 0xFFFF ? 3 : 4;
+            iter += len;
+        }
+        else
+        {
+            new_str_len += 3;
+            iter++;
+        }
+    }
+
+    return new_str_len;
+}
+
+static unsigned char* se_variant_utf8_fill(int variant, const unsigned char* iter, const unsigned char* end, unsigned char* new_str_iter)
+/*
+ * Convert the string from iter to end into new_str_iter, which has room
+ * for se_variant_utf8_len() bytes, and return the end of the output.
+ */
+{
+    seunichar32 c;
+    int len;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16)
+                {
+                    __m128i block;
+
+                    block = _mm_loadu_si128((const __m128i*)iter);
+                    if (se_variant_ascii_16(variant, block))
+                    {
+                        _mm_storeu_si128((__m128i*)new_str_iter, block);
+                        new_str_iter += 16;
+                        iter += 16;
+                        continue;
+                    }
+                }
+            #endif
+            if (iter[0] == 0 && variant == SE_MUTF8)
+                goto ill_formed;
+            *new_str_iter++ = *iter++;
+            continue;
+        }
+
+        len = se_variant_decode_char(variant, iter, end, &c);
+        if (len == 0)
+        {
+ill_formed:
+            c = SE_REPLACEMENT_CHAR;
+            len = 1;
+        }
+        else if (SE_IS_SURROGATE(c))
+        {
+            c = SE_REPLACEMENT_CHAR;
+        }
+
+        if (c <= 0x7F)
+        {
+            *new_str_iter++ = (unsigned char) c;
+        }
+        else
+        {
+            /* As UTF-8 */
+            new_str_iter += se_variant_encode_char(SE_WTF8, c, new_str_iter);
+        }
+        iter += len;
+    }
+
+    return new_str_iter;
+}
+
+static ptrdiff_t se_variant_utf16_len(int variant, const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in UTF-16 units of the string from iter to end once
+ * converted to UTF-16.
+ */
+{
+    ptrdiff_t new_str_len;
+    seunichar32 c;
+    int len;
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)iter)))
+                {
+                    new_str_len += 16;
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            new_str_len++;
+            iter++;
+        }
+        else if ((len = se_variant_decode_char(variant, iter, end, &c)) != 0)
+        {
+            new_str_len += c <= 0xFFFF ? 1 : 2;
+            iter += len;
+        }
+        else
+        {
+            new_str_len++;
+            iter++;
+        }
+    }
+
+    return new_str_len;
+}
+
+static seunichar16* se_variant_utf16_fill(int variant, sebool keep, const unsigned char* iter, const unsigned char* end, seunichar16* new_str_iter)
+/*
+ * Convert the string from iter to end into new_str_iter, which has room
+ * for se_variant_utf16_len() units, and return the end of the output.
+ */
+{
+    seunichar32 c;
+    int len;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16)
+                {
+                    __m128i block;
+
+                    block = _mm_loadu_si128((const __m128i*)iter);
+                    if (se_variant_ascii_16(variant, block))
+                    {
+                        _mm_storeu_si128((__m128i*)new_str_iter, _mm_unpacklo_epi8(block, _mm_setzero_si128()));
+                        _mm_storeu_si128((__m128i*)(new_str_iter + 8), _mm_unpackhi_epi8(block, _mm_setzero_si128()));
+                        new_str_iter += 16;
+                        iter += 16;
+                        continue;
+                    }
+                }
+            #endif
+            *new_str_iter++ = iter[0] == 0 && variant == SE_MUTF8 ? SE_REPLACEMENT_CHAR : *iter;
+            iter++;
+        }
+        else if ((len = se_variant_decode_char(variant, iter, end, &c)) != 0)
+        {
+            if (c <= 0xFFFF)
+            {
+                *new_str_iter++ = (seunichar16) (SE_IS_SURROGATE(c) && !keep ? SE_REPLACEMENT_CHAR : c);
+            }
+            else
+            {
+                *new_str_iter++ = (seunichar16) (0xD800 | ((c - 0x10000) >> 10));
+                *new_str_iter++ = (seunichar16) (0xDC00 | (c & 0x3FF));
+            }
+            iter += len;
+        }
+        else
+        {
+            *new_str_iter++ = SE_REPLACEMENT_CHAR;
+            iter++;
+        }
+    }
+
+    return new_str_iter;
+}
+
+static ptrdiff_t se_safe_utf8_variant_len(int variant, const unsigned char* iter, const unsigned char* end)
+/*
+ * Return the length in bytes of the well-formed UTF-8 string from iter to
+ * end once converted to the variant.
+ */
+{
+    ptrdiff_t new_str_len;
+
+    new_str_len = end - iter;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16 && se_variant_ascii_16(variant, _mm_loadu_si128((const __m128i*)iter)))
+                {
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            if (iter[0] == 0 && variant == SE_MUTF8)
+                new_str_len++;
+            iter++;
+        }
+        else if (iter[0] <= 0xDF)
+            iter += 2;
+        else if (iter[0] <= 0xEF)
+            iter += 3;
+        else
+        {
+            if (variant != SE_WTF8)
+                new_str_len += 2;
+            iter += 4;
+        }
+    }
+
+    return new_str_len;
+}
+
+static unsigned char* se_safe_utf8_variant_fill(int variant, const unsigned char* iter, const unsigned char* end, unsigned char* new_str_iter)
+/*
+ * Convert the well-formed UTF-8 string from iter to end into
+ * new_str_iter, which has room for se_safe_utf8_variant_len() bytes, and
+ * return the end of the output.
+ */
+{
+    seunichar32 c;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                if (end - iter >= 16)
+                {
+                    __m128i block;
+
+                    block = _mm_loadu_si128((const __m128i*)iter);
+                    if (se_variant_ascii_16(variant, block))
+                    {
+                        _mm_storeu_si128((__m128i*)new_str_iter, block);
+                        new_str_iter += 16;
+                        iter += 16;
+                        continue;
+                    }
+                }
+            #endif
+            if (iter[0] == 0 && variant == SE_MUTF8)
+            {
+                new_str_iter += se_variant_encode_char(variant, 0, new_str_iter);
+                iter++;
+            }
+            else
+                *new_str_iter++ = *iter++;
+        }
+        else if (iter[0] <= 0xEF)
+        {
+            /* The same in all the variants */
+            do
+                *new_str_iter++ = *iter++;
+            while (iter < end && (iter[0] & 0xC0) == 0x80);
+        }
+        else
+        {
+            iter = se_variant_safe_utf8_next(iter, &c);
+            new_str_iter += se_variant_encode_char(variant, c, new_str_iter);
+        }
+    }
+
+    return new_str_iter;
+}
+
+static ptrdiff_t se_utf16_variant_len(int variant, const seunichar16* iter, const seunichar16* end)
+/*
+ * Return the length in bytes of the UTF-16 string from iter to end once
+ * converted to the variant.
+ */
+{
+    ptrdiff_t new_str_len;
+    seunichar32 c;
+
+    new_str_len = 0;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                __m128i block;
+
+                if (end - iter >= 16 && se_variant_utf16_ascii_16(variant, iter, &block))
+                {
+                    new_str_len += 16;
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            new_str_len += iter[0] == 0 && variant == SE_MUTF8 ? 2 : 1;
+            iter++;
+        }
+        else
+        {
+            iter = se_variant_utf16_next(iter, end, &c);
+            new_str_len += se_variant_encode_char(variant, c, 0);
+        }
+    }
+
+    return new_str_len;
+}
+
+static unsigned char* se_utf16_variant_fill(int variant, const seunichar16* iter, const seunichar16* end, unsigned char* new_str_iter)
+/*
+ * Convert the UTF-16 string from iter to end into new_str_iter, which has
+ * room for se_utf16_variant_len() bytes, and return the end of the output.
+ */
+{
+    seunichar32 c;
+
+    while (iter < end)
+    {
+        if (iter[0] <= 0x7F)
+        {
+            #if SE_OPT_SSE2
+                __m128i block;
+
+                if (end - iter >= 16 && se_variant_utf16_ascii_16(variant, iter, &block))
+                {
+                    _mm_storeu_si128((__m128i*)new_str_iter, block);
+                    new_str_iter += 16;
+                    iter += 16;
+                    continue;
+                }
+            #endif
+            if (iter[0] == 0 && variant == SE_MUTF8)
+            {
+                new_str_iter += se_variant_encode_char(variant, 0, new_str_iter);
+                iter++;
+            }
+            else
+                *new_str_iter++ = (unsigned char) *iter++;
+        }
+        else
+        {
+            iter = se_variant_utf16_next(iter, end, &c);
+            new_str_iter += se_variant_encode_char(variant, c, new_str_iter);
+        }
+    }
+
+    return new_str_iter;
+}
+
+static sebool se_variant_is_valid_str(int variant, const char* str, ptrdiff_t len)
+{
+    const unsigned char* iter;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz((const seunichar8*)str);
+
+    iter = (const unsigned char*)str;
+
+    return se_variant_is_valid(variant, iter, iter + len);
+}
+
+static seunichar8* se_variant_to_utf8(int variant, const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    seunichar8* new_str;
+    unsigned char* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz((const seunichar8*)str);
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_variant_utf8_len(variant, iter, end);
+
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar8));
+
+    new_str_iter = se_variant_utf8_fill(variant, iter, end, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    *new_str_iter = 0;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(new_str, new_str_len));
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static seunichar16* se_variant_to_utf16(int variant, sebool keep, const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    seunichar16* new_str;
+    seunichar16* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(str);
+
+    if (len < 0)
+        len = se_utf8_str_len_sz((const seunichar8*)str);
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_variant_utf16_len(variant, iter, end);
+
+    new_str = SE_MALLOC((new_str_len + 1) * sizeof(seunichar16));
+
+    new_str_iter = se_variant_utf16_fill(variant, keep, iter, end, new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - new_str == new_str_len);
+    *new_str_iter = 0;
+
+    SE_DEBUG_ASSERT(keep || se_is_valid_utf16_str_sz(new_str, new_str_len));
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static char* se_safe_utf8_to_variant(int variant, const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    char* new_str;
+    unsigned char* new_str_iter;
+    const unsigned char* iter;
+    const unsigned char* end;
+
+    SE_DEBUG_ASSERT(se_is_valid_utf8_str_sz(str, len));
+
+    if (len < 0)
+        len = se_utf8_str_len_sz(str);
+
+    iter = (const unsigned char*)str;
+    end = iter + len;
+
+    new_str_len = se_safe_utf8_variant_len(variant, iter, end);
+
+    new_str = SE_MALLOC(new_str_len + 1);
+
+    new_str_iter = se_safe_utf8_variant_fill(variant, iter, end, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    *new_str_iter = 0;
+
+    SE_DEBUG_ASSERT(se_variant_is_valid(variant, (unsigned char*)new_str, new_str_iter));
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+static char* se_utf16_to_variant(int variant, const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+{
+    ptrdiff_t new_str_len;
+    char* new_str;
+    unsigned char* new_str_iter;
+
+    SE_DEBUG_ASSERT(str);
+    SE_DEBUG_ASSERT(variant != SE_CESU8 || se_is_valid_utf16_str_sz(str, len));
+
+    if (len < 0)
+        len = se_utf16_str_len_sz(str);
+
+    new_str_len = se_utf16_variant_len(variant, str, str + len);
+
+    new_str = SE_MALLOC(new_str_len + 1);
+
+    new_str_iter = se_utf16_variant_fill(variant, str, str + len, (unsigned char*)new_str);
+
+    SE_DEBUG_ASSERT(new_str_iter - (unsigned char*)new_str == new_str_len);
+    *new_str_iter = 0;
+
+    SE_DEBUG_ASSERT(se_variant_is_valid(variant, (unsigned char*)new_str, new_str_iter));
+
+    if (out_len)
+        *out_len = new_str_len;
+
+    return new_str;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * WTF-8.                                                                  *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API sebool se_is_valid_wtf8_str_sz(const char* str, ptrdiff_t len)
+/*
+ * str:
+ *      Input WTF-8 string.
+ *
+ * len:
+ *      The byte length of input string.
+ *      If len < 0, then the string is NUL terminated.
+ *
+ * Check whether a string is well-formed WTF-8.
+ *
+ * Return:
+ *      TRUE if the string is well-formed.
+ */
+{
+    return se_variant_is_valid_str(SE_WTF8, str, len);
+}
+
+SE_API sebool se_is_valid_wtf8_str(const char* str, int len)
+{
+    return se_is_valid_wtf8_str_sz(str, len);
+}
+
+SE_API seunichar16* se_unsafe_wtf8_to_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * str:
+ *      Input WTF-8 string.
+ *
+ * len:
+ *      The byte length of input string.
+ *      If len < 0, then the string is NUL terminated.
+ *
+ * out_len:
+ *      Location to return the length of the output string.
+ *      (Can be NULL to indicate that the result is not needed.)
+ *
+ * Convert a string from WTF-8 to UTF-16, keeping lone surrogates.
+ * Invalid codes are replaced.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_variant_to_utf16(SE_WTF8, TRUE, str, len, out_len);
+}
+
+SE_API seunichar16* se_unsafe_wtf8_to_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_wtf8_to_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar16* se_unsafe_wtf8_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from WTF-8 to UTF-16, as by se_unsafe_wtf8_to_utf16(),
+ * but replacing lone surrogates too.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_variant_to_utf16(SE_WTF8, FALSE, str, len, out_len);
+}
+
+SE_API seunichar16* se_unsafe_wtf8_to_safe_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_wtf8_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar8* se_unsafe_wtf8_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from WTF-8 to UTF-8.
+ * Invalid codes and lone surrogates are replaced.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_variant_to_utf8(SE_WTF8, str, len, out_len);
+}
+
+SE_API seunichar8* se_unsafe_wtf8_to_safe_utf8(const char* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_wtf8_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_utf16_to_wtf8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * str:
+ *      Input UTF-16 string, which can have lone surrogates.
+ *
+ * len:
+ *      The length in units of input string.
+ *      If len < 0, then the string is NUL terminated.
+ *
+ * out_len:
+ *      Location to return the byte length of the output string.
+ *      (Can be NULL to indicate that the result is not needed.)
+ *
+ * Convert a string of 16 bit units to WTF-8, without loss.
+ *
+ * Return:
+ *      A pointer to a newly allocated WTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_utf16_to_variant(SE_WTF8, str, len, out_len);
+}
+
+SE_API char* se_utf16_to_wtf8(const seunichar16* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_utf16_to_wtf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * CESU-8.                                                                 *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API sebool se_is_valid_cesu8_str_sz(const char* str, ptrdiff_t len)
+/*
+ * Check whether a string is well-formed CESU-8, as by
+ * se_is_valid_wtf8_str().
+ */
+{
+    return se_variant_is_valid_str(SE_CESU8, str, len);
+}
+
+SE_API sebool se_is_valid_cesu8_str(const char* str, int len)
+{
+    return se_is_valid_cesu8_str_sz(str, len);
+}
+
+SE_API seunichar8* se_unsafe_cesu8_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from CESU-8 to UTF-8.
+ * Invalid codes are replaced.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_variant_to_utf8(SE_CESU8, str, len, out_len);
+}
+
+SE_API seunichar8* se_unsafe_cesu8_to_safe_utf8(const char* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_cesu8_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar16* se_unsafe_cesu8_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from CESU-8 to UTF-16.
+ * Invalid codes are replaced.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_variant_to_utf16(SE_CESU8, FALSE, str, len, out_len);
+}
+
+SE_API seunichar16* se_unsafe_cesu8_to_safe_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_cesu8_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf8_to_cesu8_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-8 to CESU-8.
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated CESU-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf8_to_variant(SE_CESU8, str, len, out_len);
+}
+
+SE_API char* se_safe_utf8_to_cesu8(const seunichar8* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_cesu8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf16_to_cesu8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-16 to CESU-8.
+ * Assuming the input string is well-formed.
+ *
+ * Return:
+ *      A pointer to a newly allocated CESU-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_utf16_to_variant(SE_CESU8, str, len, out_len);
+}
+
+SE_API char* se_safe_utf16_to_cesu8(const seunichar16* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf16_to_cesu8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+/***************************************************************************
+ *                                                                         *
+ * Modified UTF-8.                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+SE_API sebool se_is_valid_mutf8_str_sz(const char* str, ptrdiff_t len)
+/*
+ * Check whether a string is well-formed Modified UTF-8, as by
+ * se_is_valid_wtf8_str().
+ */
+{
+    return se_variant_is_valid_str(SE_MUTF8, str, len);
+}
+
+SE_API sebool se_is_valid_mutf8_str(const char* str, int len)
+{
+    return se_is_valid_mutf8_str_sz(str, len);
+}
+
+SE_API seunichar16* se_unsafe_mutf8_to_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from Modified UTF-8 to UTF-16, keeping lone
+ * surrogates, as for a Java string.
+ * Invalid codes are replaced.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_variant_to_utf16(SE_MUTF8, TRUE, str, len, out_len);
+}
+
+SE_API seunichar16* se_unsafe_mutf8_to_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_mutf8_to_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar16* se_unsafe_mutf8_to_safe_utf16_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from Modified UTF-8 to UTF-16, as by
+ * se_unsafe_mutf8_to_utf16(), but replacing lone surrogates too.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-16 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_variant_to_utf16(SE_MUTF8, FALSE, str, len, out_len);
+}
+
+SE_API seunichar16* se_unsafe_mutf8_to_safe_utf16(const char* str, int len, int* out_len)
+{
+    seunichar16* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_mutf8_to_safe_utf16_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API seunichar8* se_unsafe_mutf8_to_safe_utf8_sz(const char* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from Modified UTF-8 to UTF-8.
+ * Invalid codes and lone surrogates are replaced.
+ *
+ * Return:
+ *      A pointer to a newly allocated UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_variant_to_utf8(SE_MUTF8, str, len, out_len);
+}
+
+SE_API seunichar8* se_unsafe_mutf8_to_safe_utf8(const char* str, int len, int* out_len)
+{
+    seunichar8* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_unsafe_mutf8_to_safe_utf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_utf16_to_mutf8_sz(const seunichar16* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string of 16 bit units to Modified UTF-8, without loss, as
+ * for a Java string.
+ *
+ * Return:
+ *      A pointer to a newly allocated Modified UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_utf16_to_variant(SE_MUTF8, str, len, out_len);
+}
+
+SE_API char* se_utf16_to_mutf8(const seunichar16* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_utf16_to_mutf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
+
+SE_API char* se_safe_utf8_to_mutf8_sz(const seunichar8* str, ptrdiff_t len, ptrdiff_t* out_len)
+/*
+ * Convert a string from UTF-8 to Modified UTF-8.
+ * Assuming the input string is well-formed. U+0000 can only be part
+ * of it if len is not negative.
+ *
+ * Return:
+ *      A pointer to a newly allocated Modified UTF-8 string.
+ *      This string must be freed by caller.
+ */
+{
+    return se_safe_utf8_to_variant(SE_MUTF8, str, len, out_len);
+}
+
+SE_API char* se_safe_utf8_to_mutf8(const seunichar8* str, int len, int* out_len)
+{
+    char* new_str;
+    ptrdiff_t new_str_len;
+
+    new_str = se_safe_utf8_to_mutf8_sz(str, len, &new_str_len);
+
+    if (out_len)
+        *out_len = (int) new_str_len;
+
+    return new_str;
+}
@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2000-2007 Beijing Komoxo Inc.
+# All rights reserved.
+#
+# se-mbcs-tables.py: generate the mapping tables of se-unicode-mbcs.c from
+# the codecs of Python.
+#
+#     tools/se-mbcs-tables.py > se-unicode-mbcs-tables.h
+#
+# Each encoding gets a decoding table of 16 bit code points, with one row
+# per lead byte in use and one column per trail byte in use, and maps from
+# the lead and trail bytes to the rows and columns. Single bytes above
+# ASCII that are characters get a table of their own. The encoding table
+# holds the codes of each 256 code point page of the BMP, trimmed to the
+# span of mapped code points; a code below 0x100 is a single byte. 0
+# stands for an unmapped code in all the tables. Where several codes
+# decode to the same code point, the encoding table takes the one chosen
+# by the encoder of Python. The tables are checked to round trip before
+# they are written.
+#
+# GB18030 also gets the ranges mapping the BMP code points without a
+# double byte code to the four byte codes, in the order of both.
+#
+
+import sys
+
+
+ENCODINGS = [
+    # name, Python codec, four byte codes
+    ("gb18030", "gb18030", True),
+    ("shift_jis", "shift_jis", False),
+    ("euc_kr", "euc_kr", False),
+    ("big5", "big5", False),
+]
+
+
+def decode_one(codec, data):
+    """Return the code point of data if it decodes to a single character."""
+    try:
+        text = data.decode(codec)
+    except UnicodeDecodeError:
+        return None
+    if len(text) != 1 or ord(text) < 0x80:
+        return None
+    return ord(text)
+
+
+def mapped_codes(codec):
+    """Return the single byte codes, the double byte codes, and the codes
+    of the BMP code points of codec."""
+    single = {}
+    for byte in range(0x80, 0x100):
+        c = decode_one(codec, bytes([byte]))
+        if c is not None:
+            single[byte] = c
+
+    double = {}
+    for lead in range(0x81, 0xFF):
+        if lead in single:
+            continue
+        for trail in range(0x40, 0xFF):
+            c = decode_one(codec, bytes([lead, trail]))
+            if c is not None:
+                double[lead << 8 | trail] = c
+
+    by_code = {}
+    for c in range(0x80, 0x10000):
+        if 0xD800 <= c < 0xE000:
+            continue
+        try:
+            encoded = chr(c).encode(codec)
+        except UnicodeEncodeError:
+            continue
+        if len(encoded) == 1:
+            # Not the fallbacks to ASCII, like U+00A5 to 0x5C of shift_jis
+            if encoded[0] >= 0x80:
+                by_code[c] = encoded[0]
+        elif len(encoded) == 2:
+            code = encoded[0] << 8 | encoded[1]
+            # A code only the encoder produces, like 0xA4D4 of euc_kr,
+            # which its decoder takes as the start of a longer sequence
+            double.setdefault(code, c)
+            by_code[c] = code
+
+    return single, double, by_code
+
+
+def check_round_trip(name, single, double, by_code):
+    for code, c in list(single.items()) + list(double.items()):
+        if c not in by_code:
+            sys.exit("se-mbcs-tables: %s: U+%04X does not encode" % (name, c))
+        if single.get(by_code[c], double.get(by_code[c])) != c:
+            sys.exit("se-mbcs-tables: %s: U+%04X does not round trip" % (name, c))
+    for c, code in by_code.items():
+        if single.get(code, double.get(code)) != c:
+            sys.exit("se-mbcs-tables: %s: U+%04X does not round trip" % (name, c))
+
+
+def write_array(out, decl, values, per_line=12):
+    out.write("%s =\n{\n" % decl)
+    for i in range(0, len(values), per_line):
+        out.write("    " + ", ".join(values[i:i + per_line]) + ",\n")
+    out.write("};\n\n")
+
+
+def write_index_map(out, decl, used):
+    index = ["0xFF"] * 256
+    for i, byte in enumerate(used):
+        index[byte] = "%d" % i
+    write_array(out, decl, index, 16)
+
+
+def write_encoding(out, name, codec, four_byte):
+    single, double, by_code = mapped_codes(codec)
+    check_round_trip(name, single, double, by_code)
+
+    leads = sorted(set(code >> 8 for code in double))
+    trails = sorted(set(code & 0xFF for code in double))
+
+    decode = []
+    for lead in leads:
+        for trail in trails:
+            decode.append("0x%04X" % double.get(lead << 8 | trail, 0))
+
+    pages = []
+    encode = []
+    for page in range(256):
+        mapped = [c & 0xFF for c in by_code if c >> 8 == page]
+        if not mapped:
+            pages.append("{ 0, 1, 0 }")
+            continue
+        first = min(mapped)
+        last = max(mapped)
+        pages.append("{ %d, 0x%02X, 0x%02X }" % (len(encode), first, last))
+        for c in range(page << 8 | first, (page << 8 | last) + 1):
+            encode.append("0x%04X" % by_code.get(c, 0))
+
+    out.write("/* %s: %d single byte and %d double byte codes, %d leads and %d trails */\n\n"
+              % (name, len(single), len(double), len(leads), len(trails)))
+    write_index_map(out, "static const unsigned char se_%s_rows[256]" % name, leads)
+    write_index_map(out, "static const unsigned char se_%s_columns[256]" % name, trails)
+    write_array(out, "static const unsigned short se_%s_decode[%d * %d]" % (name, len(leads), len(trails)), decode)
+    if single:
+        write_array(out, "static const unsigned short se_%s_single[128]" % name,
+                    ["0x%04X" % single.get(byte, 0) for byte in range(0x80, 0x100)])
+    write_array(out, "static const se_mbcs_page se_%s_encode_pages[256]" % name, pages, 4)
+    write_array(out, "static const unsigned short se_%s_encode[%d]" % (name, len(encode)), encode)
+
+    out.write("static const se_mbcs_codec se_%s_codec =\n{\n" % name)
+    out.write("    se_%s_rows, se_%s_columns, %d, se_%s_decode, %s,\n"
+              % (name, name, len(trails), name, "se_%s_single" % name if single else "0"))
+    out.write("    se_%s_encode_pages, se_%s_encode, %s\n" % (name, name, "TRUE" if four_byte else "FALSE"))
+    out.write("};\n\n")
+
+
+def gb18030_linear(encoded):
+    return (((encoded[0] - 0x81) * 10 + encoded[1] - 0x30) * 126 + encoded[2] - 0x81) * 10 + encoded[3] - 0x30
+
+
+def write_gb18030_ranges(out):
+    ranges = []
+    for c in range(0x80, 0x10000):
+        if 0xD800 <= c < 0xE000:
+            continue
+        encoded = chr(c).encode("gb18030")
+        if len(encoded) != 4:
+            continue
+        linear = gb18030_linear(encoded)
+        if ranges and ranges[-1][2] + 1 == c and ranges[-1][3] + 1 == linear:
+            ranges[-1][2] = c
+            ranges[-1][3] = linear
+        elif ranges and ranges[-1][3] + 1 != linear:
+            sys.exit("se-mbcs-tables: gb18030: four byte codes of U+%04X are not contiguous" % c)
+        else:
+            ranges.append([c, linear, c, linear])
+
+    out.write("/* gb18030: BMP code points with four byte codes, %d linear codes */\n\n" % (ranges[-1][3] + 1))
+    write_array(out, "static const se_gb18030_range se_gb18030_ranges[%d]" % len(ranges),
+                ["{ %d, 0x%04X }" % (r[1], r[0]) for r in ranges], 4)
+    out.write("#define SE_GB18030_BMP_LINEAR_COUNT %d\n\n" % (ranges[-1][3] + 1))
+
+
+def main():
+    out = sys.stdout
+
+    out.write("/*\n"
+              " * Copyright (C) 2000-2007 Beijing Komoxo Inc.\n"
+              " * All rights reserved.\n"
+              " */\n\n"
+              "/*\n"
+              " * Generated by tools/se-mbcs-tables.py with Python %d.%d, do not edit.\n"
+              " */\n\n" % sys.version_info[:2])
+
+    write_gb18030_ranges(out)
+    for name, codec, four_byte in ENCODINGS:
+        write_encoding(out, name, codec, four_byte)
+
+
+if __name__ == "__main__":
+    main()
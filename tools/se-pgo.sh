@@ -0,0 +1,74 @@
+#!/bin/sh
+#
+# Copyright (C) 2000-2007 Beijing Komoxo Inc.
+# All rights reserved.
+#
+# se-pgo.sh: build se-unicode with profile guided optimization and measure
+# the gain over a plain build.
+#
+#     tools/se-pgo.sh [-b BUILD_DIR] [-t SECONDS] INCLUDE_DIR PROFILE...
+#
+#     -b BUILD_DIR   Where to build (default build-pgo).
+#     -t SECONDS     se-bench measuring time per case (default 0.2).
+#
+# INCLUDE_DIR holds se-unicode.h and se-utils.h. Each PROFILE is a se-train
+# profile: ascii-heavy, cjk-heavy or mixed. For each one, an instrumented
+# build is trained with se-train and rebuilt with the profiles, then
+# se-bench runs in the plain and in the trained build. The table printed
+# for each profile gives the speedup per function and corpus; corpora
+# close to the training mix should gain, the others may lose.
+#
+# GCC finds its profiles by object path, so the trained build is done in
+# the same directory as the instrumented one.
+#
+
+set -e
+
+build=build-pgo
+seconds=0.2
+
+while getopts b:t: opt; do
+    case $opt in
+    b) build=$OPTARG ;;
+    t) seconds=$OPTARG ;;
+    *) echo "usage: se-pgo.sh [-b BUILD_DIR] [-t SECONDS] INCLUDE_DIR PROFILE..." >&2; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -lt 2 ]; then
+    echo "usage: se-pgo.sh [-b BUILD_DIR] [-t SECONDS] INCLUDE_DIR PROFILE..." >&2
+    exit 2
+fi
+
+src=$(cd "$(dirname "$0")/.." && pwd)
+include=$(cd "$1" && pwd)
+shift
+
+jobs=$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 4)
+
+configure() {
+    cmake -S "$src" -B "$1" -DCMAKE_BUILD_TYPE=Release -DSE_UNICODE_INCLUDE_DIR="$include" \
+          -DSE_UNICODE_ISA_VARIANTS= -DSE_UNICODE_BUILD_TOOLS=OFF "$@" >/dev/null
+}
+
+configure "$build/plain" -DSE_UNICODE_PGO=
+cmake --build "$build/plain" -j "$jobs" --target se-bench >/dev/null
+"$build/plain/se-bench" -t "$seconds" > "$build/plain.txt"
+
+for profile in "$@"; do
+    dir="$build/$profile"
+
+    configure "$dir" -DSE_UNICODE_PGO=GENERATE -DSE_UNICODE_PGO_TRAINING="$profile"
+    cmake --build "$dir" -j "$jobs" --target pgo-train >/dev/null
+
+    configure "$dir" -DSE_UNICODE_PGO=USE
+    cmake --build "$dir" -j "$jobs" --target se-bench >/dev/null
+    "$dir/se-bench" -t "$seconds" > "$build/$profile.txt"
+
+    echo "== $profile"
+    awk 'NR == FNR { if (FNR > 1) plain[$1 " " $2] = $3; next }
+         FNR == 1 { printf "%-44s %-14s %10s %10s %8s\n", "function", "corpus", "plain", "pgo", "gain"; next }
+         ($1 " " $2) in plain { printf "%-44s %-14s %10.3f %10.3f %7.1f%%\n", $1, $2, plain[$1 " " $2], $3,
+                                       ($3 / plain[$1 " " $2] - 1) * 100 }' "$build/plain.txt" "$build/$profile.txt"
+done
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2000-2007 Beijing Komoxo Inc.
+ * All rights reserved.
+ */
+
+/*
+ * se-uconv: validate or convert Unicode files in bulk.
+ *
+ *     se-uconv validate-utf8  FILE...
+ *     se-uconv validate-utf16 FILE...
+ *     se-uconv validate-utf32 FILE...
+ *     se-uconv detect         FILE...
+ *     se-uconv repair-utf8    IN OUT
+ *     se-uconv utf8-to-utf16  IN OUT
+ *     se-uconv utf16-to-utf8  IN OUT
+ *
+ * Exit status is 0 on success, 1 if a file is not valid and 2 on error.
+ */
+
+#ifndef SE_UNICODE_H
+    #include "se-unicode.h"
+#endif
+
+#ifndef SE_UNICODE_EXT_H
+    #include "se-unicode-ext.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+static int usage(void)
+{
+    fputs("usage: se-uconv validate-utf8|validate-utf16|validate-utf32|detect FILE...\n"
+          "       se-uconv repair-utf8|utf8-to-utf16|utf16-to-utf8 IN OUT\n", stderr);
+    return 2;
+}
+
+static int validate(int (*func)(const char*), int argc, char** argv)
+{
+    int i;
+    int valid;
+    int status;
+
+    status = 0;
+
+    for (i = 0; i < argc; i++)
+    {
+        valid = func(argv[i]);
+        if (valid < 0)
+        {
+            fprintf(stderr, "se-uconv: %s: %s\n", argv[i], strerror(errno));
+            status = 2;
+        }
+        else if (!valid)
+        {
+            printf("%s: invalid\n", argv[i]);
+            if (status == 0)
+                status = 1;
+        }
+    }
+
+    return status;
+}
+
+static int detect(int argc, char** argv)
+{
+    int i;
+    int confidence;
+    const char* name;
+    int status;
+
+    status = 0;
+
+    for (i = 0; i < argc; i++)
+    {
+        name = se_detect_file_encoding(argv[i], &confidence);
+        if (!name)
+        {
+            fprintf(stderr, "se-uconv: %s: %s\n", argv[i], strerror(errno));
+            status = 2;
+        }
+        else
+            printf("%s: %s (%d%%)\n", argv[i], name, confidence);
+    }
+
+    return status;
+}
+
+static int convert(int (*func)(const char*, const char*), int argc, char** argv)
+{
+    if (argc != 2)
+        return usage();
+
+    if (func(argv[0], argv[1]) < 0)
+    {
+        fprintf(stderr, "se-uconv: %s -> %s: %s\n", argv[0], argv[1], strerror(errno));
+        return 2;
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+        return usage();
+
+    if (strcmp(argv[1], "validate-utf8") == 0)
+        return validate(se_is_valid_utf8_file, argc - 2, argv + 2);
+    if (strcmp(argv[1], "validate-utf16") == 0)
+        return validate(se_is_valid_utf16_file, argc - 2, argv + 2);
+    if (strcmp(argv[1], "validate-utf32") == 0)
+        return validate(se_is_valid_utf32_file, argc - 2, argv + 2);
+    if (strcmp(argv[1], "detect") == 0)
+        return detect(argc - 2, argv + 2);
+    if (strcmp(argv[1], "repair-utf8") == 0)
+        return convert(se_unsafe_utf8_file_safe_copy, argc - 2, argv + 2);
+    if (strcmp(argv[1], "utf8-to-utf16") == 0)
+        return convert(se_unsafe_utf8_file_to_safe_utf16_file, argc - 2, argv + 2);
+    if (strcmp(argv[1], "utf16-to-utf8") == 0)
+        return convert(se_unsafe_utf16_file_to_safe_utf8_file, argc - 2, argv + 2);
+
+    return usage();
+}